@@ -38,6 +38,8 @@ public:
 	class Node : public NonCopyable
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 		/// Constructor
 							Node();
 							~Node();
@@ -70,7 +72,7 @@ public:
 		float				CalculateSAHCost(float inCostTraversal, float inCostLeaf) const;
 
 		/// Recursively get children (breadth first) to get in total inN children (or less if there are no more)
-		void				GetNChildren(uint inN, vector<const Node *> &outChildren) const;
+		void				GetNChildren(uint inN, TaggedVector<const Node *, EMemoryTag::Shapes> &outChildren) const;
 
 		/// Bounding box
 		AABox				mBounds;
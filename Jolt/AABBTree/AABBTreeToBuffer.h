@@ -67,9 +67,10 @@ public:
 			uint *							mParentTrianglesStart = nullptr;			// Where to store mTriangleStart (to patch mChildTrianglesStart of my parent)
 		};
 		
-		deque<NodeData *> to_process;
-		deque<NodeData *> to_process_triangles;
-		vector<NodeData> node_list;
+		using NodeDataQueue = deque<NodeData *, STLAllocator<NodeData *, EMemoryTag::Shapes>>;
+		NodeDataQueue to_process;
+		NodeDataQueue to_process_triangles;
+		TaggedVector<NodeData, EMemoryTag::Shapes> node_list;
 
 		node_list.reserve(node_count); // Needed to ensure that array is not reallocated, so we can keep pointers in the array
 		
@@ -81,7 +82,7 @@ public:
 		to_process.push_back(&node_list.back());
 
 		// Child nodes out of loop so we don't constantly realloc it
-		vector<const AABBTreeBuilder::Node *> child_nodes;
+		TaggedVector<const AABBTreeBuilder::Node *, EMemoryTag::Shapes> child_nodes;
 		child_nodes.reserve(NumChildrenPerNode);
 
 		for (;;)
@@ -0,0 +1,346 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/ByteBuffer.h>
+#include <Jolt/Math/HalfFloat.h>
+#include <Jolt/AABBTree/AABBTreeBuilder.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Node codec that stores 8 children per node (instead of 4 for NodeCodecQuadTreeHalfFloat) which halves the depth of the tree.
+/// Visitors have the same interface as for NodeCodecQuadTreeHalfFloat and are called with the children in 2 groups of 4.
+/// A visitor that sorts the children by distance (e.g. a ray cast) can in addition implement:
+///
+///		int VisitNodes8(const ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+///
+/// which tests all 8 children at once and stores the properties of the children to visit in outProperties, sorted from last to first to visit.
+/// See SortReverseAndStore8.
+template <int Alignment>
+class NodeCodecOctTreeHalfFloat
+{
+public:
+	/// Number of child nodes of this node
+	static constexpr int				NumChildrenPerNode = 8;
+
+	/// Header for the tree
+	struct Header
+	{
+		Float3							mRootBoundsMin;
+		Float3							mRootBoundsMax;
+		uint32							mRootProperties;
+	};
+
+	/// Size of the header (an empty struct is always > 0 bytes so this needs a separate variable)
+	static constexpr int				HeaderSize = sizeof(Header);
+	
+	/// Stack size to use during DecodingContext::sWalkTree
+	static constexpr int				StackSize = 128;
+
+	/// Bounds of the 8 children of a node, element 0 contains the first 4 children and element 1 the last 4
+	struct ChildBounds
+	{
+		Vec4							mMinX[2];
+		Vec4							mMinY[2];
+		Vec4							mMinZ[2];
+		Vec4							mMaxX[2];
+		Vec4							mMaxY[2];
+		Vec4							mMaxZ[2];
+	};
+
+	/// Node properties
+	enum : uint32
+	{
+		TRIANGLE_COUNT_BITS				= 4,
+		TRIANGLE_COUNT_SHIFT			= 28,
+		TRIANGLE_COUNT_MASK				= (1 << TRIANGLE_COUNT_BITS) - 1,
+		OFFSET_BITS						= 28,
+		OFFSET_MASK						= (1 << OFFSET_BITS) - 1,
+		OFFSET_NON_SIGNIFICANT_BITS		= 2,
+		OFFSET_NON_SIGNIFICANT_MASK		= (1 << OFFSET_NON_SIGNIFICANT_BITS) - 1,
+	};
+
+	/// Node structure
+	struct Node
+	{
+		HalfFloat						mBoundsMinX[8];			///< 8 child bounding boxes
+		HalfFloat						mBoundsMinY[8];
+		HalfFloat						mBoundsMinZ[8];
+		HalfFloat						mBoundsMaxX[8];
+		HalfFloat						mBoundsMaxY[8];
+		HalfFloat						mBoundsMaxZ[8];
+		uint32							mNodeProperties[8];		///< 8 child node properties
+	};
+	
+	static_assert(sizeof(Node) == 128, "Node should be 128 bytes");
+
+	/// This class encodes and compresses oct tree nodes
+	class EncodingContext
+	{
+	public:
+		/// Get an upper bound on the amount of bytes needed for a node tree with inNodeCount nodes
+		uint							GetPessimisticMemoryEstimate(uint inNodeCount) const
+		{
+			return inNodeCount * (sizeof(Node) + Alignment - 1);
+		}
+
+		/// Allocate a new node for inNode. 
+		/// Algorithm can modify the order of ioChildren to indicate in which order children should be compressed
+		/// Algorithm can enlarge the bounding boxes of the children during compression and returns these in outChildBoundsMin, outChildBoundsMax
+		/// inNodeBoundsMin, inNodeBoundsMax is the bounding box if inNode possibly widened by compressing the parent node
+		/// Returns uint(-1) on error and reports the error in outError
+		uint							NodeAllocate(const AABBTreeBuilder::Node *inNode, Vec3Arg inNodeBoundsMin, Vec3Arg inNodeBoundsMax, TaggedVector<const AABBTreeBuilder::Node *, EMemoryTag::Shapes> &ioChildren, Vec3 outChildBoundsMin[NumChildrenPerNode], Vec3 outChildBoundsMax[NumChildrenPerNode], ByteBuffer &ioBuffer, const char *&outError) const
+		{
+			// We don't emit nodes for leafs
+			if (!inNode->HasChildren())
+				return (uint)ioBuffer.size();
+				
+			// Align the buffer
+			ioBuffer.Align(Alignment);
+			uint node_start = (uint)ioBuffer.size();
+
+			// Fill in bounds
+			Node *node = ioBuffer.Allocate<Node>();
+
+			for (size_t i = 0; i < 8; ++i)
+			{
+				if (i < ioChildren.size())
+				{
+					const AABBTreeBuilder::Node *this_node = ioChildren[i];
+
+					// Copy bounding box
+					node->mBoundsMinX[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_NEG_INF>(this_node->mBounds.mMin.GetX());
+					node->mBoundsMinY[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_NEG_INF>(this_node->mBounds.mMin.GetY());
+					node->mBoundsMinZ[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_NEG_INF>(this_node->mBounds.mMin.GetZ());
+					node->mBoundsMaxX[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_POS_INF>(this_node->mBounds.mMax.GetX());
+					node->mBoundsMaxY[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_POS_INF>(this_node->mBounds.mMax.GetY());
+					node->mBoundsMaxZ[i] = HalfFloatConversion::FromFloat<HalfFloatConversion::ROUND_TO_POS_INF>(this_node->mBounds.mMax.GetZ());
+
+					// Store triangle count
+					node->mNodeProperties[i] = this_node->GetTriangleCount() << TRIANGLE_COUNT_SHIFT;
+					if (this_node->GetTriangleCount() >= TRIANGLE_COUNT_MASK)
+					{
+						outError = "NodeCodecOctTreeHalfFloat: Too many triangles";
+						return uint(-1);
+					}
+				}
+				else
+				{
+					// Make this an invalid triangle node
+					node->mNodeProperties[i] = uint32(TRIANGLE_COUNT_MASK) << TRIANGLE_COUNT_SHIFT; 
+
+					// Make bounding box invalid
+					node->mBoundsMinX[i] = HALF_FLT_MAX;
+					node->mBoundsMinY[i] = HALF_FLT_MAX;
+					node->mBoundsMinZ[i] = HALF_FLT_MAX;
+					node->mBoundsMaxX[i] = HALF_FLT_MAX;
+					node->mBoundsMaxY[i] = HALF_FLT_MAX;
+					node->mBoundsMaxZ[i] = HALF_FLT_MAX;
+				}
+			}
+
+			// Since we don't keep track of the bounding box while descending the tree, we keep the root bounds at all levels for triangle compression
+			for (int i = 0; i < NumChildrenPerNode; ++i)
+			{
+				outChildBoundsMin[i] = inNodeBoundsMin;
+				outChildBoundsMax[i] = inNodeBoundsMax;
+			}
+
+			return node_start;
+		}
+
+		/// Once all nodes have been added, this call finalizes all nodes by patching in the offsets of the child nodes (that were added after the node itself was added)
+		bool						NodeFinalize(const AABBTreeBuilder::Node *inNode, uint inNodeStart, uint inNumChildren, const uint *inChildrenNodeStart, const uint *inChildrenTrianglesStart, ByteBuffer &ioBuffer, const char *&outError) const
+		{
+			if (!inNode->HasChildren())
+				return true;
+
+			Node *node = ioBuffer.Get<Node>(inNodeStart);
+			for (uint i = 0; i < inNumChildren; ++i)
+			{
+				// If there are triangles, use the triangle offset otherwise use the node offset
+				uint offset = node->mNodeProperties[i] != 0? inChildrenTrianglesStart[i] : inChildrenNodeStart[i];
+				if (offset & OFFSET_NON_SIGNIFICANT_MASK)
+				{
+					outError = "NodeCodecOctTreeHalfFloat: Internal Error: Offset has non-signifiant bits set";
+					return false;
+				}
+				offset >>= OFFSET_NON_SIGNIFICANT_BITS;
+				if (offset & ~OFFSET_MASK)
+				{
+					outError = "NodeCodecOctTreeHalfFloat: Offset too large. Too much data.";
+					return false;
+				}
+
+				// Store offset of next node / triangles
+				node->mNodeProperties[i] |= offset;
+			}
+
+			return true;
+		}
+
+		/// Once all nodes have been finalized, this will finalize the header of the nodes
+		bool						Finalize(Header *outHeader, const AABBTreeBuilder::Node *inRoot, uint inRootNodeStart, uint inRootTrianglesStart, const char *&outError) const
+		{
+			uint offset = inRoot->HasChildren()? inRootNodeStart : inRootTrianglesStart;
+			if (offset & OFFSET_NON_SIGNIFICANT_MASK)
+			{
+				outError = "NodeCodecOctTreeHalfFloat: Internal Error: Offset has non-signifiant bits set";
+				return false;
+			}
+			offset >>= OFFSET_NON_SIGNIFICANT_BITS;
+			if (offset & ~OFFSET_MASK)
+			{
+				outError = "NodeCodecOctTreeHalfFloat: Offset too large. Too much data.";
+				return false;
+			}
+
+			inRoot->mBounds.mMin.StoreFloat3(&outHeader->mRootBoundsMin);
+			inRoot->mBounds.mMax.StoreFloat3(&outHeader->mRootBoundsMax);
+			outHeader->mRootProperties = offset + (inRoot->GetTriangleCount() << TRIANGLE_COUNT_SHIFT);
+			if (inRoot->GetTriangleCount() >= TRIANGLE_COUNT_MASK)
+			{
+				outError = "NodeCodecOctTreeHalfFloat: Too many triangles";
+				return false;
+			}
+
+			return true;
+		}		
+	};
+
+	/// This class decodes and decompresses oct tree nodes
+	class DecodingContext
+	{
+	public:
+		/// Get the amount of bits needed to store an ID to a triangle block
+		inline static uint			sTriangleBlockIDBits(const ByteBuffer &inTree)
+		{
+			return 32 - CountLeadingZeros((uint32)inTree.size()) - OFFSET_NON_SIGNIFICANT_BITS;
+		}
+
+		/// Convert a triangle block ID to the start of the triangle buffer
+		inline static const void *	sGetTriangleBlockStart(const uint8 *inBufferStart, uint inTriangleBlockID)
+		{
+			return inBufferStart + (inTriangleBlockID << OFFSET_NON_SIGNIFICANT_BITS);
+		}
+
+		/// Constructor
+		JPH_INLINE explicit			DecodingContext(const Header *inHeader)
+		{
+			// Start with the root node on the stack
+			mNodeStack[0] = inHeader->mRootProperties;
+		}
+
+		/// Test the 8 children of a node with Visitor::VisitNodes8 if the visitor implements it, otherwise test them in 2 groups of 4 with Visitor::VisitNodes.
+		/// Stores the properties of the children to visit in outProperties and returns how many there are.
+		template <class Visitor>
+		JPH_INLINE static int		sVisitNodes8(Visitor &ioVisitor, const ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			if constexpr (HasVisitNodes8<Visitor>::value)
+			{
+				// Sort all 8 children together
+				return ioVisitor.VisitNodes8(inBounds, inPropertiesLo, inPropertiesHi, outProperties, inStackTop);
+			}
+			else
+			{
+				// Check which of the last 4 sub nodes to visit and push them onto the stack first so that the first 4 sub nodes will be visited first
+				UVec4 properties_hi = inPropertiesHi;
+				int num_hi = ioVisitor.VisitNodes(inBounds.mMinX[1], inBounds.mMinY[1], inBounds.mMinZ[1], inBounds.mMaxX[1], inBounds.mMaxY[1], inBounds.mMaxZ[1], properties_hi, inStackTop);
+				properties_hi.StoreInt4(outProperties);
+
+				// Check which of the first 4 sub nodes to visit
+				UVec4 properties_lo = inPropertiesLo;
+				int num_lo = ioVisitor.VisitNodes(inBounds.mMinX[0], inBounds.mMinY[0], inBounds.mMinZ[0], inBounds.mMaxX[0], inBounds.mMaxY[0], inBounds.mMaxZ[0], properties_lo, inStackTop + num_hi);
+				properties_lo.StoreInt4(outProperties + num_hi);
+
+				return num_hi + num_lo;
+			}
+		}
+
+		/// Walk the node tree calling the Visitor::VisitNodes for each node encountered and Visitor::VisitTriangles for each triangle encountered
+		template <class TriangleContext, class Visitor>
+		JPH_INLINE void				WalkTree(const uint8 *inBufferStart, const TriangleContext &inTriangleContext, Visitor &ioVisitor)
+		{
+			do
+			{
+				// Test if node contains triangles
+				uint32 node_properties = mNodeStack[mTop];
+				uint32 tri_count = node_properties >> TRIANGLE_COUNT_SHIFT;
+				if (tri_count == 0)
+				{
+					const Node *node = reinterpret_cast<const Node *>(inBufferStart + (node_properties << OFFSET_NON_SIGNIFICANT_BITS));
+
+					// Unpack bounds, each load contains the values for all 8 children of a single axis
+					UVec4 bounds_minx = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMinX[0]));
+					UVec4 bounds_miny = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMinY[0]));
+					UVec4 bounds_minz = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMinZ[0]));
+					UVec4 bounds_maxx = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMaxX[0]));
+					UVec4 bounds_maxy = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMaxY[0]));
+					UVec4 bounds_maxz = UVec4::sLoadInt4(reinterpret_cast<const uint32 *>(&node->mBoundsMaxZ[0]));
+
+					// Load properties for 8 children
+					UVec4 properties_lo = UVec4::sLoadInt4(&node->mNodeProperties[0]);
+					UVec4 properties_hi = UVec4::sLoadInt4(&node->mNodeProperties[4]);
+
+					JPH_ASSERT(mTop + 8 < StackSize);
+
+					// Decode the bounds of both groups of 4 children
+					ChildBounds bounds;
+					bounds.mMinX[0] = HalfFloatConversion::ToFloat(bounds_minx);
+					bounds.mMinY[0] = HalfFloatConversion::ToFloat(bounds_miny);
+					bounds.mMinZ[0] = HalfFloatConversion::ToFloat(bounds_minz);
+					bounds.mMaxX[0] = HalfFloatConversion::ToFloat(bounds_maxx);
+					bounds.mMaxY[0] = HalfFloatConversion::ToFloat(bounds_maxy);
+					bounds.mMaxZ[0] = HalfFloatConversion::ToFloat(bounds_maxz);
+					bounds.mMinX[1] = HalfFloatConversion::ToFloat(bounds_minx.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+					bounds.mMinY[1] = HalfFloatConversion::ToFloat(bounds_miny.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+					bounds.mMinZ[1] = HalfFloatConversion::ToFloat(bounds_minz.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+					bounds.mMaxX[1] = HalfFloatConversion::ToFloat(bounds_maxx.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+					bounds.mMaxY[1] = HalfFloatConversion::ToFloat(bounds_maxy.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+					bounds.mMaxZ[1] = HalfFloatConversion::ToFloat(bounds_maxz.Swizzle<SWIZZLE_Z, SWIZZLE_W, SWIZZLE_UNUSED, SWIZZLE_UNUSED>());
+
+					// Check which sub nodes to visit and push them onto the stack
+					mTop += sVisitNodes8(ioVisitor, bounds, properties_lo, properties_hi, &mNodeStack[mTop], mTop);
+				}
+				else if (tri_count != TRIANGLE_COUNT_MASK) // TRIANGLE_COUNT_MASK indicates a padding node, normally we shouldn't visit these nodes but when querying with a big enough box you could touch HALF_FLT_MAX (about 65K)
+				{	
+					// Node contains triangles, do individual tests
+					uint32 triangle_block_id = node_properties & OFFSET_MASK;
+					const void *triangles = sGetTriangleBlockStart(inBufferStart, triangle_block_id);
+
+					ioVisitor.VisitTriangles(inTriangleContext, triangles, tri_count, triangle_block_id);
+				}
+
+				// Check if we're done
+				if (ioVisitor.ShouldAbort())
+					break;
+
+				// Fetch next node until we find one that the visitor wants to see
+				do 
+					--mTop;
+				while (mTop >= 0 && !ioVisitor.ShouldVisitNode(mTop));
+			}
+			while (mTop >= 0);
+		}
+
+		/// This can be used to have the visitor early out (ioVisitor.ShouldAbort() returns true) and later continue again (call WalkTree() again)
+		bool						IsDoneWalking() const
+		{
+			return mTop < 0;
+		}
+
+	private:
+		/// Detects if a visitor implements VisitNodes8
+		template <class Visitor, class = void>
+		struct HasVisitNodes8 : false_type { };
+
+		template <class Visitor>
+		struct HasVisitNodes8<Visitor, void_t<decltype(&Visitor::VisitNodes8)>> : true_type { };
+
+		uint32						mNodeStack[StackSize];
+		int							mTop = 0;
+	};
+};
+
+JPH_NAMESPACE_END
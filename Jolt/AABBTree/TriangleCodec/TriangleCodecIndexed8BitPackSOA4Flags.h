@@ -214,12 +214,12 @@ public:
 		}
 
 	private:
-		using VertexMap = vector<uint32>;
+		using VertexMap = TaggedVector<uint32, EMemoryTag::Shapes>;
 
 		uint						mNumTriangles = 0;
-		vector<uint32>				mVertices;				///< Output vertices as an index into the original vertex list (inVertices), sorted according to occurrence
+		TaggedVector<uint32, EMemoryTag::Shapes>	mVertices;				///< Output vertices as an index into the original vertex list (inVertices), sorted according to occurrence
 		VertexMap					mVertexMap;				///< Maps from the original mesh vertex index (inVertices) to the index in our output vertices (mVertices)
-		vector<uint>				mOffsetsToPatch;		///< Offsets to the vertex buffer that need to be patched in once all nodes have been packed
+		TaggedVector<uint, EMemoryTag::Shapes>	mOffsetsToPatch;		///< Offsets to the vertex buffer that need to be patched in once all nodes have been packed
 	};
 
 	/// This class is used to decode and decompress triangle data packed by the EncodingContext
@@ -7,8 +7,8 @@
 
 JPH_NAMESPACE_BEGIN
 
-/// Underlying data type for ByteBuffer
-using ByteBufferVector = vector<uint8, STLAlignedAllocator<uint8, JPH_CACHE_LINE_SIZE>>;
+/// Underlying data type for ByteBuffer (the byte buffer holds the packed trees of mesh shapes, so its memory is attributed to the shapes)
+using ByteBufferVector = vector<uint8, STLAlignedAllocator<uint8, JPH_CACHE_LINE_SIZE, EMemoryTag::Shapes>>;
 
 /// Simple byte buffer, aligned to a cache line
 class ByteBuffer : public ByteBufferVector
@@ -47,8 +47,8 @@ public:
 	}
 
 	/// Append inData to the buffer
-	template <class Type>
-	void			AppendVector(const vector<Type> &inData)
+	template <class Type, class Allocator>
+	void			AppendVector(const vector<Type, Allocator> &inData)
 	{
 		size_t size = inData.size() * sizeof(Type);
 		uint8 *data = Allocate<uint8>(size);
@@ -34,15 +34,15 @@ public:
 	void						Clear();
 
 	/// Get all registered classes
-	vector<const RTTI *>		GetAllClasses() const;
+	TaggedVector<const RTTI *>	GetAllClasses() const;
 
 	/// Singleton factory instance
 	static Factory *			sInstance;
 
 private:
-	using ClassNameMap = unordered_map<string_view, const RTTI *>;
+	using ClassNameMap = TaggedUnorderedMap<string_view, const RTTI *>;
 
-	using ClassHashMap = unordered_map<uint32, const RTTI *>;
+	using ClassHashMap = TaggedUnorderedMap<uint32, const RTTI *>;
 
 	/// Map of class names to type info
 	ClassNameMap				mClassNameMap;
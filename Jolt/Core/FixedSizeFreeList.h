@@ -6,6 +6,7 @@
 #include <Jolt/Core/NonCopyable.h>
 #include <Jolt/Core/Mutex.h>
 #include <Jolt/Core/Memory.h>
+#include <Jolt/Core/ThreadIndex.h>
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <atomic>
@@ -14,8 +15,11 @@ JPH_SUPPRESS_WARNINGS_STD_END
 JPH_NAMESPACE_BEGIN
 
 /// Class that allows lock free creation / destruction of objects (unless a new page of objects needs to be allocated)
-/// It contains a fixed pool of objects and also allows batching up a lot of objects to be destroyed
-/// and doing the actual free in a single atomic operation
+/// It contains a pool of objects that grows a page at a time and also allows batching up a lot of objects to be destroyed
+/// and doing the actual free in a single atomic operation.
+///
+/// Each thread keeps a small cache of free objects so that most creations / destructions don't need to touch the shared free list.
+/// The cache is refilled from / flushed to the shared free list in batches, which requires only a single atomic operation.
 template <typename Object>
 class FixedSizeFreeList : public NonCopyable
 {
@@ -38,8 +42,49 @@ private:
 	static_assert(alignof(ObjectStorage) == alignof(Object), "Object not properly aligned");
 
 	/// Access the object storage given the object index
-	const ObjectStorage &	GetStorage(uint32 inObjectIndex) const	{ return mPages[inObjectIndex >> mPageShift][inObjectIndex & mObjectMask]; }
-	ObjectStorage &			GetStorage(uint32 inObjectIndex)		{ return mPages[inObjectIndex >> mPageShift][inObjectIndex & mObjectMask]; }
+	const ObjectStorage &	GetStorage(uint32 inObjectIndex) const	{ return mPages.load(memory_order_acquire)[inObjectIndex >> mPageShift][inObjectIndex & mObjectMask]; }
+	ObjectStorage &			GetStorage(uint32 inObjectIndex)		{ return mPages.load(memory_order_acquire)[inObjectIndex >> mPageShift][inObjectIndex & mObjectMask]; }
+
+	/// Amount of free objects that a thread can keep in its cache (chosen so that a cache fits in a single cache line)
+	static constexpr uint32	cThreadCacheSize = 15;
+
+	/// Amount of objects that are moved between a thread cache and the shared free list at a time
+	static constexpr uint32	cThreadCacheBatchSize = 8;
+
+	/// Free objects that are owned by a single thread
+	struct alignas(JPH_CACHE_LINE_SIZE) ThreadCache
+	{
+		uint32				mNumObjects = 0;
+		uint32				mObjects[cThreadCacheSize];
+	};
+
+	/// Stored in front of the page table, a page table that was replaced by a bigger one is kept alive because other threads may still be reading from it
+	struct PageTableHeader
+	{
+		ObjectStorage **	mPreviousPages;
+		uint32				mNumPages;
+	};
+
+	/// Get the cache of the calling thread, returns nullptr if the thread doesn't have one
+	inline ThreadCache *	GetThreadCache();
+
+	/// Allocate a page table of inNumPages pages, the first mNumPages pages are copied from the current table
+	inline ObjectStorage **	AllocatePageTable(uint32 inNumPages);
+
+	/// Replace the page table by one that is twice as big, returns false if the maximum amount of objects has been reached. Needs to be called with mPageMutex locked.
+	inline bool				GrowPageTable();
+
+	/// Take up to inMaxObjects objects from the shared free list (or from pages that have not been used yet) and store their indices in outObjects, returns the number of objects taken
+	inline uint32			PopObjects(uint32 *outObjects, uint32 inMaxObjects);
+
+	/// Take inNumObjects objects from pages that have not been used yet, allocating new pages as needed, returns the number of objects taken
+	inline uint32			PopNewObjects(uint32 *outObjects, uint32 inNumObjects);
+
+	/// Add a chain of free objects that are linked through mNextFreeObject to the shared free list
+	inline void				PushObjects(uint32 inFirstObjectIndex, uint32 inLastObjectIndex);
+
+	/// Move the oldest cThreadCacheBatchSize objects of ioCache to the shared free list
+	inline void				FlushThreadCache(ThreadCache &ioCache);
 
 	/// Number of objects that we currently have in the free list / new pages
 #ifdef JPH_ENABLE_ASSERTS
@@ -61,24 +106,30 @@ private:
 	/// Mask to and an object index with to get the page number
 	uint32					mObjectMask;
 
-	/// Total number of pages that are usable
+	/// Total number of pages that are usable before the page table needs to grow
 	uint32					mNumPages;
 
 	/// Total number of objects that have been allocated
-	uint32					mNumObjectsAllocated;
+	atomic<uint32>			mNumObjectsAllocated;
 
 	/// The first free object to use when the free list is empty (may need to allocate a new page)
 	atomic<uint32>			mFirstFreeObjectInNewPage;
 
 	/// Array of pages of objects
-	ObjectStorage **		mPages = nullptr;
+	atomic<ObjectStorage **> mPages { nullptr };
+
+	/// Per thread caches of free objects, indexed by GetThreadIndex()
+	ThreadCache *			mThreadCaches = nullptr;
 
 	/// Mutex that is used to allocate a new page if the storage runs out
 	Mutex					mPageMutex;
 
+	/// Subsystem that the pages are attributed to
+	EMemoryTag				mTag = EMemoryTag::General;
+
 public:
 	/// Invalid index
-	static const uint32		cInvalidObjectIndex = 0xffffffff;
+	static constexpr uint32	cInvalidObjectIndex = 0xffffffff;
 
 	/// Size of an object + bookkeeping for the freelist
 	static const int		ObjectStorageSize = sizeof(ObjectStorage);
@@ -86,8 +137,14 @@ public:
 	/// Destructor
 	inline					~FixedSizeFreeList();
 
-	/// Initialize the free list, up to inMaxObjects can be allocated
-	inline void				Init(uint inMaxObjects, uint inPageSize);
+	/// Initialize the free list
+	/// @param inMaxObjects Initial capacity of the free list, when more objects are needed the list grows by allocating more pages
+	/// @param inPageSize Amount of objects in a page, needs to be a power of 2
+	/// @param inTag Subsystem that the memory is attributed to
+	inline void				Init(uint inMaxObjects, uint inPageSize, EMemoryTag inTag = EMemoryTag::General);
+
+	/// Get the number of objects that can be allocated before the page table needs to grow
+	inline uint				GetCapacity() const						{ return mNumPages * mPageSize; }
 
 	/// Lockless construct a new object, inParameters are passed on to the constructor
 	template <typename... Parameters>
@@ -10,28 +10,47 @@ FixedSizeFreeList<Object>::~FixedSizeFreeList()
 	JPH_ASSERT(mNumFreeObjects.load(memory_order_relaxed) == mNumPages * mPageSize);
 
 	// Free memory for pages
-	uint32 num_pages = mNumObjectsAllocated / mPageSize;
+	ObjectStorage **pages = mPages.load(memory_order_relaxed);
+	uint32 num_pages = mNumObjectsAllocated.load(memory_order_relaxed) / mPageSize;
 	for (uint32 page = 0; page < num_pages; ++page)
-		AlignedFree(mPages[page]);
-	delete [] mPages;
+		AlignedFree(pages[page], mPageSize * sizeof(ObjectStorage), mTag);
+
+	// Free the page table and the tables that it replaced
+	while (pages != nullptr)
+	{
+		PageTableHeader *header = reinterpret_cast<PageTableHeader *>(pages) - 1;
+		pages = header->mPreviousPages;
+		Free(header, sizeof(PageTableHeader) + header->mNumPages * sizeof(ObjectStorage *), mTag);
+	}
+
+	// Free thread caches
+	AlignedFree(mThreadCaches, cMaxThreadIndices * sizeof(ThreadCache), mTag);
 }
 
 template <typename Object>
-void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize)
+void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize, EMemoryTag inTag)
 {
 	// Check sanity
 	JPH_ASSERT(inPageSize > 0 && IsPowerOf2(inPageSize));
-	JPH_ASSERT(mPages == nullptr);
+	JPH_ASSERT(mPages.load(memory_order_relaxed) == nullptr);
 
 	// Store configuration parameters
-	mNumPages = (inMaxObjects + inPageSize - 1) / inPageSize;
+	mNumPages = 0;
 	mPageSize = inPageSize;
 	mPageShift = CountTrailingZeros(inPageSize);
 	mObjectMask = inPageSize - 1;
-	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects = mNumPages * inPageSize;)
+	mTag = inTag;
 
 	// Allocate page table
-	mPages = new ObjectStorage * [mNumPages];
+	uint32 num_pages = max<uint32>((inMaxObjects + inPageSize - 1) / inPageSize, 1);
+	mPages.store(AllocatePageTable(num_pages), memory_order_relaxed);
+	mNumPages = num_pages;
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects = mNumPages * inPageSize;)
+
+	// Allocate thread caches
+	mThreadCaches = reinterpret_cast<ThreadCache *>(AlignedAlloc(cMaxThreadIndices * sizeof(ThreadCache), JPH_CACHE_LINE_SIZE, mTag));
+	for (ThreadCache *c = mThreadCaches, *c_end = mThreadCaches + cMaxThreadIndices; c < c_end; ++c)
+		new (c) ThreadCache;
 
 	// We didn't yet use any objects of any page
 	mNumObjectsAllocated = 0;
@@ -45,9 +64,81 @@ void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize)
 }
 
 template <typename Object>
-template <typename... Parameters>
-uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
+typename FixedSizeFreeList<Object>::ThreadCache *FixedSizeFreeList<Object>::GetThreadCache()
 {
+	uint thread_index = GetThreadIndex();
+	return thread_index != cInvalidThreadIndex? &mThreadCaches[thread_index] : nullptr;
+}
+
+template <typename Object>
+typename FixedSizeFreeList<Object>::ObjectStorage **FixedSizeFreeList<Object>::AllocatePageTable(uint32 inNumPages)
+{
+	PageTableHeader *header = reinterpret_cast<PageTableHeader *>(Allocate(sizeof(PageTableHeader) + inNumPages * sizeof(ObjectStorage *), mTag));
+	header->mPreviousPages = mPages.load(memory_order_relaxed);
+	header->mNumPages = inNumPages;
+
+	// Copy the pages of the current table
+	ObjectStorage **pages = reinterpret_cast<ObjectStorage **>(header + 1);
+	if (header->mPreviousPages != nullptr)
+		memcpy(pages, header->mPreviousPages, mNumPages * sizeof(ObjectStorage *));
+	return pages;
+}
+
+template <typename Object>
+bool FixedSizeFreeList<Object>::GrowPageTable()
+{
+	// Double the amount of pages, but make sure that object indices stay below cInvalidObjectIndex
+	uint32 max_pages = cInvalidObjectIndex / mPageSize;
+	uint32 num_pages = min(2 * mNumPages, max_pages);
+	if (num_pages <= mNumPages)
+		return false;
+
+	// Publish the new table, the old table is kept alive because other threads may still be reading from it
+	ObjectStorage **pages = AllocatePageTable(num_pages);
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add((num_pages - mNumPages) * mPageSize, memory_order_relaxed);)
+	mNumPages = num_pages;
+	mPages.store(pages, memory_order_release);
+	return true;
+}
+
+template <typename Object>
+uint32 FixedSizeFreeList<Object>::PopNewObjects(uint32 *outObjects, uint32 inNumObjects)
+{
+	uint32 first_new = mFirstFreeObjectInNewPage.fetch_add(inNumObjects, memory_order_relaxed);
+	uint32 end_new = first_new + inNumObjects;
+	if (end_new < first_new)
+		return 0; // Out of indices!
+
+	if (end_new > mNumObjectsAllocated.load(memory_order_acquire))
+	{
+		// Allocate new pages
+		lock_guard lock(mPageMutex);
+		while (end_new > mNumObjectsAllocated.load(memory_order_relaxed))
+		{
+			uint32 num_objects_allocated = mNumObjectsAllocated.load(memory_order_relaxed);
+			uint32 next_page = num_objects_allocated / mPageSize;
+			if (next_page == mNumPages && !GrowPageTable())
+				return 0; // Out of space!
+			mPages.load(memory_order_relaxed)[next_page] = reinterpret_cast<ObjectStorage *>(AlignedAlloc(mPageSize * sizeof(ObjectStorage), JPH_CACHE_LINE_SIZE, mTag));
+			mNumObjectsAllocated.store(num_objects_allocated + mPageSize, memory_order_release);
+		}
+	}
+
+	// Objects that have never been used don't have a valid next pointer yet, mark them as in use so that other threads can safely follow it
+	for (uint32 i = 0; i < inNumObjects; ++i)
+	{
+		uint32 object_idx = first_new + i;
+		GetStorage(object_idx).mNextFreeObject.store(object_idx, memory_order_relaxed);
+		outObjects[i] = object_idx;
+	}
+	return inNumObjects;
+}
+
+template <typename Object>
+uint32 FixedSizeFreeList<Object>::PopObjects(uint32 *outObjects, uint32 inMaxObjects)
+{
+	JPH_ASSERT(inMaxObjects > 0);
+
 	for (;;)
 	{
 		// Get first object from the linked list
@@ -55,49 +146,95 @@ uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
 		uint32 first_free = uint32(first_free_object_and_tag);
 		if (first_free == cInvalidObjectIndex)
 		{
-			// The free list is empty, we take an object from the page that has never been used before
-			first_free = mFirstFreeObjectInNewPage.fetch_add(1, memory_order_relaxed);
-			if (first_free >= mNumObjectsAllocated)
-			{
-				// Allocate new page
-				lock_guard lock(mPageMutex);
-				while (first_free >= mNumObjectsAllocated)
-				{
-					uint32 next_page = mNumObjectsAllocated / mPageSize;
-					if (next_page == mNumPages)
-						return cInvalidObjectIndex; // Out of space!
-					mPages[next_page] = reinterpret_cast<ObjectStorage *>(AlignedAlloc(mPageSize * sizeof(ObjectStorage), JPH_CACHE_LINE_SIZE));
-					mNumObjectsAllocated += mPageSize;
-				}
-			}
-
-			// Allocation successful
-			JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
-			ObjectStorage &storage = GetStorage(first_free);
-			new (&storage.mData) Object(forward<Parameters>(inParameters)...);
-			storage.mNextFreeObject.store(first_free, memory_order_release);
-			return first_free;
+			// The free list is empty, we take objects from the pages that have never been used before
+			return PopNewObjects(outObjects, inMaxObjects);
 		}
-		else
+
+		// Walk the list to collect up to inMaxObjects objects.
+		// If another thread modifies the list while we're walking it, the tag will have changed and the compare and swap below fails.
+		uint32 num_objects = 0;
+		uint32 new_first_free = first_free;
+		do
 		{
-			// Load next pointer
-			uint32 new_first_free = GetStorage(first_free).mNextFreeObject.load(memory_order_acquire);
+			outObjects[num_objects++] = new_first_free;
+			new_first_free = GetStorage(new_first_free).mNextFreeObject.load(memory_order_acquire);
+		}
+		while (num_objects < inMaxObjects && new_first_free != cInvalidObjectIndex);
 
-			// Construct a new first free object tag
-			uint64 new_first_free_object_and_tag = uint64(new_first_free) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+		// Construct a new first free object tag
+		uint64 new_first_free_object_and_tag = uint64(new_first_free) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
 
-			// Compare and swap
-			if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-			{
-				// Allocation successful
-				JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
-				ObjectStorage &storage = GetStorage(first_free);
-				new (&storage.mData) Object(forward<Parameters>(inParameters)...);
-				storage.mNextFreeObject.store(first_free, memory_order_release);
-				return first_free;
-			}
+		// Compare and swap
+		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
+			return num_objects;
+	}
+}
+
+template <typename Object>
+void FixedSizeFreeList<Object>::PushObjects(uint32 inFirstObjectIndex, uint32 inLastObjectIndex)
+{
+	ObjectStorage &storage = GetStorage(inLastObjectIndex);
+	for (;;)
+	{
+		// Get first object from the list
+		uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
+		uint32 first_free = uint32(first_free_object_and_tag);
+
+		// Make it the next pointer of the last object in the chain that is to be freed
+		storage.mNextFreeObject.store(first_free, memory_order_release);
+
+		// Construct a new first free object tag
+		uint64 new_first_free_object_and_tag = uint64(inFirstObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+
+		// Compare and swap
+		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
+			return;
+	}
+}
+
+template <typename Object>
+void FixedSizeFreeList<Object>::FlushThreadCache(ThreadCache &ioCache)
+{
+	JPH_ASSERT(ioCache.mNumObjects >= cThreadCacheBatchSize);
+
+	// Link the oldest objects and return them to the shared free list
+	for (uint32 i = 0; i < cThreadCacheBatchSize - 1; ++i)
+		GetStorage(ioCache.mObjects[i]).mNextFreeObject.store(ioCache.mObjects[i + 1], memory_order_relaxed);
+	PushObjects(ioCache.mObjects[0], ioCache.mObjects[cThreadCacheBatchSize - 1]);
+
+	// Move the remaining objects to the front
+	ioCache.mNumObjects -= cThreadCacheBatchSize;
+	memmove(ioCache.mObjects, ioCache.mObjects + cThreadCacheBatchSize, ioCache.mNumObjects * sizeof(uint32));
+}
+
+template <typename Object>
+template <typename... Parameters>
+uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
+{
+	uint32 index;
+	ThreadCache *cache = GetThreadCache();
+	if (cache != nullptr)
+	{
+		// Refill the cache when it is empty
+		if (cache->mNumObjects == 0)
+		{
+			cache->mNumObjects = PopObjects(cache->mObjects, cThreadCacheBatchSize);
+			if (cache->mNumObjects == 0)
+				return cInvalidObjectIndex; // Out of space!
 		}
+
+		// Take the object that was freed last, it is most likely still in the cache of the CPU
+		index = cache->mObjects[--cache->mNumObjects];
 	}
+	else if (PopObjects(&index, 1) == 0)
+		return cInvalidObjectIndex; // Out of space!
+
+	// Allocation successful
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
+	ObjectStorage &storage = GetStorage(index);
+	new (&storage.mData) Object(forward<Parameters>(inParameters)...);
+	storage.mNextFreeObject.store(index, memory_order_release);
+	return index;
 }
 
 template <typename Object>
@@ -124,42 +261,37 @@ void FixedSizeFreeList<Object>::DestructObjectBatch(Batch &ioBatch)
 		if constexpr (!is_trivially_destructible<Object>())
 		{
 			uint32 object_idx = ioBatch.mFirstObjectIndex;
-			do
+			for (uint32 i = 0; i < ioBatch.mNumObjects; ++i)
 			{
 				ObjectStorage &storage = GetStorage(object_idx);
 				reinterpret_cast<Object &>(storage.mData).~Object();
 				object_idx = storage.mNextFreeObject.load(memory_order_relaxed);
 			}
-			while (object_idx != cInvalidObjectIndex);
 		}
 
-		// Add to objects free list
-		ObjectStorage &storage = GetStorage(ioBatch.mLastObjectIndex);
-		for (;;)
-		{
-			// Get first object from the list
-			uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
-			uint32 first_free = uint32(first_free_object_and_tag);
-
-			// Make it the next pointer of the last object in the batch that is to be freed
-			storage.mNextFreeObject.store(first_free, memory_order_release);
+		// Fill up the cache of this thread from the front of the batch
+		uint32 first_object_idx = ioBatch.mFirstObjectIndex;
+		uint32 num_objects_left = ioBatch.mNumObjects;
+		ThreadCache *cache = GetThreadCache();
+		if (cache != nullptr)
+			while (num_objects_left > 0 && cache->mNumObjects < cThreadCacheSize)
+			{
+				cache->mObjects[cache->mNumObjects++] = first_object_idx;
+				if (--num_objects_left > 0)
+					first_object_idx = GetStorage(first_object_idx).mNextFreeObject.load(memory_order_relaxed);
+			}
 
-			// Construct a new first free object tag
-			uint64 new_first_free_object_and_tag = uint64(ioBatch.mFirstObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+		// Add the rest to objects free list
+		if (num_objects_left > 0)
+			PushObjects(first_object_idx, ioBatch.mLastObjectIndex);
 
-			// Compare and swap
-			if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-			{
-				// Free successful
-				JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(ioBatch.mNumObjects, memory_order_relaxed);)
+		// Free successful
+		JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(ioBatch.mNumObjects, memory_order_relaxed);)
 
-				// Mark the batch as freed
+		// Mark the batch as freed
 #ifdef JPH_ENABLE_ASSERTS
-				ioBatch.mNumObjects = uint32(-1);
-#endif		
-				return;
-			}
-		}
+		ioBatch.mNumObjects = uint32(-1);
+#endif
 	}
 }
 
@@ -169,29 +301,22 @@ void FixedSizeFreeList<Object>::DestructObject(uint32 inObjectIndex)
 	JPH_ASSERT(inObjectIndex != cInvalidObjectIndex);
 
 	// Call destructor
-	ObjectStorage &storage = GetStorage(inObjectIndex); 
+	ObjectStorage &storage = GetStorage(inObjectIndex);
 	reinterpret_cast<Object &>(storage.mData).~Object();
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(1, memory_order_relaxed);)
 
-	// Add to object free list
-	for (;;)
+	ThreadCache *cache = GetThreadCache();
+	if (cache != nullptr)
 	{
-		// Get first object from the list
-		uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
-		uint32 first_free = uint32(first_free_object_and_tag);
-
-		// Make it the next pointer of the last object in the batch that is to be freed
-		storage.mNextFreeObject.store(first_free, memory_order_release);
-
-		// Construct a new first free object tag
-		uint64 new_first_free_object_and_tag = uint64(inObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
-
-		// Compare and swap
-		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-		{
-			// Free successful
-			JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(1, memory_order_relaxed);)
-			return;
-		}
+		// Add to the cache of this thread, make room first if it is full
+		if (cache->mNumObjects == cThreadCacheSize)
+			FlushThreadCache(*cache);
+		cache->mObjects[cache->mNumObjects++] = inObjectIndex;
+	}
+	else
+	{
+		// Add to object free list
+		PushObjects(inObjectIndex, inObjectIndex);
 	}
 }
 
@@ -199,7 +324,7 @@ template<typename Object>
 inline void FixedSizeFreeList<Object>::DestructObject(Object *inObject)
 {
 	uint32 index = reinterpret_cast<ObjectStorage *>(inObject)->mNextFreeObject.load(memory_order_relaxed);
-	JPH_ASSERT(index < mNumObjectsAllocated);
+	JPH_ASSERT(index < mNumObjectsAllocated.load(memory_order_relaxed));
 	DestructObject(index);
 }
 
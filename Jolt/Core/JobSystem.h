@@ -47,6 +47,8 @@ protected:
 	class Job;
 
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Jobs)
+
 	/// A job handle contains a reference to a job. The job will be deleted as soon as there are no JobHandles.
 	/// referring to the job and when it is not in the job queue / being processed.
 	class JobHandle : private Ref<Job>
@@ -77,6 +79,18 @@ public:
 		/// and if it does it is no longer valid to call the AddDependency/RemoveDependency functions.
 		inline void			RemoveDependency(int inCount = 1) const		{ GetPtr()->RemoveDependencyAndQueue(inCount); }
 
+		/// Get the current value of the dependency counter (only meaningful for a job that has not started executing yet)
+		inline uint32		GetNumDependencies() const					{ return GetPtr()->GetNumDependencies(); }
+
+		/// Get the number of references to the job, this includes the references that the job system holds while the job is queued or added to a barrier
+		inline uint32		GetRefCount() const							{ return GetPtr()->GetRefCount(); }
+
+		/// Make a job that has finished executing available for execution again, this avoids allocating a new job for work that repeats every frame.
+		/// The job will start whenever RemoveDependency causes the dependency counter to reach zero, so inNumDependencies must be larger than zero.
+		/// Only allowed when the job system no longer references the job (use GetRefCount to check that only your own JobHandles are left),
+		/// otherwise a worker thread that still has the job in its queue could pick it up again.
+		inline void			Reset(uint32 inNumDependencies) const		{ GetPtr()->Reset(inNumDependencies); }
+
 		/// Remove a dependency from a batch of jobs at once, this can be more efficient than removing them one by one as it requires less locking
 		static inline void	sRemoveDependencies(JobHandle *inHandles, uint inNumHandles, int inCount = 1);
 
@@ -205,6 +219,7 @@ protected:
 			// Run the job function
 			{
 				JPH_PROFILE(mJobName, mColor.GetUInt32());
+				JPH_PROFILE_FLOW_END(GetFlowID());
 				mJobFunction();
 			}
 
@@ -229,12 +244,35 @@ protected:
 			return cDoneState;
 		}
 
+		/// Get the current value of the dependency counter
+		inline uint32		GetNumDependencies() const					{ return mNumDependencies.load(memory_order_relaxed); }
+
+		/// Get the amount of JobHandles and job system references pointing to this job
+		inline uint32		GetRefCount() const							{ return mReferenceCount.load(memory_order_acquire); }
+
+		/// Reset a job that has finished executing so that it can be executed again
+		inline void			Reset(uint32 inNumDependencies)
+		{
+			JPH_ASSERT(IsDone(), "Only a job that has finished executing can be reset");
+			JPH_ASSERT(inNumDependencies > 0, "Use RemoveDependency to start the job");
+			mBarrier.store(0, memory_order_relaxed);
+			mNumDependencies.store(inNumDependencies, memory_order_relaxed);
+		#ifdef JPH_PROFILE_ENABLED
+			++mGeneration;
+		#endif // JPH_PROFILE_ENABLED
+		}
+
 		/// Test if the job can be executed
 		inline bool			CanBeExecuted() const						{ return mNumDependencies.load(memory_order_relaxed) == 0; }
 
 		/// Test if the job finished executing
 		inline bool			IsDone() const								{ return mNumDependencies.load(memory_order_relaxed) == cDoneState; }
 
+	#ifdef JPH_PROFILE_ENABLED
+		/// Identifies this run of the job in the profiler so that removing a dependency can be drawn as an arrow to the job
+		inline uint64		GetFlowID() const							{ return uint64(reinterpret_cast<uintptr_t>(this)) + (uint64(mGeneration) << 48); }
+	#endif // JPH_PROFILE_ENABLED
+
 		static constexpr uint32 cExecutingState = 0xe0e0e0e0;			///< Value of mNumDependencies when job is executing
 		static constexpr uint32 cDoneState		= 0xd0d0d0d0;			///< Value of mNumDependencies when job is done executing
 
@@ -245,6 +283,9 @@ private:
 		const char *		mJobName;									///< Name of the job
 		Color				mColor;										///< Color of the job in the profiler
 	#endif // defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+	#ifdef JPH_PROFILE_ENABLED
+		uint32				mGeneration = 0;							///< Incremented every time the job is reset, see GetFlowID
+	#endif // JPH_PROFILE_ENABLED
 		JobSystem *			mJobSystem;									///< The job system we belong to
 		atomic<intptr_t>	mBarrier = 0;								///< Barrier that this job is associated with (is a Barrier pointer)
 		JobFunction			mJobFunction;								///< Main job function
@@ -11,6 +11,9 @@ void JobSystem::Job::AddDependency(int inCount)
 
 bool JobSystem::Job::RemoveDependency(int inCount)
 {
+	// Draw an arrow from the current scope to the job in the profiler, this needs to happen before the job can start
+	JPH_PROFILE_FLOW_BEGIN(GetFlowID());
+
 	uint32 old_value = mNumDependencies.fetch_sub(inCount, memory_order_release);
 	JPH_ASSERT(old_value != cExecutingState && old_value != cDoneState, "Job is running or done, it is not allowed to add a dependency to a running job");
 	uint32 new_value = old_value - inCount;
@@ -0,0 +1,435 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/JobSystemWorkStealing.h>
+#include <Jolt/Core/Profiler.h>
+#include <Jolt/Core/FPException.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <algorithm>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+#ifdef JPH_PLATFORM_WINDOWS
+	JPH_SUPPRESS_WARNING_PUSH
+	JPH_MSVC_SUPPRESS_WARNING(5039) // winbase.h(13179): warning C5039: 'TpSetCallbackCleanupGroup': pointer or reference to potentially throwing function passed to 'extern "C"' function under -EHc. Undefined behavior may occur if this function throws an exception.
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+	JPH_SUPPRESS_WARNING_POP
+#endif
+
+JPH_NAMESPACE_BEGIN
+
+// The job system and work queue that belong to the worker thread that is currently running (nullptr / -1 when this is not a worker thread)
+static thread_local JobSystemWorkStealing *sWorkerJobSystem = nullptr;
+static thread_local int sWorkerIndex = -1;
+
+JobSystemWorkStealing::WorkQueue::WorkQueue()
+{
+	for (atomic<Job *> &j : mJobs)
+		j = nullptr;
+}
+
+bool JobSystemWorkStealing::WorkQueue::Push(Job *inJob)
+{
+	uint bottom = mBottom.load(memory_order_relaxed);
+	uint top = mTop.load(memory_order_acquire);
+
+	// Check if there's space in the queue
+	if (int(bottom - top) >= int(cQueueLength))
+		return false;
+
+	// Store the job and publish it to stealing threads
+	mJobs[bottom & (cQueueLength - 1)].store(inJob, memory_order_relaxed);
+	mBottom.store(bottom + 1, memory_order_release);
+	return true;
+}
+
+JobSystem::Job *JobSystemWorkStealing::WorkQueue::Pop()
+{
+	// Reserve the last job by moving bottom, this needs to be visible to stealing threads before we read top
+	uint bottom = mBottom.load(memory_order_relaxed) - 1;
+	mBottom.store(bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	uint top = mTop.load(memory_order_relaxed);
+
+	int size = int(bottom - top);
+	if (size < 0)
+	{
+		// Queue was empty, restore bottom
+		mBottom.store(bottom + 1, memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job *job = mJobs[bottom & (cQueueLength - 1)].load(memory_order_relaxed);
+	if (size == 0)
+	{
+		// This is the last job, we're racing against stealing threads so we need to take it by moving top
+		if (!mTop.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+			job = nullptr;
+		mBottom.store(bottom + 1, memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job *JobSystemWorkStealing::WorkQueue::Steal()
+{
+	for (;;)
+	{
+		uint top = mTop.load(memory_order_acquire);
+		atomic_thread_fence(memory_order_seq_cst);
+		uint bottom = mBottom.load(memory_order_acquire);
+
+		// Check if the queue is empty
+		if (int(bottom - top) <= 0)
+			return nullptr;
+
+		// Read the job before taking it, the owner can't overwrite this slot until top has moved
+		Job *job = mJobs[top & (cQueueLength - 1)].load(memory_order_relaxed);
+		if (mTop.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+			return job;
+
+		// Another thread took the job, try again
+	}
+}
+
+void JobSystemWorkStealing::Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads, uint inScratchArenaSize)
+{
+	JobSystemWithBarrier::Init(inMaxBarriers);
+
+	// Init freelist of jobs
+	mJobs.Init(inMaxJobs, inMaxJobs, EMemoryTag::Jobs);
+
+	// Start the worker threads
+	mScratchArenaSize = inScratchArenaSize;
+	StartThreads(inNumThreads);
+}
+
+JobSystemWorkStealing::JobSystemWorkStealing(uint inMaxJobs, uint inMaxBarriers, int inNumThreads, uint inScratchArenaSize)
+{
+	Init(inMaxJobs, inMaxBarriers, inNumThreads, inScratchArenaSize);
+}
+
+void JobSystemWorkStealing::StartThreads(int inNumThreads)
+{
+	// Auto detect number of threads
+	if (inNumThreads < 0)
+		inNumThreads = thread::hardware_concurrency() - 1;
+
+	// If no threads are requested we're done
+	if (inNumThreads == 0)
+		return;
+
+	// Don't quit the threads
+	mQuit = false;
+
+	// Allocate a work queue per thread
+	mNumWorkQueues = (uint)inNumThreads;
+	mWorkQueues = new WorkQueue [inNumThreads];
+
+	// Allocate a scratch arena per thread
+	mScratchArenas = new ScratchArena [inNumThreads];
+	for (int i = 0; i < inNumThreads; ++i)
+		mScratchArenas[i].Init(mScratchArenaSize);
+
+	// Start running threads
+	JPH_ASSERT(mThreads.empty());
+	mThreads.reserve(inNumThreads);
+	for (int i = 0; i < inNumThreads; ++i)
+	{
+		// Name the thread
+		char name[64];
+		snprintf(name, sizeof(name), "Worker %d", int(i + 1));
+
+		// Create thread
+		mThreads.emplace_back([this, name, i] { ThreadMain(name, i); });
+	}
+}
+
+JobSystemWorkStealing::~JobSystemWorkStealing()
+{
+	// Stop all worker threads
+	StopThreads();
+}
+
+void JobSystemWorkStealing::StopThreads()
+{
+	if (mThreads.empty())
+		return;
+
+	// Signal threads that we want to stop and wake them up
+	mQuit = true;
+	mSemaphore.Release((uint)mThreads.size());
+
+	// Wait for all threads to finish
+	for (thread &t : mThreads)
+		if (t.joinable())
+			t.join();
+
+	// Delete all threads
+	mThreads.clear();
+
+	// Ensure that there are no lingering jobs in the queues, since the workers are gone we can pop from their queues
+	for (WorkQueue *q = mWorkQueues, *q_end = mWorkQueues + mNumWorkQueues; q < q_end; ++q)
+		for (Job *job_ptr = q->Pop(); job_ptr != nullptr; job_ptr = q->Pop())
+		{
+			job_ptr->Execute();
+			job_ptr->Release();
+		}
+	for (Job *job_ptr = TakeInjectedJob(); job_ptr != nullptr; job_ptr = TakeInjectedJob())
+	{
+		job_ptr->Execute();
+		job_ptr->Release();
+	}
+
+	// Destroy scratch arenas
+	delete [] mScratchArenas;
+	mScratchArenas = nullptr;
+
+	// Destroy work queues and reset injection queue
+	delete [] mWorkQueues;
+	mWorkQueues = nullptr;
+	mNumWorkQueues = 0;
+	mInjectionHead = 0;
+	mInjectionTail = 0;
+}
+
+JobHandle JobSystemWorkStealing::CreateJob(const char *inJobName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Loop until we can get a job from the free list
+	uint32 index;
+	for (;;)
+	{
+		index = mJobs.ConstructObject(inJobName, inColor, this, inJobFunction, inNumDependencies);
+		if (index != AvailableJobs::cInvalidObjectIndex)
+			break;
+		JPH_ASSERT(false, "No jobs available!");
+		this_thread::sleep_for(100us);
+	}
+	Job *job = &mJobs.Get(index);
+
+	// Construct handle to keep a reference, the job is queued below and may immediately complete
+	JobHandle handle(job);
+
+	// If there are no dependencies, queue the job now
+	if (inNumDependencies == 0)
+		QueueJob(job);
+
+	// Return the handle
+	return handle;
+}
+
+void JobSystemWorkStealing::FreeJob(Job *inJob)
+{
+	mJobs.DestructObject(inJob);
+}
+
+void JobSystemWorkStealing::InjectJobs(Job **inJobs, uint inNumJobs)
+{
+	Job **job = inJobs, **jobs_end = inJobs + inNumJobs;
+	for (;;)
+	{
+		{
+			lock_guard lock(mInjectionLock);
+
+			// Add as many jobs as fit in the queue
+			uint head = mInjectionHead.load(memory_order_relaxed);
+			uint tail = mInjectionTail.load(memory_order_relaxed);
+			for (; job < jobs_end && tail - head < cInjectionQueueLength; ++job, ++tail)
+				mInjectionQueue[tail & (cInjectionQueueLength - 1)] = *job;
+			mInjectionTail.store(tail, memory_order_release);
+		}
+
+		// If all jobs were added we're done
+		if (job == jobs_end)
+			break;
+
+		// Wake up all threads in order to ensure that they empty the queue
+		mSemaphore.Release((uint)mThreads.size());
+
+		// Sleep a little (we have to wait for other threads to take jobs from the queue)
+		this_thread::sleep_for(100us);
+	}
+}
+
+JobSystem::Job *JobSystemWorkStealing::TakeInjectedJob()
+{
+	// Test if the queue is empty without taking the lock
+	if (mInjectionHead.load(memory_order_relaxed) == mInjectionTail.load(memory_order_acquire))
+		return nullptr;
+
+	lock_guard lock(mInjectionLock);
+
+	// Check again now that we have the lock
+	uint head = mInjectionHead.load(memory_order_relaxed);
+	if (head == mInjectionTail.load(memory_order_relaxed))
+		return nullptr;
+
+	// Take the first job
+	Job *job = mInjectionQueue[head & (cInjectionQueueLength - 1)];
+	mInjectionHead.store(head + 1, memory_order_relaxed);
+	return job;
+}
+
+void JobSystemWorkStealing::QueueJobsInternal(Job **inJobs, uint inNumJobs)
+{
+	// Add reference to jobs because we're adding them to a queue
+	for (Job **job = inJobs, **jobs_end = inJobs + inNumJobs; job < jobs_end; ++job)
+		(*job)->AddRef();
+
+	if (sWorkerJobSystem == this)
+	{
+		// We're running on one of our workers, push the jobs on the queue of this worker
+		WorkQueue &queue = mWorkQueues[sWorkerIndex];
+		Job **job = inJobs, **jobs_end = inJobs + inNumJobs;
+		while (job < jobs_end && queue.Push(*job))
+			++job;
+
+		// If the queue of the worker is full, the remainder goes to the injection queue
+		if (job < jobs_end)
+			InjectJobs(job, uint(jobs_end - job));
+	}
+	else
+	{
+		// Not a worker thread, use the injection queue
+		InjectJobs(inJobs, inNumJobs);
+	}
+}
+
+void JobSystemWorkStealing::QueueJob(Job *inJob)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// If we have no worker threads, we can't queue the job either. We assume in this case that the job will be added to a barrier and that the barrier will execute the job when it's Wait() function is called.
+	if (mThreads.empty())
+		return;
+
+	// Queue the job
+	QueueJobsInternal(&inJob, 1);
+
+	// Wake up thread
+	mSemaphore.Release();
+}
+
+void JobSystemWorkStealing::QueueJobs(Job **inJobs, uint inNumJobs)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumJobs > 0);
+
+	// If we have no worker threads, we can't queue the job either. We assume in this case that the job will be added to a barrier and that the barrier will execute the job when it's Wait() function is called.
+	if (mThreads.empty())
+		return;
+
+	// Queue all jobs
+	QueueJobsInternal(inJobs, inNumJobs);
+
+	// Wake up threads
+	mSemaphore.Release(min(inNumJobs, (uint)mThreads.size()));
+}
+
+JobSystem::Job *JobSystemWorkStealing::FindJob(int inThreadIndex)
+{
+	// First try our own queue, the most recently pushed job is the most likely to have its data in the cache
+	Job *job = mWorkQueues[inThreadIndex].Pop();
+	if (job != nullptr)
+		return job;
+
+	// Then try jobs that were queued from outside of the worker threads
+	job = TakeInjectedJob();
+	if (job != nullptr)
+		return job;
+
+	// Try to steal the oldest job from one of the other workers, start with the next worker so that not all threads go for the same victim
+	for (uint i = 1; i < mNumWorkQueues; ++i)
+	{
+		job = mWorkQueues[(inThreadIndex + i) % mNumWorkQueues].Steal();
+		if (job != nullptr)
+			return job;
+	}
+
+	return nullptr;
+}
+
+#ifdef JPH_PLATFORM_WINDOWS
+
+// Sets the current thread name in MSVC debugger
+static void SetThreadName(const char *inName)
+{
+	#pragma pack(push, 8)
+
+	struct THREADNAME_INFO
+	{
+		DWORD	dwType;			// Must be 0x1000.
+		LPCSTR	szName;			// Pointer to name (in user addr space).
+		DWORD	dwThreadID;		// Thread ID (-1=caller thread).
+		DWORD	dwFlags;		// Reserved for future use, must be zero.
+	};
+
+	#pragma pack(pop)
+
+	THREADNAME_INFO info;
+	info.dwType = 0x1000;
+	info.szName = inName;
+	info.dwThreadID = (DWORD)-1;
+	info.dwFlags = 0;
+
+	__try
+	{
+		RaiseException(0x406D1388, 0, sizeof(info) / sizeof(ULONG_PTR), (ULONG_PTR *)&info);
+	}
+	__except(EXCEPTION_EXECUTE_HANDLER)
+	{
+	}
+}
+
+#endif
+
+void JobSystemWorkStealing::ThreadMain([[maybe_unused]] const char *inName, int inThreadIndex)
+{
+#ifdef JPH_PLATFORM_WINDOWS
+	SetThreadName(inName);
+#endif
+
+	// Enable floating point exceptions
+	FPExceptionsEnable enable_exceptions;
+	JPH_UNUSED(enable_exceptions);
+
+	JPH_PROFILE_THREAD_START(inName);
+
+	// Jobs that run on this thread allocate their scratch memory from our arena
+	ScratchArena::sSetForThread(&mScratchArenas[inThreadIndex]);
+
+	// Register this thread as a worker so that jobs queued from this thread go to our own queue
+	sWorkerJobSystem = this;
+	sWorkerIndex = inThreadIndex;
+
+	while (!mQuit)
+	{
+		// Wait for jobs
+		mSemaphore.Acquire();
+
+		{
+			JPH_PROFILE("Executing Jobs");
+
+			// Execute jobs until we can't find any anymore
+			for (Job *job_ptr = FindJob(inThreadIndex); job_ptr != nullptr; job_ptr = FindJob(inThreadIndex))
+			{
+				job_ptr->Execute();
+				job_ptr->Release();
+			}
+		}
+	}
+
+	sWorkerJobSystem = nullptr;
+	sWorkerIndex = -1;
+
+	ScratchArena::sSetForThread(nullptr);
+
+	JPH_PROFILE_THREAD_END();
+}
+
+JPH_NAMESPACE_END
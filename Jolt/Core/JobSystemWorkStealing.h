@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/ScratchArena.h>
+#include <Jolt/Core/Mutex.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// Implementation of a JobSystem using a pool of threads that each own a work stealing deque.
+///
+/// Jobs that are queued from a worker thread (e.g. because a job removed the last dependency of another job) are pushed
+/// on the deque of that worker, so that the worker can pick them up again without touching shared cache lines. Jobs
+/// that are queued from other threads go into a shared injection queue. A worker that runs out of work first checks
+/// the injection queue and then tries to steal the oldest job from the deques of the other workers.
+///
+/// Compared to JobSystemThreadPool this scales better with high thread counts since there is no single queue that all
+/// threads contend on. It is a drop in replacement for JobSystemThreadPool.
+class JobSystemWorkStealing final : public JobSystemWithBarrier
+{
+public:
+	/// Creates a thread pool.
+	/// @see JobSystemWorkStealing::Init
+							JobSystemWorkStealing(uint inMaxJobs, uint inMaxBarriers, int inNumThreads = -1, uint inScratchArenaSize = ScratchArena::cDefaultSize);
+							JobSystemWorkStealing() = default;
+	virtual					~JobSystemWorkStealing() override;
+
+	/// Initialize the thread pool
+	/// @param inMaxJobs Number of jobs to reserve space for, more space is allocated when more jobs are alive at the same time
+	/// @param inMaxBarriers Max number of barriers that can be allocated at any time
+	/// @param inNumThreads Number of threads to start (the number of concurrent jobs is 1 more because the main thread will also run jobs while waiting for a barrier to complete). Use -1 to autodetect the amount of CPU's.
+	/// @param inScratchArenaSize Size in bytes of the ScratchArena that every worker thread gets to allocate scratch memory from while executing jobs.
+	void					Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads = -1, uint inScratchArenaSize = ScratchArena::cDefaultSize);
+
+	// See JobSystem
+	virtual int				GetMaxConcurrency() const override				{ return int(mThreads.size()) + 1; }
+	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0) override;
+
+	/// Change the max concurrency after initialization
+	void					SetNumThreads(int inNumThreads)					{ StopThreads(); StartThreads(inNumThreads); }
+
+	/// Get the maximum amount of scratch memory that worker thread inThreadIndex (0 .. GetMaxConcurrency() - 2) used since the last call to ResetScratchArenaHighWaterMarks
+	uint					GetScratchArenaHighWaterMark(int inThreadIndex) const { JPH_ASSERT(inThreadIndex >= 0 && inThreadIndex < int(mThreads.size())); return mScratchArenas[inThreadIndex].GetHighWaterMark(); }
+
+	/// Reset the high water marks of the scratch arenas of all worker threads (e.g. at the start of a physics update)
+	void					ResetScratchArenaHighWaterMarks()				{ for (size_t i = 0; i < mThreads.size(); ++i) mScratchArenas[i].ResetHighWaterMark(); }
+
+protected:
+	// See JobSystem
+	virtual void			QueueJob(Job *inJob) override;
+	virtual void			QueueJobs(Job **inJobs, uint inNumJobs) override;
+	virtual void			FreeJob(Job *inJob) override;
+
+private:
+	/// A bounded Chase-Lev deque. The owning worker pushes and pops jobs at the bottom, other threads steal jobs from the top.
+	class alignas(JPH_CACHE_LINE_SIZE) WorkQueue
+	{
+	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Jobs)
+
+		/// Constructor
+							WorkQueue();
+
+		/// Push a job at the bottom of the queue, only the owning thread is allowed to do this. Returns false if the queue is full.
+		inline bool			Push(Job *inJob);
+
+		/// Pop the last pushed job from the bottom of the queue, only the owning thread is allowed to do this. Returns nullptr if the queue is empty.
+		inline Job *		Pop();
+
+		/// Steal the oldest job from the top of the queue, can be called from any thread. Returns nullptr if the queue is empty.
+		inline Job *		Steal();
+
+	private:
+		static constexpr uint cQueueLength = 1024;
+		static_assert(IsPowerOf2(cQueueLength));							// We do bit operations and require queue length to be a power of 2
+
+		// Top and bottom of the queue, these can wrap around so we always compare them as a signed difference
+		alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mTop { 0 };				///< Read end of the queue for stealing threads
+		alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mBottom { 0 };			///< Read/write end of the queue for the owning thread
+		atomic<Job *>		mJobs[cQueueLength];							///< The jobs, do index modulo cQueueLength to get the element
+	};
+
+	/// Start/stop the worker threads
+	void					StartThreads(int inNumThreads);
+	void					StopThreads();
+
+	/// Entry point for a thread
+	void					ThreadMain(const char *inName, int inThreadIndex);
+
+	/// Find a job to execute for a thread, returns nullptr if no job could be found
+	inline Job *			FindJob(int inThreadIndex);
+
+	/// Add jobs to the shared injection queue, used when queueing from a thread that is not one of our workers or when the work queue of a worker is full
+	void					InjectJobs(Job **inJobs, uint inNumJobs);
+
+	/// Take a job from the shared injection queue, returns nullptr if it is empty
+	Job *					TakeInjectedJob();
+
+	/// Internal helper function to queue a batch of jobs (does not wake up threads)
+	void					QueueJobsInternal(Job **inJobs, uint inNumJobs);
+
+	/// Array of jobs (fixed size)
+	using AvailableJobs = FixedSizeFreeList<Job>;
+	AvailableJobs			mJobs;
+
+	/// Threads running jobs
+	TaggedVector<thread, EMemoryTag::Jobs>	mThreads;
+
+	/// Per worker thread the arena to allocate scratch memory from
+	uint					mScratchArenaSize = ScratchArena::cDefaultSize;
+	ScratchArena *			mScratchArenas = nullptr;
+
+	/// Per worker thread the queue of jobs that it owns
+	uint					mNumWorkQueues = 0;
+	WorkQueue *				mWorkQueues = nullptr;
+
+	/// Queue for jobs that were queued from a non worker thread, protected by mInjectionLock
+	static constexpr uint	cInjectionQueueLength = 1024;
+	static_assert(IsPowerOf2(cInjectionQueueLength));						// We do bit operations and require queue length to be a power of 2
+	Mutex					mInjectionLock;
+	Job *					mInjectionQueue[cInjectionQueueLength];
+	atomic<uint>			mInjectionHead = 0;								///< Read end of the injection queue
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mInjectionTail = 0;			///< Write end of the injection queue, can be read without the lock to test if the queue is empty
+
+	/// Semaphore used to signal worker threads that there is new work
+	Semaphore				mSemaphore;
+
+	/// Boolean to indicate that we want to stop the job system
+	atomic<bool>			mQuit = false;
+};
+
+JPH_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include <Jolt/Core/Memory.h>
 #include <Jolt/Core/NonCopyable.h>
+#include <Jolt/Core/Mutex.h>
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <atomic>
@@ -12,18 +13,28 @@ JPH_SUPPRESS_WARNINGS_STD_END
 
 JPH_NAMESPACE_BEGIN
 
-/// Allocator for a lock free hash map
+/// Allocator for a lock free hash map.
+/// The object store is split up in chunks that are allocated when they are first needed, the first chunk is cFirstChunkSize bytes and every next chunk doubles the size of the store.
+/// Chunks never move so key value pairs stay valid while the store grows.
 class LFHMAllocator : public NonCopyable
 {
 public:
+	/// Size of the first chunk of the object store
+	static constexpr uint32	cFirstChunkSize = 64 * 1024;
+
+	/// Max size of the object store
+	static constexpr uint32	cMaxObjectStoreSizeBytes = 0x80000000;
+
 	/// Destructor
 	inline					~LFHMAllocator();
 
 	/// Initialize the allocator
-	/// @param inObjectStoreSizeBytes Number of bytes to reserve for all key value pairs
-	inline void				Init(uint inObjectStoreSizeBytes);
+	/// @param inObjectStoreSizeBytes Max number of bytes that can be used for all key value pairs, memory is only allocated when it is needed so this can be a worst case estimate
+	/// @param inTag Subsystem that the memory is attributed to
+	inline void				Init(uint inObjectStoreSizeBytes, EMemoryTag inTag = EMemoryTag::General);
 
-	/// Clear all allocations
+	/// Clear all allocations.
+	/// Chunks that were not needed since the last call to Clear are freed (except for one spare chunk), so memory usage follows demand.
 	inline void				Clear();
 
 	/// Allocate a new block of data
@@ -32,18 +43,50 @@ public:
 	/// @param ioEnd Should be the byte beyond the current memory block on input, will contain the byte beyond the allocated block on return.
 	inline void				Allocate(uint32 inBlockSize, uint32 &ioBegin, uint32 &ioEnd);
 
-	/// Convert a pointer to an offset
-	template <class T>
-	inline uint32			ToOffset(const T *inData) const;
-
 	/// Convert an offset to a pointer
 	template <class T>
 	inline T *				FromOffset(uint32 inOffset) const;
 
+	/// Get the amount of bytes that have been handed out since the last call to Clear
+	inline uint32			GetNumBytesUsed() const					{ return min(mWriteOffset.load(memory_order_relaxed), mObjectStoreSizeBytes); }
+
+	/// Get the amount of bytes that are currently allocated for the object store
+	inline uint32			GetNumBytesAllocated() const			{ return mNumBytesAllocated.load(memory_order_relaxed); }
+
+	/// Get the max amount of bytes that the object store can grow to
+	inline uint32			GetMaxBytes() const						{ return mObjectStoreSizeBytes; }
+
+	/// Get the amount of allocations that failed because the object store was full since the last call to Clear
+	inline uint32			GetNumFailedAllocations() const			{ return mNumFailedAllocations.load(memory_order_relaxed); }
+
 private:
-	uint8 *					mObjectStore = nullptr;			///< This contains a contigous list of objects (possibly of varying size)
-	uint32					mObjectStoreSizeBytes = 0;		///< The size of mObjectStore in bytes
-	atomic<uint32>			mWriteOffset { 0 };				///< Next offset to write to in mObjectStore
+	friend class LFHMAllocatorContext;
+
+	/// Max amount of chunks in the object store
+	static constexpr uint	cMaxChunks = 16;
+
+	/// Get the chunk that contains inOffset
+	static inline uint		sGetChunkIndex(uint32 inOffset)			{ return 32 - CountLeadingZeros(inOffset / cFirstChunkSize); }
+
+	/// Get the offset of the first byte in a chunk
+	static inline uint32	sGetChunkStart(uint inChunkIndex)		{ return inChunkIndex == 0? 0 : cFirstChunkSize << (inChunkIndex - 1); }
+
+	/// Get the amount of bytes in a chunk
+	inline uint32			GetChunkSize(uint inChunkIndex) const	{ return min(cFirstChunkSize << max<int>(int(inChunkIndex) - 1, 0), mObjectStoreSizeBytes - sGetChunkStart(inChunkIndex)); }
+
+	/// Allocate a chunk if it has not been allocated yet
+	inline void				EnsureChunk(uint inChunkIndex);
+
+	/// Free a chunk
+	inline void				FreeChunk(uint inChunkIndex);
+
+	atomic<uintptr_t>		mChunks[cMaxChunks] = { };				///< Address of each chunk minus the offset of its first byte so that adding an offset results in the address of the object, 0 if the chunk has not been allocated
+	uint32					mObjectStoreSizeBytes = 0;				///< The max size of the object store in bytes
+	EMemoryTag				mTag = EMemoryTag::General;				///< Subsystem that the object store is attributed to
+	atomic<uint32>			mWriteOffset { 0 };						///< Next offset to write to in the object store
+	atomic<uint32>			mNumBytesAllocated { 0 };				///< Sum of the sizes of all allocated chunks
+	atomic<uint32>			mNumFailedAllocations { 0 };			///< Amount of allocations that failed since the last call to Clear
+	Mutex					mChunkMutex;							///< Mutex that is used when allocating a new chunk
 };
 
 /// Allocator context object for a lock free hash map that allocates a larger memory block at once and hands it out in smaller portions.
@@ -67,7 +110,20 @@ private:
 	uint32					mEnd = 0;
 };
 
-/// Very simple lock free hash map that only allows insertion, retrieval and provides a fixed amount of buckets and fixed storage.
+/// Statistics of a LockFreeHashMap, see LockFreeHashMap::GetStats
+struct LockFreeHashMapStats
+{
+	uint32					mNumBuckets = 0;						///< Amount of buckets that are in use
+	uint32					mNumAllocatedBuckets = 0;				///< Amount of buckets that memory has been allocated for
+	uint32					mNumUsedBuckets = 0;					///< Amount of buckets that contain at least one key value pair
+	uint32					mNumKeyValues = 0;						///< Amount of key value pairs in the map
+	float					mLoadFactor = 0.0f;						///< mNumKeyValues / mNumBuckets
+	uint32					mMaxProbeLength = 0;					///< Max amount of key value pairs that need to be visited to find a key
+	float					mAverageProbeLength = 0.0f;				///< Average amount of key value pairs that need to be visited to find a key that is in the map
+};
+
+/// Very simple lock free hash map that only allows insertion and retrieval.
+/// The amount of buckets can be changed while the map is empty (e.g. between simulation steps) and the storage grows as needed (see LFHMAllocator).
 /// Note: This class currently assumes key and value are simple types that need no calls to the destructor.
 template <class Key, class Value>
 class LockFreeHashMap : public NonCopyable
@@ -80,8 +136,9 @@ public:
 							~LockFreeHashMap();
 
 	/// Initialization
-	/// @param inMaxBuckets Max amount of buckets to use in the hashmap. Must be power of 2.
-	void					Init(uint32 inMaxBuckets);
+	/// @param inMaxBuckets Max amount of buckets to use in the hashmap. Must be power of 2. The map starts with this amount of buckets, use SetNumBuckets to lower it.
+	/// @param inTag Subsystem that the memory is attributed to
+	void					Init(uint32 inMaxBuckets, EMemoryTag inTag = EMemoryTag::General);
 
 	/// Remove all elements.
 	/// Note that this cannot happen simultaneously with adding new elements.
@@ -95,8 +152,13 @@ public:
 
 	/// Update the number of buckets. This must be done after clearing the map and cannot be done concurrently with any other operations on the map.
 	/// Note that the number of buckets can never become bigger than the specified max buckets during initialization and that it must be a power of 2.
+	/// Memory for the buckets is reallocated when the map needs more buckets than have been allocated, or less than a quarter of them.
 	void					SetNumBuckets(uint32 inNumBuckets);
 
+	/// Get statistics about the distribution of the key value pairs over the buckets (slow, iterates through all key value pairs).
+	/// This cannot be done concurrently with Create().
+	LockFreeHashMapStats	GetStats() const;
+
 	/// A key / value pair that is inserted in the map
 	class KeyValue
 	{
@@ -109,6 +171,7 @@ public:
 		template <class K, class V> friend class LockFreeHashMap;
 
 		Key					mKey;							///< Key for this entry
+		uint32				mOffset;						///< Offset in mObjectStore of this KeyValue entry, the object store consists of multiple chunks so the offset cannot be calculated from the address
 		uint32				mNextOffset;					///< Offset in mObjectStore of next KeyValue entry with same hash
 		Value				mValue;							///< Value for this entry + optionally extra bytes
 	};
@@ -137,7 +200,8 @@ public:
 #endif // JPH_ENABLE_ASSERTS
 
 	/// Get all key/value pairs
-	inline void				GetAllKeyValues(vector<const KeyValue *> &outAll) const;
+	template <class Allocator>
+	inline void				GetAllKeyValues(vector<const KeyValue *, Allocator> &outAll) const;
 
 	/// Non-const iterator
 	struct Iterator
@@ -176,7 +240,9 @@ private:
 
 	atomic<uint32> *		mBuckets = nullptr;				///< This contains the offset in mObjectStore of the first object with a particular hash
 	uint32					mNumBuckets = 0;				///< Current number of buckets
+	uint32					mNumAllocatedBuckets = 0;		///< Number of buckets that mBuckets has space for
 	uint32					mMaxBuckets = 0;				///< Maximum number of buckets
+	EMemoryTag				mTag = EMemoryTag::General;		///< Subsystem that mBuckets is attributed to
 };
 
 JPH_NAMESPACE_END
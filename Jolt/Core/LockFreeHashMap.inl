@@ -11,20 +11,63 @@ JPH_NAMESPACE_BEGIN
 
 inline LFHMAllocator::~LFHMAllocator()
 {
-	delete [] mObjectStore;
+	for (uint i = 0; i < cMaxChunks; ++i)
+		FreeChunk(i);
 }
 
-inline void LFHMAllocator::Init(uint inObjectStoreSizeBytes)
+inline void LFHMAllocator::Init(uint inObjectStoreSizeBytes, EMemoryTag inTag)
 {
-	JPH_ASSERT(mObjectStore == nullptr);
+	JPH_ASSERT(mObjectStoreSizeBytes == 0);
+	JPH_ASSERT(inObjectStoreSizeBytes > 0 && inObjectStoreSizeBytes <= cMaxObjectStoreSizeBytes);
 
 	mObjectStoreSizeBytes = inObjectStoreSizeBytes;
-	mObjectStore = new uint8 [inObjectStoreSizeBytes];
+	mTag = inTag;
 }
 
 inline void LFHMAllocator::Clear()
 {
+	// Free the chunks that were not used, keep one spare chunk so that we don't free and allocate a chunk every time usage crosses a chunk boundary
+	uint32 num_bytes_used = GetNumBytesUsed();
+	uint num_chunks_to_keep = num_bytes_used > 0? sGetChunkIndex(num_bytes_used - 1) + 2 : 1;
+	for (uint i = num_chunks_to_keep; i < cMaxChunks; ++i)
+		FreeChunk(i);
+
 	mWriteOffset = 0;
+	mNumFailedAllocations = 0;
+}
+
+inline void LFHMAllocator::EnsureChunk(uint inChunkIndex)
+{
+	JPH_ASSERT(inChunkIndex < cMaxChunks && sGetChunkStart(inChunkIndex) < mObjectStoreSizeBytes);
+
+	// Check if another thread already allocated the chunk
+	atomic<uintptr_t> &chunk = mChunks[inChunkIndex];
+	if (chunk.load(memory_order_acquire) != 0)
+		return;
+
+	lock_guard lock(mChunkMutex);
+
+	// Check again now that we have the lock
+	if (chunk.load(memory_order_relaxed) != 0)
+		return;
+
+	uint32 size = GetChunkSize(inChunkIndex);
+	void *data = JPH::Allocate(size, mTag);
+	mNumBytesAllocated.fetch_add(size, memory_order_relaxed);
+	chunk.store(uintptr_t(data) - sGetChunkStart(inChunkIndex), memory_order_release);
+}
+
+inline void LFHMAllocator::FreeChunk(uint inChunkIndex)
+{
+	atomic<uintptr_t> &chunk = mChunks[inChunkIndex];
+	uintptr_t address = chunk.load(memory_order_relaxed);
+	if (address == 0)
+		return;
+
+	uint32 size = GetChunkSize(inChunkIndex);
+	JPH::Free(reinterpret_cast<void *>(address + sGetChunkStart(inChunkIndex)), size, mTag);
+	mNumBytesAllocated.fetch_sub(size, memory_order_relaxed);
+	chunk.store(0, memory_order_relaxed);
 }
 
 inline void LFHMAllocator::Allocate(uint32 inBlockSize, uint32 &ioBegin, uint32 &ioEnd)
@@ -39,37 +82,32 @@ inline void LFHMAllocator::Allocate(uint32 inBlockSize, uint32 &ioBegin, uint32
 
 	// Atomically fetch a block from the pool
 	uint32 begin = mWriteOffset.fetch_add(inBlockSize, memory_order_relaxed);
-	uint32 end = min(begin + inBlockSize, mObjectStoreSizeBytes);
+	if (begin >= mObjectStoreSizeBytes)
+		return;
+
+	// Make sure the memory for the block exists, a block cannot cross the end of a chunk because chunks are not contiguous in memory
+	uint chunk_index = sGetChunkIndex(begin);
+	EnsureChunk(chunk_index);
+	uint32 end = min(begin + inBlockSize, sGetChunkStart(chunk_index) + GetChunkSize(chunk_index));
 
-	if (ioEnd == begin)
+	if (ioEnd == begin && sGetChunkIndex(ioBegin) == chunk_index)
 	{
 		// Block is allocated straight after our previous block
 		begin = ioBegin;
 	}
-	else
-	{
-		// Block is a new block
-		begin = min(begin, mObjectStoreSizeBytes);
-	}
 
 	// Store the begin and end of the resulting block
 	ioBegin = begin;
 	ioEnd = end;
 }
 
-template <class T>
-inline uint32 LFHMAllocator::ToOffset(const T *inData) const
-{
-	const uint8 *data = reinterpret_cast<const uint8 *>(inData);
-	JPH_ASSERT(data >= mObjectStore && data < mObjectStore + mObjectStoreSizeBytes);
-	return uint32(data - mObjectStore);
-}
-
 template <class T>
 inline T *LFHMAllocator::FromOffset(uint32 inOffset) const
 {
 	JPH_ASSERT(inOffset < mObjectStoreSizeBytes);
-	return reinterpret_cast<T *>(mObjectStore + inOffset);
+	uintptr_t chunk = mChunks[sGetChunkIndex(inOffset)].load(memory_order_relaxed);
+	JPH_ASSERT(chunk != 0);
+	return reinterpret_cast<T *>(chunk + inOffset);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -92,7 +130,10 @@ inline bool LFHMAllocatorContext::Allocate(uint32 inSize, uint32 &outWriteOffset
 
 		// Check if we have space again
 		if (mEnd - mBegin < inSize)
+		{
+			mAllocator.mNumFailedAllocations.fetch_add(1, memory_order_relaxed);
 			return false;
+		}
 	}
 
 	// Make the allocation
@@ -106,15 +147,17 @@ inline bool LFHMAllocatorContext::Allocate(uint32 inSize, uint32 &outWriteOffset
 ///////////////////////////////////////////////////////////////////////////////////
 
 template <class Key, class Value>
-void LockFreeHashMap<Key, Value>::Init(uint32 inMaxBuckets)
+void LockFreeHashMap<Key, Value>::Init(uint32 inMaxBuckets, EMemoryTag inTag)
 {
 	JPH_ASSERT(inMaxBuckets >= 4 && IsPowerOf2(inMaxBuckets));
 	JPH_ASSERT(mBuckets == nullptr);
 
 	mNumBuckets = inMaxBuckets;
+	mNumAllocatedBuckets = inMaxBuckets;
 	mMaxBuckets = inMaxBuckets;
+	mTag = inTag;
 
-	mBuckets = reinterpret_cast<atomic<uint32> *>(AlignedAlloc(inMaxBuckets * sizeof(atomic<uint32>), 16));
+	mBuckets = reinterpret_cast<atomic<uint32> *>(AlignedAlloc(inMaxBuckets * sizeof(atomic<uint32>), 16, inTag));
 
 	Clear();
 }
@@ -122,7 +165,7 @@ void LockFreeHashMap<Key, Value>::Init(uint32 inMaxBuckets)
 template <class Key, class Value>
 LockFreeHashMap<Key, Value>::~LockFreeHashMap()
 {
-	AlignedFree(mBuckets);
+	AlignedFree(mBuckets, mNumAllocatedBuckets * sizeof(atomic<uint32>), mTag);
 }
 
 template <class Key, class Value>
@@ -153,7 +196,56 @@ void LockFreeHashMap<Key, Value>::SetNumBuckets(uint32 inNumBuckets)
 	JPH_ASSERT(inNumBuckets <= mMaxBuckets);
 	JPH_ASSERT(inNumBuckets >= 4 && IsPowerOf2(inNumBuckets));
 
-	mNumBuckets = inNumBuckets;	
+	// Reallocate the buckets when we need more than we have or when we're wasting a lot of memory
+	if (inNumBuckets > mNumAllocatedBuckets || inNumBuckets < mNumAllocatedBuckets / 4)
+	{
+		AlignedFree(mBuckets, mNumAllocatedBuckets * sizeof(atomic<uint32>), mTag);
+		mNumAllocatedBuckets = inNumBuckets;
+		mBuckets = reinterpret_cast<atomic<uint32> *>(AlignedAlloc(inNumBuckets * sizeof(atomic<uint32>), 16, mTag));
+	}
+
+	mNumBuckets = inNumBuckets;
+
+	// The buckets that were not in use have not been cleared
+	Clear();
+}
+
+template <class Key, class Value>
+LockFreeHashMapStats LockFreeHashMap<Key, Value>::GetStats() const
+{
+	LockFreeHashMapStats stats;
+	stats.mNumBuckets = mNumBuckets;
+	stats.mNumAllocatedBuckets = mNumAllocatedBuckets;
+
+	uint64 total_probe_length = 0;
+	for (const atomic<uint32> *bucket = mBuckets, *bucket_end = mBuckets + mNumBuckets; bucket < bucket_end; ++bucket)
+	{
+		// Count the key value pairs in this bucket
+		uint32 num_in_bucket = 0;
+		uint32 offset = bucket->load(memory_order_acquire);
+		while (offset != cInvalidHandle)
+		{
+			const KeyValue *kv = mAllocator.template FromOffset<const KeyValue>(offset);
+			offset = kv->mNextOffset;
+			++num_in_bucket;
+		}
+
+		if (num_in_bucket > 0)
+		{
+			// Finding the n-th key value pair in a bucket takes n probes
+			++stats.mNumUsedBuckets;
+			stats.mNumKeyValues += num_in_bucket;
+			stats.mMaxProbeLength = max(stats.mMaxProbeLength, num_in_bucket);
+			total_probe_length += uint64(num_in_bucket) * (num_in_bucket + 1) / 2;
+		}
+	}
+
+	if (stats.mNumKeyValues > 0)
+		stats.mAverageProbeLength = float(double(total_probe_length) / stats.mNumKeyValues);
+	if (stats.mNumBuckets > 0)
+		stats.mLoadFactor = float(stats.mNumKeyValues) / stats.mNumBuckets;
+
+	return stats;
 }
 
 template <class Key, class Value>
@@ -183,6 +275,7 @@ inline typename LockFreeHashMap<Key, Value>::KeyValue *LockFreeHashMap<Key, Valu
 	memset(kv, 0xcd, size);
 #endif
 	kv->mKey = inKey;
+	kv->mOffset = write_offset;
 	new (&kv->mValue) Value(forward<Params>(inConstructorParams)...);
 
 	// Get the offset to the first object from the bucket with corresponding hash
@@ -221,7 +314,7 @@ inline const typename LockFreeHashMap<Key, Value>::KeyValue *LockFreeHashMap<Key
 template <class Key, class Value>
 inline uint32 LockFreeHashMap<Key, Value>::ToHandle(const KeyValue *inKeyValue) const
 {
-	return mAllocator.ToOffset(inKeyValue);
+	return inKeyValue->mOffset;
 }
 
 template <class Key, class Value>
@@ -231,7 +324,8 @@ inline const typename LockFreeHashMap<Key, Value>::KeyValue *LockFreeHashMap<Key
 }
 
 template <class Key, class Value>
-inline void LockFreeHashMap<Key, Value>::GetAllKeyValues(vector<const KeyValue *> &outAll) const
+template <class Allocator>
+inline void LockFreeHashMap<Key, Value>::GetAllKeyValues(vector<const KeyValue *, Allocator> &outAll) const
 {
 	for (const atomic<uint32> *bucket = mBuckets; bucket < mBuckets + mNumBuckets; ++bucket)
 	{
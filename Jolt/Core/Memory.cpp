@@ -7,12 +7,28 @@
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <cstdlib>
+#include <atomic>
 JPH_SUPPRESS_WARNINGS_STD_END
 #include <stdlib.h>
 
 JPH_NAMESPACE_BEGIN
 
-void *AlignedAlloc(size_t inSize, size_t inAlignment)
+static void *DefaultAllocate(size_t inSize, [[maybe_unused]] EMemoryTag inTag)
+{
+	return malloc(inSize);
+}
+
+static void *DefaultReallocate(void *inBlock, [[maybe_unused]] size_t inOldSize, size_t inNewSize, [[maybe_unused]] EMemoryTag inTag)
+{
+	return realloc(inBlock, inNewSize);
+}
+
+static void DefaultFree(void *inBlock, [[maybe_unused]] size_t inSize, [[maybe_unused]] EMemoryTag inTag)
+{
+	free(inBlock);
+}
+
+static void *DefaultAlignedAllocate(size_t inSize, size_t inAlignment, [[maybe_unused]] EMemoryTag inTag)
 {
 #if defined(JPH_PLATFORM_WINDOWS)
 	// Microsoft doesn't implement C++17 std::aligned_alloc
@@ -24,7 +40,7 @@ void *AlignedAlloc(size_t inSize, size_t inAlignment)
 #endif
 }
 
-void AlignedFree(void *inBlock)
+static void DefaultAlignedFree(void *inBlock, [[maybe_unused]] size_t inSize, [[maybe_unused]] EMemoryTag inTag)
 {
 #if defined(JPH_PLATFORM_WINDOWS)
 	_aligned_free(inBlock);
@@ -35,4 +51,155 @@ void AlignedFree(void *inBlock)
 #endif
 }
 
+static constexpr AllocatorHooks cDefaultHooks = { DefaultAllocate, DefaultReallocate, DefaultFree, DefaultAlignedAllocate, DefaultAlignedFree };
+
+// The hooks that are currently in use
+static AllocatorHooks sHooks = cDefaultHooks;
+
+// Memory usage per tag, on separate cache lines to avoid false sharing between subsystems that allocate from different threads
+struct alignas(JPH_CACHE_LINE_SIZE) TagUsage
+{
+	atomic<uint64>					mNumBytes { 0 };
+	atomic<uint64>					mNumAllocations { 0 };
+};
+
+static TagUsage sTagUsage[uint(EMemoryTag::Count)];
+
+static inline void sTrackAllocate(size_t inSize, EMemoryTag inTag)
+{
+	TagUsage &usage = sTagUsage[uint(inTag)];
+	usage.mNumBytes.fetch_add(inSize, memory_order_relaxed);
+	usage.mNumAllocations.fetch_add(1, memory_order_relaxed);
+}
+
+static inline void sTrackFree(size_t inSize, EMemoryTag inTag)
+{
+	TagUsage &usage = sTagUsage[uint(inTag)];
+	usage.mNumBytes.fetch_sub(inSize, memory_order_relaxed);
+	usage.mNumAllocations.fetch_sub(1, memory_order_relaxed);
+}
+
+const char *GetMemoryTagName(EMemoryTag inTag)
+{
+	switch (inTag)
+	{
+	case EMemoryTag::General:		return "General";
+	case EMemoryTag::Bodies:		return "Bodies";
+	case EMemoryTag::BroadPhase:	return "BroadPhase";
+	case EMemoryTag::Shapes:		return "Shapes";
+	case EMemoryTag::Contacts:		return "Contacts";
+	case EMemoryTag::Constraints:	return "Constraints";
+	case EMemoryTag::Jobs:			return "Jobs";
+	case EMemoryTag::Temporary:		return "Temporary";
+	case EMemoryTag::Count:			break;
+	}
+
+	JPH_ASSERT(false);
+	return "Invalid";
+}
+
+void RegisterAllocatorHooks(const AllocatorHooks &inHooks)
+{
+	sHooks = inHooks;
+}
+
+void RegisterDefaultAllocatorHooks()
+{
+	sHooks = cDefaultHooks;
+}
+
+const AllocatorHooks &GetAllocatorHooks()
+{
+	return sHooks;
+}
+
+void *Allocate(size_t inSize, EMemoryTag inTag)
+{
+	void *block = sHooks.mAllocate(inSize, inTag);
+	if (block != nullptr)
+		sTrackAllocate(inSize, inTag);
+	return block;
+}
+
+void *Reallocate(void *inBlock, size_t inOldSize, size_t inNewSize, EMemoryTag inTag)
+{
+	void *block = sHooks.mReallocate(inBlock, inOldSize, inNewSize, inTag);
+	if (block != nullptr)
+	{
+		if (inBlock != nullptr)
+			sTrackFree(inOldSize, inTag);
+		sTrackAllocate(inNewSize, inTag);
+	}
+	return block;
+}
+
+void Free(void *inBlock, size_t inSize, EMemoryTag inTag)
+{
+	if (inBlock != nullptr)
+	{
+		sTrackFree(inSize, inTag);
+		sHooks.mFree(inBlock, inSize, inTag);
+	}
+}
+
+// Header that is stored in front of every block returned by AlignedAlloc so that the block can be freed without knowing its size
+struct AlignedHeader
+{
+	size_t							mSize;							///< Size of the block as requested by the caller
+	uint32							mHeaderSize;					///< Offset from the start of the allocation to the block, the header is stored just before the block
+	EMemoryTag						mTag;							///< Tag that the block is attributed to
+};
+
+static inline AlignedHeader *sGetAlignedHeader(void *inBlock)
+{
+	return reinterpret_cast<AlignedHeader *>(static_cast<uint8 *>(inBlock) - sizeof(AlignedHeader));
+}
+
+void *AlignedAlloc(size_t inSize, size_t inAlignment, EMemoryTag inTag)
+{
+	JPH_ASSERT(IsPowerOf2(inAlignment));
+
+	// Reserve space for the header in front of the block, keeping the block aligned
+	size_t header_size = AlignUp(sizeof(AlignedHeader), max(inAlignment, alignof(AlignedHeader)));
+	uint8 *allocation = static_cast<uint8 *>(sHooks.mAlignedAllocate(header_size + inSize, inAlignment, inTag));
+	if (allocation == nullptr)
+		return nullptr;
+
+	uint8 *block = allocation + header_size;
+	AlignedHeader *header = sGetAlignedHeader(block);
+	header->mSize = inSize;
+	header->mHeaderSize = uint32(header_size);
+	header->mTag = inTag;
+
+	sTrackAllocate(inSize, inTag);
+	return block;
+}
+
+void AlignedFree(void *inBlock, [[maybe_unused]] size_t inSize, [[maybe_unused]] EMemoryTag inTag)
+{
+	JPH_ASSERT(inBlock == nullptr || (sGetAlignedHeader(inBlock)->mSize == inSize && sGetAlignedHeader(inBlock)->mTag == inTag), "Block was allocated with a different size or tag");
+
+	AlignedFree(inBlock);
+}
+
+void AlignedFree(void *inBlock)
+{
+	if (inBlock != nullptr)
+	{
+		const AlignedHeader *header = sGetAlignedHeader(inBlock);
+		size_t size = header->mSize;
+		uint32 header_size = header->mHeaderSize;
+		EMemoryTag tag = header->mTag;
+
+		sTrackFree(size, tag);
+		sHooks.mAlignedFree(static_cast<uint8 *>(inBlock) - header_size, header_size + size, tag);
+	}
+}
+
+MemoryUsage GetMemoryUsage(EMemoryTag inTag)
+{
+	const TagUsage &usage = sTagUsage[uint(inTag)];
+	return { usage.mNumBytes.load(memory_order_relaxed), usage.mNumAllocations.load(memory_order_relaxed) };
+}
+
 JPH_NAMESPACE_END
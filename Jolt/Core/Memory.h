@@ -5,10 +5,99 @@
 
 JPH_NAMESPACE_BEGIN
 
-/// Allocate a block of memory aligned to inAlignment bytes of size inSize
-void *AlignedAlloc(size_t inSize, size_t inAlignment);
+/// Subsystem that an allocation is attributed to, used to report how much memory each part of the library is using (see GetMemoryUsage)
+enum class EMemoryTag : uint8
+{
+	General,						///< Memory that has not been attributed to a specific subsystem
+	Bodies,							///< Bodies, motion properties and the bookkeeping of the body manager
+	BroadPhase,						///< Broadphase trees, grids and sort lists
+	Shapes,							///< Shapes
+	Contacts,						///< Contact cache
+	Constraints,					///< Constraints
+	Jobs,							///< Jobs and scratch arenas of the job system
+	Temporary,						///< Temp allocators
 
-/// Free memory block allocated with AlignedAlloc
+	Count							///< Number of tags
+};
+
+/// Get the name of a memory tag
+const char *GetMemoryTagName(EMemoryTag inTag);
+
+/// Function that allocates inSize bytes of memory, memory needs to be aligned to at least alignof(max_align_t) bytes (like malloc)
+using AllocateFunction = void *(*)(size_t inSize, EMemoryTag inTag);
+
+/// Function that resizes a block previously returned by AllocateFunction, inBlock can be nullptr
+using ReallocateFunction = void *(*)(void *inBlock, size_t inOldSize, size_t inNewSize, EMemoryTag inTag);
+
+/// Function that frees a block previously returned by AllocateFunction / ReallocateFunction, inBlock is never nullptr
+using FreeFunction = void (*)(void *inBlock, size_t inSize, EMemoryTag inTag);
+
+/// Function that allocates inSize bytes of memory aligned to inAlignment bytes
+using AlignedAllocateFunction = void *(*)(size_t inSize, size_t inAlignment, EMemoryTag inTag);
+
+/// Function that frees a block previously returned by AlignedAllocateFunction, inBlock is never nullptr
+using AlignedFreeFunction = void (*)(void *inBlock, size_t inSize, EMemoryTag inTag);
+
+/// Set of functions that all memory that the library allocates goes through
+struct AllocatorHooks
+{
+	AllocateFunction				mAllocate;
+	ReallocateFunction				mReallocate;
+	FreeFunction					mFree;
+	AlignedAllocateFunction			mAlignedAllocate;
+	AlignedFreeFunction				mAlignedFree;
+};
+
+/// Route all allocations through inHooks (e.g. to place them in the arenas of your own allocator).
+/// This needs to be called before any memory is allocated, blocks need to be freed by the hooks that allocated them.
+void RegisterAllocatorHooks(const AllocatorHooks &inHooks);
+
+/// Restore the default hooks which use the allocation functions of the C runtime
+void RegisterDefaultAllocatorHooks();
+
+/// Get the hooks that are currently in use (e.g. to forward to them from your own hooks)
+const AllocatorHooks &GetAllocatorHooks();
+
+/// Allocate a block of memory of size inSize (aligned to at least alignof(max_align_t) bytes, use AlignedAlloc for types that need more)
+void *Allocate(size_t inSize, EMemoryTag inTag = EMemoryTag::General);
+
+/// Resize a block of memory allocated with Allocate, the contents up to min(inOldSize, inNewSize) is preserved
+void *Reallocate(void *inBlock, size_t inOldSize, size_t inNewSize, EMemoryTag inTag = EMemoryTag::General);
+
+/// Free a block of memory of size inSize allocated with Allocate / Reallocate
+void Free(void *inBlock, size_t inSize, EMemoryTag inTag = EMemoryTag::General);
+
+/// Allocate a block of memory aligned to inAlignment bytes of size inSize.
+/// The size and tag of the block are stored in a header in front of it, the hooks are asked for a block that is at least max(inAlignment, 16) bytes larger.
+void *AlignedAlloc(size_t inSize, size_t inAlignment, EMemoryTag inTag = EMemoryTag::General);
+
+/// Free memory block of size inSize allocated with AlignedAlloc
+void AlignedFree(void *inBlock, size_t inSize, EMemoryTag inTag = EMemoryTag::General);
+
+/// Free memory block allocated with AlignedAlloc, the size and tag are taken from the header of the block
 void AlignedFree(void *inBlock);
 
+/// Memory that is currently allocated for a tag
+struct MemoryUsage
+{
+	uint64							mNumBytes;						///< Amount of bytes that are allocated
+	uint64							mNumAllocations;				///< Amount of blocks that are allocated
+};
+
+/// Get the amount of memory that is currently allocated for a tag (can be called from any thread)
+MemoryUsage GetMemoryUsage(EMemoryTag inTag);
+
+/// Macro to override the new and delete functions of a class so that its instances are allocated through the allocator hooks with tag inTag
+#define JPH_OVERRIDE_NEW_DELETE(inTag) \
+	JPH_INLINE static void *operator new (size_t inCount)												{ return JPH::Allocate(inCount, inTag); } \
+	JPH_INLINE static void operator delete (void *inPointer, size_t inCount) noexcept					{ JPH::Free(inPointer, inCount, inTag); } \
+	JPH_INLINE static void *operator new[] (size_t inCount)												{ return JPH::Allocate(inCount, inTag); } \
+	JPH_INLINE static void operator delete[] (void *inPointer, size_t inCount) noexcept					{ JPH::Free(inPointer, inCount, inTag); } \
+	JPH_INLINE static void *operator new (size_t inCount, std::align_val_t inAlignment)					{ return JPH::AlignedAlloc(inCount, static_cast<size_t>(inAlignment), inTag); } \
+	JPH_INLINE static void operator delete (void *inPointer, size_t inCount, std::align_val_t) noexcept	{ JPH::AlignedFree(inPointer, inCount, inTag); } \
+	JPH_INLINE static void *operator new[] (size_t inCount, std::align_val_t inAlignment)				{ return JPH::AlignedAlloc(inCount, static_cast<size_t>(inAlignment), inTag); } \
+	JPH_INLINE static void operator delete[] (void *inPointer, size_t inCount, std::align_val_t) noexcept { JPH::AlignedFree(inPointer, inCount, inTag); } \
+	JPH_INLINE static void *operator new ([[maybe_unused]] size_t inCount, void *inPointer) noexcept	{ return inPointer; } \
+	JPH_INLINE static void operator delete ([[maybe_unused]] void *inPointer, [[maybe_unused]] void *inPlace) noexcept { }
+
 JPH_NAMESPACE_END
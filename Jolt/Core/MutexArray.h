@@ -84,6 +84,8 @@ private:
 	/// Align the mutex to a cache line to ensure there is no false sharing (this is platform dependent, we do this to be safe)
 	struct alignas(JPH_CACHE_LINE_SIZE) MutexStorage
 	{
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 		MutexType			mMutex;
 	};
 
@@ -28,14 +28,30 @@ void Profiler::NextFrame()
 {
 	lock_guard lock(mLock);
 
+	// Copy the samples before DumpInternal modifies them
+	if (mNumTraceFrames > 0 || mDumpTrace)
+		CaptureTraceFrame();
+
 	if (mDump)
 	{
 		DumpInternal();
 		mDump = false;
 	}
 
+	if (mDumpTrace)
+	{
+		DumpTraceInternal();
+		mDumpTrace = false;
+		mTracing.store(mNumTraceFrames > 0, memory_order_relaxed);
+	}
+
 	for (ProfileThread *t : mThreads)
+	{
 		t->mCurrentSample = 0;
+		t->mCurrentFlowEvent = 0;
+	}
+
+	mFrameStartCycle = GetProcessorTickCount();
 }
 
 void Profiler::Dump(const string_view &inTag)
@@ -44,10 +60,28 @@ void Profiler::Dump(const string_view &inTag)
 	mDumpTag = inTag;
 }
 
+void Profiler::CaptureTrace(uint inNumFrames)
+{
+	lock_guard lock(mLock);
+
+	mNumTraceFrames = inNumFrames;
+	mTraceFrames.clear();
+	mNextTraceFrame = 0;
+	mTracing.store(mNumTraceFrames > 0 || mDumpTrace, memory_order_relaxed);
+}
+
+void Profiler::DumpTrace(const string_view &inTag)
+{
+	mDumpTrace = true;
+	mDumpTraceTag = inTag;
+	mTracing.store(true, memory_order_relaxed);
+}
+
 void Profiler::AddThread(ProfileThread *inThread)										
 { 
 	lock_guard lock(mLock); 
 
+	inThread->mThreadID = mNextThreadID++;
 	mThreads.push_back(inThread); 
 }
 
@@ -55,7 +89,7 @@ void Profiler::RemoveThread(ProfileThread *inThread)
 { 
 	lock_guard lock(mLock); 
 	
-	vector<ProfileThread *>::iterator i = find(mThreads.begin(), mThreads.end(), inThread); 
+	TaggedVector<ProfileThread *>::iterator i = find(mThreads.begin(), mThreads.end(), inThread); 
 	JPH_ASSERT(i != mThreads.end()); 
 	mThreads.erase(i); 
 }
@@ -167,6 +201,177 @@ void Profiler::DumpInternal()
 	DumpChart(tag.c_str(), threads, key_to_aggregators, aggregators);
 }
 
+void Profiler::CaptureTraceFrame()
+{
+	// When we're not capturing we only keep the current frame
+	uint num_frames = max(mNumTraceFrames, 1U);
+
+	// Take the next frame from the ring buffer
+	if (mTraceFrames.size() < num_frames)
+	{
+		mNextTraceFrame = uint(mTraceFrames.size());
+		mTraceFrames.emplace_back();
+	}
+	TraceFrame &frame = mTraceFrames[mNextTraceFrame];
+	mNextTraceFrame = (mNextTraceFrame + 1) % num_frames;
+
+	// Copy the samples of all threads
+	// Note that this has the same thread safety issues as DumpInternal
+	frame.mEndCycle = GetProcessorTickCount();
+	frame.mThreads.resize(mThreads.size());
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		const ProfileThread *t = mThreads[i];
+		TraceThread &trace_thread = frame.mThreads[i];
+		trace_thread.mThreadName = t->mThreadName;
+		trace_thread.mThreadID = t->mThreadID;
+
+		// Skip samples that are still running, they contain data from a previous frame
+		trace_thread.mSamples.clear();
+		for (const ProfileSample *s = t->mSamples, *end = t->mSamples + t->mCurrentSample; s < end; ++s)
+			if (s->mStartCycle >= mFrameStartCycle && s->mStartCycle <= s->mEndCycle && s->mEndCycle <= frame.mEndCycle)
+				trace_thread.mSamples.push_back({ s->mName, s->mColor, s->mStartCycle, s->mEndCycle });
+
+		trace_thread.mFlowEvents.assign(t->mFlowEvents, t->mFlowEvents + t->mCurrentFlowEvent);
+	}
+}
+
+static string sJSONEncode(const char *inString)
+{
+	string str(inString);
+	StringReplace(str, "\\", "\\\\");
+	StringReplace(str, "\"", "\\\"");
+	return str;
+}
+
+void Profiler::DumpTraceInternal()
+{
+	// Determine tag of this trace
+	string tag;
+	if (mDumpTraceTag.empty())
+	{
+		// Next sequence number
+		static int number = 0;
+		++number;
+		tag = ConvertToString(number);
+	}
+	else
+	{
+		// Take provided tag
+		tag = mDumpTraceTag;
+		mDumpTraceTag.clear();
+	}
+
+	// Open file
+	ofstream f;
+	f.open(StringFormat("profile_trace_%s.json", tag.c_str()).c_str(), ofstream::out | ofstream::trunc);
+	if (f.is_open())
+	{
+		// Get the frames from oldest to newest
+		TaggedVector<const TraceFrame *> frames;
+		uint num_frames = uint(mTraceFrames.size());
+		uint first_frame = num_frames < max(mNumTraceFrames, 1U)? 0 : mNextTraceFrame;
+		for (uint i = 0; i < num_frames; ++i)
+			frames.push_back(&mTraceFrames[(first_frame + i) % num_frames]);
+
+		// Timestamps are in micro seconds relative to the first sample
+		uint64 min_cycle = 0xffffffffffffffffUL;
+		for (const TraceFrame *frame : frames)
+			for (const TraceThread &t : frame->mThreads)
+			{
+				if (!t.mSamples.empty())
+					min_cycle = min(min_cycle, t.mSamples.front().mStartCycle);
+				for (const ProfileFlowEvent &e : t.mFlowEvents)
+					min_cycle = min(min_cycle, e.mCycle);
+			}
+		double us_per_cycle = 1.0e6 / GetProcessorTicksPerSecond();
+		auto to_us = [min_cycle, us_per_cycle](uint64 inCycle) { return us_per_cycle * double(inCycle - min_cycle); };
+
+		f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		auto write_event = [&f, &first](const string &inEvent)
+		{
+			if (!first)
+				f << ",\n";
+			first = false;
+			f << inEvent;
+		};
+
+		// Name the threads
+		TaggedUnorderedMap<uint32, string> thread_names;
+		for (const TraceFrame *frame : frames)
+			for (const TraceThread &t : frame->mThreads)
+				thread_names.try_emplace(t.mThreadID, t.mThreadName);
+		for (const pair<const uint32, string> &t : thread_names)
+			write_event(StringFormat(R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":"%s"}})", t.first, sJSONEncode(t.second.c_str()).c_str()));
+
+		uint frame_number = 0;
+		for (const TraceFrame *frame : frames)
+		{
+			for (const TraceThread &t : frame->mThreads)
+				for (const TraceSample &s : t.mSamples)
+				{
+					string color;
+					if (s.mColor != 0)
+					{
+						Color c(s.mColor);
+						color = StringFormat(R"(,"args":{"color":"#%02x%02x%02x"})", c.r, c.g, c.b);
+					}
+					write_event(StringFormat(R"({"name":"%s","cat":"profile","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f%s})", sJSONEncode(s.mName).c_str(), t.mThreadID, to_us(s.mStartCycle), us_per_cycle * double(s.mEndCycle - s.mStartCycle), color.c_str()));
+				}
+
+			// Mark the end of the frame
+			write_event(StringFormat(R"({"name":"Frame %u","cat":"frame","ph":"i","s":"g","pid":1,"tid":0,"ts":%.3f})", frame_number++, to_us(frame->mEndCycle)));
+		}
+
+		// Find where each flow ends, the same id can be reused after a flow has ended so keep all ends sorted by time
+		struct FlowEnd
+		{
+			uint64				mCycle;
+			uint32				mThreadID;
+
+			bool				operator < (const FlowEnd &inRHS) const				{ return mCycle < inRHS.mCycle; }
+		};
+		using FlowEnds = TaggedVector<FlowEnd>;
+		TaggedUnorderedMap<uint64, FlowEnds> flow_ends;
+		for (const TraceFrame *frame : frames)
+			for (const TraceThread &t : frame->mThreads)
+				for (const ProfileFlowEvent &e : t.mFlowEvents)
+					if (e.mIsEnd)
+						flow_ends[e.mFlowID].push_back({ e.mCycle, t.mThreadID });
+		for (TaggedUnorderedMap<uint64, FlowEnds>::value_type &ends : flow_ends)
+			sort(ends.second.begin(), ends.second.end());
+
+		// Write an arrow from every flow begin to the first end after it, a flow can have multiple begins so every arrow gets its own id
+		uint32 arrow_id = 0;
+		for (const TraceFrame *frame : frames)
+			for (const TraceThread &t : frame->mThreads)
+				for (const ProfileFlowEvent &e : t.mFlowEvents)
+					if (!e.mIsEnd)
+					{
+						TaggedUnorderedMap<uint64, FlowEnds>::const_iterator ends = flow_ends.find(e.mFlowID);
+						if (ends == flow_ends.end())
+							continue;
+						FlowEnds::const_iterator end = lower_bound(ends->second.begin(), ends->second.end(), FlowEnd { e.mCycle, 0 });
+						if (end != ends->second.end())
+						{
+							write_event(StringFormat(R"({"name":"Flow","cat":"flow","ph":"s","id":%u,"pid":1,"tid":%u,"ts":%.3f})", arrow_id, t.mThreadID, to_us(e.mCycle)));
+							write_event(StringFormat(R"({"name":"Flow","cat":"flow","ph":"f","bp":"e","id":%u,"pid":1,"tid":%u,"ts":%.3f})", arrow_id, end->mThreadID, to_us(end->mCycle)));
+							++arrow_id;
+						}
+					}
+
+		f << "\n]}\n";
+	}
+
+	// When we're not capturing, the frame was only captured for this dump
+	if (mNumTraceFrames == 0)
+	{
+		mTraceFrames.clear();
+		mNextTraceFrame = 0;
+	}
+}
+
 static string sHTMLEncode(const char *inString)
 {
 	string str(inString);
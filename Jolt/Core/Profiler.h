@@ -5,6 +5,7 @@
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <mutex>
+#include <atomic>
 #include <unordered_map>
 JPH_SUPPRESS_WARNINGS_STD_END
 
@@ -44,6 +45,10 @@ JPH_CLANG_SUPPRESS_WARNING("-Wc++98-compat-pedantic")
 #define JPH_PROFILE_THREAD_END()				
 #define JPH_PROFILE_NEXTFRAME()			
 #define JPH_PROFILE_DUMP(...)				
+#define JPH_PROFILE_FLOW_BEGIN(id)
+#define JPH_PROFILE_FLOW_END(id)
+#define JPH_PROFILE_CAPTURE_TRACE(num_frames)
+#define JPH_PROFILE_DUMP_TRACE(...)
 								
 // Scope profiling measurement
 #define JPH_PROFILE_TAG2(line)		profile##line
@@ -70,6 +75,7 @@ JPH_SUPPRESS_WARNING_POP
 JPH_NAMESPACE_BEGIN
 
 class ProfileSample;
+class ProfileFlowEvent;
 class ProfileThread;
 
 /// Singleton class for managing profiling information
@@ -83,6 +89,18 @@ public:
 	/// @param inTag If not empty, this overrides the auto incrementing number in the filename of the dump file
 	void						Dump(const string_view &inTag = string_view());
 
+	/// Keep the samples of the last inNumFrames frames in a ring buffer so they can be written as a timeline with DumpTrace.
+	/// @param inNumFrames Amount of frames to keep, 0 stops capturing
+	void						CaptureTrace(uint inNumFrames);
+
+	/// Write the captured frames (or only the current frame when not capturing) at the start of the next frame to profile_trace_<tag>.json.
+	/// The file uses the Trace Event Format, it can be loaded in chrome://tracing or https://ui.perfetto.dev.
+	/// @param inTag If not empty, this overrides the auto incrementing number in the filename of the dump file
+	void						DumpTrace(const string_view &inTag = string_view());
+
+	/// Check if a trace is being captured (see CaptureTrace and DumpTrace), flow events are only recorded while tracing
+	inline bool					IsTracing() const													{ return mTracing.load(memory_order_relaxed); }
+
 	/// Add a thread to be instrumented
 	void						AddThread(ProfileThread *inThread);
 
@@ -135,9 +153,34 @@ private:
 		uint64					mMaxCyclesInCallWithChildren = 0;									///< Maximum amount of cycles spent per call
 	};							
 
-	using Threads = vector<ThreadSamples>;
-	using Aggregators = vector<Aggregator>;
-	using KeyToAggregator = unordered_map<const char *, size_t>;
+	/// Copy of a ProfileSample that is kept in the trace
+	struct TraceSample
+	{
+		const char *			mName;
+		uint32					mColor;
+		uint64					mStartCycle;
+		uint64					mEndCycle;
+	};
+
+	/// Copy of the samples of a single thread during a single frame
+	struct TraceThread
+	{
+		string					mThreadName;
+		uint32					mThreadID;
+		TaggedVector<TraceSample>	mSamples;
+		TaggedVector<ProfileFlowEvent> mFlowEvents;
+	};
+
+	/// Copy of the samples of all threads during a single frame
+	struct TraceFrame
+	{
+		uint64					mEndCycle;
+		TaggedVector<TraceThread>	mThreads;
+	};
+
+	using Threads = TaggedVector<ThreadSamples>;
+	using Aggregators = TaggedVector<Aggregator>;
+	using KeyToAggregator = TaggedUnorderedMap<const char *, size_t>;
 
 	/// Helper function to aggregate profile sample data
 	static void					sAggregate(int inDepth, uint32 inColor, ProfileSample *&ioSample, const ProfileSample *inEnd, Aggregators &ioAggregators, KeyToAggregator &ioKeyToAggregator);
@@ -147,10 +190,24 @@ private:
 	void						DumpList(const char *inTag, const Aggregators &inAggregators);
 	void						DumpChart(const char *inTag, const Threads &inThreads, const KeyToAggregator &inKeyToAggregators, const Aggregators &inAggregators);
 
+	/// Copy the samples of the current frame into the trace ring buffer
+	void						CaptureTraceFrame();
+
+	/// Write the trace ring buffer to file
+	void						DumpTraceInternal();
+
 	mutex						mLock;																///< Lock that protects mThreads
-	vector<ProfileThread *>		mThreads;															///< List of all active threads
+	TaggedVector<ProfileThread *>	mThreads;															///< List of all active threads
 	bool						mDump = false;														///< When true, the samples are dumped next frame
 	string						mDumpTag;															///< When not empty, this overrides the auto incrementing number of the dump filename
+	uint64						mFrameStartCycle = 0;												///< Cycle counter at the start of the current frame
+	uint32						mNextThreadID = 0;													///< Identifier for the next thread that is added, used to identify threads in the trace
+	atomic<bool>				mTracing { false };													///< If a trace is being captured or will be dumped at the start of the next frame
+	TaggedVector<TraceFrame>	mTraceFrames;														///< Ring buffer of captured frames
+	uint						mNumTraceFrames = 0;												///< Amount of frames to capture, 0 if not capturing
+	uint						mNextTraceFrame = 0;												///< Next frame in mTraceFrames to write to
+	bool						mDumpTrace = false;													///< When true, the trace is dumped next frame
+	string						mDumpTraceTag;														///< When not empty, this overrides the auto incrementing number of the trace filename
 };							
 
 // Class that contains the information of a single scoped measurement
@@ -165,19 +222,37 @@ public:
 	uint64						mEndCycle;															///< Cycle counter at end of measurement
 };
 
+/// Marks the start or end of an arrow between two samples in the trace, e.g. from the job that removes a dependency from a job to the job itself
+class ProfileFlowEvent
+{
+public:
+	uint64						mCycle;																///< Cycle counter when the event was recorded
+	uint64						mFlowID;															///< Identifier of the flow, can be reused once the flow has ended (e.g. JobSystem::Job::GetFlowID)
+	bool						mIsEnd;																///< False if this is where the arrow starts, true if this is where it ends
+};
+
 /// Collects all samples of a single thread
 class ProfileThread : public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	/// Constructor
 	inline						ProfileThread(const string_view &inThreadName);
 	inline						~ProfileThread();
 
+	/// Record a flow event for the current thread (if it is instrumented)
+	static inline void			sAddFlowEvent(uint64 inFlowID, bool inIsEnd);
+
 	static const uint cMaxSamples = 65536;
+	static const uint cMaxFlowEvents = 16384;
 
 	string						mThreadName;														///< Name of the thread that we're collecting information for
+	uint32						mThreadID = 0;														///< Unique identifier of the thread, assigned by the profiler
 	ProfileSample				mSamples[cMaxSamples];												///< Buffer of samples
 	uint						mCurrentSample = 0;													///< Next position to write a sample to
+	ProfileFlowEvent			mFlowEvents[cMaxFlowEvents];										///< Buffer of flow events
+	uint						mCurrentFlowEvent = 0;												///< Next position to write a flow event to
 
 	static thread_local ProfileThread *sInstance;
 };
@@ -228,6 +303,20 @@ JPH_CLANG_SUPPRESS_WARNING("-Wc++98-compat-pedantic")
 /// Dump profiling info
 #define JPH_PROFILE_DUMP(...)			Profiler::sInstance.Dump(__VA_ARGS__)
 
+/// Mark the current scope as the start of an arrow to the first scope after it that calls JPH_PROFILE_FLOW_END with the same id.
+/// Only recorded (and id only evaluated) while tracing.
+#define JPH_PROFILE_FLOW_BEGIN(id)		do { if (Profiler::sInstance.IsTracing()) ProfileThread::sAddFlowEvent(id, false); } while (false)
+
+/// Mark the current scope as the end of an arrow from the scope(s) that called JPH_PROFILE_FLOW_BEGIN with the same id.
+/// Only recorded (and id only evaluated) while tracing.
+#define JPH_PROFILE_FLOW_END(id)		do { if (Profiler::sInstance.IsTracing()) ProfileThread::sAddFlowEvent(id, true); } while (false)
+
+/// Keep the last num_frames frames for JPH_PROFILE_DUMP_TRACE
+#define JPH_PROFILE_CAPTURE_TRACE(num_frames) Profiler::sInstance.CaptureTrace(num_frames)
+
+/// Dump the captured frames as a timeline that can be loaded in chrome://tracing or Perfetto
+#define JPH_PROFILE_DUMP_TRACE(...)		Profiler::sInstance.DumpTrace(__VA_ARGS__)
+
 JPH_SUPPRESS_WARNING_POP
 
 #else
@@ -245,6 +334,10 @@ JPH_CLANG_SUPPRESS_WARNING("-Wc++98-compat-pedantic")
 #define JPH_PROFILE_FUNCTION()
 #define JPH_PROFILE_NEXTFRAME()
 #define JPH_PROFILE_DUMP(...)
+#define JPH_PROFILE_FLOW_BEGIN(id)
+#define JPH_PROFILE_FLOW_END(id)
+#define JPH_PROFILE_CAPTURE_TRACE(num_frames)
+#define JPH_PROFILE_DUMP_TRACE(...)
 
 JPH_SUPPRESS_WARNING_POP
 
@@ -18,6 +18,18 @@ ProfileThread::~ProfileThread()
 	Profiler::sInstance.RemoveThread(this);
 }
 
+void ProfileThread::sAddFlowEvent(uint64 inFlowID, bool inIsEnd)
+{
+	ProfileThread *thread = sInstance;
+	if (thread != nullptr && thread->mCurrentFlowEvent < cMaxFlowEvents)
+	{
+		ProfileFlowEvent &event = thread->mFlowEvents[thread->mCurrentFlowEvent++];
+		event.mCycle = GetProcessorTickCount();
+		event.mFlowID = inFlowID;
+		event.mIsEnd = inIsEnd;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // ProfileMeasurement
 //////////////////////////////////////////////////////////////////////////////////////////
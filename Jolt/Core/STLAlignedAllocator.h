@@ -7,8 +7,8 @@
 
 JPH_NAMESPACE_BEGIN
 
-/// STL allocator that takes care that memory is aligned to N bytes
-template <typename T, size_t N>
+/// STL allocator that takes care that memory is aligned to N bytes, memory is attributed to Tag
+template <typename T, size_t N, EMemoryTag Tag = EMemoryTag::General>
 class STLAlignedAllocator
 {
 public:
@@ -31,27 +31,27 @@ public:
 
 	/// Constructor from other allocator
 	template <typename T2>
-	inline explicit			STLAlignedAllocator(const STLAlignedAllocator<T2, N> &) { }
+	inline explicit			STLAlignedAllocator(const STLAlignedAllocator<T2, N, Tag> &) { }
 
 	/// Allocate memory
 	inline pointer			allocate(size_type inN)
 	{
-		return (pointer)AlignedAlloc(inN * sizeof(value_type), N);
+		return (pointer)AlignedAlloc(inN * sizeof(value_type), N, Tag);
 	}
 
 	/// Free memory
-	inline void				deallocate(pointer inPointer, size_type)
+	inline void				deallocate(pointer inPointer, size_type inN)
 	{
-		AlignedFree(inPointer);
+		AlignedFree(inPointer, inN * sizeof(value_type), Tag);
 	}
 
 	/// Allocators are stateless so assumed to be equal
-	inline bool				operator == (const STLAlignedAllocator<T, N> &) const
+	inline bool				operator == (const STLAlignedAllocator<T, N, Tag> &) const
 	{
 		return true;
 	}
 
-	inline bool				operator != (const STLAlignedAllocator<T, N> &) const
+	inline bool				operator != (const STLAlignedAllocator<T, N, Tag> &) const
 	{
 		return false;
 	}
@@ -60,7 +60,7 @@ public:
 	template <typename T2>
 	struct rebind
 	{
-		using other = STLAlignedAllocator<T2, N>;
+		using other = STLAlignedAllocator<T2, N, Tag>;
 	};
 };
 
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/Memory.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// STL allocator that allocates through the allocator hooks (see RegisterAllocatorHooks), memory is attributed to Tag
+template <typename T, EMemoryTag Tag = EMemoryTag::General>
+class STLAllocator
+{
+public:
+	using value_type = T;
+
+	/// Pointer to type
+	using pointer = T *;
+	using const_pointer = const T *;
+
+	/// Reference to type.
+	/// Can be removed in C++20.
+	using reference = T &;
+	using const_reference = const T &;
+
+	using size_type = size_t;
+	using difference_type = ptrdiff_t;
+
+	/// Constructor
+	inline					STLAllocator() = default;
+
+	/// Constructor from other allocator
+	template <typename T2>
+	inline					STLAllocator(const STLAllocator<T2, Tag> &) { }
+
+	/// Allocate only guarantees the alignment of malloc, over aligned types (e.g. Vec3 on platforms where max_align_t is 8 bytes) need AlignedAlloc
+	static constexpr bool	cNeedsAlignedAlloc = alignof(T) > alignof(max_align_t);
+
+	/// Allocate memory
+	inline pointer			allocate(size_type inN)
+	{
+		if constexpr (cNeedsAlignedAlloc)
+			return (pointer)AlignedAlloc(inN * sizeof(value_type), alignof(T), Tag);
+		else
+			return (pointer)Allocate(inN * sizeof(value_type), Tag);
+	}
+
+	/// Free memory
+	inline void				deallocate(pointer inPointer, size_type inN)
+	{
+		if constexpr (cNeedsAlignedAlloc)
+			AlignedFree(inPointer, inN * sizeof(value_type), Tag);
+		else
+			Free(inPointer, inN * sizeof(value_type), Tag);
+	}
+
+	/// Allocators are stateless so assumed to be equal
+	inline bool				operator == (const STLAllocator<T, Tag> &) const
+	{
+		return true;
+	}
+
+	inline bool				operator != (const STLAllocator<T, Tag> &) const
+	{
+		return false;
+	}
+
+	/// Converting to allocator for other type
+	template <typename T2>
+	struct rebind
+	{
+		using other = STLAllocator<T2, Tag>;
+	};
+};
+
+/// Vector that allocates its memory through the allocator hooks and attributes it to Tag
+template <typename T, EMemoryTag Tag = EMemoryTag::General>
+using TaggedVector = vector<T, STLAllocator<T, Tag>>;
+
+/// Unordered map that allocates its memory through the allocator hooks and attributes it to Tag
+template <typename Key, typename T, EMemoryTag Tag = EMemoryTag::General, typename Hash = hash<Key>, typename KeyEqual = equal_to<Key>>
+using TaggedUnorderedMap = unordered_map<Key, T, Hash, KeyEqual, STLAllocator<pair<const Key, T>, Tag>>;
+
+/// Unordered set that allocates its memory through the allocator hooks and attributes it to Tag
+template <typename Key, EMemoryTag Tag = EMemoryTag::General, typename Hash = hash<Key>, typename KeyEqual = equal_to<Key>>
+using TaggedUnorderedSet = unordered_set<Key, Hash, KeyEqual, STLAllocator<Key, Tag>>;
+
+JPH_NAMESPACE_END
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/ScratchArena.h>
+
+JPH_NAMESPACE_BEGIN
+
+// The arena that is used by the calling thread
+static thread_local ScratchArena *sThreadArena = nullptr;
+
+ScratchArena::~ScratchArena()
+{
+	JPH_ASSERT(mTop == 0);
+	AlignedFree(mBase, mSize, EMemoryTag::Jobs);
+}
+
+void ScratchArena::Init(uint inSize)
+{
+	JPH_ASSERT(mBase == nullptr);
+	mBase = static_cast<uint8 *>(AlignedAlloc(inSize, 16, EMemoryTag::Jobs));
+	mSize = inSize;
+}
+
+ScratchArena *ScratchArena::sGetForThread()
+{
+	if (sThreadArena == nullptr)
+	{
+		// This thread has not been given an arena, create a default one that lives until the thread exits
+		static thread_local ScratchArena sDefaultArena(cDefaultSize);
+		sThreadArena = &sDefaultArena;
+	}
+
+	return sThreadArena;
+}
+
+void ScratchArena::sSetForThread(ScratchArena *inArena)
+{
+	sThreadArena = inArena;
+}
+
+JPH_NAMESPACE_END
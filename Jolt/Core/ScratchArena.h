@@ -0,0 +1,200 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/NonCopyable.h>
+#include <Jolt/Core/Memory.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <atomic>
+#include <type_traits>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// Linear allocator for scratch memory that is owned by a single thread.
+///
+/// Where the TempAllocator can only be used in the serialized parts of a physics update, every thread can have its own
+/// ScratchArena so that jobs that run in parallel can allocate scratch memory without taking locks or calling malloc.
+/// Memory is released by rewinding the arena to a previous marker, usually through a ScratchArenaScope:
+///
+///		ScratchArenaScope scope;
+///		Foo *foo = static_cast<Foo *>(scope.Allocate(100 * sizeof(Foo)));
+///		if (foo == nullptr)
+///			... arena is full, fall back to another allocation strategy ...
+///
+/// The job system assigns an arena to each of its worker threads (see JobSystemThreadPool), other threads get a default
+/// arena the first time they request one or can install their own through sSetForThread.
+class ScratchArena : public NonCopyable
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Jobs)
+
+	/// Size of the arena that is created for threads that did not get an arena from the job system
+	static constexpr uint	cDefaultSize = 256 * 1024;
+
+	/// Constructor
+							ScratchArena() = default;
+	explicit				ScratchArena(uint inSize)						{ Init(inSize); }
+
+	/// Destructor
+							~ScratchArena();
+
+	/// Allocate the memory block for the arena
+	/// @param inSize Max amount of bytes that can be allocated from this arena at any time
+	void					Init(uint inSize);
+
+	/// Allocates inSize bytes of memory aligned to 16 bytes, returns nullptr if the arena doesn't have enough space left
+	inline void *			Allocate(uint inSize)
+	{
+		uint new_top = mTop + AlignUp(inSize, 16);
+		if (new_top > mSize)
+			return nullptr; // Out of memory
+		void *address = mBase + mTop;
+		mTop = new_top;
+
+		// Track how much memory was used at most
+		if (new_top > mHighWaterMark.load(memory_order_relaxed))
+			mHighWaterMark.store(new_top, memory_order_relaxed);
+
+		return address;
+	}
+
+	/// Get a marker that can be used to release all memory that has been allocated after this call
+	inline uint				GetMarker() const								{ return mTop; }
+
+	/// Release all memory that was allocated after inMarker was obtained
+	inline void				Rewind(uint inMarker)							{ JPH_ASSERT(inMarker <= mTop); mTop = inMarker; }
+
+	/// Check if no allocations have been made
+	inline bool				IsEmpty() const									{ return mTop == 0; }
+
+	/// Get the total size of the arena
+	inline uint				GetSize() const									{ return mSize; }
+
+	/// Get the maximum amount of bytes that were in use at the same time since the last call to ResetHighWaterMark (can be called from any thread)
+	inline uint				GetHighWaterMark() const						{ return mHighWaterMark.load(memory_order_relaxed); }
+
+	/// Reset the high water mark (can be called from any thread)
+	inline void				ResetHighWaterMark()							{ mHighWaterMark.store(0, memory_order_relaxed); }
+
+	/// Get the arena of the calling thread, if the thread doesn't have an arena yet a default one of cDefaultSize bytes is created
+	static ScratchArena *	sGetForThread();
+
+	/// Install an arena for the calling thread (the thread does not take ownership), pass nullptr to uninstall it
+	static void				sSetForThread(ScratchArena *inArena);
+
+private:
+	uint8 *					mBase = nullptr;								///< Base address of the memory block
+	uint					mSize = 0;										///< Size of the memory block
+	uint					mTop = 0;										///< Current top of the arena
+	atomic<uint>			mHighWaterMark { 0 };							///< Highest value of mTop since the last reset
+};
+
+/// Helper class that takes memory from the scratch arena of the calling thread and releases it when it goes out of scope
+class ScratchArenaScope : public NonCopyable
+{
+public:
+	/// Constructor
+	inline					ScratchArenaScope() : mArena(ScratchArena::sGetForThread()), mMarker(mArena->GetMarker()) { }
+
+	/// Destructor, releases all memory allocated through this scope
+	inline					~ScratchArenaScope()							{ mArena->Rewind(mMarker); }
+
+	/// Allocates inSize bytes of memory aligned to 16 bytes, returns nullptr if the arena doesn't have enough space left
+	inline void *			Allocate(uint inSize)							{ return mArena->Allocate(inSize); }
+
+private:
+	ScratchArena *			mArena;
+	uint					mMarker;
+};
+
+/// Array with a fixed capacity that takes its memory from the scratch arena of the calling thread.
+/// When the arena is full the memory is allocated from the heap instead.
+template <class T>
+class ScratchArray : public NonCopyable
+{
+public:
+	using size_type = uint;
+	using iterator = T *;
+	using const_iterator = const T *;
+
+	static_assert(alignof(T) <= 16, "Scratch memory is only 16 byte aligned");
+
+	/// Constructor
+	explicit				ScratchArray(size_type inCapacity) :
+		mCapacity(inCapacity)
+	{
+		mElements = static_cast<T *>(mScope.Allocate(inCapacity * sizeof(T)));
+		if (mElements == nullptr)
+		{
+			mElements = static_cast<T *>(AlignedAlloc(inCapacity * sizeof(T), 16));
+			mIsHeapAllocated = true;
+		}
+	}
+
+	/// Destructor
+							~ScratchArray()
+	{
+		clear();
+		if (mIsHeapAllocated)
+			AlignedFree(mElements, mCapacity * sizeof(T));
+	}
+
+	/// Destruct all elements and set length to zero
+	void					clear()
+	{
+		if constexpr (!is_trivially_destructible<T>())
+			for (T *e = mElements, *e_end = mElements + mSize; e < e_end; ++e)
+				e->~T();
+		mSize = 0;
+	}
+
+	/// Add element to the back of the array
+	void					push_back(const T &inElement)
+	{
+		JPH_ASSERT(mSize < mCapacity);
+		::new (&mElements[mSize++]) T(inElement);
+	}
+
+	/// Construct element at the back of the array
+	template <class... A>
+	void					emplace_back(A &&... inElement)
+	{
+		JPH_ASSERT(mSize < mCapacity);
+		::new (&mElements[mSize++]) T(forward<A>(inElement)...);
+	}
+
+	/// Number of elements in the array
+	size_type				size() const									{ return mSize; }
+
+	/// Returns maximum amount of elements the array can hold
+	size_type				capacity() const								{ return mCapacity; }
+
+	/// Returns true if there are no elements in the array
+	bool					empty() const									{ return mSize == 0; }
+
+	/// Access to the elements
+	T *						data()											{ return mElements; }
+	const T *				data() const									{ return mElements; }
+
+	/// Iterators
+	iterator				begin()											{ return mElements; }
+	iterator				end()											{ return mElements + mSize; }
+	const_iterator			begin() const									{ return mElements; }
+	const_iterator			end() const										{ return mElements + mSize; }
+
+	/// Access element
+	T &						operator [] (size_type inIdx)					{ JPH_ASSERT(inIdx < mSize); return mElements[inIdx]; }
+	const T &				operator [] (size_type inIdx) const				{ JPH_ASSERT(inIdx < mSize); return mElements[inIdx]; }
+
+private:
+	ScratchArenaScope		mScope;											///< Releases the memory when the array is destructed, needs to be constructed before mElements is allocated
+	T *						mElements;
+	size_type				mSize = 0;
+	size_type				mCapacity;
+	bool					mIsHeapAllocated = false;						///< If the arena was full and mElements was allocated from the heap
+};
+
+JPH_NAMESPACE_END
@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/Semaphore.h>
+
+#ifdef JPH_PLATFORM_WINDOWS
+	JPH_SUPPRESS_WARNING_PUSH
+	JPH_MSVC_SUPPRESS_WARNING(5039) // winbase.h(13179): warning C5039: 'TpSetCallbackCleanupGroup': pointer or reference to potentially throwing function passed to 'extern "C"' function under -EHc. Undefined behavior may occur if this function throws an exception.
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+	JPH_SUPPRESS_WARNING_POP
+#elif defined(JPH_PLATFORM_LINUX) || defined(JPH_PLATFORM_ANDROID)
+	#include <unistd.h>
+	#include <sys/syscall.h>
+	#include <linux/futex.h>
+#endif
+
+JPH_NAMESPACE_BEGIN
+
+#if defined(JPH_PLATFORM_LINUX) || defined(JPH_PLATFORM_ANDROID)
+
+/// Number of times we try to acquire the semaphore before we go to sleep
+static constexpr int cSpinCount = 1000;
+
+/// Hint to the CPU that we're spinning
+static inline void sSpinPause()
+{
+#if defined(JPH_CPU_X86)
+	_mm_pause();
+#elif defined(JPH_CPU_ARM64)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+/// Wait until the value of the futex word is no longer inExpected (or until we're woken up spuriously)
+static inline void sFutexWait(atomic<uint32> &inFutex, uint32 inExpected)
+{
+	static_assert(sizeof(atomic<uint32>) == sizeof(uint32));
+	syscall(SYS_futex, reinterpret_cast<uint32 *>(&inFutex), FUTEX_WAIT_PRIVATE, inExpected, nullptr, nullptr, 0);
+}
+
+/// Wake up to inNumber threads waiting on the futex word
+static inline void sFutexWake(atomic<uint32> &inFutex, int inNumber)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32 *>(&inFutex), FUTEX_WAKE_PRIVATE, inNumber, nullptr, nullptr, 0);
+}
+
+void Semaphore::WaitForWakeup()
+{
+	for (;;)
+	{
+		// Try to consume a wakeup
+		uint32 wakeups = mWakeups.load(memory_order_relaxed);
+		while (wakeups > 0)
+			if (mWakeups.compare_exchange_weak(wakeups, wakeups - 1, memory_order_acquire, memory_order_relaxed))
+				return;
+
+		// No wakeups available, go to sleep. We register as parked before the kernel checks the futex word
+		// so that a releasing thread either sees us as parked or we see its wakeup.
+		mNumParked.fetch_add(1, memory_order_seq_cst);
+		sFutexWait(mWakeups, 0);
+		mNumParked.fetch_sub(1, memory_order_relaxed);
+	}
+}
+
+#endif
+
+Semaphore::Semaphore()
+{
+#ifdef JPH_PLATFORM_WINDOWS
+	mSemaphore = CreateSemaphore(nullptr, 0, INT_MAX, nullptr);
+#endif
+}
+
+Semaphore::~Semaphore()
+{
+#ifdef JPH_PLATFORM_WINDOWS
+	CloseHandle(mSemaphore);
+#endif
+}
+
+void Semaphore::Release(uint inNumber)
+{
+	JPH_ASSERT(inNumber > 0);
+
+#ifdef JPH_PLATFORM_WINDOWS
+	int old_value = mCount.fetch_add(inNumber);
+	if (old_value < 0)
+	{
+		int new_value = old_value + (int)inNumber;
+		int num_to_release = min(new_value, 0) - old_value;
+		::ReleaseSemaphore(mSemaphore, num_to_release, nullptr);
+	}
+#elif defined(JPH_PLATFORM_LINUX) || defined(JPH_PLATFORM_ANDROID)
+	int old_value = mCount.fetch_add(inNumber, memory_order_release);
+	if (old_value < 0)
+	{
+		// There are threads waiting for a wakeup, hand them out
+		int new_value = old_value + (int)inNumber;
+		int num_to_release = min(new_value, 0) - old_value;
+		mWakeups.fetch_add(num_to_release, memory_order_seq_cst);
+
+		// Only do the system call if a thread is sleeping, a thread that is still spinning will pick up the wakeup by itself
+		if (mNumParked.load(memory_order_seq_cst) > 0)
+			sFutexWake(mWakeups, num_to_release);
+	}
+#else
+	lock_guard lock(mLock);
+	mCount += (int)inNumber;
+	if (inNumber > 1)
+		mWaitVariable.notify_all();
+	else
+		mWaitVariable.notify_one();
+#endif
+}
+
+void Semaphore::Acquire(uint inNumber)
+{
+	JPH_ASSERT(inNumber > 0);
+
+#ifdef JPH_PLATFORM_WINDOWS
+	int old_value = mCount.fetch_sub(inNumber);
+	int new_value = old_value - (int)inNumber;
+	if (new_value < 0)
+	{
+		int num_to_acquire = min(old_value, 0) - new_value;
+		for (int i = 0; i < num_to_acquire; ++i)
+			WaitForSingleObject(mSemaphore, INFINITE);
+	}
+#elif defined(JPH_PLATFORM_LINUX) || defined(JPH_PLATFORM_ANDROID)
+	// Spin for a while, in a physics update jobs come in rapid succession so there's a good chance we can acquire without sleeping
+	for (int i = 0; i < cSpinCount; ++i)
+	{
+		int value = mCount.load(memory_order_relaxed);
+		if (value >= (int)inNumber && mCount.compare_exchange_weak(value, value - (int)inNumber, memory_order_acquire, memory_order_relaxed))
+			return;
+		sSpinPause();
+	}
+
+	// Take the count, if it goes negative we need to wait for a release
+	int old_value = mCount.fetch_sub(inNumber, memory_order_acquire);
+	int new_value = old_value - (int)inNumber;
+	if (new_value < 0)
+	{
+		int num_to_acquire = min(old_value, 0) - new_value;
+		for (int i = 0; i < num_to_acquire; ++i)
+			WaitForWakeup();
+	}
+#else
+	unique_lock lock(mLock);
+	mCount -= (int)inNumber;
+	mWaitVariable.wait(lock, [this]() { return mCount >= 0; });
+#endif
+}
+
+JPH_NAMESPACE_END
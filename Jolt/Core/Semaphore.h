@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// Implements a semaphore
+/// When we switch to C++20 we can use counting_semaphore to unify this
+class Semaphore
+{
+public:
+	/// Constructor
+							Semaphore();
+							~Semaphore();
+
+	/// Release the semaphore, signalling the thread waiting on the barrier that there may be work
+	void					Release(uint inNumber = 1);
+
+	/// Acquire the semaphore inNumber times
+	void					Acquire(uint inNumber = 1);
+
+	/// Get the current value of the semaphore
+	inline int				GetValue() const								{ return mCount; }
+
+private:
+#ifdef JPH_PLATFORM_WINDOWS
+	// On windows we use a semaphore object since it is more efficient than a lock and a condition variable
+	alignas(JPH_CACHE_LINE_SIZE) atomic<int> mCount { 0 };					///< We increment mCount for every release, to acquire we decrement the count. If the count is negative we know that we are waiting on the actual semaphore.
+	void *					mSemaphore;										///< The semaphore is an expensive construct so we only acquire/release it if we know that we need to wait/have waiting threads
+#elif defined(JPH_PLATFORM_LINUX) || defined(JPH_PLATFORM_ANDROID)
+	/// Park the calling thread until a wakeup is available and consume it
+	void					WaitForWakeup();
+
+	// On Linux we spin for a while and then park the thread on a futex, a system call is only made when a thread actually needs to sleep or be woken up
+	alignas(JPH_CACHE_LINE_SIZE) atomic<int> mCount { 0 };					///< We increment mCount for every release, to acquire we decrement the count. If the count is negative we know that we are waiting on the futex.
+	atomic<uint32>			mWakeups { 0 };									///< Number of wakeups that have been released but not yet consumed by a waiting thread (this is the futex word)
+	atomic<uint32>			mNumParked { 0 };								///< Number of threads that are (about to go) sleeping on the futex, when zero we can skip the wake system call
+#else
+	// Other platforms: Emulate a semaphore using a mutex, condition variable and count
+	mutex					mLock;
+	condition_variable		mWaitVariable;
+	int						mCount = 0;
+#endif
+};
+
+JPH_NAMESPACE_END
@@ -15,6 +15,8 @@ JPH_NAMESPACE_BEGIN
 class TempAllocator : public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Temporary)
+
 	/// Destructor
 	virtual							~TempAllocator() = default;
 
@@ -31,7 +33,7 @@ class TempAllocatorImpl final : public TempAllocator
 public:
 	/// Constructs the allocator with a maximum allocatable size of inSize
 	explicit						TempAllocatorImpl(uint inSize) :
-		mBase(static_cast<uint8 *>(malloc(inSize))),
+		mBase(static_cast<uint8 *>(AlignedAlloc(inSize, 16, EMemoryTag::Temporary))),
 		mSize(inSize)
 	{
 	}
@@ -40,7 +42,7 @@ public:
 	virtual							~TempAllocatorImpl() override
 	{
 		JPH_ASSERT(mTop == 0);
-		free(mBase);
+		AlignedFree(mBase, mSize, EMemoryTag::Temporary);
 	}
 
 	// See: TempAllocator
@@ -96,13 +98,13 @@ public:
 	// See: TempAllocator
 	virtual void *					Allocate(uint inSize) override
 	{
-		return AlignedAlloc(inSize, 16);
+		return AlignedAlloc(inSize, 16, EMemoryTag::Temporary);
 	}
 
 	// See: TempAllocator
 	virtual void					Free(void *inAddress, uint inSize) override
 	{
-		AlignedFree(inAddress);
+		AlignedFree(inAddress, inSize, EMemoryTag::Temporary);
 	}
 };
 
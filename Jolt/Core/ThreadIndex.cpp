@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/ThreadIndex.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <atomic>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+static_assert(cMaxThreadIndices == 64, "sUsedThreadIndices needs one bit per index");
+
+// Bit mask of the indices that have been handed out
+static atomic<uint64> sUsedThreadIndices { 0 };
+
+// Index of a thread, returned to the pool when the thread exits
+class ThreadIndexSlot
+{
+public:
+	~ThreadIndexSlot()
+	{
+		if (mIndex != cInvalidThreadIndex)
+			sUsedThreadIndices.fetch_and(~(uint64(1) << mIndex), memory_order_release);
+	}
+
+	uint					mIndex = cInvalidThreadIndex;
+};
+
+static thread_local ThreadIndexSlot sThreadIndexSlot;
+
+uint GetThreadIndex()
+{
+	ThreadIndexSlot &slot = sThreadIndexSlot;
+	if (slot.mIndex == cInvalidThreadIndex)
+	{
+		// Claim the lowest free index
+		uint64 used = sUsedThreadIndices.load(memory_order_relaxed);
+		while (used != ~uint64(0))
+		{
+			uint64 available = ~used;
+			uint index = uint32(available) != 0? CountTrailingZeros(uint32(available)) : 32 + CountTrailingZeros(uint32(available >> 32));
+			if (sUsedThreadIndices.compare_exchange_weak(used, used | (uint64(1) << index), memory_order_acquire))
+			{
+				slot.mIndex = index;
+				break;
+			}
+		}
+	}
+
+	return slot.mIndex;
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,19 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_NAMESPACE_BEGIN
+
+/// Max amount of threads that can have a thread index at the same time
+static constexpr uint cMaxThreadIndices = 64;
+
+/// Value returned by GetThreadIndex when all indices are in use
+static constexpr uint cInvalidThreadIndex = ~uint(0);
+
+/// Get a small index in the range [0, cMaxThreadIndices) that identifies the calling thread.
+/// Indices are handed out on first use and recycled when a thread exits, so they can be used to give threads their own slot
+/// in a fixed size array (see FixedSizeFreeList). Returns cInvalidThreadIndex if more than cMaxThreadIndices threads are running.
+uint GetThreadIndex();
+
+JPH_NAMESPACE_END
@@ -26,6 +26,8 @@ public:
 	class Edge : public NonCopyable
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 		/// Constructor
 						Edge(Face *inFace, int inStartIdx)	: mFace(inFace), mStartIdx(inStartIdx) { }
 
@@ -44,12 +46,14 @@ public:
 		int				mStartIdx;							///< Vertex index in mPositions that indicates the start vertex of this edge
 	};
 
-	using ConflictList = vector<int>;
+	using ConflictList = TaggedVector<int, EMemoryTag::Shapes>;
 
 	/// Class that holds the information of one face
 	class Face : public NonCopyable
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 		/// Destructor
 						~Face();
 
@@ -78,8 +82,8 @@ public:
 	};
 
 	// Typedefs
-	using Positions = vector<Vec3>;
-	using Faces = vector<Face *>;
+	using Positions = TaggedVector<Vec3, EMemoryTag::Shapes>;
+	using Faces = TaggedVector<Face *, EMemoryTag::Shapes>;
 
 	/// Constructor
 	explicit			ConvexHullBuilder(const Positions &inPositions);
@@ -108,7 +112,7 @@ public:
 	int					GetNumVerticesUsed() const;
 
 	/// Returns true if the hull contains a polygon with inIndices (counter clockwise indices in mPositions)
-	bool				ContainsFace(const vector<int> &inIndices) const;
+	bool				ContainsFace(const TaggedVector<int, EMemoryTag::Shapes> &inIndices) const;
 
 	/// Calculate the center of mass and the volume of the current convex hull
 	void				GetCenterOfMassAndVolume(Vec3 &outCenterOfMass, float &outVolume) const;
@@ -139,7 +143,7 @@ private:
 	};
 
 	// Private typedefs
-	using FullEdges = vector<FullEdge>;
+	using FullEdges = TaggedVector<FullEdge, EMemoryTag::Shapes>;
 
 	// Determine a suitable tolerance for detecting that points are coplanar
 	float				DetermineCoplanarDistance() const;
@@ -13,8 +13,8 @@ JPH_NAMESPACE_BEGIN
 class ConvexHullBuilder2D : public NonCopyable
 {
 public:
-	using Positions = vector<Vec3>; 
-	using Edges = vector<int>;
+	using Positions = TaggedVector<Vec3, EMemoryTag::Shapes>; 
+	using Edges = TaggedVector<int, EMemoryTag::Shapes>;
 
 	/// Constructor
 	/// @param inPositions Positions used to make the hull. Uses X and Y component of Vec3 only!
@@ -53,7 +53,7 @@ private:
 	/// Assigns a position to one of the supplied edges based on which edge is closest.
 	/// @param inPositionIdx Index of the position to add
 	/// @param inEdges List of edges to consider
-	void				AssignPointToEdge(int inPositionIdx, const vector<Edge *> &inEdges) const;
+	void				AssignPointToEdge(int inPositionIdx, const TaggedVector<Edge *, EMemoryTag::Shapes> &inEdges) const;
 
 #ifdef JPH_CONVEX_BUILDER_2D_DEBUG
 	/// Draw state of algorithm
@@ -65,12 +65,14 @@ private:
 	void				ValidateEdges() const;
 #endif
 
-	using ConflictList = vector<int>;
+	using ConflictList = TaggedVector<int, EMemoryTag::Shapes>;
 
 	/// Linked list of edges
 	class Edge
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 		/// Constructor
 		explicit		Edge(int inStartIdx)						: mStartIdx(inStartIdx) { }
 
@@ -98,8 +98,8 @@ public:
 	uint32			mMaterialIndex = 0;
 };
 
-using IndexedTriangleNoMaterialList = vector<IndexedTriangleNoMaterial>;
-using IndexedTriangleList = vector<IndexedTriangle>;
+using IndexedTriangleNoMaterialList = TaggedVector<IndexedTriangleNoMaterial, EMemoryTag::Shapes>;
+using IndexedTriangleList = TaggedVector<IndexedTriangle, EMemoryTag::Shapes>;
 
 JPH_NAMESPACE_END
 
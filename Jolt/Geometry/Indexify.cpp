@@ -19,7 +19,7 @@ void Indexify(const TriangleList &inTriangles, VertexList &outVertices, IndexedT
 	outVertices.clear();
 
 	// Find unique vertices
-	unordered_map<Float3, uint32> vertex_map;
+	TaggedUnorderedMap<Float3, uint32, EMemoryTag::Shapes> vertex_map;
 	for (const Triangle &t : inTriangles)
 		for (const Float3 &v : t.mV)
 		{
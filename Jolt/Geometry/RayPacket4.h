@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_NAMESPACE_BEGIN
+
+/// Packet of 4 rays stored in structure of arrays layout, one ray per component.
+/// Used to trace coherent rays (e.g. a fan of sensor rays) through a tree together so that every node is fetched only once for the entire packet.
+class RayPacket4
+{
+public:
+	/// Number of rays in a packet
+	static constexpr int	cNumRays = 4;
+
+	/// Constructors
+	inline					RayPacket4() = default;
+	inline					RayPacket4(const Vec3 *inOrigins, const Vec3 *inDirections, int inNumRays) { Set(inOrigins, inDirections, inNumRays); }
+
+	/// Set the rays, when inNumRays < cNumRays the remaining rays are disabled and will never report a hit
+	inline void				Set(const Vec3 *inOrigins, const Vec3 *inDirections, int inNumRays)
+	{
+		JPH_ASSERT(inNumRays > 0 && inNumRays <= cNumRays);
+
+		// Transpose the rays, unused rays get the first ray so that they don't produce NaNs
+		for (int i = 0; i < cNumRays; ++i)
+		{
+			int src = i < inNumRays? i : 0;
+			mOriginX[i] = inOrigins[src].GetX();
+			mOriginY[i] = inOrigins[src].GetY();
+			mOriginZ[i] = inOrigins[src].GetZ();
+			mInvDirectionX[i] = inDirections[src].GetX();
+			mInvDirectionY[i] = inDirections[src].GetY();
+			mInvDirectionZ[i] = inDirections[src].GetZ();
+			mIsValid[i] = i < inNumRays? 0xffffffff : 0;
+		}
+
+		// if (abs(direction) <= Epsilon) the ray is nearly parallel to the slab.
+		Vec4 epsilon = Vec4::sReplicate(1.0e-20f);
+		mIsParallelX = Vec4::sLessOrEqual(mInvDirectionX.Abs(), epsilon);
+		mIsParallelY = Vec4::sLessOrEqual(mInvDirectionY.Abs(), epsilon);
+		mIsParallelZ = Vec4::sLessOrEqual(mInvDirectionZ.Abs(), epsilon);
+
+		// Calculate 1 / direction while avoiding division by zero
+		Vec4 one = Vec4::sReplicate(1.0f);
+		mInvDirectionX = Vec4::sSelect(mInvDirectionX, one, mIsParallelX).Reciprocal();
+		mInvDirectionY = Vec4::sSelect(mInvDirectionY, one, mIsParallelY).Reciprocal();
+		mInvDirectionZ = Vec4::sSelect(mInvDirectionZ, one, mIsParallelZ).Reciprocal();
+	}
+
+	Vec4					mOriginX;						///< Origin of the rays
+	Vec4					mOriginY;
+	Vec4					mOriginZ;
+	Vec4					mInvDirectionX;					///< 1 / ray direction
+	Vec4					mInvDirectionY;
+	Vec4					mInvDirectionZ;
+	UVec4					mIsParallelX;					///< For each ray if it is parallel to the coordinate axis
+	UVec4					mIsParallelY;
+	UVec4					mIsParallelZ;
+	UVec4					mIsValid;						///< For each ray if it is in use
+};
+
+/// Intersect AABB with a packet of 4 rays, returns for each ray the minimal distance along the ray or FLT_MAX if no hit
+/// Note: Can return negative values if a ray starts in the box
+JPH_INLINE Vec4 RayPacket4AABox(const RayPacket4 &inRays, Vec3Arg inBoundsMin, Vec3Arg inBoundsMax)
+{
+	// Constants
+	Vec4 flt_min = Vec4::sReplicate(-FLT_MAX);
+	Vec4 flt_max = Vec4::sReplicate(FLT_MAX);
+
+	// if bounds are invalid return FLOAT_MAX;
+	if (Vec3::sGreater(inBoundsMin, inBoundsMax).TestAnyXYZTrue())
+		return flt_max;
+
+	// Bounds
+	Vec4 bounds_minx = inBoundsMin.SplatX();
+	Vec4 bounds_miny = inBoundsMin.SplatY();
+	Vec4 bounds_minz = inBoundsMin.SplatZ();
+	Vec4 bounds_maxx = inBoundsMax.SplatX();
+	Vec4 bounds_maxy = inBoundsMax.SplatY();
+	Vec4 bounds_maxz = inBoundsMax.SplatZ();
+
+	// Test against all three axii simultaneously.
+	Vec4 t1x = (bounds_minx - inRays.mOriginX) * inRays.mInvDirectionX;
+	Vec4 t1y = (bounds_miny - inRays.mOriginY) * inRays.mInvDirectionY;
+	Vec4 t1z = (bounds_minz - inRays.mOriginZ) * inRays.mInvDirectionZ;
+	Vec4 t2x = (bounds_maxx - inRays.mOriginX) * inRays.mInvDirectionX;
+	Vec4 t2y = (bounds_maxy - inRays.mOriginY) * inRays.mInvDirectionY;
+	Vec4 t2z = (bounds_maxz - inRays.mOriginZ) * inRays.mInvDirectionZ;
+
+	// Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
+	// use the results from any directions parallel to the slab.
+	Vec4 t_minx = Vec4::sSelect(Vec4::sMin(t1x, t2x), flt_min, inRays.mIsParallelX);
+	Vec4 t_miny = Vec4::sSelect(Vec4::sMin(t1y, t2y), flt_min, inRays.mIsParallelY);
+	Vec4 t_minz = Vec4::sSelect(Vec4::sMin(t1z, t2z), flt_min, inRays.mIsParallelZ);
+	Vec4 t_maxx = Vec4::sSelect(Vec4::sMax(t1x, t2x), flt_max, inRays.mIsParallelX);
+	Vec4 t_maxy = Vec4::sSelect(Vec4::sMax(t1y, t2y), flt_max, inRays.mIsParallelY);
+	Vec4 t_maxz = Vec4::sSelect(Vec4::sMax(t1z, t2z), flt_max, inRays.mIsParallelZ);
+
+	// t_min = maximum(t_minx, t_miny, t_minz);
+	Vec4 t_min = Vec4::sMax(Vec4::sMax(t_minx, t_miny), t_minz);
+
+	// t_max = minimum(t_maxx, t_maxy, t_maxz);
+	Vec4 t_max = Vec4::sMin(Vec4::sMin(t_maxx, t_maxy), t_maxz);
+
+	// if (t_min > t_max) return FLT_MAX;
+	UVec4 no_intersection = Vec4::sGreater(t_min, t_max);
+
+	// if (t_max < 0.0f) return FLT_MAX;
+	no_intersection = UVec4::sOr(no_intersection, Vec4::sLess(t_max, Vec4::sZero()));
+
+	// if (mIsParallel && !(Min <= origin && origin <= Max)) return FLT_MAX; else return t_min;
+	UVec4 no_parallel_overlapx = UVec4::sAnd(inRays.mIsParallelX, UVec4::sOr(Vec4::sLess(inRays.mOriginX, bounds_minx), Vec4::sGreater(inRays.mOriginX, bounds_maxx)));
+	UVec4 no_parallel_overlapy = UVec4::sAnd(inRays.mIsParallelY, UVec4::sOr(Vec4::sLess(inRays.mOriginY, bounds_miny), Vec4::sGreater(inRays.mOriginY, bounds_maxy)));
+	UVec4 no_parallel_overlapz = UVec4::sAnd(inRays.mIsParallelZ, UVec4::sOr(Vec4::sLess(inRays.mOriginZ, bounds_minz), Vec4::sGreater(inRays.mOriginZ, bounds_maxz)));
+	no_intersection = UVec4::sOr(no_intersection, UVec4::sOr(UVec4::sOr(no_parallel_overlapx, no_parallel_overlapy), no_parallel_overlapz));
+
+	// Rays that are not in use never hit
+	no_intersection = UVec4::sOr(no_intersection, UVec4::sNot(inRays.mIsValid));
+	return Vec4::sSelect(t_min, flt_max, no_intersection);
+}
+
+/// Intersect 4 AABBs with a packet of 4 rays, outFractions[i] receives for box i the distances along the 4 rays (see RayPacket4AABox)
+JPH_INLINE void RayPacket4AABox4(const RayPacket4 &inRays, Vec4Arg inBoundsMinX, Vec4Arg inBoundsMinY, Vec4Arg inBoundsMinZ, Vec4Arg inBoundsMaxX, Vec4Arg inBoundsMaxY, Vec4Arg inBoundsMaxZ, Vec4 *outFractions)
+{
+	// Transpose so that each column contains the bounds of a single box
+	Mat44 bounds_min = Mat44(inBoundsMinX, inBoundsMinY, inBoundsMinZ, Vec4::sZero()).Transposed();
+	Mat44 bounds_max = Mat44(inBoundsMaxX, inBoundsMaxY, inBoundsMaxZ, Vec4::sZero()).Transposed();
+
+	for (int i = 0; i < 4; ++i)
+		outFractions[i] = RayPacket4AABox(inRays, bounds_min.GetColumn3(i), bounds_max.GetColumn3(i));
+}
+
+JPH_NAMESPACE_END
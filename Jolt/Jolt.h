@@ -6,6 +6,8 @@
 // Project includes
 #include <Jolt/Core/Core.h>
 #include <Jolt/Core/IssueReporting.h>
+#include <Jolt/Core/Memory.h>
+#include <Jolt/Core/STLAllocator.h>
 #include <Jolt/Math/Math.h>
 #include <Jolt/Math/Vec4.h>
 #include <Jolt/Math/Mat44.h>
@@ -232,6 +232,9 @@ public:
 	/// Get vector that contains the sign of each element (returns 1.0f if positive, -1.0f if negative)
 	JPH_INLINE Vec4				GetSign() const;
 
+	/// Calculate the sine and cosine for each element of this vector (input in radians)
+	inline void					SinCos(Vec4 &outSin, Vec4 &outCos) const;
+
 	/// To String
 	friend ostream &			operator << (ostream &inStream, Vec4Arg inV)
 	{
@@ -32,8 +32,8 @@ const RTTI *GetPrimitiveTypeOfType(RefConst<T> *)
 	return GetRTTIOfType((T *)nullptr);
 }
 
-template <class T>				
-const RTTI *GetPrimitiveTypeOfType(vector<T> *)
+template <class T, class A>
+const RTTI *GetPrimitiveTypeOfType(vector<T, A> *)
 { 
 	return GetPrimitiveTypeOfType((T *)nullptr);
 }
@@ -14,6 +14,8 @@ JPH_NAMESPACE_BEGIN
 class ObjectStream
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	/// Stream type
 	enum class EStreamType
 	{
@@ -109,8 +111,8 @@ public:
 #include <Jolt/ObjectStream/ObjectStreamTypes.h>
 
 // Define serialization templates
-template <class T>
-bool OSIsType(vector<T> *, int inArrayDepth, EOSDataType inDataType, const char *inClassName)	
+template <class T, class A>
+bool OSIsType(vector<T, A> *, int inArrayDepth, EOSDataType inDataType, const char *inClassName)	
 { 
 	return (inArrayDepth > 0 && OSIsType((T *)nullptr, inArrayDepth - 1, inDataType, inClassName)); 
 }
@@ -140,8 +142,8 @@ bool OSIsType(RefConst<T> *, int inArrayDepth, EOSDataType inDataType, const cha
 }
 
 /// Define serialization templates for dynamic arrays
-template <class T>
-bool OSReadData(IObjectStreamIn &ioStream, vector<T> &inArray)
+template <class T, class A>
+bool OSReadData(IObjectStreamIn &ioStream, vector<T, A> &inArray)
 {
 	bool continue_reading = true;
 
@@ -218,15 +220,15 @@ bool OSReadData(IObjectStreamIn &ioStream, RefConst<T> &inRef)
 }
 
 // Define serialization templates for dynamic arrays
-template <class T>
-void OSWriteDataType(IObjectStreamOut &ioStream, vector<T> *)		
+template <class T, class A>
+void OSWriteDataType(IObjectStreamOut &ioStream, vector<T, A> *)		
 { 
 	ioStream.WriteDataType(EOSDataType::Array); 
 	OSWriteDataType(ioStream, (T *)nullptr); 
 }
 
-template <class T>
-void OSWriteData(IObjectStreamOut &ioStream, const vector<T> &inArray)
+template <class T, class A>
+void OSWriteData(IObjectStreamOut &ioStream, const vector<T, A> &inArray)
 {
 	// Write size of array
 	ioStream.HintNextItem();
@@ -79,7 +79,7 @@ ObjectStreamIn *ObjectStreamIn::Open(istream &inStream)
 
 void *ObjectStreamIn::Read(const RTTI *inRTTI)
 {
-	using ObjectSet = unordered_set<void *>;
+	using ObjectSet = TaggedUnorderedSet<void *>;
 
 	// Read all information on the stream
 	void *main_object = nullptr;
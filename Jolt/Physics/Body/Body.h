@@ -269,6 +269,7 @@ public:
 
 private:
 	friend class BodyManager;
+	friend class BodyStateSoA;
 
 	explicit				Body(bool);														///< Alternative constructor that initializes all members
 
@@ -85,6 +85,11 @@ BodyInterface::AddState BodyInterface::AddBodiesPrepare(BodyID *ioBodies, int in
 	return mBroadPhase->AddBodiesPrepare(ioBodies, inNumber);
 }
 
+BodyInterface::AddState BodyInterface::AddBodiesPrepare(BodyID *ioBodies, int inNumber, const BroadPhaseTreeLayout &inLayout)
+{
+	return mBroadPhase->AddBodiesPrepareFromLayout(ioBodies, inNumber, inLayout);
+}
+
 void BodyInterface::AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState, EActivation inActivationMode)
 {
 	BodyLockMultiWrite lock(*mBodyLockInterface, ioBodies, inNumber);
@@ -15,6 +15,7 @@ class Body;
 class BodyCreationSettings;
 class BodyLockInterface;
 class BroadPhase;
+class BroadPhaseTreeLayout;
 class BodyManager;
 class TransformedShape;
 class PhysicsMaterial;
@@ -64,6 +65,7 @@ public:
 	/// Note that ioBodies array must be kept constant while the add is in progress.
 	///@{
 	AddState					AddBodiesPrepare(BodyID *ioBodies, int inNumber);
+	AddState					AddBodiesPrepare(BodyID *ioBodies, int inNumber, const BroadPhaseTreeLayout &inLayout);
 	void						AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState, EActivation inActivationMode);
 	void						AddBodiesAbort(BodyID *ioBodies, int inNumber, AddState inAddState);
 	void						RemoveBodies(BodyID *ioBodies, int inNumber);
@@ -10,6 +10,9 @@
 #include <Jolt/Physics/Body/BodyActivationListener.h>
 #include <Jolt/Physics/StateRecorder.h>
 #include <Jolt/Core/StringTools.h>
+#include <Jolt/Core/Memory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Geometry/MortonCode.h>
 #ifdef JPH_DEBUG_RENDERER
 	#include <Jolt/Renderer/DebugRenderer.h>
 #endif // JPH_DEBUG_RENDERER
@@ -21,22 +24,43 @@ JPH_NAMESPACE_BEGIN
 	thread_local bool BodyManager::sOverrideAllowDeactivation = false;
 #endif
 
-// Helper class that combines a body and its motion properties
-class BodyWithMotionProperties : public Body
+Body *BodyManager::GetBodyStorage(uint32 inBodyIndex)
 {
-public:
-	MotionProperties		mMotionProperties;
-};
+	Body *&page = mBodyPages[inBodyIndex >> cBodyPageShift];
+	if (page == nullptr)
+		page = reinterpret_cast<Body *>(AlignedAlloc(cBodiesPerPage * sizeof(Body), JPH_CACHE_LINE_SIZE, EMemoryTag::Bodies));
+	return page + (inBodyIndex & (cBodiesPerPage - 1));
+}
 
-inline void BodyManager::sDeleteBody(Body *inBody)
+MotionProperties *BodyManager::AllocateMotionProperties(uint32 inBodyIndex)
 {
-	if (inBody->mMotionProperties != nullptr)
+	// Reuse a freed entry or take the next unused entry
+	uint32 idx;
+	if (!mFreeMotionProperties.empty())
 	{
-		JPH_IF_ENABLE_ASSERTS(inBody->mMotionProperties = nullptr;)
-		delete static_cast<BodyWithMotionProperties *>(inBody);
+		idx = mFreeMotionProperties.back();
+		mFreeMotionProperties.pop_back();
 	}
 	else
-		delete inBody;
+		idx = mNumMotionPropertiesUsed++;
+	mBodyMotionPropertiesIndex[inBodyIndex] = idx;
+
+	MotionProperties *&page = mMotionPropertiesPages[idx >> cBodyPageShift];
+	if (page == nullptr)
+		page = reinterpret_cast<MotionProperties *>(AlignedAlloc(cBodiesPerPage * sizeof(MotionProperties), JPH_CACHE_LINE_SIZE, EMemoryTag::Bodies));
+	return page + (idx & (cBodiesPerPage - 1));
+}
+
+void BodyManager::DeleteBody(Body *inBody)
+{
+	if (inBody->mMotionProperties != nullptr)
+	{
+		inBody->mMotionProperties->~MotionProperties();
+		inBody->mMotionProperties = nullptr;
+		mFreeMotionProperties.push_back(mBodyMotionPropertiesIndex[inBody->GetID().GetIndex()]);
+	}
+
+	inBody->~Body();
 }
 
 BodyManager::~BodyManager()
@@ -46,9 +70,20 @@ BodyManager::~BodyManager()
 	// Destroy any bodies that are still alive
 	for (Body *b : mBodies)
 		if (sIsValidBodyPointer(b))
-			sDeleteBody(b);
+			DeleteBody(b);
 
-	delete [] mActiveBodies;
+	// Free the storage
+	for (uint page = 0; page < mNumPages; ++page)
+	{
+		if (mBodyPages[page] != nullptr)
+			AlignedFree(mBodyPages[page], cBodiesPerPage * sizeof(Body), EMemoryTag::Bodies);
+		if (mMotionPropertiesPages[page] != nullptr)
+			AlignedFree(mMotionPropertiesPages[page], cBodiesPerPage * sizeof(MotionProperties), EMemoryTag::Bodies);
+	}
+	Free(mBodyPages, mNumPages * sizeof(Body *), EMemoryTag::Bodies);
+	Free(mMotionPropertiesPages, mNumPages * sizeof(MotionProperties *), EMemoryTag::Bodies);
+
+	Free(mActiveBodies, GetMaxBodies() * sizeof(BodyID), EMemoryTag::Bodies);
 }
 
 void BodyManager::Init(uint inMaxBodies, uint inNumBodyMutexes, const BroadPhaseLayerInterface &inLayerInterface)
@@ -64,9 +99,21 @@ void BodyManager::Init(uint inMaxBodies, uint inNumBodyMutexes, const BroadPhase
 	// Allocate space for bodies
 	mBodies.reserve(inMaxBodies);
 
-	// Allocate space for active bodies
+	// Allocate the page tables for the body storage, the pages themselves are allocated when needed
+	JPH_ASSERT(mBodyPages == nullptr);
+	mNumPages = (inMaxBodies + cBodiesPerPage - 1) >> cBodyPageShift;
+	mBodyPages = static_cast<Body **>(Allocate(mNumPages * sizeof(Body *), EMemoryTag::Bodies));
+	mMotionPropertiesPages = static_cast<MotionProperties **>(Allocate(mNumPages * sizeof(MotionProperties *), EMemoryTag::Bodies));
+	for (uint page = 0; page < mNumPages; ++page)
+	{
+		mBodyPages[page] = nullptr;
+		mMotionPropertiesPages[page] = nullptr;
+	}
+	mBodyMotionPropertiesIndex.resize(inMaxBodies);
+
+	// Allocate space for active bodies (mBodies may have reserved more than inMaxBodies, GetMaxBodies is the limit that is used when activating bodies)
 	JPH_ASSERT(mActiveBodies == nullptr);
-	mActiveBodies = new BodyID [inMaxBodies];
+	mActiveBodies = static_cast<BodyID *>(Allocate(GetMaxBodies() * sizeof(BodyID), EMemoryTag::Bodies));
 
 	// Allocate space for sequence numbers
 	mBodySequenceNumbers.resize(inMaxBodies);
@@ -120,6 +167,8 @@ Body *BodyManager::CreateBody(const BodyCreationSettings &inBodyCreationSettings
 {
 	// Determine next free index
 	uint32 idx;
+	Body *body_storage;
+	MotionProperties *motion_properties_storage = nullptr;
 	{
 		UniqueLock lock(mBodiesMutex, EPhysicsLockTypes::BodiesList);
 
@@ -148,23 +197,20 @@ Body *BodyManager::CreateBody(const BodyCreationSettings &inBodyCreationSettings
 
 		// Update cached number of bodies
 		mNumBodies++;
+
+		// Get storage for the body
+		body_storage = GetBodyStorage(idx);
+		if (inBodyCreationSettings.HasMassProperties())
+			motion_properties_storage = AllocateMotionProperties(idx);
 	}
 
 	// Get next sequence number
 	uint8 seq_no = GetNextSequenceNumber(idx);
 
 	// Fill in basic properties
-	Body *body;
-	if (inBodyCreationSettings.HasMassProperties())
-	{
-		BodyWithMotionProperties *bmp = new BodyWithMotionProperties;
-		body = bmp;
-		body->mMotionProperties = &bmp->mMotionProperties;
-	}
-	else
-	{
-	 	body = new Body;
-	}
+	Body *body = new (body_storage) Body;
+	if (motion_properties_storage != nullptr)
+		body->mMotionProperties = new (motion_properties_storage) MotionProperties;
 	body->mID = BodyID(idx, seq_no);
 	body->mShape = inBodyCreationSettings.GetShape();
 	body->mUserData = inBodyCreationSettings.mUserData;
@@ -232,7 +278,7 @@ void BodyManager::DestroyBodies(const BodyID *inBodyIDs, int inNumber)
 		mBodyIDFreeListStart = (uintptr_t(idx) << cFreedBodyIndexShift) | cIsFreedBody;
 
 		// Free the body
-		sDeleteBody(body);
+		DeleteBody(body);
 	}
 
 #if defined(_DEBUG) && defined(JPH_ENABLE_ASSERTS)
@@ -354,6 +400,43 @@ void BodyManager::GetActiveBodies(BodyIDVector &outBodyIDs) const
 	outBodyIDs.assign(mActiveBodies, mActiveBodies + mNumActiveBodies);
 }
 
+void BodyManager::SortActiveBodiesSpatially(TempAllocator *inTempAllocator)
+{
+	JPH_PROFILE_FUNCTION();
+
+	UniqueLock lock(mActiveBodiesMutex, EPhysicsLockTypes::ActiveBodiesList);
+
+	uint32 num_active_bodies = mNumActiveBodies;
+	if (num_active_bodies < 2)
+		return;
+
+	// Calculate the bounds of the centers of all active bodies
+	AABox centers;
+	for (const BodyID *id = mActiveBodies, *id_end = mActiveBodies + num_active_bodies; id < id_end; ++id)
+		centers.Encapsulate(mBodies[id->GetIndex()]->GetWorldSpaceBounds().GetCenter());
+	centers.EnsureMinimalEdgeLength(1.0e-3f);
+
+	// Sort on Morton code, ties are broken by body index so that the order is deterministic
+	uint64 *keys = (uint64 *)inTempAllocator->Allocate(num_active_bodies * sizeof(uint64));
+	for (uint32 i = 0; i < num_active_bodies; ++i)
+	{
+		const BodyID &id = mActiveBodies[i];
+		uint32 code = MortonCode::sGetMortonCode(mBodies[id.GetIndex()]->GetWorldSpaceBounds().GetCenter(), centers);
+		keys[i] = (uint64(code) << 32) | id.GetIndex();
+	}
+	sort(keys, keys + num_active_bodies);
+
+	// Rebuild the active body list
+	for (uint32 i = 0; i < num_active_bodies; ++i)
+	{
+		Body *body = mBodies[uint32(keys[i])];
+		mActiveBodies[i] = body->GetID();
+		body->mMotionProperties->mIndexInActiveBodies = i;
+	}
+
+	inTempAllocator->Free(keys, num_active_bodies * sizeof(uint64));
+}
+
 void BodyManager::GetBodyIDs(BodyIDVector &outBodies) const
 {
 	JPH_PROFILE_FUNCTION();
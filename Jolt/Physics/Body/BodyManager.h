@@ -6,6 +6,7 @@
 #include <Jolt/Physics/Body/Body.h>
 #include <Jolt/Core/Mutex.h>
 #include <Jolt/Core/MutexArray.h>
+#include <Jolt/Core/STLAllocator.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -13,15 +14,16 @@ JPH_NAMESPACE_BEGIN
 class BodyCreationSettings;
 class BodyActivationListener;
 struct PhysicsSettings;
+class TempAllocator;
 #ifdef JPH_DEBUG_RENDERER
 class DebugRenderer;
 #endif // JPH_DEBUG_RENDERER
 
 /// Array of bodies
-using BodyVector = vector<Body *>;
+using BodyVector = TaggedVector<Body *, EMemoryTag::Bodies>;
 
 /// Array of body ID's
-using BodyIDVector = vector<BodyID>;
+using BodyIDVector = TaggedVector<BodyID, EMemoryTag::Bodies>;
 
 /// Class that contains all bodies
 class BodyManager : public NonCopyable
@@ -82,6 +84,11 @@ public:
 	/// Get the number of active bodies.
 	uint32							GetNumActiveBodies() const					{ return mNumActiveBodies; }
 
+	/// Reorder the active bodies along a Morton curve through the centers of their world space bounds, so that bodies that are
+	/// close to each other in the active body list are also close to each other in space (see PhysicsSettings::mSortActiveBodiesInterval).
+	/// This function should only be called when an exclusive lock for the bodies are held and no physics update is running.
+	void							SortActiveBodiesSpatially(TempAllocator *inTempAllocator);
+
 	/// Get the number of active bodies that are using continuous collision detection
 	uint32							GetNumActiveCCDBodies() const				{ return mNumActiveCCDBodies; }
 
@@ -219,8 +226,38 @@ private:
 #endif
 	inline uint8					GetNextSequenceNumber(int inBodyIndex)		{ return ++mBodySequenceNumbers[inBodyIndex]; }
 
-	/// Helper function to delete a body (which could actually be a BodyWithMotionProperties)
-	inline static void				sDeleteBody(Body *inBody);
+	/// Get the storage for the body with index inBodyIndex, allocates a new page if needed (mBodiesMutex must be locked)
+	inline Body *					GetBodyStorage(uint32 inBodyIndex);
+
+	/// Get storage for the motion properties of the body with index inBodyIndex, allocates a new page if needed (mBodiesMutex must be locked)
+	inline MotionProperties *		AllocateMotionProperties(uint32 inBodyIndex);
+
+	/// Helper function to destruct a body and return its motion properties to the pool (mBodiesMutex must be locked)
+	inline void						DeleteBody(Body *inBody);
+
+	/// Bodies are stored in pages of cBodiesPerPage bodies, the body with index i is stored in entry i.
+	/// Pages are aligned to cache lines so that the hot data at the start of a Body (position, rotation and bounds) is exactly one cache line.
+	static constexpr uint			cBodyPageShift = 8;
+	static constexpr uint			cBodiesPerPage = 1 << cBodyPageShift;
+	static_assert(sizeof(Body) % JPH_CACHE_LINE_SIZE == 0, "Bodies should not straddle cache lines");
+
+	/// Number of entries in mBodyPages and mMotionPropertiesPages
+	uint							mNumPages = 0;
+
+	/// Pages of storage for the bodies, allocated on demand and only freed when the BodyManager is destroyed
+	Body **							mBodyPages = nullptr;
+
+	/// Pages of storage for the motion properties (only dynamic and kinematic bodies have motion properties), allocated on demand and only freed when the BodyManager is destroyed
+	MotionProperties **				mMotionPropertiesPages = nullptr;
+
+	/// Number of entries in mMotionPropertiesPages that have been handed out (including the ones that were returned to mFreeMotionProperties)
+	uint32							mNumMotionPropertiesUsed = 0;
+
+	/// Entries in mMotionPropertiesPages that can be reused
+	TaggedVector<uint32, EMemoryTag::Bodies> mFreeMotionProperties;
+
+	/// For each body index the entry in mMotionPropertiesPages that holds its motion properties
+	TaggedVector<uint32, EMemoryTag::Bodies> mBodyMotionPropertiesIndex;
 
 	/// List of pointers to all bodies. Contains invalid pointers for deleted bodies, check with sIsValidBodyPointer. Note that this array is reserved to the max bodies that is passed in the Init function so that adding bodies will not reallocate the array.
 	BodyVector						mBodies;
@@ -240,7 +277,7 @@ private:
 	/// Index of first entry in mBodies that is unused
 	uintptr_t						mBodyIDFreeListStart = cBodyIDFreeListEnd;
 
-	/// Protects mBodies array (but not the bodies it points to), mNumBodies and mBodyIDFreeListStart
+	/// Protects mBodies array (but not the bodies it points to), mNumBodies, mBodyIDFreeListStart and the body / motion properties storage
 	mutable Mutex					mBodiesMutex; 
 
 	/// An array of mutexes protecting the bodies in the mBodies array
@@ -248,7 +285,7 @@ private:
 	mutable BodyMutexes				mBodyMutexes;
 
 	/// List of next sequence number for a body ID
-	vector<uint8>					mBodySequenceNumbers;
+	TaggedVector<uint8, EMemoryTag::Bodies> mBodySequenceNumbers;
 
 	/// Mutex that protects the mActiveBodies array
 	mutable Mutex					mActiveBodiesMutex;
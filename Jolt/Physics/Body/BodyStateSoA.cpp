@@ -0,0 +1,243 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Physics/Body/BodyStateSoA.h>
+#include <Jolt/Physics/Body/Body.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Helper functions that operate on 4 lanes of a Vec3SoA / QuatSoA
+static JPH_INLINE Vec4 sLoad4(const float *inValues)
+{
+	return Vec4::sLoadFloat4Aligned(reinterpret_cast<const Float4 *>(inValues));
+}
+
+static JPH_INLINE void sStore4(Vec4Arg inValue, float *outValues)
+{
+	inValue.StoreFloat4(reinterpret_cast<Float4 *>(outValues));
+}
+
+/// Rotate vector (inX, inY, inZ) by quaternion (inQX, inQY, inQZ, inQW) for 4 lanes: v' = v + 2 w (q x v) + 2 q x (q x v)
+static JPH_INLINE void sRotate(Vec4Arg inQX, Vec4Arg inQY, Vec4Arg inQZ, Vec4Arg inQW, Vec4 &ioX, Vec4 &ioY, Vec4 &ioZ)
+{
+	Vec4 tx = 2.0f * (inQY * ioZ - inQZ * ioY);
+	Vec4 ty = 2.0f * (inQZ * ioX - inQX * ioZ);
+	Vec4 tz = 2.0f * (inQX * ioY - inQY * ioX);
+	ioX += inQW * tx + (inQY * tz - inQZ * ty);
+	ioY += inQW * ty + (inQZ * tx - inQX * tz);
+	ioZ += inQW * tz + (inQX * ty - inQY * tx);
+}
+
+/// Clamp the length of vector (ioX, ioY, ioZ) to inMaxLength for the lanes in inClamp
+static JPH_INLINE void sClampLength(Vec4 &ioX, Vec4 &ioY, Vec4 &ioZ, Vec4Arg inMaxLength, UVec4Arg inClamp)
+{
+	Vec4 len_sq = ioX * ioX + ioY * ioY + ioZ * ioZ;
+	UVec4 clamp = UVec4::sAnd(Vec4::sGreater(len_sq, inMaxLength * inMaxLength), inClamp);
+
+	// Avoid dividing by zero for the lanes that are not clamped
+	Vec4 scale = inMaxLength / Vec4::sSelect(Vec4::sReplicate(1.0f), len_sq.Sqrt(), clamp);
+	ioX = Vec4::sSelect(ioX, ioX * scale, clamp);
+	ioY = Vec4::sSelect(ioY, ioY * scale, clamp);
+	ioZ = Vec4::sSelect(ioZ, ioZ * scale, clamp);
+}
+
+void BodyStateSoA::GatherVelocities(Body *const *inBodies, int inNumBodies)
+{
+	JPH_ASSERT(inNumBodies <= cMaxBodies);
+
+	mNumLanes = (inNumBodies + 3) & ~3;
+
+	for (int i = 0; i < inNumBodies; ++i)
+	{
+		const Body *body = inBodies[i];
+		const MotionProperties *mp = body->mMotionProperties;
+		mLinearVelocity.Set(i, mp->mLinearVelocity);
+		mAngularVelocity.Set(i, mp->mAngularVelocity);
+		mMaxLinearVelocity[i] = mp->mMaxLinearVelocity;
+		mMaxAngularVelocity[i] = mp->mMaxAngularVelocity;
+		mClampVelocity[i] = body->IsDynamic()? 0xffffffff : 0;
+	}
+
+	for (int i = inNumBodies; i < mNumLanes; ++i)
+	{
+		mLinearVelocity.Set(i, Vec3::sZero());
+		mAngularVelocity.Set(i, Vec3::sZero());
+		mMaxLinearVelocity[i] = 0.0f;
+		mMaxAngularVelocity[i] = 0.0f;
+		mClampVelocity[i] = 0;
+	}
+}
+
+void BodyStateSoA::ClampVelocities()
+{
+	for (int i = 0; i < mNumLanes; i += 4)
+	{
+		UVec4 clamp = UVec4::sLoadInt4Aligned(mClampVelocity + i);
+
+		Vec4 vx = sLoad4(mLinearVelocity.mX + i), vy = sLoad4(mLinearVelocity.mY + i), vz = sLoad4(mLinearVelocity.mZ + i);
+		sClampLength(vx, vy, vz, sLoad4(mMaxLinearVelocity + i), clamp);
+		sStore4(vx, mLinearVelocity.mX + i); sStore4(vy, mLinearVelocity.mY + i); sStore4(vz, mLinearVelocity.mZ + i);
+
+		Vec4 wx = sLoad4(mAngularVelocity.mX + i), wy = sLoad4(mAngularVelocity.mY + i), wz = sLoad4(mAngularVelocity.mZ + i);
+		sClampLength(wx, wy, wz, sLoad4(mMaxAngularVelocity + i), clamp);
+		sStore4(wx, mAngularVelocity.mX + i); sStore4(wy, mAngularVelocity.mY + i); sStore4(wz, mAngularVelocity.mZ + i);
+	}
+}
+
+void BodyStateSoA::ScatterVelocities(Body *const *ioBodies, int inNumBodies) const
+{
+	for (int i = 0; i < inNumBodies; ++i)
+	{
+		MotionProperties *mp = ioBodies[i]->mMotionProperties;
+		mp->mLinearVelocity = mLinearVelocity.Get(i);
+		mp->mAngularVelocity = mAngularVelocity.Get(i);
+		JPH_ASSERT(!mp->mLinearVelocity.IsNaN());
+		JPH_ASSERT(!mp->mAngularVelocity.IsNaN());
+	}
+}
+
+void BodyStateSoA::sApplyForceTorqueAndDrag(Body *const *ioBodies, int inNumBodies, Vec3Arg inGravity, float inDeltaTime)
+{
+	BodyStateSoA state;
+
+	// Gather the state of the bodies
+	state.GatherVelocities(ioBodies, inNumBodies);
+	for (int i = 0; i < inNumBodies; ++i)
+	{
+		const Body *body = ioBodies[i];
+		JPH_ASSERT(body->IsDynamic());
+		const MotionProperties *mp = body->mMotionProperties;
+		state.mRotation.Set(i, body->mRotation);
+		state.mInvMass[i] = mp->mInvMass;
+		state.mInvInertiaDiagonal.Set(i, mp->mInvInertiaDiagonal);
+		state.mInertiaRotation.Set(i, mp->mInertiaRotation);
+		state.mForce.Set(i, Vec3::sLoadFloat3Unsafe(mp->mForce));
+		state.mTorque.Set(i, Vec3::sLoadFloat3Unsafe(mp->mTorque));
+		state.mLinearDamping[i] = mp->mLinearDamping;
+		state.mAngularDamping[i] = mp->mAngularDamping;
+		state.mGravityFactor[i] = mp->mGravityFactor;
+	}
+	for (int i = inNumBodies; i < state.mNumLanes; ++i)
+	{
+		state.mRotation.Set(i, Quat::sIdentity());
+		state.mInvMass[i] = 0.0f;
+		state.mInvInertiaDiagonal.Set(i, Vec3::sZero());
+		state.mInertiaRotation.Set(i, Quat::sIdentity());
+		state.mForce.Set(i, Vec3::sZero());
+		state.mTorque.Set(i, Vec3::sZero());
+		state.mLinearDamping[i] = 0.0f;
+		state.mAngularDamping[i] = 0.0f;
+		state.mGravityFactor[i] = 0.0f;
+	}
+
+	Vec4 gravity_x = Vec4::sReplicate(inGravity.GetX()), gravity_y = Vec4::sReplicate(inGravity.GetY()), gravity_z = Vec4::sReplicate(inGravity.GetZ());
+	Vec4 delta_time = Vec4::sReplicate(inDeltaTime);
+
+	for (int i = 0; i < state.mNumLanes; i += 4)
+	{
+		// Update linear velocity
+		Vec4 gravity_factor = sLoad4(state.mGravityFactor + i);
+		Vec4 inv_mass = sLoad4(state.mInvMass + i);
+		Vec4 vx = sLoad4(state.mLinearVelocity.mX + i) + delta_time * (gravity_factor * gravity_x + inv_mass * sLoad4(state.mForce.mX + i));
+		Vec4 vy = sLoad4(state.mLinearVelocity.mY + i) + delta_time * (gravity_factor * gravity_y + inv_mass * sLoad4(state.mForce.mY + i));
+		Vec4 vz = sLoad4(state.mLinearVelocity.mZ + i) + delta_time * (gravity_factor * gravity_z + inv_mass * sLoad4(state.mForce.mZ + i));
+
+		// Calculate rotation that takes the inverse inertia diagonal to world space: q = body rotation * inertia rotation
+		Vec4 bx = sLoad4(state.mRotation.mX + i), by = sLoad4(state.mRotation.mY + i), bz = sLoad4(state.mRotation.mZ + i), bw = sLoad4(state.mRotation.mW + i);
+		Vec4 ix = sLoad4(state.mInertiaRotation.mX + i), iy = sLoad4(state.mInertiaRotation.mY + i), iz = sLoad4(state.mInertiaRotation.mZ + i), iw = sLoad4(state.mInertiaRotation.mW + i);
+		Vec4 qx = bw * ix + bx * iw + by * iz - bz * iy;
+		Vec4 qy = bw * iy - bx * iz + by * iw + bz * ix;
+		Vec4 qz = bw * iz + bx * iy - by * ix + bz * iw;
+		Vec4 qw = bw * iw - bx * ix - by * iy - bz * iz;
+
+		// Multiply torque with world space inverse inertia: q * D * q^-1 * torque
+		Vec4 tx = sLoad4(state.mTorque.mX + i), ty = sLoad4(state.mTorque.mY + i), tz = sLoad4(state.mTorque.mZ + i);
+		sRotate(-qx, -qy, -qz, qw, tx, ty, tz);
+		tx *= sLoad4(state.mInvInertiaDiagonal.mX + i);
+		ty *= sLoad4(state.mInvInertiaDiagonal.mY + i);
+		tz *= sLoad4(state.mInvInertiaDiagonal.mZ + i);
+		sRotate(qx, qy, qz, qw, tx, ty, tz);
+
+		// Update angular velocity
+		Vec4 wx = sLoad4(state.mAngularVelocity.mX + i) + delta_time * tx;
+		Vec4 wy = sLoad4(state.mAngularVelocity.mY + i) + delta_time * ty;
+		Vec4 wz = sLoad4(state.mAngularVelocity.mZ + i) + delta_time * tz;
+
+		// Linear and angular damping (see MotionProperties::ApplyForceTorqueAndDragInternal)
+		Vec4 linear_damping = Vec4::sMax(Vec4::sZero(), Vec4::sReplicate(1.0f) - sLoad4(state.mLinearDamping + i) * delta_time);
+		Vec4 angular_damping = Vec4::sMax(Vec4::sZero(), Vec4::sReplicate(1.0f) - sLoad4(state.mAngularDamping + i) * delta_time);
+		sStore4(vx * linear_damping, state.mLinearVelocity.mX + i);
+		sStore4(vy * linear_damping, state.mLinearVelocity.mY + i);
+		sStore4(vz * linear_damping, state.mLinearVelocity.mZ + i);
+		sStore4(wx * angular_damping, state.mAngularVelocity.mX + i);
+		sStore4(wy * angular_damping, state.mAngularVelocity.mY + i);
+		sStore4(wz * angular_damping, state.mAngularVelocity.mZ + i);
+	}
+
+	state.ClampVelocities();
+
+	state.ScatterVelocities(ioBodies, inNumBodies);
+}
+
+void BodyStateSoA::sClampVelocitiesAndIntegrateRotation(Body *const *ioBodies, int inNumBodies, float inDeltaTime)
+{
+	BodyStateSoA state;
+
+	// Gather the state of the bodies
+	state.GatherVelocities(ioBodies, inNumBodies);
+	for (int i = 0; i < inNumBodies; ++i)
+		state.mRotation.Set(i, ioBodies[i]->mRotation);
+	for (int i = inNumBodies; i < state.mNumLanes; ++i)
+		state.mRotation.Set(i, Quat::sIdentity());
+
+	state.ClampVelocities();
+
+	Vec4 delta_time = Vec4::sReplicate(inDeltaTime);
+
+	for (int i = 0; i < state.mNumLanes; i += 4)
+	{
+		// Angular velocity times delta time (see Body::AddRotationStep)
+		Vec4 ax = delta_time * sLoad4(state.mAngularVelocity.mX + i);
+		Vec4 ay = delta_time * sLoad4(state.mAngularVelocity.mY + i);
+		Vec4 az = delta_time * sLoad4(state.mAngularVelocity.mZ + i);
+		Vec4 len = (ax * ax + ay * ay + az * az).Sqrt();
+
+		// Only rotate the lanes that have a significant rotation, this also avoids dividing by zero
+		UVec4 rotate = Vec4::sGreater(len, Vec4::sReplicate(1.0e-6f));
+		if (!rotate.TestAnyTrue())
+			continue;
+
+		// Create rotation quaternion around axis a / |a| with angle |a|
+		Vec4 s, c;
+		(0.5f * len).SinCos(s, c);
+		Vec4 s_div_len = s / Vec4::sSelect(Vec4::sReplicate(1.0f), len, rotate);
+		Vec4 rx = ax * s_div_len, ry = ay * s_div_len, rz = az * s_div_len, rw = c;
+
+		// Rotate: q' = r * q
+		Vec4 qx = sLoad4(state.mRotation.mX + i), qy = sLoad4(state.mRotation.mY + i), qz = sLoad4(state.mRotation.mZ + i), qw = sLoad4(state.mRotation.mW + i);
+		Vec4 nx = rw * qx + rx * qw + ry * qz - rz * qy;
+		Vec4 ny = rw * qy - rx * qz + ry * qw + rz * qx;
+		Vec4 nz = rw * qz + rx * qy - ry * qx + rz * qw;
+		Vec4 nw = rw * qw - rx * qx - ry * qy - rz * qz;
+
+		// Normalize
+		Vec4 inv_len = Vec4::sReplicate(1.0f) / (nx * nx + ny * ny + nz * nz + nw * nw).Sqrt();
+		sStore4(Vec4::sSelect(qx, nx * inv_len, rotate), state.mRotation.mX + i);
+		sStore4(Vec4::sSelect(qy, ny * inv_len, rotate), state.mRotation.mY + i);
+		sStore4(Vec4::sSelect(qz, nz * inv_len, rotate), state.mRotation.mZ + i);
+		sStore4(Vec4::sSelect(qw, nw * inv_len, rotate), state.mRotation.mW + i);
+	}
+
+	// Scatter the state back to the bodies
+	state.ScatterVelocities(ioBodies, inNumBodies);
+	for (int i = 0; i < inNumBodies; ++i)
+	{
+		Body *body = ioBodies[i];
+		body->mRotation = state.mRotation.Get(i);
+		JPH_ASSERT(!body->mRotation.IsNaN());
+	}
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/NonCopyable.h>
+
+JPH_NAMESPACE_BEGIN
+
+class Body;
+
+/// Structure of arrays copy of the state of a batch of bodies that is needed to integrate them (rotation, linear and angular velocity, inverse mass and inertia).
+/// The state is gathered from the Body / MotionProperties, integrated for 4 bodies at a time using SIMD and then scattered back.
+/// The results are close to but not bit exact with the per body versions (Body::AddRotationStep uses the standard library sin / cos).
+class BodyStateSoA : public NonCopyable
+{
+public:
+	/// Maximum number of bodies that can be processed in one call
+	static constexpr int	cMaxBodies = 64;
+
+	/// Apply gravity, accumulated forces, torques and drag to the velocities of dynamic bodies (see MotionProperties::ApplyForceTorqueAndDragInternal)
+	static void				sApplyForceTorqueAndDrag(Body *const *ioBodies, int inNumBodies, Vec3Arg inGravity, float inDeltaTime);
+
+	/// Clamp the velocities of dynamic bodies and update the rotation of dynamic or kinematic bodies according to their angular velocity (see Body::AddRotationStep)
+	static void				sClampVelocitiesAndIntegrateRotation(Body *const *ioBodies, int inNumBodies, float inDeltaTime);
+
+private:
+	static_assert(cMaxBodies % 4 == 0, "Bodies are processed in groups of 4");
+
+	/// Vector of 3 components stored as arrays
+	struct Vec3SoA
+	{
+		JPH_INLINE void		Set(int inIndex, Vec3Arg inV)					{ mX[inIndex] = inV.GetX(); mY[inIndex] = inV.GetY(); mZ[inIndex] = inV.GetZ(); }
+		JPH_INLINE Vec3		Get(int inIndex) const							{ return Vec3(mX[inIndex], mY[inIndex], mZ[inIndex]); }
+
+		alignas(16) float	mX[cMaxBodies];
+		alignas(16) float	mY[cMaxBodies];
+		alignas(16) float	mZ[cMaxBodies];
+	};
+
+	/// Quaternion stored as arrays
+	struct QuatSoA : public Vec3SoA
+	{
+		JPH_INLINE void		Set(int inIndex, QuatArg inQ)					{ Vec3SoA::Set(inIndex, inQ.GetXYZ()); mW[inIndex] = inQ.GetW(); }
+		JPH_INLINE Quat		Get(int inIndex) const							{ return Quat(mX[inIndex], mY[inIndex], mZ[inIndex], mW[inIndex]); }
+
+		alignas(16) float	mW[cMaxBodies];
+	};
+
+	/// Gather velocities and velocity limits, unused lanes are padded with zero velocity
+	void					GatherVelocities(Body *const *inBodies, int inNumBodies);
+
+	/// Clamp velocities of lanes that have mClampVelocity set
+	void					ClampVelocities();
+
+	/// Scatter velocities back to the bodies
+	void					ScatterVelocities(Body *const *ioBodies, int inNumBodies) const;
+
+	int						mNumLanes;										///< Number of bodies rounded up to a multiple of 4
+	QuatSoA					mRotation;										///< World space rotation of center of mass
+	Vec3SoA					mLinearVelocity;								///< World space linear velocity of the center of mass (m/s)
+	Vec3SoA					mAngularVelocity;								///< World space angular velocity (rad/s)
+	alignas(16) float		mMaxLinearVelocity[cMaxBodies];					///< Maximum linear velocity that the body can reach (m/s)
+	alignas(16) float		mMaxAngularVelocity[cMaxBodies];				///< Maximum angular velocity that the body can reach (rad/s)
+	alignas(16) uint32		mClampVelocity[cMaxBodies];						///< 0xffffffff if the velocity of the body should be clamped (only dynamic bodies)
+	alignas(16) float		mInvMass[cMaxBodies];							///< Inverse mass of the body (1/kg)
+	Vec3SoA					mInvInertiaDiagonal;							///< Diagonal of inverse inertia matrix: D
+	QuatSoA					mInertiaRotation;								///< Rotation (R) that takes inverse inertia diagonal to local space: Ibody^-1 = R * D * R^-1
+	Vec3SoA					mForce;											///< Accumulated world space force (N)
+	Vec3SoA					mTorque;										///< Accumulated world space torque (N m)
+	alignas(16) float		mLinearDamping[cMaxBodies];						///< Linear damping: dv/dt = -c * v
+	alignas(16) float		mAngularDamping[cMaxBodies];					///< Angular damping: dw/dt = -c * w
+	alignas(16) float		mGravityFactor[cMaxBodies];						///< Factor to multiply gravity with
+};
+
+JPH_NAMESPACE_END
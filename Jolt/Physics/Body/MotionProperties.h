@@ -145,6 +145,7 @@ public:
 private:
 	friend class BodyManager;
 	friend class Body;
+	friend class BodyStateSoA;
 
 	// 1st cache line
 	// 16 byte aligned
@@ -5,6 +5,7 @@
 
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <Jolt/Core/Memory.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -16,6 +17,7 @@ JPH_NAMESPACE_BEGIN
 #endif // JPH_TRACK_BROADPHASE_STATS
 
 class BodyManager;
+class BroadPhaseTreeLayout;
 struct BodyPair;
 
 using BodyPairCollector = CollisionCollector<BodyPair, CollisionCollectorTraitsCollideShape>;
@@ -24,6 +26,8 @@ using BodyPairCollector = CollisionCollector<BodyPair, CollisionCollectorTraitsC
 class BroadPhase : public BroadPhaseQuery
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::BroadPhase)
+
 	/// Initialize the broadphase.
 	/// @param inBodyManager The body manager singleton
 	/// @param inLayerInterface Interface that maps object layers to broadphase layers.
@@ -33,6 +37,20 @@ public:
 	/// Should be called after many objects have been inserted to make the broadphase more efficient, usually done on startup only
 	virtual void		Optimize()															{ /* Optionally overridden by implementation */ }
 
+	/// Same as Optimize, but instead of doing the work immediately it is spread out over the next calls to UpdatePrepare (which runs in a background job during the physics update).
+	/// The broadphase remains usable in the meantime and the optimized structures are swapped in during UpdateFinalize.
+	virtual void		OptimizeInBackground()												{ /* Optionally overridden by implementation */ }
+
+	/// Set the amount of time that UpdatePrepare may spend (in seconds). This is a soft limit, at least one unit of work is done if there is work to be done.
+	virtual void		SetUpdateTimeBudget(float inTimeBudget)								{ /* Optionally overridden by implementation */ }
+
+	/// Enlarge the bounding boxes of moving bodies so that the broadphase doesn't need to be modified every time a body moves a little bit (see PhysicsSettings::mBroadPhaseBoundsMargin)
+	virtual void		SetBodyBoundsMargin(float inMargin, float inPredictionTime)		{ /* Optionally overridden by implementation */ }
+
+	/// Move bodies that woke up from the structures for sleeping bodies back to the structures for active bodies (see PhysicsSettings::mBroadPhaseDormantInterval).
+	/// When inMoveSleepingBodies is true, bodies that fell asleep are moved to the structures for sleeping bodies too. Must be called between LockModifications and UpdatePrepare.
+	virtual void		UpdateDormantBodies(bool inMoveSleepingBodies)						{ /* Optionally overridden by implementation */ }
+
 	/// Must be called just before updating the broadphase when none of the body mutexes are locked
 	virtual void		FrameSync()															{ /* Optionally overridden by implementation */ }
 
@@ -60,6 +78,11 @@ public:
 	/// ioBodies may be shuffled around by this function and should be kept that way until AddBodiesFinalize/Abort is called.
 	virtual AddState	AddBodiesPrepare(BodyID *ioBodies, int inNumber)					{ return nullptr; } // By default the broadphase doesn't support this
 
+	/// Same as AddBodiesPrepare, but for a batch of bodies for which the structure of the tree has been built in advance (see BroadPhaseTreeLayout).
+	/// ioBodies must be in the order of the bounding boxes that were passed to BroadPhaseTreeLayout::Build. When the bodies are not all in the same broadphase layer
+	/// (or when the broadphase doesn't use trees) the layout is ignored and this is the same as AddBodiesPrepare.
+	virtual AddState	AddBodiesPrepareFromLayout(BodyID *ioBodies, int inNumber, const BroadPhaseTreeLayout &inLayout) { return AddBodiesPrepare(ioBodies, inNumber); }
+
 	/// Finalize adding bodies to the broadphase, supply the return value of AddBodiesPrepare in inAddState.
 	/// Please ensure that the ioBodies array passed to AddBodiesPrepare is unmodified and passed again to this function.
 	virtual void		AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState) = 0;
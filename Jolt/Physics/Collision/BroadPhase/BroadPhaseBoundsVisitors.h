@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Geometry/RayAABox.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Helper functions that create the visitors that BroadPhaseSAP and HashedGrid use to test the bounds of a single body during a query.
+/// A visitor is called as visitor(BodyID, const Tracking &), where Tracking stores the mObjectLayer, mBoundsMin and mBoundsMax of the body,
+/// and returns true when the query should stop.
+
+/// Create a visitor that casts a ray from inOrigin against the bounds of a body expanded by inExtent (use a zero extent for a ray cast, the extent of the box for a box cast).
+/// ioEarlyOutFraction should start at the early out fraction of ioCollector and is updated while hits are found.
+template <class Collector>
+inline auto BroadPhaseCastBoundsVisitor(Vec3Arg inOrigin, Vec3Arg inExtent, const RayInvDirection &inInvDirection, const ObjectLayerFilter &inObjectLayerFilter, Collector &ioCollector, float &ioEarlyOutFraction)
+{
+	return [origin = Vec3(inOrigin), extent = Vec3(inExtent), &inInvDirection, &inObjectLayerFilter, &ioCollector, &ioEarlyOutFraction](BodyID inBodyID, const auto &inTracking)
+	{
+		if (inObjectLayerFilter.ShouldCollide(inTracking.mObjectLayer))
+		{
+			float fraction = RayAABox(origin, inInvDirection, Vec3(inTracking.mBoundsMin) - extent, Vec3(inTracking.mBoundsMax) + extent);
+			if (fraction < ioEarlyOutFraction)
+			{
+				// Store hit
+				BroadPhaseCastResult result { inBodyID, fraction };
+				ioCollector.AddHit(result);
+				if (ioCollector.ShouldEarlyOut())
+					return true;
+				ioEarlyOutFraction = ioCollector.GetEarlyOutFraction();
+			}
+		}
+		return false;
+	};
+}
+
+/// Create a visitor that collects a body when inOverlaps(const AABox &inBodyBounds) returns true
+template <class Overlaps>
+inline auto BroadPhaseCollideBoundsVisitor(const ObjectLayerFilter &inObjectLayerFilter, CollideShapeBodyCollector &ioCollector, const Overlaps &inOverlaps)
+{
+	return [&inObjectLayerFilter, &ioCollector, &inOverlaps](BodyID inBodyID, const auto &inTracking)
+	{
+		if (inObjectLayerFilter.ShouldCollide(inTracking.mObjectLayer)
+			&& inOverlaps(AABox(Vec3(inTracking.mBoundsMin), Vec3(inTracking.mBoundsMax))))
+		{
+			// Store hit
+			ioCollector.AddHit(inBodyID);
+			return ioCollector.ShouldEarlyOut();
+		}
+		return false;
+	};
+}
+
+/// Create a visitor that collects the pairs between inBody1 (with bounds expanded by the speculative contact distance in inBounds1) and the bodies it visits
+inline auto BroadPhasePairBoundsVisitor(const BodyVector &inBodies, const Body &inBody1, const AABox &inBounds1, ObjectLayerPairFilter inObjectLayerPairFilter, BodyPairCollector &ioPairCollector)
+{
+	return [&inBodies, &inBody1, layer1 = inBody1.GetObjectLayer(), &inBounds1, inObjectLayerPairFilter, &ioPairCollector](BodyID inBodyID, const auto &inTracking)
+	{
+		// Don't collide with self and check if the layers and bounds overlap
+		BodyID b1_id = inBody1.GetID();
+		if (b1_id != inBodyID
+			&& inObjectLayerPairFilter(layer1, inTracking.mObjectLayer)
+			&& inBounds1.Overlaps(AABox(Vec3(inTracking.mBoundsMin), Vec3(inTracking.mBoundsMax))))
+		{
+			// Collision between dynamic pairs need to be picked up only once
+			const Body &body2 = *inBodies[inBodyID.GetIndex()];
+			if (Body::sFindCollidingPairsCanCollide(inBody1, body2))
+			{
+				// Store potential hit between bodies
+				ioPairCollector.AddHit({ b1_id, inBodyID });
+			}
+		}
+		return false;
+	};
+}
+
+JPH_NAMESPACE_END
@@ -63,6 +63,11 @@ public:
 	/// Convert an object layer to the corresponding broadphase layer
 	virtual BroadPhaseLayer			GetBroadPhaseLayer(ObjectLayer inLayer) const = 0;
 
+	/// Get the cell size of the hashed grid that is used to store a broadphase layer (only used by BroadPhaseQuadTree).
+	/// A grid works better than a tree for a layer that contains many bodies of roughly the same size (e.g. debris or particles), the cell size should be around twice the size of a typical body.
+	/// Return 0 to store the layer in a tree (the default) or a negative value to calculate the cell size from the average size of the bodies in the layer.
+	virtual float					GetBroadPhaseLayerGridCellSize(BroadPhaseLayer inLayer) const { return 0.0f; }
+
 #if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
 	/// Get the user readable name of a broadphase layer (debugging purposes)
 	virtual const char *			GetBroadPhaseLayerName(BroadPhaseLayer inLayer) const = 0;
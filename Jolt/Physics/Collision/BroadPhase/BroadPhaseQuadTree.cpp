@@ -7,12 +7,15 @@
 #include <Jolt/Physics/Collision/AABoxCast.h>
 #include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Physics/PhysicsLock.h>
+#include <Jolt/Geometry/RayPacket4.h>
+#include <Jolt/Core/TickCounter.h>
 
 JPH_NAMESPACE_BEGIN
 
 BroadPhaseQuadTree::~BroadPhaseQuadTree()
 {
 	delete [] mLayers;
+	delete [] mGrids;
 }
 
 void BroadPhaseQuadTree::Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface)
@@ -29,26 +32,140 @@ void BroadPhaseQuadTree::Init(BodyManager *inBodyManager, const BroadPhaseLayerI
 
 	// Initialize tracking data
 	mTracking.resize(mMaxBodies);
+	mIsDormant.resize(mMaxBodies, 0);
 
 	// Init allocator
 	// Estimate the amount of nodes we're going to need
 	uint32 num_leaves = (uint32)(mMaxBodies + 1) / 2; // Assume 50% fill
 	uint32 num_leaves_plus_internal_nodes = num_leaves + (num_leaves + 2) / 3; // = Sum(num_leaves * 4^-i) with i = [0, Inf].
-	mAllocator.Init(2 * num_leaves_plus_internal_nodes, 256); // We use double the amount of nodes while rebuilding the tree during Update()
+	mAllocator.Init(2 * num_leaves_plus_internal_nodes, 256, EMemoryTag::BroadPhase); // We use double the amount of nodes while rebuilding the tree during Update()
 
 	// Init sub trees
-	mLayers = new QuadTree [mNumLayers];
+	mLayers = new QuadTree [2 * mNumLayers];
+	mDormantLayers = mLayers + mNumLayers;
+	mDormantTreeReceivedBodies.resize(mNumLayers, false);
+	mGrids = new HashedGrid [mNumLayers];
 	for (uint l = 0; l < mNumLayers; ++l)
 	{
 		mLayers[l].Init(mAllocator);
+		mDormantLayers[l].Init(mAllocator);
+
+		// Use a grid instead of a tree if requested
+		float cell_size = inLayerInterface.GetBroadPhaseLayerGridCellSize(BroadPhaseLayer(BroadPhaseLayer::Type(l)));
+		if (cell_size != 0.0f)
+			mGrids[l].Init(cell_size > 0.0f? cell_size : HashedGrid::cAutoCellSize, uint(mMaxBodies));
 
 #if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
 		// Set the name of the layer
-		mLayers[l].SetName(inLayerInterface.GetBroadPhaseLayerName(BroadPhaseLayer(BroadPhaseLayer::Type(l))));
+		const char *name = inLayerInterface.GetBroadPhaseLayerName(BroadPhaseLayer(BroadPhaseLayer::Type(l)));
+		mLayers[l].SetName(name);
+		mDormantLayers[l].SetName(name);
+		mGrids[l].SetName(name);
 #endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
 	}
 }
 
+void BroadPhaseQuadTree::SetBodyBoundsMargin(float inMargin, float inPredictionTime)
+{
+	for (uint l = 0; l < mNumLayers; ++l)
+		mLayers[l].SetBodyBoundsMargin(inMargin, inPredictionTime);
+}
+
+void BroadPhaseQuadTree::OptimizeInBackground()
+{
+	for (uint t = 0; t < 2 * mNumLayers; ++t)
+		if (mLayers[t].HasBodies())
+			mLayers[t].RequestFullRebuild();
+}
+
+void BroadPhaseQuadTree::SetUpdateTimeBudget(float inTimeBudget)
+{
+	mUpdateTimeBudget = uint64(double(inTimeBudget) * double(GetProcessorTicksPerSecond()));
+}
+
+void BroadPhaseQuadTree::MoveBodies(BodyID *ioBodies, int inNumber, bool inToDormant)
+{
+	const BodyVector &bodies = mBodyManager->GetBodies();
+
+	// Sort bodies on layer
+	const Tracking *tracking = mTracking.data(); // C pointer or else sort is incredibly slow in debug mode
+	sort(ioBodies, ioBodies + inNumber, [tracking](BodyID inLHS, BodyID inRHS) { return tracking[inLHS.GetIndex()].mBroadPhaseLayer < tracking[inRHS.GetIndex()].mBroadPhaseLayer; });
+
+	BodyID *b_start = ioBodies, *b_end = ioBodies + inNumber;
+	while (b_start < b_end)
+	{
+		// Get broadphase layer
+		BroadPhaseLayer::Type broadphase_layer = tracking[b_start->GetIndex()].mBroadPhaseLayer;
+		JPH_ASSERT(broadphase_layer < mNumLayers);
+		JPH_ASSERT(!mGrids[broadphase_layer].IsInitialized());
+
+		// Find first body with different layer
+		BodyID *b_mid = upper_bound(b_start, b_end, broadphase_layer, [tracking](BroadPhaseLayer::Type inLayer, BodyID inBodyID) { return inLayer < tracking[inBodyID.GetIndex()].mBroadPhaseLayer; });
+		int num_bodies = int(b_mid - b_start);
+
+		// Remove the bodies from one tree and insert them in the other
+		QuadTree &active_tree = mLayers[broadphase_layer];
+		QuadTree &dormant_tree = mDormantLayers[broadphase_layer];
+		QuadTree &from_tree = inToDormant? active_tree : dormant_tree;
+		QuadTree &to_tree = inToDormant? dormant_tree : active_tree;
+		from_tree.RemoveBodies(bodies, mTracking, b_start, num_bodies);
+		QuadTree::AddState add_state;
+		to_tree.AddBodiesPrepare(bodies, mTracking, b_start, num_bodies, add_state);
+		to_tree.AddBodiesFinalize(mTracking, num_bodies, add_state);
+
+		// Update bookkeeping
+		for (const BodyID *b = b_start; b < b_mid; ++b)
+		{
+			JPH_ASSERT(mIsDormant[b->GetIndex()] != uint8(inToDormant));
+			mIsDormant[b->GetIndex()] = uint8(inToDormant);
+		}
+		if (inToDormant)
+			mDormantTreeReceivedBodies[broadphase_layer] = true;
+
+		// Repeat
+		b_start = b_mid;
+	}
+}
+
+void BroadPhaseQuadTree::UpdateDormantBodies(bool inMoveSleepingBodies)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// LockModifications should have been called, this means that no bodies can be added, removed or moved in the meantime
+	JPH_ASSERT(mUpdateMutex.is_locked());
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	TaggedVector<BodyID, EMemoryTag::BroadPhase> bodies_to_move;
+
+	// Bodies that woke up are moved back to the tree for active bodies, they're all in the active bodies list so this is cheap
+	const BodyID *active_bodies = mBodyManager->GetActiveBodiesUnsafe();
+	for (const BodyID *b = active_bodies, *b_end = active_bodies + mBodyManager->GetNumActiveBodies(); b < b_end; ++b)
+		if (mIsDormant[b->GetIndex()])
+			bodies_to_move.push_back(*b);
+	if (!bodies_to_move.empty())
+		MoveBodies(bodies_to_move.data(), int(bodies_to_move.size()), false);
+
+	if (inMoveSleepingBodies)
+	{
+		// Find all bodies that can move but are asleep and are not in a dormant tree yet
+		bodies_to_move.clear();
+		for (const Body *body : bodies)
+			if (BodyManager::sIsValidBodyPointer(body)
+				&& body->IsInBroadPhase()
+				&& !body->IsStatic()
+				&& !body->IsActive())
+			{
+				uint32 index = body->GetID().GetIndex();
+				if (!mIsDormant[index] && !mGrids[mTracking[index].mBroadPhaseLayer].IsInitialized())
+					bodies_to_move.push_back(body->GetID());
+			}
+		if (!bodies_to_move.empty())
+			MoveBodies(bodies_to_move.data(), int(bodies_to_move.size()), true);
+	}
+}
+
 void BroadPhaseQuadTree::FrameSync()
 {
 	JPH_PROFILE_FUNCTION();
@@ -59,8 +176,11 @@ void BroadPhaseQuadTree::FrameSync()
 	// nothing else is locked this is safe. This is why BroadPhaseQuery should be the highest priority lock.
 	UniqueLock root_lock(mQueryLocks[mQueryLockIdx ^ 1], EPhysicsLockTypes::BroadPhaseQuery);
 
+	for (uint t = 0; t < 2 * mNumLayers; ++t)
+		mLayers[t].DiscardOldTree();
+
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-		mLayers[l].DiscardOldTree();
+		mGrids[l].DiscardOldGrid();
 }
 
 void BroadPhaseQuadTree::Optimize()
@@ -71,9 +191,9 @@ void BroadPhaseQuadTree::Optimize()
 
 	LockModifications();
 
-	for (uint l = 0; l < mNumLayers; ++l)
+	for (uint t = 0; t < 2 * mNumLayers; ++t)
 	{
-		QuadTree &tree = mLayers[l];
+		QuadTree &tree = mLayers[t];
 		if (tree.HasBodies())
 		{
 			QuadTree::UpdateState update_state;
@@ -82,9 +202,21 @@ void BroadPhaseQuadTree::Optimize()
 		}
 	}
 
+	for (uint l = 0; l < mNumLayers; ++l)
+	{
+		HashedGrid &grid = mGrids[l];
+		if (grid.HasBodies())
+		{
+			grid.UpdatePrepare(mTracking);
+			grid.UpdateFinalize();
+		}
+
+		mDormantTreeReceivedBodies[l] = false;
+	}
+
 	UnlockModifications();
 
-	mNextLayerToUpdate = 0;
+	mNextTreeToUpdate = 0;
 }
 
 void BroadPhaseQuadTree::LockModifications()
@@ -101,25 +233,54 @@ BroadPhase::UpdateState BroadPhaseQuadTree::UpdatePrepare()
 	// Create update state
 	UpdateState update_state;
 	UpdateStateImpl *update_state_impl = reinterpret_cast<UpdateStateImpl *>(&update_state);
+	update_state_impl->mNumTrees = 0;
+	update_state_impl->mNumGrids = 0;
+
+	uint64 start_time = mUpdateTimeBudget > 0? GetProcessorTickCount() : 0;
 
-	// Loop until we've seen all layers
-	for (uint iteration = 0; iteration < mNumLayers; ++iteration)
+	// Loop until we've seen all trees
+	uint num_trees = 2 * mNumLayers;
+	for (uint iteration = 0; iteration < num_trees; ++iteration)
 	{
-		// Get the layer
-		QuadTree &tree = mLayers[mNextLayerToUpdate];
-		mNextLayerToUpdate = (mNextLayerToUpdate + 1) % mNumLayers;
+		// Get the tree
+		uint tree_idx = mNextTreeToUpdate;
+		QuadTree &tree = mLayers[tree_idx];
+		mNextTreeToUpdate = (mNextTreeToUpdate + 1) % num_trees;
+
+		// A dormant tree only needs to be rebuilt when bodies were moved into it, bodies that were removed or moved without waking up don't make the tree incorrect
+		bool full_rebuild = tree.IsFullRebuildRequested();
+		bool is_dormant = tree_idx >= mNumLayers;
+		bool is_dirty = tree.IsDirty() && (!is_dormant || mDormantTreeReceivedBodies[tree_idx - mNumLayers]);
+
+		// If it is dirty or needs to be optimized we update this one
+		if (tree.HasBodies() && (is_dirty || full_rebuild) && tree.CanBeUpdated())
+		{
+			if (is_dormant)
+				mDormantTreeReceivedBodies[tree_idx - mNumLayers] = false;
+
+			uint32 idx = update_state_impl->mNumTrees++;
+			update_state_impl->mTree[idx] = uint16(tree_idx);
+			tree.UpdatePrepare(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState[idx], full_rebuild);
 
-		// If it is dirty we update this one
-		if (tree.HasBodies() && tree.IsDirty() && tree.CanBeUpdated())
+			// Stop when we're out of time or when we can't store more trees
+			if (update_state_impl->mNumTrees == cMaxTreesPerUpdate
+				|| mUpdateTimeBudget == 0
+				|| GetProcessorTickCount() - start_time >= mUpdateTimeBudget)
+				break;
+		}
+	}
+
+	// Rebuilding a grid takes linear time, so we rebuild all grids that changed
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+	{
+		HashedGrid &grid = mGrids[l];
+		if (grid.IsDirty() && grid.CanBeUpdated())
 		{
-			update_state_impl->mTree = &tree;
-			tree.UpdatePrepare(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState, false);
-			return update_state;
+			grid.UpdatePrepare(mTracking);
+			++update_state_impl->mNumGrids;
 		}
 	}
 
-	// Nothing to update
-	update_state_impl->mTree = nullptr;
 	return update_state;
 }
 
@@ -128,12 +289,17 @@ void BroadPhaseQuadTree::UpdateFinalize(const UpdateState &inUpdateState)
 	// LockModifications should have been called
 	JPH_ASSERT(mUpdateMutex.is_locked());
 
-	// Test if a tree was updated
+	// Test if a tree or grid was updated
 	const UpdateStateImpl *update_state_impl = reinterpret_cast<const UpdateStateImpl *>(&inUpdateState);
-	if (update_state_impl->mTree == nullptr)
+	if (update_state_impl->mNumTrees == 0 && update_state_impl->mNumGrids == 0)
 		return;
 
-	update_state_impl->mTree->UpdateFinalize(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState);
+	for (uint32 i = 0; i < update_state_impl->mNumTrees; ++i)
+		mLayers[update_state_impl->mTree[i]].UpdateFinalize(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState[i]);
+
+	if (update_state_impl->mNumGrids > 0)
+		for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+			mGrids[l].UpdateFinalize();
 
 	// Make all queries from now on use the new lock
 	mQueryLockIdx = mQueryLockIdx ^ 1;
@@ -175,8 +341,9 @@ BroadPhase::AddState BroadPhaseQuadTree::AddBodiesPrepare(BodyID *ioBodies, int
 		layer_state.mBodyStart = b_start;
 		layer_state.mBodyEnd = b_mid;
 
-		// Insert all bodies of the same layer
-		mLayers[broadphase_layer].AddBodiesPrepare(bodies, mTracking, b_start, int(b_mid - b_start), layer_state.mAddState);
+		// Insert all bodies of the same layer, bodies are added to a grid in AddBodiesFinalize
+		if (!mGrids[broadphase_layer].IsInitialized())
+			mLayers[broadphase_layer].AddBodiesPrepare(bodies, mTracking, b_start, int(b_mid - b_start), layer_state.mAddState);
 
 		// Keep track in which tree we placed the object
 		for (const BodyID *b = b_start; b < b_mid; ++b)
@@ -184,6 +351,7 @@ BroadPhase::AddState BroadPhaseQuadTree::AddBodiesPrepare(BodyID *ioBodies, int
 			uint32 index = b->GetIndex();
 			JPH_ASSERT(bodies[index]->GetID() == *b, "Provided BodyID doesn't match BodyID in body manager");
 			JPH_ASSERT(!bodies[index]->IsInBroadPhase());
+			JPH_ASSERT(!mIsDormant[index]);
 			Tracking &t = mTracking[index];
 			JPH_ASSERT(t.mBroadPhaseLayer == (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid);
 			t.mBroadPhaseLayer = broadphase_layer;
@@ -198,6 +366,50 @@ BroadPhase::AddState BroadPhaseQuadTree::AddBodiesPrepare(BodyID *ioBodies, int
 	return state;
 }
 	
+BroadPhase::AddState BroadPhaseQuadTree::AddBodiesPrepareFromLayout(BodyID *ioBodies, int inNumber, const BroadPhaseTreeLayout &inLayout)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+	JPH_ASSERT(inLayout.mNumBodies == uint32(inNumber));
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// The layout can only be used when all bodies go into the same tree
+	BroadPhaseLayer::Type broadphase_layer = (BroadPhaseLayer::Type)bodies[ioBodies->GetIndex()]->GetBroadPhaseLayer();
+	JPH_ASSERT(broadphase_layer < mNumLayers);
+	if (mGrids[broadphase_layer].IsInitialized())
+		return AddBodiesPrepare(ioBodies, inNumber);
+	for (const BodyID *b = ioBodies + 1, *b_end = ioBodies + inNumber; b < b_end; ++b)
+		if ((BroadPhaseLayer::Type)bodies[b->GetIndex()]->GetBroadPhaseLayer() != broadphase_layer)
+			return AddBodiesPrepare(ioBodies, inNumber);
+
+	LayerState *state = new LayerState [mNumLayers];
+
+	// Insert all bodies using the prebuilt tree
+	LayerState &layer_state = state[broadphase_layer];
+	layer_state.mBodyStart = ioBodies;
+	layer_state.mBodyEnd = ioBodies + inNumber;
+	mLayers[broadphase_layer].AddBodiesPrepare(bodies, mTracking, ioBodies, inNumber, inLayout, layer_state.mAddState);
+
+	// Keep track in which tree we placed the object
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		JPH_ASSERT(bodies[index]->GetID() == *b, "Provided BodyID doesn't match BodyID in body manager");
+		JPH_ASSERT(!bodies[index]->IsInBroadPhase());
+		JPH_ASSERT(!mIsDormant[index]);
+		Tracking &t = mTracking[index];
+		JPH_ASSERT(t.mBroadPhaseLayer == (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid);
+		t.mBroadPhaseLayer = broadphase_layer;
+		JPH_ASSERT(t.mObjectLayer == cObjectLayerInvalid);
+		t.mObjectLayer = bodies[index]->GetObjectLayer();
+	}
+
+	return state;
+}
+	
 void BroadPhaseQuadTree::AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState)
 { 
 	JPH_PROFILE_FUNCTION();
@@ -216,7 +428,11 @@ void BroadPhaseQuadTree::AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddSt
 		if (l.mBodyStart != nullptr)
 		{
 			// Insert all bodies of the same layer
-			mLayers[broadphase_layer].AddBodiesFinalize(mTracking, int(l.mBodyEnd - l.mBodyStart), l.mAddState);
+			HashedGrid &grid = mGrids[broadphase_layer];
+			if (grid.IsInitialized())
+				grid.AddBodies(bodies, mTracking, l.mBodyStart, int(l.mBodyEnd - l.mBodyStart));
+			else
+				mLayers[broadphase_layer].AddBodiesFinalize(mTracking, int(l.mBodyEnd - l.mBodyStart), l.mAddState);
 
 			// Mark added to broadphase
 			for (const BodyID *b = l.mBodyStart; b < l.mBodyEnd; ++b)
@@ -249,7 +465,8 @@ void BroadPhaseQuadTree::AddBodiesAbort(BodyID *ioBodies, int inNumber, AddState
 		if (l.mBodyStart != nullptr)
 		{
 			// Insert all bodies of the same layer
-			mLayers[broadphase_layer].AddBodiesAbort(mTracking, l.mAddState);
+			if (!mGrids[broadphase_layer].IsInitialized())
+				mLayers[broadphase_layer].AddBodiesAbort(mTracking, l.mAddState);
 
 			// Reset bookkeeping
 			for (const BodyID *b = l.mBodyStart; b < l.mBodyEnd; ++b)
@@ -295,12 +512,25 @@ void BroadPhaseQuadTree::RemoveBodies(BodyID *ioBodies, int inNumber)
 		BodyID *b_mid = upper_bound(b_start, b_end, broadphase_layer, [tracking](BroadPhaseLayer::Type inLayer, BodyID inBodyID) { return inLayer < tracking[inBodyID.GetIndex()].mBroadPhaseLayer; });
 
 		// Remove all bodies of the same layer
-		mLayers[broadphase_layer].RemoveBodies(bodies, mTracking, b_start, int(b_mid - b_start));
+		HashedGrid &grid = mGrids[broadphase_layer];
+		if (grid.IsInitialized())
+			grid.RemoveBodies(mTracking, b_start, int(b_mid - b_start));
+		else
+		{
+			// Split the bodies in the ones in the active and the ones in the dormant tree
+			const uint8 *is_dormant = mIsDormant.data();
+			BodyID *b_dormant = partition(b_start, b_mid, [is_dormant](BodyID inBodyID) { return !is_dormant[inBodyID.GetIndex()]; });
+			if (b_start < b_dormant)
+				mLayers[broadphase_layer].RemoveBodies(bodies, mTracking, b_start, int(b_dormant - b_start));
+			if (b_dormant < b_mid)
+				mDormantLayers[broadphase_layer].RemoveBodies(bodies, mTracking, b_dormant, int(b_mid - b_dormant));
+		}
 
 		for (const BodyID *b = b_start; b < b_mid; ++b)
 		{
 			// Reset bookkeeping
 			uint32 index = b->GetIndex();
+			mIsDormant[index] = 0;
 			Tracking &t = tracking[index];
 			t.mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
 			t.mObjectLayer = cObjectLayerInvalid;
@@ -345,7 +575,19 @@ void BroadPhaseQuadTree::NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber,
 		BodyID *b_mid = upper_bound(b_start, b_end, broadphase_layer, [tracking](BroadPhaseLayer::Type inLayer, BodyID inBodyID) { return inLayer < tracking[inBodyID.GetIndex()].mBroadPhaseLayer; });
 
 		// Nodify all bodies of the same layer changed
-		mLayers[broadphase_layer].NotifyBodiesAABBChanged(bodies, mTracking, b_start, int(b_mid - b_start));
+		HashedGrid &grid = mGrids[broadphase_layer];
+		if (grid.IsInitialized())
+			grid.NotifyBodiesAABBChanged(bodies, mTracking, b_start, int(b_mid - b_start));
+		else
+		{
+			// Split the bodies in the ones in the active and the ones in the dormant tree
+			const uint8 *is_dormant = mIsDormant.data();
+			BodyID *b_dormant = partition(b_start, b_mid, [is_dormant](BodyID inBodyID) { return !is_dormant[inBodyID.GetIndex()]; });
+			if (b_start < b_dormant)
+				mLayers[broadphase_layer].NotifyBodiesAABBChanged(bodies, mTracking, b_start, int(b_dormant - b_start));
+			if (b_dormant < b_mid)
+				mDormantLayers[broadphase_layer].NotifyBodiesAABBChanged(bodies, mTracking, b_dormant, int(b_mid - b_dormant));
+		}
 
 		// Repeat
 		b_start = b_mid;
@@ -391,6 +633,37 @@ void BroadPhaseQuadTree::NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber
 	}
 }
 
+template <class Visitor>
+bool BroadPhaseQuadTree::VisitLayer(BroadPhaseLayer::Type inLayer, Visitor &ioVisitor) const
+{
+	// A layer is either stored in a grid or in a tree
+	const HashedGrid &grid = mGrids[inLayer];
+	const QuadTree &tree = mLayers[inLayer];
+	if (grid.HasBodies())
+	{
+		JPH_PROFILE(grid.GetName());
+		if (ioVisitor(grid))
+			return true;
+	}
+	else if (tree.HasBodies())
+	{
+		JPH_PROFILE(tree.GetName());
+		if (ioVisitor(tree))
+			return true;
+	}
+
+	// Also visit the bodies that are asleep
+	const QuadTree &dormant_tree = mDormantLayers[inLayer];
+	if (dormant_tree.HasBodies())
+	{
+		JPH_PROFILE(dormant_tree.GetName());
+		if (ioVisitor(dormant_tree))
+			return true;
+	}
+
+	return false;
+}
+
 void BroadPhaseQuadTree::CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const 
 { 
 	JPH_PROFILE_FUNCTION();
@@ -400,18 +673,58 @@ void BroadPhaseQuadTree::CastRay(const RayCast &inRay, RayCastBodyCollector &ioC
 	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
 	shared_lock lock(mQueryLocks[mQueryLockIdx]);
 
+	auto visitor = [this, &inRay, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CastRay(inRay, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
+}
+
+void BroadPhaseQuadTree::CastRayPacket(const RayCast *inRays, int inNumRays, RayPacketBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());	
+
+	// Convert the rays to a packet
+	JPH_ASSERT(inNumRays > 0 && inNumRays <= RayPacket4::cNumRays);
+	Vec3 origins[RayPacket4::cNumRays], directions[RayPacket4::cNumRays];
+	for (int i = 0; i < inNumRays; ++i)
 	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+		origins[i] = inRays[i].mOrigin;
+		directions[i] = inRays[i].mDirection;
+	}
+	RayPacket4 packet(origins, directions, inNumRays);
+
+	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	auto visitor = [this, inRays, inNumRays, &packet, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		if constexpr (is_same_v<decay_t<decltype(inTree)>, HashedGrid>)
 		{
-			JPH_PROFILE(tree.GetName());
-			tree.CastRay(inRay, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
+			// The grid doesn't support packets, cast the rays one by one
+			for (int i = 0; i < inNumRays; ++i)
+			{
+				RayPacketSingleRayCollector collector(ioCollector, i);
+				if (!collector.ShouldEarlyOut())
+					inTree.CastRay(inRays[i], collector, inObjectLayerFilter, mTracking);
+			}
 		}
-	}
+		else
+			inTree.CastRayPacket(packet, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const 
@@ -423,18 +736,16 @@ void BroadPhaseQuadTree::CollideAABox(const AABox &inBox, CollideShapeBodyCollec
 	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
 	shared_lock lock(mQueryLocks[mQueryLockIdx]);
 
+	auto visitor = [this, &inBox, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CollideAABox(inBox, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
-		{
-			JPH_PROFILE(tree.GetName());
-			tree.CollideAABox(inBox, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
-		}
-	}
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
@@ -446,18 +757,16 @@ void BroadPhaseQuadTree::CollideSphere(Vec3Arg inCenter, float inRadius, Collide
 	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
 	shared_lock lock(mQueryLocks[mQueryLockIdx]);
 
+	auto visitor = [this, center = Vec3(inCenter), inRadius, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CollideSphere(center, inRadius, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
-		{
-			JPH_PROFILE(tree.GetName());
-			tree.CollideSphere(inCenter, inRadius, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
-		}
-	}
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
@@ -469,18 +778,16 @@ void BroadPhaseQuadTree::CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector
 	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
 	shared_lock lock(mQueryLocks[mQueryLockIdx]);
 
+	auto visitor = [this, point = Vec3(inPoint), &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CollidePoint(point, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
-		{
-			JPH_PROFILE(tree.GetName());
-			tree.CollidePoint(inPoint, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
-		}
-	}
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
@@ -492,18 +799,16 @@ void BroadPhaseQuadTree::CollideOrientedBox(const OrientedBox &inBox, CollideSha
 	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
 	shared_lock lock(mQueryLocks[mQueryLockIdx]);
 
+	auto visitor = [this, &inBox, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CollideOrientedBox(inBox, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
-		{
-			JPH_PROFILE(tree.GetName());
-			tree.CollideOrientedBox(inBox, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
-		}
-	}
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const 
@@ -512,18 +817,16 @@ void BroadPhaseQuadTree::CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCo
 
 	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());	
 
+	auto visitor = [this, &inBox, &ioCollector, &inObjectLayerFilter](const auto &inTree)
+	{
+		inTree.CastAABox(inBox, ioCollector, inObjectLayerFilter, mTracking);
+		return ioCollector.ShouldEarlyOut();
+	};
+
 	// Loop over all layers and test the ones that could hit
 	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-	{
-		const QuadTree &tree = mLayers[l];
-		if (tree.HasBodies() && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
-		{
-			JPH_PROFILE(tree.GetName());
-			tree.CastAABox(inBox, ioCollector, inObjectLayerFilter, mTracking);
-			if (ioCollector.ShouldEarlyOut())
-				break;
-		}
-	}
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)) && VisitLayer(l, visitor))
+			break;
 }
 
 void BroadPhaseQuadTree::CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const 
@@ -557,16 +860,19 @@ void BroadPhaseQuadTree::FindCollidingPairs(BodyID *ioActiveBodies, int inNumAct
 		// Find first body with different layer
 		BodyID *b_mid = upper_bound(b_start, b_end, object_layer, [tracking](ObjectLayer inLayer, BodyID inBodyID) { return inLayer < tracking[inBodyID.GetIndex()].mObjectLayer; });
 
+		auto visitor = [this, &bodies, b_start, b_mid, inSpeculativeContactDistance, &ioPairCollector, inObjectLayerPairFilter](const auto &inTree)
+		{
+			if constexpr (is_same_v<decay_t<decltype(inTree)>, HashedGrid>)
+				inTree.FindCollidingPairs(bodies, b_start, int(b_mid - b_start), inSpeculativeContactDistance, ioPairCollector, inObjectLayerPairFilter, mTracking);
+			else
+				inTree.FindCollidingPairs(bodies, b_start, int(b_mid - b_start), inSpeculativeContactDistance, ioPairCollector, inObjectLayerPairFilter);
+			return false;
+		};
+
 		// Loop over all layers and test the ones that could hit
 		for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-		{
-			const QuadTree &tree = mLayers[l];
-			if (tree.HasBodies() && inObjectVsBroadPhaseLayerFilter(object_layer, BroadPhaseLayer(l)))
-			{
-				JPH_PROFILE(tree.GetName());
-				tree.FindCollidingPairs(bodies, b_start, int(b_mid - b_start), inSpeculativeContactDistance, ioPairCollector, inObjectLayerPairFilter);
-			}
-		}
+			if (inObjectVsBroadPhaseLayerFilter(object_layer, BroadPhaseLayer(l)))
+				VisitLayer(l, visitor);
 
 		// Repeat
 		b_start = b_mid;
@@ -578,8 +884,8 @@ void BroadPhaseQuadTree::FindCollidingPairs(BodyID *ioActiveBodies, int inNumAct
 void BroadPhaseQuadTree::ReportStats()
 {
 	Trace("Query Type, Filter Description, Tree Name, Num Queries, Total Time (ms), Total Time Excl. Collector (ms), Nodes Visited, Bodies Visited, Hits Reported, Hits Reported vs Bodies Visited (%%), Hits Reported vs Nodes Visited");
-	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
-		mLayers[l].ReportStats();
+	for (uint t = 0; t < 2 * mNumLayers; ++t)
+		mLayers[t].ReportStats();
 }
 
 #endif // JPH_TRACK_BROADPHASE_STATS
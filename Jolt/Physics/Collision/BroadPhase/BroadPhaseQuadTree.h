@@ -4,11 +4,14 @@
 #pragma once
 
 #include <Jolt/Physics/Collision/BroadPhase/QuadTree.h>
+#include <Jolt/Physics/Collision/BroadPhase/HashedGrid.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
 
 JPH_NAMESPACE_BEGIN
 
 /// Fast SIMD based quad tree BroadPhase that is multithreading aware and tries to do a minimal amount of locking.
+/// Layers for which BroadPhaseLayerInterface::GetBroadPhaseLayerGridCellSize returns a non zero value are stored in a HashedGrid instead of a QuadTree.
+/// Every QuadTree layer has a second (dormant) tree that bodies are moved to when they fall asleep, see UpdateDormantBodies.
 class BroadPhaseQuadTree final : public BroadPhase
 {
 public:
@@ -18,18 +21,24 @@ public:
 	// Implementing interface of BroadPhase (see BroadPhase for documentation)
 	virtual void			Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface) override;
 	virtual void			Optimize() override;
+	virtual void			OptimizeInBackground() override;
+	virtual void			SetUpdateTimeBudget(float inTimeBudget) override;
+	virtual void			SetBodyBoundsMargin(float inMargin, float inPredictionTime) override;
+	virtual void			UpdateDormantBodies(bool inMoveSleepingBodies) override;
 	virtual void			FrameSync() override;
 	virtual void			LockModifications() override;
 	virtual	UpdateState		UpdatePrepare() override;
 	virtual void			UpdateFinalize(const UpdateState &inUpdateState) override;
 	virtual void			UnlockModifications() override;
 	virtual AddState		AddBodiesPrepare(BodyID *ioBodies, int inNumber) override;
+	virtual AddState		AddBodiesPrepareFromLayout(BodyID *ioBodies, int inNumber, const BroadPhaseTreeLayout &inLayout) override;
 	virtual void			AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState) override;
 	virtual void			AddBodiesAbort(BodyID *ioBodies, int inNumber, AddState inAddState) override;
 	virtual void			RemoveBodies(BodyID *ioBodies, int inNumber) override;
 	virtual void			NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber, bool inTakeLock) override;
 	virtual void			NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber) override;
 	virtual void			CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CastRayPacket(const RayCast *inRays, int inNumRays, RayPacketBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
 	virtual void			CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
 	virtual void			CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
 	virtual void			CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
@@ -45,6 +54,8 @@ private:
 	/// Helper struct for AddBodies handle
 	struct LayerState
 	{
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::BroadPhase)
+
 		BodyID *			mBodyStart = nullptr;
 		BodyID *			mBodyEnd;
 		QuadTree::AddState	mAddState;
@@ -53,6 +64,15 @@ private:
 	using Tracking = QuadTree::Tracking;
 	using TrackingVector = QuadTree::TrackingVector;
 
+	/// Move inNumber bodies between the tree for active bodies and the dormant tree of their layer (ioBodies may be shuffled around by this function)
+	void					MoveBodies(BodyID *ioBodies, int inNumber, bool inToDormant);
+
+	/// Call ioVisitor for the grid (or the tree for active bodies) and for the dormant tree of layer inLayer, skipping the ones that don't have any bodies.
+	/// ioVisitor is called as ioVisitor(const HashedGrid &) or ioVisitor(const QuadTree &) and returns true when the query should stop.
+	/// Returns true when the query was stopped.
+	template <class Visitor>
+	bool					VisitLayer(BroadPhaseLayer::Type inLayer, Visitor &ioVisitor) const;
+
 	/// Max amount of bodies we support
 	size_t					mMaxBodies = 0;
 
@@ -65,15 +85,32 @@ private:
 	/// Information about broad phase layers
 	const BroadPhaseLayerInterface *mBroadPhaseLayerInterface = nullptr;
 
-	/// One tree per object layer
+	/// One tree per object layer followed by one dormant tree per object layer (mLayers[l + mNumLayers] == mDormantLayers[l])
 	QuadTree *				mLayers;
 	uint					mNumLayers;
 
+	/// One tree per object layer that contains the bodies that were asleep when UpdateDormantBodies was last called with inMoveSleepingBodies = true
+	QuadTree *				mDormantLayers;
+
+	/// For each BodyID if the body is stored in the dormant tree of its layer
+	TaggedVector<uint8, EMemoryTag::BroadPhase> mIsDormant;
+
+	/// For each object layer if bodies were moved into the dormant tree since it was last rebuilt, a dormant tree is only rebuilt when this is true or when a full rebuild was requested
+	TaggedVector<bool, EMemoryTag::BroadPhase>	mDormantTreeReceivedBodies;
+
+	/// One grid per object layer, only initialized for the layers that use a grid instead of a tree
+	HashedGrid *			mGrids = nullptr;
+
+	/// Max amount of trees that can be rebuilt in a single UpdatePrepare/Finalize()
+	static constexpr int	cMaxTreesPerUpdate = 4;
+
 	/// UpdateState implementation for this tree used during UpdatePrepare/Finalize()
 	struct UpdateStateImpl
 	{
-		QuadTree *				mTree;
-		QuadTree::UpdateState	mUpdateState;
+		QuadTree::UpdateState	mUpdateState[cMaxTreesPerUpdate];
+		uint16					mTree[cMaxTreesPerUpdate];							///< Index in mLayers of the trees that were rebuilt
+		uint32					mNumTrees;
+		uint32					mNumGrids;											///< Number of grids that were rebuilt
 	};
 
 	static_assert(sizeof(UpdateStateImpl) <= sizeof(UpdateState));
@@ -89,8 +126,11 @@ private:
 	/// This index indicates which lock is currently active, it alternates between 0 and 1
 	atomic<uint32>			mQueryLockIdx { 0 };
 
-	/// This is the next tree to update in UpdatePrepare()
-	uint32					mNextLayerToUpdate = 0;
+	/// This is the next tree (index in mLayers) to update in UpdatePrepare()
+	uint32					mNextTreeToUpdate = 0;
+
+	/// Amount of time that UpdatePrepare may spend rebuilding trees (in processor ticks), when this is 0 only 1 tree is rebuilt per update
+	uint64					mUpdateTimeBudget = 0;
 };
 
 JPH_NAMESPACE_END
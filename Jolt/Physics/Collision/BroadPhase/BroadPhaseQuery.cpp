@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+
+JPH_NAMESPACE_BEGIN
+
+RayPacketSingleRayCollector::RayPacketSingleRayCollector(RayPacketBodyCollector &ioCollector, int inRayIndex) :
+	mCollector(ioCollector),
+	mRayIndex(inRayIndex)
+{
+	ResetEarlyOutFraction(ioCollector.GetEarlyOutFractions()[inRayIndex]);
+}
+
+void RayPacketSingleRayCollector::AddHit(const BroadPhaseCastResult &inResult)
+{
+	// Only this ray hits the body
+	Vec4 fractions = Vec4::sReplicate(FLT_MAX);
+	fractions[mRayIndex] = inResult.mFraction;
+	mCollector.AddHit(inResult.mBodyID, fractions);
+
+	// The packet collector may have found a closer hit for this ray
+	ResetEarlyOutFraction(mCollector.GetEarlyOutFractions()[mRayIndex]);
+}
+
+void BroadPhaseQuery::CastRayPacket(const RayCast *inRays, int inNumRays, RayPacketBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	for (int i = 0; i < inNumRays; ++i)
+	{
+		RayPacketSingleRayCollector collector(ioCollector, i);
+		if (!collector.ShouldEarlyOut())
+			CastRay(inRays[i], collector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+	}
+}
+
+JPH_NAMESPACE_END
@@ -22,6 +22,45 @@ using RayCastBodyCollector = CollisionCollector<BroadPhaseCastResult, CollisionC
 using CastShapeBodyCollector = CollisionCollector<BroadPhaseCastResult, CollisionCollectorTraitsCastShape>;
 using CollideShapeBodyCollector = CollisionCollector<BodyID, CollisionCollectorTraitsCollideShape>;
 
+/// Collector that receives the bodies whose bounding box is hit by a packet of rays, see BroadPhaseQuery::CastRayPacket
+class RayPacketBodyCollector : public NonCopyable
+{
+public:
+	/// Destructor
+	virtual					~RayPacketBodyCollector() = default;
+
+	/// Called for every body whose bounding box is hit by at least one of the rays.
+	/// inFractions contains for each ray the fraction at which it enters the bounding box, or FLT_MAX when the ray misses the box or the box is further than the early out fraction of the ray.
+	virtual void			AddHit(const BodyID &inBodyID, Vec4Arg inFractions) = 0;
+
+	/// Update the early out fraction for each ray (should be lower than before), rays that are not in use should get a fraction of 0
+	inline void				UpdateEarlyOutFractions(Vec4Arg inFractions)	{ mEarlyOutFractions = inFractions; }
+
+	/// Get the current early out fraction for each ray
+	inline Vec4				GetEarlyOutFractions() const					{ return mEarlyOutFractions; }
+
+	/// When true, none of the rays can generate any additional hits and the collision detection routine should early out as soon as possible
+	inline bool				ShouldEarlyOut() const							{ return Vec4::sLessOrEqual(mEarlyOutFractions, Vec4::sReplicate(CollisionCollectorTraitsCastRay::ShouldEarlyOutFraction)).TestAllTrue(); }
+
+private:
+	Vec4					mEarlyOutFractions = Vec4::sReplicate(CollisionCollectorTraitsCastRay::InitialEarlyOutFraction);
+};
+
+/// Collector that forwards the hits of a single ray of a packet to a RayPacketBodyCollector, this is used to implement CastRayPacket by casting the rays one by one
+class RayPacketSingleRayCollector : public RayCastBodyCollector
+{
+public:
+	/// Constructor
+							RayPacketSingleRayCollector(RayPacketBodyCollector &ioCollector, int inRayIndex);
+
+	// See: RayCastBodyCollector
+	virtual void			AddHit(const BroadPhaseCastResult &inResult) override;
+
+private:
+	RayPacketBodyCollector &mCollector;
+	int						mRayIndex;
+};
+
 /// Interface to the broadphase that can perform collision queries. These queries will only test the bounding box of the body to quickly determine a potential set of colliding bodies
 class BroadPhaseQuery : public NonCopyable
 {
@@ -32,6 +71,10 @@ public:
 	/// Cast a ray and add any hits to ioCollector
 	virtual void		CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }) const = 0;
 
+	/// Cast a packet of up to RayPacket4::cNumRays rays and add any hits to ioCollector. The rays should be coherent (e.g. a fan of sensor rays) as they're traced through the broadphase together.
+	/// The default implementation casts the rays one by one.
+	virtual void		CastRayPacket(const RayCast *inRays, int inNumRays, RayPacketBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }) const;
+
 	/// Get bodies intersecting with inBox and any hits to ioCollector
 	virtual void		CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }) const = 0;
 
@@ -0,0 +1,715 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseSAP.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBoundsVisitors.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Physics/PhysicsLock.h>
+#include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Geometry/OrientedBox.h>
+
+JPH_NAMESPACE_BEGIN
+
+BroadPhaseSAP::~BroadPhaseSAP()
+{
+	delete [] mLayers;
+}
+
+void BroadPhaseSAP::Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface)
+{
+	BroadPhase::Init(inBodyManager, inLayerInterface);
+
+	// Store input parameters
+	mNumLayers = inLayerInterface.GetNumBroadPhaseLayers();
+	JPH_ASSERT(mNumLayers <= 64, "UpdateStateImpl can only store 64 layers");
+
+	// Store max bodies
+	mMaxBodies = inBodyManager->GetMaxBodies();
+
+	// Initialize tracking data
+	mTracking.resize(mMaxBodies);
+
+	// Reserve space for all bodies in each layer so that the arrays never need to be reallocated while they're being queried
+	mLayers = new Layer [mNumLayers];
+	for (uint l = 0; l < mNumLayers; ++l)
+		for (SortedArrays &arrays : mLayers[l].mArrays)
+			for (AxisArray &a : arrays.mAxes)
+				a.mEntries.resize(mMaxBodies);
+}
+
+uint BroadPhaseSAP::GetSweepAxis(BroadPhaseLayer inLayer, const AABox &inBounds) const
+{
+	const Layer &layer = mLayers[(BroadPhaseLayer::Type)inLayer];
+
+	uint axis;
+	const SortEntry *begin, *end;
+	sFindSweepRange(layer.mArrays[layer.mCurrent], inBounds.mMin, inBounds.mMax, axis, begin, end);
+	return axis;
+}
+
+void BroadPhaseSAP::FrameSync()
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Take a unique lock on the old query lock so that we know no one is using the old arrays anymore.
+	// Note that nothing should be locked at this point to avoid risking a lock inversion deadlock (see BroadPhaseQuadTree::FrameSync).
+	UniqueLock root_lock(mQueryLocks[mQueryLockIdx ^ 1], EPhysicsLockTypes::BroadPhaseQuery);
+
+	for (uint l = 0; l < mNumLayers; ++l)
+		mLayers[l].mCanBeSorted = true;
+}
+
+void BroadPhaseSAP::Optimize()
+{
+	JPH_PROFILE_FUNCTION();
+
+	FrameSync();
+
+	LockModifications();
+
+	// Sort all layers from scratch
+	UpdateState update_state;
+	UpdateStateImpl *update_state_impl = reinterpret_cast<UpdateStateImpl *>(&update_state);
+	update_state_impl->mSortedLayers = 0;
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+	{
+		Layer &layer = mLayers[l];
+		if (layer.mArrays[layer.mCurrent].mNumEntries > 0)
+		{
+			SortLayer(l, true);
+			update_state_impl->mSortedLayers |= uint64(1) << l;
+		}
+	}
+
+	UpdateFinalize(update_state);
+
+	UnlockModifications();
+}
+
+void BroadPhaseSAP::LockModifications()
+{
+	// From this point on we prevent modifications to the arrays
+	PhysicsLock::sLock(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+}
+
+BroadPhase::UpdateState BroadPhaseSAP::UpdatePrepare()
+{
+	// LockModifications should have been called
+	JPH_ASSERT(mUpdateMutex.is_locked());
+
+	// Create update state
+	UpdateState update_state;
+	UpdateStateImpl *update_state_impl = reinterpret_cast<UpdateStateImpl *>(&update_state);
+	update_state_impl->mSortedLayers = 0;
+
+	// Sort all layers that changed
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+	{
+		Layer &layer = mLayers[l];
+		if (layer.mIsDirty && layer.mCanBeSorted)
+		{
+			SortLayer(l, false);
+			update_state_impl->mSortedLayers |= uint64(1) << l;
+		}
+	}
+
+	return update_state;
+}
+
+void BroadPhaseSAP::UpdateFinalize(const UpdateState &inUpdateState)
+{
+	// LockModifications should have been called
+	JPH_ASSERT(mUpdateMutex.is_locked());
+
+	// Test if a layer was sorted
+	const UpdateStateImpl *update_state_impl = reinterpret_cast<const UpdateStateImpl *>(&inUpdateState);
+	if (update_state_impl->mSortedLayers == 0)
+		return;
+
+	// Swap in the sorted arrays
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (update_state_impl->mSortedLayers & (uint64(1) << l))
+		{
+			Layer &layer = mLayers[l];
+			layer.mCurrent.store(layer.mCurrent.load(memory_order_relaxed) ^ 1, memory_order_release);
+			layer.mCanBeSorted = false;
+		}
+
+	// Make all queries from now on use the new lock
+	mQueryLockIdx = mQueryLockIdx ^ 1;
+}
+
+void BroadPhaseSAP::UnlockModifications()
+{
+	// From this point on we allow modifications to the arrays again
+	PhysicsLock::sUnlock(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+}
+
+void BroadPhaseSAP::SortLayer(BroadPhaseLayer::Type inLayer, bool inFullSort)
+{
+	JPH_PROFILE_FUNCTION();
+
+	Layer &layer = mLayers[inLayer];
+	layer.mIsDirty = false;
+
+	uint32 current = layer.mCurrent;
+	uint32 next = current ^ 1;
+	const SortedArrays &src = layer.mArrays[current];
+	SortedArrays &dst = layer.mArrays[next];
+	uint32 num_src = src.mNumEntries;
+
+	// Order on key, use the body ID to make the order independent of the order in which bodies were added
+	auto less = [](const SortEntry &inLHS, const SortEntry &inRHS)
+	{
+		return inLHS.mKey < inRHS.mKey || (inLHS.mKey == inRHS.mKey && inLHS.mBodyID < inRHS.mBodyID);
+	};
+
+	uint32 num_dst = 0;
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		const SortEntry *src_entries = src.mAxes[axis].mEntries.data();
+		SortEntry *dst_entries = dst.mAxes[axis].mEntries.data(); // C pointer or else sort is incredibly slow in debug mode
+
+		// Copy the bodies that are still in this layer, sorted part first, with the current minimum of their bounds as key
+		uint32 num_dst_sorted = 0;
+		num_dst = 0;
+		for (uint32 i = 0; i < num_src; ++i)
+		{
+			if (i == src.mNumSorted)
+				num_dst_sorted = num_dst;
+
+			const SortEntry &e = src_entries[i];
+			const Tracking &t = mTracking[e.mBodyID.GetIndex()];
+			if (t.mBroadPhaseLayer == inLayer && t.mIndex[current][axis] == i)
+			{
+				dst_entries[num_dst].mKey = t.mBoundsMin[axis];
+				dst_entries[num_dst].mBodyID = e.mBodyID;
+				++num_dst;
+			}
+		}
+		if (src.mNumSorted >= num_src)
+			num_dst_sorted = num_dst;
+
+		SortEntry *dst_sorted_end = dst_entries + num_dst_sorted, *dst_end = dst_entries + num_dst;
+		if (inFullSort)
+			sort(dst_entries, dst_end, less);
+		else
+		{
+			// Bodies don't move much between updates so the previously sorted part is nearly sorted, insertion sort is close to linear for this case.
+			// Bail out to a regular sort when too many elements need to move (e.g. because many bodies were teleported).
+			uint64 moves_left = 8 * uint64(num_dst_sorted) + 64;
+			for (SortEntry *e = dst_entries + 1; e < dst_sorted_end && moves_left > 0; ++e)
+			{
+				SortEntry value = *e;
+				SortEntry *insert = e;
+				for (; insert > dst_entries && less(value, insert[-1]) && moves_left > 0; --insert, --moves_left)
+					*insert = insert[-1];
+				*insert = value;
+			}
+			if (moves_left == 0)
+				sort(dst_entries, dst_sorted_end, less);
+
+			// Sort the bodies that were added since the last sort and merge them in
+			if (dst_sorted_end < dst_end)
+			{
+				sort(dst_sorted_end, dst_end, less);
+				inplace_merge(dst_entries, dst_sorted_end, dst_end, less);
+			}
+		}
+
+		// Update tracking information and calculate how far the bounds extend beyond the keys
+		float max_above_key = 0.0f;
+		for (uint32 i = 0; i < num_dst; ++i)
+		{
+			const SortEntry &e = dst_entries[i];
+			Tracking &t = mTracking[e.mBodyID.GetIndex()];
+			t.mIndex[next][axis] = i;
+			t.mKey[axis] = e.mKey;
+			max_above_key = max(max_above_key, t.mBoundsMax[axis] - e.mKey);
+		}
+
+		AxisArray &dst_axis = dst.mAxes[axis];
+		dst_axis.mMaxBelowKey = 0.0f;
+		dst_axis.mMaxAboveKey = max_above_key;
+	}
+
+	dst.mNumSorted = num_dst;
+	dst.mNumEntries.store(num_dst, memory_order_release);
+}
+
+void BroadPhaseSAP::CompactLayer(BroadPhaseLayer::Type inLayer)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// This modifies arrays that can be in use, so we need to wait for all queries to finish.
+	// Note that this can only happen when lots of bodies are added and removed without updating the physics system in between, normally we avoid taking these locks here as the collectors of queries can lock bodies.
+	unique_lock lock0(mQueryLocks[0]);
+	unique_lock lock1(mQueryLocks[1]);
+
+	Layer &layer = mLayers[inLayer];
+	uint32 current = layer.mCurrent;
+	SortedArrays &arrays = layer.mArrays[current];
+
+	// Remove the entries of bodies that are no longer in this layer, this keeps the entries in order
+	uint32 num_entries = arrays.mNumEntries, num_sorted = arrays.mNumSorted;
+	uint32 num_kept = 0, num_kept_sorted = 0;
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		SortEntry *entries = arrays.mAxes[axis].mEntries.data();
+		num_kept = 0;
+		for (uint32 i = 0; i < num_entries; ++i)
+		{
+			if (i == num_sorted)
+				num_kept_sorted = num_kept;
+
+			const SortEntry &e = entries[i];
+			Tracking &t = mTracking[e.mBodyID.GetIndex()];
+			if (t.mBroadPhaseLayer == inLayer && t.mIndex[current][axis] == i)
+			{
+				t.mIndex[current][axis] = num_kept;
+				entries[num_kept++] = e;
+			}
+		}
+		if (num_sorted >= num_entries)
+			num_kept_sorted = num_kept;
+	}
+
+	arrays.mNumSorted = num_kept_sorted;
+	arrays.mNumEntries = num_kept;
+}
+
+void BroadPhaseSAP::AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// This cannot run concurrently with UpdatePrepare()/UpdateFinalize()
+	SharedLock lock(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+
+	BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	lock_guard add_remove_lock(mAddRemoveMutex);
+
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		Body &body = *bodies[index];
+
+		// Validate that body ID is consistent with array index
+		JPH_ASSERT(body.GetID() == *b);
+		JPH_ASSERT(!body.IsInBroadPhase());
+
+		// Get layer
+		BroadPhaseLayer::Type broadphase_layer = (BroadPhaseLayer::Type)body.GetBroadPhaseLayer();
+		JPH_ASSERT(broadphase_layer < mNumLayers);
+		Layer &layer = mLayers[broadphase_layer];
+		uint32 current = layer.mCurrent;
+		SortedArrays &arrays = layer.mArrays[current];
+
+		// Make space when the arrays are filled up with bodies that have been removed
+		if (arrays.mNumEntries == mMaxBodies)
+			CompactLayer(broadphase_layer);
+
+		// Update tracking information
+		Tracking &t = mTracking[index];
+		const AABox &bounds = body.GetWorldSpaceBounds();
+		bounds.mMin.StoreFloat3(&t.mBoundsMin);
+		bounds.mMax.StoreFloat3(&t.mBoundsMax);
+		t.mObjectLayer = body.GetObjectLayer();
+
+		// Append to the unsorted part of the arrays, the entries need to be written before they become visible to queries
+		uint32 array_idx = arrays.mNumEntries.load(memory_order_relaxed);
+		JPH_ASSERT(array_idx < mMaxBodies);
+		for (uint axis = 0; axis < 3; ++axis)
+		{
+			t.mKey[axis] = t.mBoundsMin[axis];
+			arrays.mAxes[axis].mEntries[array_idx] = { t.mKey[axis], *b };
+			t.mIndex[current][axis] = array_idx;
+		}
+		t.mBroadPhaseLayer = broadphase_layer;
+		arrays.mNumEntries.store(array_idx + 1, memory_order_release);
+
+		++layer.mNumBodies;
+		layer.mIsDirty = true;
+
+		// Indicate body is in the broadphase
+		body.SetInBroadPhaseInternal(true);
+	}
+}
+
+void BroadPhaseSAP::RemoveBodies(BodyID *ioBodies, int inNumber)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// This cannot run concurrently with UpdatePrepare()/UpdateFinalize()
+	SharedLock lock(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+
+	BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	lock_guard add_remove_lock(mAddRemoveMutex);
+
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		Body &body = *bodies[index];
+
+		// Validate that body ID is consistent with array index
+		JPH_ASSERT(body.GetID() == *b);
+		JPH_ASSERT(body.IsInBroadPhase());
+
+		// Reset bookkeeping, the entries in the arrays are skipped from now on and discarded by the next sort
+		Tracking &t = mTracking[index];
+		BroadPhaseLayer::Type broadphase_layer = t.mBroadPhaseLayer;
+		JPH_ASSERT(broadphase_layer != (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid);
+		t.mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
+		t.mObjectLayer = cObjectLayerInvalid;
+
+		Layer &layer = mLayers[broadphase_layer];
+		--layer.mNumBodies;
+		layer.mIsDirty = true;
+
+		// Mark removed from broadphase
+		body.SetInBroadPhaseInternal(false);
+	}
+}
+
+void BroadPhaseSAP::NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber, bool inTakeLock)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// This cannot run concurrently with UpdatePrepare()/UpdateFinalize()
+	if (inTakeLock)
+		PhysicsLock::sLockShared(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+	else
+		JPH_ASSERT(mUpdateMutex.is_locked());
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		const Body &body = *bodies[index];
+		JPH_ASSERT(body.GetID() == *b);
+
+		Tracking &t = mTracking[index];
+		BroadPhaseLayer::Type broadphase_layer = t.mBroadPhaseLayer;
+		JPH_ASSERT(broadphase_layer != (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid);
+
+		// Update the bounds in place
+		const AABox &bounds = body.GetWorldSpaceBounds();
+		bounds.mMin.StoreFloat3(&t.mBoundsMin);
+		bounds.mMax.StoreFloat3(&t.mBoundsMax);
+
+		// The body may have moved away from its position in the sorted arrays, widen the range that queries need to look at
+		Layer &layer = mLayers[broadphase_layer];
+		SortedArrays &arrays = layer.mArrays[layer.mCurrent];
+		for (uint axis = 0; axis < 3; ++axis)
+		{
+			AxisArray &a = arrays.mAxes[axis];
+			AtomicMax(a.mMaxBelowKey, t.mKey[axis] - bounds.mMin[axis], memory_order_relaxed);
+			AtomicMax(a.mMaxAboveKey, bounds.mMax[axis] - t.mKey[axis], memory_order_relaxed);
+		}
+
+		// Avoid writing to the shared cache line when possible
+		if (!layer.mIsDirty.load(memory_order_relaxed))
+			layer.mIsDirty = true;
+	}
+
+	if (inTakeLock)
+		PhysicsLock::sUnlockShared(mUpdateMutex, EPhysicsLockTypes::BroadPhaseUpdate);
+}
+
+void BroadPhaseSAP::NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// First sort the bodies that actually changed layer to beginning of the array
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+	for (BodyID *body_id = ioBodies + inNumber - 1; body_id >= ioBodies; --body_id)
+	{
+		uint32 index = body_id->GetIndex();
+		JPH_ASSERT(bodies[index]->GetID() == *body_id, "Provided BodyID doesn't match BodyID in body manager");
+		const Body *body = bodies[index];
+		BroadPhaseLayer::Type broadphase_layer = (BroadPhaseLayer::Type)body->GetBroadPhaseLayer();
+		JPH_ASSERT(broadphase_layer < mNumLayers);
+		if (mTracking[index].mBroadPhaseLayer == broadphase_layer)
+		{
+			// Update tracking information
+			mTracking[index].mObjectLayer = body->GetObjectLayer();
+
+			// Move the body to the end, layer didn't change
+			swap(*body_id, ioBodies[inNumber - 1]);
+			--inNumber;
+		}
+	}
+
+	if (inNumber > 0)
+	{
+		// Changing layer requires us to remove from one layer and add to another, so this is equivalent to removing all bodies first and then adding them again
+		RemoveBodies(ioBodies, inNumber);
+		AddBodiesFinalize(ioBodies, inNumber, nullptr);
+	}
+}
+
+void BroadPhaseSAP::sFindSweepRange(const SortedArrays &inArrays, Vec3Arg inMin, Vec3Arg inMax, uint &outAxis, const SortEntry *&outBegin, const SortEntry *&outEnd)
+{
+	auto key_less = [](const SortEntry &inEntry, float inKey) { return inEntry.mKey < inKey; };
+	auto less_key = [](float inKey, const SortEntry &inEntry) { return inKey < inEntry.mKey; };
+
+	uint32 num_sorted = inArrays.mNumSorted;
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		const AxisArray &a = inArrays.mAxes[axis];
+		const SortEntry *entries = a.mEntries.data();
+		const SortEntry *sorted_end = entries + num_sorted;
+
+		// The keys of the bodies that can overlap are in the range [min - max above key, max + max below key]
+		float min_key = inMin[axis] - a.mMaxAboveKey.load(memory_order_relaxed);
+		float max_key = inMax[axis] + a.mMaxBelowKey.load(memory_order_relaxed);
+
+		// Binary search for the range and keep the axis with the fewest entries
+		const SortEntry *begin = lower_bound(entries, sorted_end, min_key, key_less);
+		const SortEntry *end = upper_bound(begin, sorted_end, max_key, less_key);
+		if (axis == 0 || end - begin < outEnd - outBegin)
+		{
+			outAxis = axis;
+			outBegin = begin;
+			outEnd = end;
+
+			// Nothing can be rejected any further
+			if (begin == end)
+				break;
+		}
+	}
+}
+
+template <class Visitor>
+bool BroadPhaseSAP::VisitLayer(BroadPhaseLayer::Type inLayer, Vec3Arg inMin, Vec3Arg inMax, Visitor &ioVisitor) const
+{
+	const Layer &layer = mLayers[inLayer];
+	uint32 current = layer.mCurrent.load(memory_order_acquire);
+	const SortedArrays &arrays = layer.mArrays[current];
+	uint32 num_entries = arrays.mNumEntries.load(memory_order_acquire);
+
+	// Select the axis to sweep, the bodies that are visited are rejected on the other axes by the visitor
+	uint axis;
+	const SortEntry *begin, *end;
+	sFindSweepRange(arrays, inMin, inMax, axis, begin, end);
+	const SortEntry *entries = arrays.mAxes[axis].mEntries.data();
+
+	// Visits a single entry if the body is still stored at this location
+	auto visit = [this, inLayer, current, axis, entries, &ioVisitor](const SortEntry *inEntry)
+	{
+		BodyID body_id = inEntry->mBodyID;
+		const Tracking &t = mTracking[body_id.GetIndex()];
+		return t.mBroadPhaseLayer.load(memory_order_relaxed) == inLayer
+			&& t.mIndex[current][axis].load(memory_order_relaxed) == uint32(inEntry - entries)
+			&& ioVisitor(body_id, t);
+	};
+
+	// Sweep over the bodies in the range
+	for (const SortEntry *e = begin; e < end; ++e)
+		if (visit(e))
+			return true;
+
+	// Test all bodies that have been added since the last sort
+	for (const SortEntry *e = entries + arrays.mNumSorted, *e_end = entries + num_entries; e < e_end; ++e)
+		if (visit(e))
+			return true;
+
+	return false;
+}
+
+void BroadPhaseSAP::CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	// Load ray
+	Vec3 origin(inRay.mOrigin);
+	RayInvDirection inv_direction(inRay.mDirection);
+
+	// Test the bounds of a body
+	float early_out_fraction = ioCollector.GetEarlyOutFraction();
+	auto visitor = BroadPhaseCastBoundsVisitor(origin, Vec3::sZero(), inv_direction, inObjectLayerFilter, ioCollector, early_out_fraction);
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+		{
+			// Test the bodies that overlap with the bounds of the ray
+			Vec3 end = origin + early_out_fraction * inRay.mDirection;
+			if (VisitLayer(l, Vec3::sMin(origin, end), Vec3::sMax(origin, end), visitor))
+				break;
+		}
+}
+
+void BroadPhaseSAP::CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	// Test the bounds of a body
+	auto overlaps = [&inBox](const AABox &inBounds) { return inBounds.Overlaps(inBox); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+			if (VisitLayer(l, inBox.mMin, inBox.mMax, visitor))
+				break;
+}
+
+void BroadPhaseSAP::CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	// Test the bounds of a body
+	float radius_sq = Square(inRadius);
+	auto overlaps = [inCenter, radius_sq](const AABox &inBounds) { return inBounds.GetSqDistanceTo(inCenter) <= radius_sq; };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	// Loop over all layers and test the ones that could hit
+	Vec3 radius = Vec3::sReplicate(inRadius);
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+			if (VisitLayer(l, inCenter - radius, inCenter + radius, visitor))
+				break;
+}
+
+void BroadPhaseSAP::CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	// Test the bounds of a body
+	auto overlaps = [inPoint](const AABox &inBounds) { return inBounds.Contains(inPoint); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+			if (VisitLayer(l, inPoint, inPoint, visitor))
+				break;
+}
+
+void BroadPhaseSAP::CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	// Test the bounds of a body
+	auto overlaps = [&inBox](const AABox &inBounds) { return inBox.Overlaps(inBounds); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	// Loop over all layers and test the ones that could hit
+	AABox bounds = AABox(-inBox.mHalfExtents, inBox.mHalfExtents).Transformed(inBox.mOrientation);
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+			if (VisitLayer(l, bounds.mMin, bounds.mMax, visitor))
+				break;
+}
+
+void BroadPhaseSAP::CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Load box
+	Vec3 origin(inBox.mBox.GetCenter());
+	Vec3 extent(inBox.mBox.GetExtent());
+	RayInvDirection inv_direction(inBox.mDirection);
+
+	// Test the bounds of a body, expanded by the extent of the box
+	float early_out_fraction = ioCollector.GetEarlyOutFraction();
+	auto visitor = BroadPhaseCastBoundsVisitor(origin, extent, inv_direction, inObjectLayerFilter, ioCollector, early_out_fraction);
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (mLayers[l].mNumBodies > 0 && inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+		{
+			// Test the bodies that overlap with the bounds of the swept box
+			Vec3 offset = early_out_fraction * inBox.mDirection;
+			if (VisitLayer(l, inBox.mBox.mMin + Vec3::sMin(offset, Vec3::sZero()), inBox.mBox.mMax + Vec3::sMax(offset, Vec3::sZero()), visitor))
+				break;
+		}
+}
+
+void BroadPhaseSAP::CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	// Prevent this from running in parallel with sorting the next arrays, see notes in FrameSync()
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	CastAABoxNoLock(inBox, ioCollector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+}
+
+void BroadPhaseSAP::FindCollidingPairs(BodyID *ioActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter, BodyPairCollector &ioPairCollector) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Note that we don't take any locks at this point. We know that the arrays are not going to be swapped or overwritten while finding collision pairs due to the way the jobs are scheduled in the PhysicsSystem::Update.
+
+	// Loop over all active bodies
+	for (int b1 = 0; b1 < inNumActiveBodies; ++b1)
+	{
+		BodyID b1_id = ioActiveBodies[b1];
+		const Body &body1 = *bodies[b1_id.GetIndex()];
+		JPH_ASSERT(!body1.IsStatic());
+		const ObjectLayer layer1 = body1.GetObjectLayer();
+
+		// Expand the bounding box by the speculative contact distance
+		AABox bounds1 = body1.GetWorldSpaceBounds();
+		bounds1.ExpandBy(Vec3::sReplicate(inSpeculativeContactDistance));
+
+		// Test against a single body
+		auto visitor = BroadPhasePairBoundsVisitor(bodies, body1, bounds1, inObjectLayerPairFilter, ioPairCollector);
+
+		// Loop over all layers and test the ones that could hit
+		for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+			if (mLayers[l].mNumBodies > 0 && inObjectVsBroadPhaseLayerFilter(layer1, BroadPhaseLayer(l)))
+				VisitLayer(l, bounds1.mMin, bounds1.mMax, visitor);
+	}
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Core/Mutex.h>
+#include <Jolt/Core/Atomics.h>
+#include <Jolt/Core/STLAllocator.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Sweep and prune BroadPhase. Each broadphase layer keeps an array of bodies per axis sorted on the minimum of their bounding box along that axis.
+/// When a body moves only its bounds are updated, the arrays are resorted in UpdatePrepare (which runs in a background job) using an insertion sort.
+/// Because bodies don't move much between physics steps the arrays are nearly sorted and this takes close to linear time.
+/// Queries do a binary search on all 3 axes and sweep the axis that has the fewest bodies in the range of the query, the bodies that are visited
+/// are rejected on the other 2 axes by testing their bounds. This means that a scene that is flat (or a tall stack) is swept along the axis in which
+/// the bodies near the query are spread out the most, only bodies that overlap with the query along every axis need to be tested.
+/// A single large body in a layer widens the range that every query needs to sweep, put such bodies in their own layer.
+/// Note that each layer reserves space for all bodies, so memory usage is 2 * 3 * number of broadphase layers * max bodies * 8 bytes on top of the per body data.
+class BroadPhaseSAP final : public BroadPhase
+{
+public:
+	/// Destructor
+	virtual					~BroadPhaseSAP() override;
+
+	// Implementing interface of BroadPhase (see BroadPhase for documentation)
+	virtual void			Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface) override;
+	virtual void			Optimize() override;
+	virtual void			FrameSync() override;
+	virtual void			LockModifications() override;
+	virtual	UpdateState		UpdatePrepare() override;
+	virtual void			UpdateFinalize(const UpdateState &inUpdateState) override;
+	virtual void			UnlockModifications() override;
+	virtual void			AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState) override;
+	virtual void			RemoveBodies(BodyID *ioBodies, int inNumber) override;
+	virtual void			NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber, bool inTakeLock) override;
+	virtual void			NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber) override;
+	virtual void			CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			FindCollidingPairs(BodyID *ioActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter, BodyPairCollector &ioPairCollector) const override;
+
+	/// Get the axis (0 = X, 1 = Y, 2 = Z) that a query for inBounds sweeps in inLayer, this is the axis along which the fewest sorted bodies overlap with inBounds
+	uint					GetSweepAxis(BroadPhaseLayer inLayer, const AABox &inBounds) const;
+
+private:
+	/// For each body keeps track of where it is stored and what its bounds are
+	struct Tracking
+	{
+		/// Constructor to satisfy the vector class
+							Tracking() = default;
+							Tracking(const Tracking &inRHS) : mBroadPhaseLayer(inRHS.mBroadPhaseLayer.load()), mObjectLayer(inRHS.mObjectLayer.load()), mKey { inRHS.mKey[0], inRHS.mKey[1], inRHS.mKey[2] }, mBoundsMin(inRHS.mBoundsMin), mBoundsMax(inRHS.mBoundsMax) { for (int a = 0; a < 2; ++a) for (int i = 0; i < 3; ++i) mIndex[a][i] = inRHS.mIndex[a][i].load(); }
+
+		atomic<BroadPhaseLayer::Type> mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
+		atomic<ObjectLayer>	mObjectLayer = cObjectLayerInvalid;
+		atomic<uint32>		mIndex[2][3] { };										///< Index of the body in the array of each axis, for both sets of sorted arrays of its layer
+		float				mKey[3];												///< Minimum of the bounds per axis at the time the body was sorted (or added)
+		Float3				mBoundsMin;												///< World space bounds of the body
+		Float3				mBoundsMax;
+	};
+
+	using TrackingVector = TaggedVector<Tracking, EMemoryTag::BroadPhase>;
+
+	/// Element of a sorted array
+	struct SortEntry
+	{
+		float				mKey;													///< Sort key, see Tracking::mKey
+		BodyID				mBodyID;												///< Body that this element refers to
+	};
+
+	/// Array of bodies sorted along a single axis
+	struct AxisArray
+	{
+		TaggedVector<SortEntry, EMemoryTag::BroadPhase> mEntries;	///< Space for all bodies, entries [0, SortedArrays::mNumSorted) are sorted on mKey and the entries after that have been added since and are not sorted
+		atomic<float>		mMaxBelowKey { 0.0f };									///< Max distance that the minimum of the bounds of a sorted body along this axis lies below its key
+		atomic<float>		mMaxAboveKey { 0.0f };									///< Max distance that the maximum of the bounds of a sorted body along this axis lies above its key
+	};
+
+	/// The bodies of a layer sorted along all 3 axes, each layer has 2 of these so that the next one can be sorted while the current one is being queried.
+	/// All axes contain the same bodies, the unsorted entries of bodies that were added since the last sort are stored at the same index on every axis.
+	struct SortedArrays
+	{
+		AxisArray			mAxes[3];
+		atomic<uint32>		mNumEntries { 0 };										///< Number of used entries per axis, this includes entries of bodies that have been removed (these are skipped)
+		uint32				mNumSorted = 0;											///< Number of sorted entries per axis
+	};
+
+	/// All bodies in a broadphase layer
+	struct Layer
+	{
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::BroadPhase)
+
+		SortedArrays		mArrays[2];
+		atomic<uint32>		mCurrent { 0 };											///< Index in mArrays of the arrays that are used for queries and modifications
+		atomic<uint32>		mNumBodies { 0 };										///< Number of bodies in this layer
+		atomic<bool>		mIsDirty { false };										///< If bodies were added, removed or moved since the last sort
+		bool				mCanBeSorted = true;									///< The next array may still be in use by queries until FrameSync is called, so a layer can only be sorted once per FrameSync
+	};
+
+	/// Sort the bodies of the current arrays of inLayer into the next arrays, when inFullSort is true the arrays are sorted from scratch instead of incrementally
+	void					SortLayer(BroadPhaseLayer::Type inLayer, bool inFullSort);
+
+	/// Find the entries of the sorted part of the arrays of inLayer that can overlap with the range [inMin, inMax] along the axis that has the fewest of them
+	static void				sFindSweepRange(const SortedArrays &inArrays, Vec3Arg inMin, Vec3Arg inMax, uint &outAxis, const SortEntry *&outBegin, const SortEntry *&outEnd);
+
+	/// Visit all bodies in inLayer with bounds that can overlap with the range [inMin, inMax] along the sweep axis of the query.
+	/// ioVisitor is called as ioVisitor(BodyID, const Tracking &) and returns true when the query should stop, the function returns true when the query was stopped.
+	template <class Visitor>
+	bool					VisitLayer(BroadPhaseLayer::Type inLayer, Vec3Arg inMin, Vec3Arg inMax, Visitor &ioVisitor) const;
+
+	/// Remove the entries of bodies that are no longer in inLayer from the current arrays of the layer, used when the arrays are full when adding bodies
+	void					CompactLayer(BroadPhaseLayer::Type inLayer);
+
+	/// Max amount of bodies we support
+	size_t					mMaxBodies = 0;
+
+	/// Array that for each BodyID keeps track of where it is located and what its bounds are
+	TrackingVector			mTracking;
+
+	/// Sorted arrays per broadphase layer
+	Layer *					mLayers = nullptr;
+	uint					mNumLayers = 0;
+
+	/// UpdateState implementation for this broadphase used during UpdatePrepare/Finalize()
+	struct UpdateStateImpl
+	{
+		uint64				mSortedLayers;											///< Bit mask of layers that were sorted into their next array
+	};
+
+	static_assert(sizeof(UpdateStateImpl) <= sizeof(UpdateState));
+	static_assert(alignof(UpdateStateImpl) <= alignof(UpdateState));
+
+	/// Mutex that prevents object modification during UpdatePrepare/Finalize()
+	SharedMutex				mUpdateMutex;
+
+	/// Mutex that serializes adding and removing bodies, no other locks are taken while this mutex is held
+	Mutex					mAddRemoveMutex;
+
+	/// We double buffer all sorted arrays so that we can query while sorting the next one and we overwrite the old array the next physics update.
+	/// This structure ensures that we wait for queries that are still using the old array.
+	mutable SharedMutex		mQueryLocks[2];
+
+	/// This index indicates which lock is currently active, it alternates between 0 and 1
+	atomic<uint32>			mQueryLockIdx { 0 };
+};
+
+JPH_NAMESPACE_END
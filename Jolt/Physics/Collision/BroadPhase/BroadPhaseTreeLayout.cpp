@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseTreeLayout.h>
+#include <Jolt/Physics/Collision/BroadPhase/QuadTree.h>
+#include <Jolt/Core/StreamIn.h>
+#include <Jolt/Core/StreamOut.h>
+
+JPH_NAMESPACE_BEGIN
+
+void BroadPhaseTreeLayout::Build(const AABox *inBounds, uint inNumBodies)
+{
+	QuadTree::sBuildLayout(inBounds, inNumBodies, *this);
+}
+
+bool BroadPhaseTreeLayout::IsValid() const
+{
+	// A single body doesn't need any nodes, more bodies do
+	if (mNodes.empty())
+		return mNumBodies <= 1;
+	if (mNumBodies < 2)
+		return false;
+
+	TaggedVector<bool, EMemoryTag::BroadPhase> body_used(mNumBodies, false);
+	TaggedVector<bool, EMemoryTag::BroadPhase> node_used(mNodes.size(), false);
+	node_used[0] = true;
+	for (uint32 n = 0; n < (uint32)mNodes.size(); ++n)
+		for (uint32 child : mNodes[n].mChildren)
+			if (child == cInvalidChild)
+				continue;
+			else if ((child & cIsNode) != 0)
+			{
+				// Children must come after their parent so that the tree can be built bottom up by walking the nodes in reverse order
+				uint32 child_idx = child & ~cIsNode;
+				if (child_idx <= n || child_idx >= (uint32)mNodes.size() || node_used[child_idx])
+					return false;
+				node_used[child_idx] = true;
+			}
+			else
+			{
+				if (child >= mNumBodies || body_used[child])
+					return false;
+				body_used[child] = true;
+			}
+
+	// All nodes and bodies must be referenced
+	for (bool b : body_used)
+		if (!b)
+			return false;
+	for (bool b : node_used)
+		if (!b)
+			return false;
+	return true;
+}
+
+void BroadPhaseTreeLayout::SaveBinaryState(StreamOut &inStream) const
+{
+	inStream.Write(mNumBodies);
+	inStream.Write(mNodes);
+}
+
+void BroadPhaseTreeLayout::RestoreBinaryState(StreamIn &inStream)
+{
+	inStream.Read(mNumBodies);
+	inStream.Read(mNodes);
+}
+
+JPH_NAMESPACE_END
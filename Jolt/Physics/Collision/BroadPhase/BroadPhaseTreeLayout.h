@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Geometry/AABox.h>
+
+JPH_NAMESPACE_BEGIN
+
+class StreamIn;
+class StreamOut;
+
+/// Structure of a broadphase tree that was built in advance for a batch of bodies (e.g. the static bodies of a level when it is saved).
+/// Adding the batch with BroadPhase::AddBodiesPrepareFromLayout then doesn't need to build a tree and the broadphase doesn't need to be optimized afterwards.
+/// Only the structure of the tree is stored, the bounding boxes are taken from the bodies when they're added.
+class BroadPhaseTreeLayout
+{
+public:
+	/// Bit that is set for a child that refers to another node in mNodes, when it is not set the child refers to a body (index in the array of bodies that the layout was built for)
+	static constexpr uint32		cIsNode = 0x80000000;
+
+	/// Value for a child that is not used
+	static constexpr uint32		cInvalidChild = 0xffffffff;
+
+	/// A node in the tree
+	struct Node
+	{
+		uint32					mChildren[4];					///< Index of child node (| cIsNode), index of body or cInvalidChild
+	};
+
+	/// Build the layout for inNumBodies bodies with bounding boxes inBounds, this uses the same algorithm as the broadphase uses to build its trees
+	void						Build(const AABox *inBounds, uint inNumBodies);
+
+	/// Check if the layout is consistent: every body is referenced exactly once and every node is referenced once by a node that comes before it in mNodes
+	bool						IsValid() const;
+
+	/// Saves the state of this object in binary form to inStream.
+	void						SaveBinaryState(StreamOut &inStream) const;
+
+	/// Restore the state of this object from inStream. Call IsValid afterwards when the stream is not trusted.
+	void						RestoreBinaryState(StreamIn &inStream);
+
+	/// Number of bodies that the layout was built for
+	uint32						mNumBodies = 0;
+
+	/// All nodes of the tree, the first node is the root. When there is only a single body there are no nodes.
+	TaggedVector<Node, EMemoryTag::BroadPhase>	mNodes;
+};
+
+JPH_NAMESPACE_END
@@ -0,0 +1,457 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/BroadPhase/HashedGrid.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBoundsVisitors.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Geometry/OrientedBox.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Extra distance (as fraction of the cell size) by which queries are enlarged to compensate for rounding errors when calculating cell coordinates
+static constexpr float cCellSlack = 1.0e-3f;
+
+/// Maximum amount of boxes that a cast is split up in
+static constexpr int cMaxCastBoxes = 16;
+
+void HashedGrid::Init(float inCellSize, uint inMaxBodies)
+{
+	JPH_ASSERT(inCellSize > 0.0f || inCellSize == cAutoCellSize);
+	mCellSize = inCellSize;
+
+	for (Grid &grid : mGrids)
+	{
+		// Start with a single empty bucket, when the cell size is calculated automatically we start with 1 m cells
+		grid.mCellSize = inCellSize > 0.0f? inCellSize : 1.0f;
+		grid.mInvCellSize = 1.0f / grid.mCellSize;
+		grid.mBucketMask = 0;
+		grid.mBucketStart.assign(2, 0);
+
+		// Reserve space for all bodies so that the list of added bodies never needs to be reallocated while it is being queried
+		grid.mAdded = TaggedVector<atomic<uint32>, EMemoryTag::BroadPhase>(inMaxBodies);
+		grid.mFreeAdded.reserve(inMaxBodies);
+	}
+}
+
+inline void HashedGrid::sGetCell(const Grid &inGrid, Vec3Arg inPosition, int *outCell)
+{
+	Vec3 cell = inPosition * inGrid.mInvCellSize;
+	for (int i = 0; i < 3; ++i)
+		outCell[i] = int(Clamp(floor(cell[i]), -float(cMaxCellCoordinate), float(cMaxCellCoordinate)));
+}
+
+inline uint32 HashedGrid::sGetBucket(const Grid &inGrid, int inX, int inY, int inZ)
+{
+	return ((uint32(inX) * 73856093U) ^ (uint32(inY) * 19349663U) ^ (uint32(inZ) * 83492791U)) & inGrid.mBucketMask;
+}
+
+bool HashedGrid::sAddBuckets(const Grid &inGrid, Vec3Arg inMin, Vec3Arg inMax, BucketList &ioBuckets)
+{
+	// Bodies can extend beyond the cell they're stored in by the margin
+	Vec3 margin = Vec3::sReplicate(inGrid.mMargin.load(memory_order_relaxed) + cCellSlack * inGrid.mCellSize);
+	int min_cell[3], max_cell[3];
+	sGetCell(inGrid, inMin - margin, min_cell);
+	sGetCell(inGrid, inMax + margin, max_cell);
+
+	// Check if we can store all buckets, if there are more cells than buckets it is cheaper to test all bodies
+	uint64 num_cells = uint64(max_cell[0] - min_cell[0] + 1) * uint64(max_cell[1] - min_cell[1] + 1) * uint64(max_cell[2] - min_cell[2] + 1);
+	if (num_cells > uint64(cMaxQueryBuckets - ioBuckets.mNumBuckets) || num_cells > uint64(inGrid.mBucketMask) + 1)
+		return false;
+
+	for (int z = min_cell[2]; z <= max_cell[2]; ++z)
+		for (int y = min_cell[1]; y <= max_cell[1]; ++y)
+			for (int x = min_cell[0]; x <= max_cell[0]; ++x)
+				ioBuckets.mBuckets[ioBuckets.mNumBuckets++] = sGetBucket(inGrid, x, y, z);
+	return true;
+}
+
+void HashedGrid::UpdatePrepare(TrackingVector &ioTracking)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(mCanBeUpdated && !mNextGridReady);
+	mIsDirty = false;
+
+	uint32 current = mCurrentGrid;
+	const Grid &src = mGrids[current];
+	Grid &dst = mGrids[current ^ 1];
+
+	// Collect all bodies that are still in the grid
+	TaggedVector<BodyID, EMemoryTag::BroadPhase> body_ids;
+	body_ids.reserve(mNumBodies);
+	for (const Entry &e : src.mEntries)
+	{
+		uint32 body_id = e.mBodyID.load(memory_order_relaxed);
+		if (body_id != BodyID::cInvalidBodyID)
+			body_ids.push_back(BodyID(body_id));
+	}
+	for (uint32 i = 0, n = src.mNumAdded; i < n; ++i)
+	{
+		uint32 body_id = src.mAdded[i].load(memory_order_relaxed);
+		if (body_id != BodyID::cInvalidBodyID)
+			body_ids.push_back(BodyID(body_id));
+	}
+	JPH_ASSERT(body_ids.size() == mNumBodies);
+	uint32 num_bodies = (uint32)body_ids.size();
+
+	// Determine the cell size, when it is calculated automatically we use twice the average of the largest edge of the bounding boxes
+	float cell_size = mCellSize;
+	if (cell_size == cAutoCellSize)
+	{
+		float sum_size = 0.0f;
+		for (BodyID body_id : body_ids)
+		{
+			const Tracking &t = ioTracking[body_id.GetIndex()];
+			sum_size += (Vec3(t.mBoundsMax) - Vec3(t.mBoundsMin)).ReduceMax();
+		}
+		cell_size = num_bodies > 0? max(2.0f * sum_size / num_bodies, 1.0e-3f) : src.mCellSize;
+	}
+	dst.mCellSize = cell_size;
+	dst.mInvCellSize = 1.0f / cell_size;
+
+	// Use roughly 1 bucket per body
+	uint32 num_buckets = GetNextPowerOf2(max(num_bodies, 1U));
+	dst.mBucketMask = num_buckets - 1;
+
+	// Determine the cell and bucket of each body and count the number of bodies per bucket
+	TaggedVector<int, EMemoryTag::BroadPhase> cells(3 * num_bodies);
+	TaggedVector<uint32, EMemoryTag::BroadPhase> bucket_of_body(num_bodies);
+	dst.mBucketStart.assign(num_buckets + 1, 0);
+	for (uint32 i = 0; i < num_bodies; ++i)
+	{
+		const Tracking &t = ioTracking[body_ids[i].GetIndex()];
+		int *cell = &cells[3 * i];
+		sGetCell(dst, 0.5f * (Vec3(t.mBoundsMin) + Vec3(t.mBoundsMax)), cell);
+		uint32 bucket = sGetBucket(dst, cell[0], cell[1], cell[2]);
+		bucket_of_body[i] = bucket;
+		dst.mBucketStart[bucket + 1]++;
+	}
+
+	// Calculate the start of each bucket
+	for (uint32 b = 0; b < num_buckets; ++b)
+		dst.mBucketStart[b + 1] += dst.mBucketStart[b];
+
+	// Place the bodies in their buckets
+	dst.mEntries.resize(num_bodies);
+	TaggedVector<uint32, EMemoryTag::BroadPhase> next_in_bucket(dst.mBucketStart.begin(), dst.mBucketStart.end() - 1);
+	float margin = 0.0f;
+	for (uint32 i = 0; i < num_bodies; ++i)
+	{
+		BodyID body_id = body_ids[i];
+		uint32 entry_idx = next_in_bucket[bucket_of_body[i]]++;
+		Entry &e = dst.mEntries[entry_idx];
+		e.mBodyID.store(body_id.GetIndexAndSequenceNumber(), memory_order_relaxed);
+		e.mCellX = cells[3 * i];
+		e.mCellY = cells[3 * i + 1];
+		e.mCellZ = cells[3 * i + 2];
+
+		// Calculate how far the body extends beyond its cell
+		Tracking &t = ioTracking[body_id.GetIndex()];
+		Vec3 cell_min = Vec3(float(e.mCellX), float(e.mCellY), float(e.mCellZ)) * cell_size;
+		margin = max(margin, Vec3::sMax(cell_min - Vec3(t.mBoundsMin), Vec3(t.mBoundsMax) - cell_min - Vec3::sReplicate(cell_size)).ReduceMax());
+
+		// Store the new location of the body, this is not used by queries so can be done while the current grid is being queried
+		t.mBodyLocation = entry_idx;
+	}
+	dst.mMargin = margin;
+
+	// Everything that was added has been merged into the grid
+	dst.mNumAdded = 0;
+	dst.mFreeAdded.clear();
+
+	mNextGridReady = true;
+}
+
+void HashedGrid::UpdateFinalize()
+{
+	if (!mNextGridReady)
+		return;
+
+	// Make all queries from now on use the new grid
+	mCurrentGrid.store(mCurrentGrid.load(memory_order_relaxed) ^ 1, memory_order_release);
+	mNextGridReady = false;
+	mCanBeUpdated = false;
+}
+
+void HashedGrid::AddBodies(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber)
+{
+	lock_guard lock(mAddedMutex);
+
+	Grid &grid = mGrids[mCurrentGrid];
+
+	for (const BodyID *b = inBodyIDs, *b_end = inBodyIDs + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		const Body &body = *inBodies[index];
+		JPH_ASSERT(body.GetID() == *b);
+
+		// Store the bounds of the body
+		Tracking &t = ioTracking[index];
+		const AABox &bounds = body.GetWorldSpaceBounds();
+		bounds.mMin.StoreFloat3(&t.mBoundsMin);
+		bounds.mMax.StoreFloat3(&t.mBoundsMax);
+
+		// Reuse an element that was freed by removing a body or append a new one
+		uint32 num_added = grid.mNumAdded.load(memory_order_relaxed);
+		uint32 added_idx;
+		if (!grid.mFreeAdded.empty())
+		{
+			added_idx = grid.mFreeAdded.back();
+			grid.mFreeAdded.pop_back();
+		}
+		else
+			added_idx = num_added;
+		JPH_ASSERT(added_idx < grid.mAdded.size());
+
+		// The tracking information needs to be written before the body becomes visible to queries
+		t.mBodyLocation = added_idx | cAddedBit;
+		grid.mAdded[added_idx].store(b->GetIndexAndSequenceNumber(), memory_order_release);
+		if (added_idx == num_added)
+			grid.mNumAdded.store(num_added + 1, memory_order_release);
+	}
+
+	mNumBodies += inNumber;
+	mIsDirty = true;
+}
+
+void HashedGrid::RemoveBodies(TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber)
+{
+	lock_guard lock(mAddedMutex);
+
+	Grid &grid = mGrids[mCurrentGrid];
+
+	for (const BodyID *b = inBodyIDs, *b_end = inBodyIDs + inNumber; b < b_end; ++b)
+	{
+		// Invalidate the element that stores the body, queries will skip it from now on
+		Tracking &t = ioTracking[b->GetIndex()];
+		uint32 location = t.mBodyLocation;
+		JPH_ASSERT(location != Tracking::cInvalidBodyLocation);
+		if (location & cAddedBit)
+		{
+			uint32 added_idx = location & ~cAddedBit;
+			JPH_ASSERT(grid.mAdded[added_idx] == b->GetIndexAndSequenceNumber());
+			grid.mAdded[added_idx].store(BodyID::cInvalidBodyID, memory_order_relaxed);
+			grid.mFreeAdded.push_back(added_idx);
+		}
+		else
+		{
+			JPH_ASSERT(grid.mEntries[location].mBodyID == b->GetIndexAndSequenceNumber());
+			grid.mEntries[location].mBodyID.store(BodyID::cInvalidBodyID, memory_order_relaxed);
+		}
+		t.mBodyLocation = Tracking::cInvalidBodyLocation;
+	}
+
+	JPH_ASSERT(mNumBodies >= uint32(inNumber));
+	mNumBodies -= inNumber;
+	mIsDirty = true;
+}
+
+void HashedGrid::NotifyBodiesAABBChanged(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber)
+{
+	// The body locations refer to the next grid between UpdatePrepare and UpdateFinalize
+	JPH_ASSERT(!mNextGridReady);
+
+	Grid &grid = mGrids[mCurrentGrid];
+	float cell_size = grid.mCellSize;
+
+	float margin = 0.0f;
+	for (const BodyID *b = inBodyIDs, *b_end = inBodyIDs + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		const Body &body = *inBodies[index];
+		JPH_ASSERT(body.GetID() == *b);
+
+		// Update the bounds in place
+		Tracking &t = ioTracking[index];
+		const AABox &bounds = body.GetWorldSpaceBounds();
+		bounds.mMin.StoreFloat3(&t.mBoundsMin);
+		bounds.mMax.StoreFloat3(&t.mBoundsMax);
+
+		// The body may have moved out of its cell, calculate how far it extends beyond it (bodies in the list of added bodies are always tested)
+		uint32 location = t.mBodyLocation;
+		JPH_ASSERT(location != Tracking::cInvalidBodyLocation);
+		if ((location & cAddedBit) == 0)
+		{
+			const Entry &e = grid.mEntries[location];
+			Vec3 cell_min = Vec3(float(e.mCellX), float(e.mCellY), float(e.mCellZ)) * cell_size;
+			margin = max(margin, Vec3::sMax(cell_min - bounds.mMin, bounds.mMax - cell_min - Vec3::sReplicate(cell_size)).ReduceMax());
+		}
+	}
+
+	// Widen the area that queries need to look at
+	AtomicMax(grid.mMargin, margin, memory_order_relaxed);
+
+	// Avoid writing to the shared cache line when possible
+	if (!mIsDirty.load(memory_order_relaxed))
+		mIsDirty = true;
+}
+
+/// Split a cast of inBox along inDirection up in boxes that are around the size of a cell and returns the amount of boxes
+static int sGetCastBoxes(float inCellSize, const AABox &inBox, Vec3Arg inDirection, AABox *outBoxes)
+{
+	int num_boxes = Clamp(int(ceil(inDirection.Length() / inCellSize)), 1, cMaxCastBoxes);
+	Vec3 step = inDirection / float(num_boxes);
+	for (int i = 0; i < num_boxes; ++i)
+	{
+		Vec3 start = float(i) * step;
+		Vec3 end = start + step;
+		outBoxes[i] = AABox(inBox.mMin + Vec3::sMin(start, end), inBox.mMax + Vec3::sMax(start, end));
+	}
+	return num_boxes;
+}
+
+template <class Visitor>
+bool HashedGrid::VisitBodies(const AABox *inBoxes, int inNumBoxes, const TrackingVector &inTracking, Visitor &ioVisitor) const
+{
+	const Grid &grid = GetCurrentGrid();
+
+	// Visits a body if it has not been removed
+	auto visit = [&inTracking, &ioVisitor](uint32 inBodyID)
+	{
+		if (inBodyID == BodyID::cInvalidBodyID)
+			return false;
+		BodyID body_id(inBodyID);
+		return ioVisitor(body_id, inTracking[body_id.GetIndex()]);
+	};
+
+	// Collect the buckets that we need to visit
+	BucketList buckets;
+	bool use_buckets = true;
+	for (const AABox *box = inBoxes, *box_end = inBoxes + inNumBoxes; box < box_end && use_buckets; ++box)
+		use_buckets = sAddBuckets(grid, box->mMin, box->mMax, buckets);
+
+	const Entry *entries = grid.mEntries.data();
+	if (use_buckets)
+	{
+		// Multiple cells can map to the same bucket, make sure we visit each bucket only once
+		uint32 *buckets_begin = buckets.mBuckets, *buckets_end = buckets.mBuckets + buckets.mNumBuckets;
+		sort(buckets_begin, buckets_end);
+		buckets_end = unique(buckets_begin, buckets_end);
+
+		for (const uint32 *b = buckets_begin; b < buckets_end; ++b)
+			for (const Entry *e = entries + grid.mBucketStart[*b], *e_end = entries + grid.mBucketStart[*b + 1]; e < e_end; ++e)
+				if (visit(e->mBodyID.load(memory_order_relaxed)))
+					return true;
+	}
+	else
+	{
+		// Query is too big, test all bodies
+		for (const Entry *e = entries, *e_end = entries + grid.mEntries.size(); e < e_end; ++e)
+			if (visit(e->mBodyID.load(memory_order_relaxed)))
+				return true;
+	}
+
+	// Test all bodies that have been added since the grid was built
+	for (uint32 i = 0, n = grid.mNumAdded.load(memory_order_acquire); i < n; ++i)
+		if (visit(grid.mAdded[i].load(memory_order_acquire)))
+			return true;
+
+	return false;
+}
+
+void HashedGrid::CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Load ray
+	Vec3 origin(inRay.mOrigin);
+	RayInvDirection inv_direction(inRay.mDirection);
+
+	// Test the bounds of a body
+	float early_out_fraction = ioCollector.GetEarlyOutFraction();
+	auto visitor = BroadPhaseCastBoundsVisitor(origin, Vec3::sZero(), inv_direction, inObjectLayerFilter, ioCollector, early_out_fraction);
+
+	// Test the cells along the ray
+	AABox boxes[cMaxCastBoxes];
+	int num_boxes = sGetCastBoxes(GetCurrentGrid().mCellSize, AABox(origin, origin), min(early_out_fraction, 1.0f) * inRay.mDirection, boxes);
+	VisitBodies(boxes, num_boxes, inTracking, visitor);
+}
+
+void HashedGrid::CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Test the bounds of a body
+	auto overlaps = [&inBox](const AABox &inBounds) { return inBounds.Overlaps(inBox); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	VisitBodies(&inBox, 1, inTracking, visitor);
+}
+
+void HashedGrid::CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Test the bounds of a body
+	float radius_sq = Square(inRadius);
+	auto overlaps = [inCenter, radius_sq](const AABox &inBounds) { return inBounds.GetSqDistanceTo(inCenter) <= radius_sq; };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	Vec3 radius = Vec3::sReplicate(inRadius);
+	AABox box(inCenter - radius, inCenter + radius);
+	VisitBodies(&box, 1, inTracking, visitor);
+}
+
+void HashedGrid::CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Test the bounds of a body
+	auto overlaps = [inPoint](const AABox &inBounds) { return inBounds.Contains(inPoint); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	AABox box(inPoint, inPoint);
+	VisitBodies(&box, 1, inTracking, visitor);
+}
+
+void HashedGrid::CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Test the bounds of a body
+	auto overlaps = [&inBox](const AABox &inBounds) { return inBox.Overlaps(inBounds); };
+	auto visitor = BroadPhaseCollideBoundsVisitor(inObjectLayerFilter, ioCollector, overlaps);
+
+	AABox box = AABox(-inBox.mHalfExtents, inBox.mHalfExtents).Transformed(inBox.mOrientation);
+	VisitBodies(&box, 1, inTracking, visitor);
+}
+
+void HashedGrid::CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	// Load box
+	Vec3 origin(inBox.mBox.GetCenter());
+	Vec3 extent(inBox.mBox.GetExtent());
+	RayInvDirection inv_direction(inBox.mDirection);
+
+	// Test the bounds of a body, expanded by the extent of the box
+	float early_out_fraction = ioCollector.GetEarlyOutFraction();
+	auto visitor = BroadPhaseCastBoundsVisitor(origin, extent, inv_direction, inObjectLayerFilter, ioCollector, early_out_fraction);
+
+	// Test the cells along the path of the box
+	AABox boxes[cMaxCastBoxes];
+	int num_boxes = sGetCastBoxes(GetCurrentGrid().mCellSize, inBox.mBox, min(early_out_fraction, 1.0f) * inBox.mDirection, boxes);
+	VisitBodies(boxes, num_boxes, inTracking, visitor);
+}
+
+void HashedGrid::FindCollidingPairs(const BodyVector &inBodies, const BodyID *inActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, BodyPairCollector &ioPairCollector, ObjectLayerPairFilter inObjectLayerPairFilter, const TrackingVector &inTracking) const
+{
+	// Note that we don't lock the grid at this point. We know that the grid is not going to be swapped while finding collision pairs due to the way the jobs are scheduled in the PhysicsSystem::Update.
+
+	// Assert sane input
+	JPH_ASSERT(inActiveBodies != nullptr);
+	JPH_ASSERT(inNumActiveBodies > 0);
+
+	// Loop over all active bodies
+	for (int b1 = 0; b1 < inNumActiveBodies; ++b1)
+	{
+		BodyID b1_id = inActiveBodies[b1];
+		const Body &body1 = *inBodies[b1_id.GetIndex()];
+		JPH_ASSERT(!body1.IsStatic());
+
+		// Expand the bounding box by the speculative contact distance
+		AABox bounds1 = body1.GetWorldSpaceBounds();
+		bounds1.ExpandBy(Vec3::sReplicate(inSpeculativeContactDistance));
+
+		// Test against a single body
+		auto visitor = BroadPhasePairBoundsVisitor(inBodies, body1, bounds1, inObjectLayerPairFilter, ioPairCollector);
+
+		VisitBodies(&bounds1, 1, inTracking, visitor);
+	}
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Physics/Collision/BroadPhase/QuadTree.h>
+#include <Jolt/Core/Mutex.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Loose hashed grid that can be used instead of a QuadTree for a broadphase layer that contains many bodies of roughly the same size (e.g. debris or particles).
+/// Each body is stored in the cell that contains the center of its bounding box, the cells are mapped onto a fixed number of buckets using a hash of the cell coordinates.
+/// Instead of moving bodies to another cell when they move, the grid keeps track of how far bodies extend beyond the cell they're stored in and enlarges queries by this margin.
+/// The grid is rebuilt in UpdatePrepare() (which runs in a background job) and swapped in UpdateFinalize(), similar to the QuadTree it is double buffered so that it can be queried while the next grid is being built.
+/// Bodies that are added between rebuilds are stored in a separate list that is tested by every query.
+class HashedGrid : public NonCopyable
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::BroadPhase)
+
+	using Tracking = QuadTree::Tracking;
+	using TrackingVector = QuadTree::TrackingVector;
+
+	/// Special cell size that indicates that the cell size should be calculated from the size of the bodies in the grid
+	static constexpr float		cAutoCellSize = -1.0f;
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+	/// Name of the grid for debugging purposes
+	void						SetName(const char *inName)			{ mName = inName; }
+	inline const char *			GetName() const						{ return mName; }
+#endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
+
+	/// Initialization
+	/// @param inCellSize Size of a cell (m), should be around twice the size of a typical body. Use cAutoCellSize to base it on the average size of the bodies in the grid every time it is rebuilt.
+	/// @param inMaxBodies Maximum number of bodies that can be in the grid
+	void						Init(float inCellSize, uint inMaxBodies);
+
+	/// Check if Init has been called (if not the layer uses a QuadTree)
+	inline bool					IsInitialized() const				{ return mCellSize != 0.0f; }
+
+	/// Check if there is anything in the grid
+	inline bool					HasBodies() const					{ return mNumBodies != 0; }
+
+	/// Check if the grid needs an UpdatePrepare/Finalize()
+	inline bool					IsDirty() const						{ return mIsDirty; }
+
+	/// Check if this grid can get an UpdatePrepare/Finalize() or if it needs a DiscardOldGrid() first
+	inline bool					CanBeUpdated() const				{ return mCanBeUpdated; }
+
+	/// Get the cell size of the grid that is currently used for queries
+	inline float				GetCellSize() const					{ return mGrids[mCurrentGrid].mCellSize; }
+
+	/// Indicates that no queries are using the previous grid anymore so that we can start building a new grid in the background
+	void						DiscardOldGrid()					{ mCanBeUpdated = true; }
+
+	/// Update the grid, needs to be called regularly to put moved bodies in the correct cell and to merge added bodies into the grid.
+	/// UpdatePrepare() builds the next grid, UpdateFinalize() swaps the grids.
+	void						UpdatePrepare(TrackingVector &ioTracking);
+	void						UpdateFinalize();
+
+	/// Add inNumber bodies to the grid
+	void						AddBodies(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber);
+
+	/// Remove inNumber bodies in inBodyIDs from the grid
+	void						RemoveBodies(TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber);
+
+	/// Call whenever the aabb of a body changes
+	void						NotifyBodiesAABBChanged(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber);
+
+	/// Cast a ray and get the intersecting bodies in ioCollector.
+	void						CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Get bodies intersecting with inBox in ioCollector
+	void						CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Get bodies intersecting with a sphere in ioCollector
+	void						CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Get bodies intersecting with a point and any hits to ioCollector
+	void						CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Get bodies intersecting with an oriented box and any hits to ioCollector
+	void						CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Cast a box and get intersecting bodies in ioCollector
+	void						CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
+	/// Find all colliding pairs between dynamic bodies, calls ioPairCollector for every pair found
+	void						FindCollidingPairs(const BodyVector &inBodies, const BodyID *inActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, BodyPairCollector &ioPairCollector, ObjectLayerPairFilter inObjectLayerPairFilter, const TrackingVector &inTracking) const;
+
+private:
+	/// Bit that is set in Tracking::mBodyLocation when the body is stored in the list of added bodies
+	static constexpr uint32		cAddedBit = 0x80000000;
+
+	/// Cell coordinates are clamped to this range to avoid overflows for bodies that are very far away
+	static constexpr int		cMaxCellCoordinate = 1 << 20;
+
+	/// Maximum amount of buckets a query can visit, if a query overlaps with more cells it tests all bodies in the grid
+	static constexpr int		cMaxQueryBuckets = 128;
+
+	/// A body stored in the grid
+	struct Entry
+	{
+		/// Constructor to satisfy the vector class
+								Entry() = default;
+								Entry(const Entry &inRHS) : mBodyID(inRHS.mBodyID.load()), mCellX(inRHS.mCellX), mCellY(inRHS.mCellY), mCellZ(inRHS.mCellZ) { }
+
+		atomic<uint32>			mBodyID { BodyID::cInvalidBodyID };	///< Body stored in this entry, reset to cInvalidBodyID when the body is removed
+		int						mCellX;								///< Cell in which the body is stored
+		int						mCellY;
+		int						mCellZ;
+	};
+
+	/// One version of the grid
+	struct Grid
+	{
+		float					mCellSize = 0.0f;					///< Size of a cell
+		float					mInvCellSize = 0.0f;				///< 1 / mCellSize
+		uint32					mBucketMask = 0;					///< Number of buckets - 1, the number of buckets is a power of 2
+		TaggedVector<uint32, EMemoryTag::BroadPhase> mBucketStart;	///< Entries of bucket i are mEntries[mBucketStart[i], mBucketStart[i + 1])
+		TaggedVector<Entry, EMemoryTag::BroadPhase> mEntries;	///< All bodies in the grid ordered by bucket
+		atomic<float>			mMargin { 0.0f };					///< Max distance that a body extends beyond the cell it is stored in
+		TaggedVector<atomic<uint32>, EMemoryTag::BroadPhase> mAdded;	///< Space for all bodies, contains the bodies that were added since the grid was built (or cInvalidBodyID if the body was removed again)
+		atomic<uint32>			mNumAdded { 0 };					///< Number of used elements in mAdded
+		TaggedVector<uint32, EMemoryTag::BroadPhase> mFreeAdded;	///< Elements in mAdded that can be reused
+	};
+
+	/// Fixed size list of buckets that a query needs to visit
+	struct BucketList
+	{
+		uint32					mBuckets[cMaxQueryBuckets];
+		int						mNumBuckets = 0;
+	};
+
+	/// Get the cell coordinates that contain inPosition
+	static inline void			sGetCell(const Grid &inGrid, Vec3Arg inPosition, int *outCell);
+
+	/// Get the bucket for a cell
+	static inline uint32		sGetBucket(const Grid &inGrid, int inX, int inY, int inZ);
+
+	/// Add the buckets of all cells that can contain bodies overlapping with [inMin, inMax] to ioBuckets, returns false if there are too many
+	static bool					sAddBuckets(const Grid &inGrid, Vec3Arg inMin, Vec3Arg inMax, BucketList &ioBuckets);
+
+	/// Calls ioVisitor for all bodies in the grid that can overlap with the boxes in inBoxes (and for all bodies that have been added since the grid was built).
+	/// ioVisitor is called as ioVisitor(BodyID, const Tracking &) and returns true when the query should stop, the function returns true when the query was stopped.
+	template <class Visitor>
+	bool						VisitBodies(const AABox *inBoxes, int inNumBoxes, const TrackingVector &inTracking, Visitor &ioVisitor) const;
+
+	/// Current grid that is used for queries and modifications
+	const Grid &				GetCurrentGrid() const				{ return mGrids[mCurrentGrid.load(memory_order_acquire)]; }
+
+	/// Cell size as passed to Init
+	float						mCellSize = 0.0f;
+
+	/// We alternate between two grids in order to let collision queries complete in parallel to building the next grid
+	Grid						mGrids[2];
+	atomic<uint32>				mCurrentGrid { 0 };
+
+	/// Number of bodies in the grid
+	atomic<uint32>				mNumBodies { 0 };
+
+	/// If bodies were added, removed or moved since the last update
+	atomic<bool>				mIsDirty { false };
+
+	/// If the next grid has been built in UpdatePrepare and needs to be swapped in by UpdateFinalize
+	bool						mNextGridReady = false;
+
+	/// The next grid may still be in use by queries until DiscardOldGrid is called, so the grid can only be updated once per DiscardOldGrid
+	bool						mCanBeUpdated = true;
+
+	/// Mutex that protects the list of added bodies against concurrent modification, no other locks are taken while this mutex is held
+	Mutex						mAddedMutex;
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+	/// Name of this grid for profiling purposes
+	const char *				mName = "Layer";
+#endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
+};
+
+JPH_NAMESPACE_END
@@ -11,6 +11,7 @@
 #include <Jolt/Physics/PhysicsLock.h>
 #include <Jolt/Geometry/AABox4.h>
 #include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Geometry/RayPacket4.h>
 #include <Jolt/Geometry/OrientedBox.h>
 
 JPH_NAMESPACE_BEGIN
@@ -214,7 +215,7 @@ void QuadTree::DiscardOldTree()
 	}
 }
 
-void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild)
+void QuadTree::UpdatePrepare([[maybe_unused]] const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild)
 {
 #ifdef JPH_ENABLE_ASSERTS
 	// We only read positions
@@ -226,6 +227,8 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 
 	// Mark tree non-dirty
 	mIsDirty = false;
+	if (inFullRebuild)
+		mFullRebuildRequested = false;
 
 	// Get the current root node
 	const RootNode &root_node = GetCurrentRoot();
@@ -240,7 +243,8 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 #endif
 
 	// Create space for all body ID's
-	NodeID *node_ids = new NodeID [mNumBodies];
+	uint32 max_node_ids = mNumBodies;
+	NodeID *node_ids = static_cast<NodeID *>(Allocate(max_node_ids * sizeof(NodeID), EMemoryTag::BroadPhase));
 	NodeID *cur_node_id = node_ids;
 
 	// Collect all bodies
@@ -322,7 +326,7 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 
 		// Build new tree
 		AABox root_bounds;
-		root_node_id = BuildTree(inBodies, ioTracking, node_ids, num_node_ids, cMaxDepthMarkChanged, root_bounds);
+		root_node_id = BuildTree(ioTracking, node_ids, num_node_ids, cMaxDepthMarkChanged, root_bounds);
 
 		if (root_node_id.IsBody())
 		{
@@ -343,7 +347,7 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 	}
 
 	// Delete temporary data
-	delete [] node_ids;
+	Free(node_ids, max_node_ids * sizeof(NodeID), EMemoryTag::BroadPhase);
 
 	outUpdateState.mRootNodeID = root_node_id;
 }
@@ -454,7 +458,27 @@ void QuadTree::sPartition4(NodeID *ioNodeIDs, Vec3 *ioNodeCenters, int inBegin,
 	outSplit[4] = inEnd;
 }
 
-AABox QuadTree::GetNodeOrBodyBounds(const BodyVector &inBodies, NodeID inNodeID) const
+AABox QuadTree::GetEnlargedBodyBounds(const Body &inBody, bool inPredictMotion) const
+{
+	AABox bounds = inBody.GetWorldSpaceBounds();
+	if (!inBody.IsStatic())
+	{
+		// Enlarge by the margin
+		if (mBodyBoundsMargin > 0.0f)
+			bounds.ExpandBy(Vec3::sReplicate(mBodyBoundsMargin));
+
+		// Extend in the direction the body is moving
+		if (inPredictMotion && mBodyBoundsPredictionTime > 0.0f)
+		{
+			Vec3 displacement = mBodyBoundsPredictionTime * inBody.GetLinearVelocity();
+			bounds.mMin += Vec3::sMin(displacement, Vec3::sZero());
+			bounds.mMax += Vec3::sMax(displacement, Vec3::sZero());
+		}
+	}
+	return bounds;
+}
+
+AABox QuadTree::GetNodeOrBodyBounds(const TrackingVector &inTracking, NodeID inNodeID) const
 {
 	if (inNodeID.IsNode())
 	{
@@ -469,11 +493,12 @@ AABox QuadTree::GetNodeOrBodyBounds(const BodyVector &inBodies, NodeID inNodeID)
 	else
 	{
 		// It is a body
-		return inBodies[inNodeID.GetBodyID().GetIndex()]->GetWorldSpaceBounds();
+		const Tracking &tracking = inTracking[inNodeID.GetBodyID().GetIndex()];
+		return AABox(Vec3(tracking.mBoundsMin), Vec3(tracking.mBoundsMax));
 	}
 }
 
-QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds)
+QuadTree::NodeID QuadTree::BuildTree(TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds)
 {
 	// Trivial case: No bodies in tree
 	if (inNumber == 0)
@@ -491,16 +516,15 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 			Node &node = mAllocator->Get(ioNodeIDs->GetNodeIndex());
 			node.mParentNodeIndex = cInvalidNodeIndex;
 		}
-		outBounds = GetNodeOrBodyBounds(inBodies, *ioNodeIDs);
+		outBounds = GetNodeOrBodyBounds(ioTracking, *ioNodeIDs);
 		return *ioNodeIDs;
 	}
 
 	// Calculate centers of all bodies that are to be inserted
-	Vec3 *centers = new Vec3 [inNumber];
-	JPH_ASSERT(IsAligned(centers, 16));
+	Vec3 *centers = static_cast<Vec3 *>(AlignedAlloc(inNumber * sizeof(Vec3), alignof(Vec3), EMemoryTag::BroadPhase));
 	Vec3 *c = centers;
 	for (const NodeID *n = ioNodeIDs, *n_end = ioNodeIDs + inNumber; n < n_end; ++n, ++c)
-		*c = GetNodeOrBodyBounds(inBodies, *n).GetCenter();
+		*c = GetNodeOrBodyBounds(ioTracking, *n).GetCenter();
 	
 	// The algorithm is a recursive tree build, but to avoid the call overhead we keep track of a stack here
 	struct StackEntry
@@ -566,7 +590,7 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 			{
 				// Get body info
 				NodeID child_node_id = ioNodeIDs[low];
-				AABox bounds = GetNodeOrBodyBounds(inBodies, child_node_id);
+				AABox bounds = GetNodeOrBodyBounds(ioTracking, child_node_id);
 
 				// Update node
 				Node &node = mAllocator->Get(cur_stack.mNodeIdx);
@@ -606,7 +630,7 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 	}
 
 	// Delete temporary data
-	delete [] centers;
+	AlignedFree(centers, inNumber * sizeof(Vec3), EMemoryTag::BroadPhase);
 
 	// Store bounding box of root
 	outBounds.mMin = stack[0].mNodeBoundsMin;
@@ -779,9 +803,18 @@ void QuadTree::AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTr
 		NodeID::sFromBodyID(*b);
 #endif
 
+	// Store the bounds with which the bodies are inserted in the tree
+	for (const BodyID *b = ioBodyIDs, *b_end = ioBodyIDs + inNumber; b < b_end; ++b)
+	{
+		Tracking &tracking = ioTracking[b->GetIndex()];
+		AABox bounds = GetEnlargedBodyBounds(*inBodies[b->GetIndex()], false);
+		bounds.mMin.StoreFloat3(&tracking.mBoundsMin);
+		bounds.mMax.StoreFloat3(&tracking.mBoundsMax);
+	}
+
 	// Build subtree for the new bodies, note that we mark all nodes as 'not changed' 
 	// so they will stay together as a batch and will make the tree rebuild cheaper
-	outState.mLeafID = BuildTree(inBodies, ioTracking, (NodeID *)ioBodyIDs, inNumber, 0, outState.mLeafBounds);
+	outState.mLeafID = BuildTree(ioTracking, (NodeID *)ioBodyIDs, inNumber, 0, outState.mLeafBounds);
 
 #ifdef _DEBUG
 	if (outState.mLeafID.IsNode())
@@ -789,6 +822,147 @@ void QuadTree::AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTr
 #endif
 }
 
+void QuadTree::AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber, const BroadPhaseTreeLayout &inLayout, AddState &outState)
+{
+	// Assert sane input
+	JPH_ASSERT(inBodyIDs != nullptr);
+	JPH_ASSERT(inNumber > 0);
+	JPH_ASSERT(inLayout.mNumBodies == uint32(inNumber));
+	JPH_ASSERT(inLayout.IsValid());
+
+	// Store the bounds with which the bodies are inserted in the tree
+	for (const BodyID *b = inBodyIDs, *b_end = inBodyIDs + inNumber; b < b_end; ++b)
+	{
+		Tracking &tracking = ioTracking[b->GetIndex()];
+		AABox bounds = GetEnlargedBodyBounds(*inBodies[b->GetIndex()], false);
+		bounds.mMin.StoreFloat3(&tracking.mBoundsMin);
+		bounds.mMax.StoreFloat3(&tracking.mBoundsMax);
+	}
+
+	// Trivial case: A single body doesn't need a node
+	uint num_nodes = (uint)inLayout.mNodes.size();
+	if (num_nodes == 0)
+	{
+		outState.mLeafID = NodeID::sFromBodyID(inBodyIDs[0]);
+		outState.mLeafBounds = GetNodeOrBodyBounds(ioTracking, outState.mLeafID);
+		return;
+	}
+
+	// Allocate all nodes, we mark them as 'not changed' so they will stay together as a batch (see AddBodiesPrepare above)
+	TaggedVector<uint32, EMemoryTag::BroadPhase> node_indices(num_nodes);
+	for (uint n = 0; n < num_nodes; ++n)
+		node_indices[n] = AllocateNode(false);
+
+	// Children come after their parents in the layout, so walking the nodes in reverse order calculates the bounds bottom up
+	TaggedVector<AABox, EMemoryTag::BroadPhase> node_bounds(num_nodes);
+	for (int n = int(num_nodes) - 1; n >= 0; --n)
+	{
+		uint32 node_idx = node_indices[n];
+		Node &node = mAllocator->Get(node_idx);
+		AABox &bounds = node_bounds[n];
+		for (int c = 0; c < 4; ++c)
+		{
+			uint32 child = inLayout.mNodes[n].mChildren[c];
+			if (child == BroadPhaseTreeLayout::cInvalidChild)
+				continue;
+
+			AABox child_bounds;
+			if ((child & BroadPhaseTreeLayout::cIsNode) != 0)
+			{
+				// Link child node
+				uint32 child_layout_idx = child & ~BroadPhaseTreeLayout::cIsNode;
+				uint32 child_node_idx = node_indices[child_layout_idx];
+				mAllocator->Get(child_node_idx).mParentNodeIndex = node_idx;
+				node.mChildNodeID[c] = NodeID::sFromNodeIndex(child_node_idx);
+				child_bounds = node_bounds[child_layout_idx];
+				node.SetChildBounds(c, child_bounds);
+			}
+			else
+			{
+				// Link body
+				BodyID body_id = inBodyIDs[child];
+				node.mChildNodeID[c] = NodeID::sFromBodyID(body_id);
+				child_bounds = GetNodeOrBodyBounds(ioTracking, NodeID::sFromBodyID(body_id));
+				node.SetChildBounds(c, child_bounds);
+				SetBodyLocation(ioTracking, body_id, node_idx, c);
+			}
+			bounds.Encapsulate(child_bounds);
+		}
+	}
+
+	// Return the root
+	outState.mLeafID = NodeID::sFromNodeIndex(node_indices[0]);
+	outState.mLeafBounds = node_bounds[0];
+
+#ifdef _DEBUG
+	ValidateTree(inBodies, ioTracking, outState.mLeafID.GetNodeIndex(), inNumber);
+#endif
+}
+
+void QuadTree::sBuildLayout(const AABox *inBounds, uint inNumBodies, BroadPhaseTreeLayout &outLayout)
+{
+	outLayout.mNumBodies = inNumBodies;
+	outLayout.mNodes.clear();
+
+	JPH_ASSERT(inNumBodies <= BodyID::cMaxBodyIndex);
+
+	// Trivial case: Zero or one body doesn't need any nodes
+	if (inNumBodies <= 1)
+		return;
+
+	// Use the body index as node ID so that we can use the same partitioning as BuildTree
+	NodeID *node_ids = static_cast<NodeID *>(Allocate(inNumBodies * sizeof(NodeID), EMemoryTag::BroadPhase));
+	Vec3 *centers = static_cast<Vec3 *>(AlignedAlloc(inNumBodies * sizeof(Vec3), alignof(Vec3), EMemoryTag::BroadPhase));
+	for (uint b = 0; b < inNumBodies; ++b)
+	{
+		node_ids[b] = NodeID::sFromBodyID(BodyID(b));
+		centers[b] = inBounds[b].GetCenter();
+	}
+
+	// Range of bodies that a node in the layout needs to contain
+	struct Range
+	{
+		uint32			mNodeIdx;
+		int				mBegin;
+		int				mEnd;
+	};
+	TaggedVector<Range, EMemoryTag::BroadPhase> to_process;
+	outLayout.mNodes.push_back({ });
+	to_process.push_back({ 0, 0, int(inNumBodies) });
+
+	// Process the nodes breadth first, this ensures that child nodes always come after their parent
+	for (size_t i = 0; i < to_process.size(); ++i)
+	{
+		Range range = to_process[i];
+
+		int split[5];
+		sPartition4(node_ids, centers, range.mBegin, range.mEnd, split);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			uint32 child;
+			int num_bodies = split[c + 1] - split[c];
+			if (num_bodies == 0)
+				child = BroadPhaseTreeLayout::cInvalidChild;
+			else if (num_bodies == 1)
+				child = node_ids[split[c]].GetBodyID().GetIndex();
+			else
+			{
+				uint32 child_node_idx = (uint32)outLayout.mNodes.size();
+				outLayout.mNodes.push_back({ });
+				to_process.push_back({ child_node_idx, split[c], split[c + 1] });
+				child = child_node_idx | BroadPhaseTreeLayout::cIsNode;
+			}
+			outLayout.mNodes[range.mNodeIdx].mChildren[c] = child;
+		}
+	}
+
+	AlignedFree(centers, inNumBodies * sizeof(Vec3), EMemoryTag::BroadPhase);
+	Free(node_ids, inNumBodies * sizeof(NodeID), EMemoryTag::BroadPhase);
+
+	JPH_ASSERT(outLayout.IsValid());
+}
+
 void QuadTree::AddBodiesFinalize(TrackingVector &ioTracking, int inNumberBodies, const AddState &inState)
 {
 	// Assert sane input
@@ -889,7 +1063,7 @@ void QuadTree::RemoveBodies([[maybe_unused]] const BodyVector &inBodies, Trackin
 	mNumBodies -= inNumber;
 }
 
-void QuadTree::NotifyBodiesAABBChanged(const BodyVector &inBodies, const TrackingVector &inTracking, const BodyID *ioBodyIDs, int inNumber)
+void QuadTree::NotifyBodiesAABBChanged(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *ioBodyIDs, int inNumber)
 {
 	// Assert sane input
 	JPH_ASSERT(ioBodyIDs != nullptr);
@@ -901,12 +1075,19 @@ void QuadTree::NotifyBodiesAABBChanged(const BodyVector &inBodies, const Trackin
 		const Body *body = inBodies[cur->GetIndex()];
 		JPH_ASSERT(body->GetID() == *cur, "Provided BodyID doesn't match BodyID in body manager");
 
+		// If the body is still inside the bounds that it was inserted with there's nothing to do
+		Tracking &tracking = ioTracking[cur->GetIndex()];
+		if (AABox(Vec3(tracking.mBoundsMin), Vec3(tracking.mBoundsMax)).Contains(body->GetWorldSpaceBounds()))
+			continue;
+
 		// Get the new bounding box
-		const AABox &new_bounds = body->GetWorldSpaceBounds();
+		AABox new_bounds = GetEnlargedBodyBounds(*body, true);
+		new_bounds.mMin.StoreFloat3(&tracking.mBoundsMin);
+		new_bounds.mMax.StoreFloat3(&tracking.mBoundsMax);
 
 		// Get location of body
 		uint32 node_idx, child_idx;
-		GetBodyLocation(inTracking, *cur, node_idx, child_idx);
+		GetBodyLocation(ioTracking, *cur, node_idx, child_idx);
 
 		// Widen bounds for node
 		Node &node = mAllocator->Get(node_idx);
@@ -1083,6 +1264,62 @@ void QuadTree::CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector,
 	WalkTree(inObjectLayerFilter, inTracking, visitor JPH_IF_TRACK_BROADPHASE_STATS(, mCastRayStats));
 }
 
+void QuadTree::CastRayPacket(const RayPacket4 &inRays, RayPacketBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
+{
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE				Visitor(const RayPacket4 &inRays, RayPacketBodyCollector &ioCollector) :
+			mRays(inRays),
+			mCollector(ioCollector)
+		{
+			// Rays that are not in use never visit a node
+			mFractionStack[0] = Vec4::sSelect(Vec4::sReplicate(FLT_MAX), Vec4::sReplicate(-1.0f), inRays.mIsValid);
+		}
+
+		/// Returns true if further processing of the tree should be aborted
+		JPH_INLINE bool			ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Returns true if this node / body should be visited, false if none of the rays can generate a hit
+		JPH_INLINE bool			ShouldVisitNode(int inStackTop) const
+		{
+			return Vec4::sLess(mFractionStack[inStackTop], mCollector.GetEarlyOutFractions()).TestAnyTrue();
+		}
+
+		/// Visit nodes, returns number of hits found and sorts ioChildNodeIDs so that they are at the beginning of the vector.
+		JPH_INLINE int			VisitNodes(Vec4Arg inBoundsMinX, Vec4Arg inBoundsMinY, Vec4Arg inBoundsMinZ, Vec4Arg inBoundsMaxX, Vec4Arg inBoundsMaxY, Vec4Arg inBoundsMaxZ, UVec4 &ioChildNodeIDs, int inStackTop)
+		{
+			// Test the rays against 4 bounding boxes
+			Vec4 fractions[4];
+			RayPacket4AABox4(mRays, inBoundsMinX, inBoundsMinY, inBoundsMinZ, inBoundsMaxX, inBoundsMaxY, inBoundsMaxZ, fractions);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStorePacket(fractions, mCollector.GetEarlyOutFractions(), ioChildNodeIDs, &mFractionStack[inStackTop]);
+		}
+
+		/// Visit a body, returns false if the algorithm should terminate because no hits can be generated anymore
+		JPH_INLINE void			VisitBody(const BodyID &inBodyID, int inStackTop)
+		{
+			// Store potential hit with body, rays that found a closer hit in the meantime don't hit
+			Vec4 fractions = mFractionStack[inStackTop];
+			fractions = Vec4::sSelect(fractions, Vec4::sReplicate(FLT_MAX), Vec4::sGreaterOrEqual(fractions, mCollector.GetEarlyOutFractions()));
+			mCollector.AddHit(inBodyID, fractions);
+		}
+
+	private:
+		const RayPacket4 &		mRays;
+		RayPacketBodyCollector & mCollector;
+		Vec4					mFractionStack[cStackSize];
+	};
+
+	Visitor visitor(inRays, ioCollector);
+	WalkTree(inObjectLayerFilter, inTracking, visitor JPH_IF_TRACK_BROADPHASE_STATS(, mCastRayStats));
+}
+
 void QuadTree::CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const
 {
 	class Visitor
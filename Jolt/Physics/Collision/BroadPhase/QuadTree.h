@@ -8,6 +8,7 @@
 #include <Jolt/Core/NonCopyable.h>
 #include <Jolt/Physics/Body/BodyManager.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseTreeLayout.h>
 
 #ifdef JPH_TRACK_BROADPHASE_STATS
 	#include <map>
@@ -17,6 +18,8 @@
 
 JPH_NAMESPACE_BEGIN
 
+class RayPacket4;
+
 /// Internal tree structure in broadphase, is essentially a quad AABB tree.
 /// Tree is lockless (except for UpdatePrepare/Finalize() function), modifying objects in the tree will widen the aabbs of parent nodes to make the node fit.
 /// During the UpdatePrepare/Finalize() call the tree is rebuilt to achieve a tight fit again.
@@ -144,6 +147,8 @@ private:
 	static_assert(is_trivially_destructible<Node>(), "Assuming that we don't have a destructor");
 
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::BroadPhase)
+
 	/// Class that allocates tree nodes, can be shared between multiple trees
 	using Allocator = FixedSizeFreeList<Node>;
 
@@ -154,7 +159,7 @@ public:
 	{
 		/// Constructor to satisfy the vector class
 								Tracking() = default;
-								Tracking(const Tracking &inRHS) : mBroadPhaseLayer(inRHS.mBroadPhaseLayer.load()), mObjectLayer(inRHS.mObjectLayer.load()), mBodyLocation(inRHS.mBodyLocation.load()) { }
+								Tracking(const Tracking &inRHS) : mBroadPhaseLayer(inRHS.mBroadPhaseLayer.load()), mObjectLayer(inRHS.mObjectLayer.load()), mBodyLocation(inRHS.mBodyLocation.load()), mBoundsMin(inRHS.mBoundsMin), mBoundsMax(inRHS.mBoundsMax) { }
 
 		/// Invalid body location identifier
 		static const uint32		cInvalidBodyLocation = 0xffffffff;
@@ -162,9 +167,14 @@ public:
 		atomic<BroadPhaseLayer::Type> mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
 		atomic<ObjectLayer>		mObjectLayer = cObjectLayerInvalid;
 		atomic<uint32>			mBodyLocation { cInvalidBodyLocation };
+
+		/// Bounding box of the body as it was inserted in the tree, this can be larger than the world space bounds of the body (see SetBodyBoundsMargin).
+		/// The tree only needs to be modified when the world space bounds of the body are no longer contained in this box.
+		Float3					mBoundsMin;
+		Float3					mBoundsMax;
 	};
 
-	using TrackingVector = vector<Tracking>;
+	using TrackingVector = TaggedVector<Tracking, EMemoryTag::BroadPhase>;
 
 	/// Destructor
 								~QuadTree();
@@ -181,12 +191,23 @@ public:
 	/// Check if the tree needs an UpdatePrepare/Finalize()
 	inline bool					IsDirty() const						{ return mIsDirty; }
 
+	/// Request that the next UpdatePrepare/Finalize() rebuilds the entire tree
+	inline void					RequestFullRebuild()				{ mFullRebuildRequested = true; }
+
+	/// Check if RequestFullRebuild was called and the tree hasn't been rebuilt since
+	inline bool					IsFullRebuildRequested() const		{ return mFullRebuildRequested; }
+
 	/// Check if this tree can get an UpdatePrepare/Finalize() or if it needs a DiscardOldTree() first
 	inline bool					CanBeUpdated() const				{ return mFreeNodeBatch.mNumObjects == 0; }
 
 	/// Initialization
 	void						Init(Allocator &inAllocator);
 
+	/// Enlarge the bounding boxes of moving bodies in the tree so that the tree doesn't need to be modified every time a body moves a little bit.
+	/// @param inMargin Distance by which the bounding boxes of dynamic and kinematic bodies are enlarged (m)
+	/// @param inPredictionTime The bounding boxes are also extended by the distance the body travels in this amount of time at its current linear velocity (s)
+	void						SetBodyBoundsMargin(float inMargin, float inPredictionTime) { mBodyBoundsMargin = inMargin; mBodyBoundsPredictionTime = inPredictionTime; }
+
 	struct UpdateState
 	{
 		NodeID					mRootNodeID;						///< This will be the new root node id
@@ -212,6 +233,13 @@ public:
 	/// ioBodyIDs may be shuffled around by this function.
 	void						AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTracking, BodyID *ioBodyIDs, int inNumber, AddState &outState);
 
+	/// Same as AddBodiesPrepare, but instead of building a tree for the bodies the structure of the tree is taken from inLayout.
+	/// inBodyIDs must be in the order of the bounding boxes that were passed to BroadPhaseTreeLayout::Build.
+	void						AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *inBodyIDs, int inNumber, const BroadPhaseTreeLayout &inLayout, AddState &outState);
+
+	/// Build the structure of a tree for inNumBodies bodies with bounding boxes inBounds without allocating any nodes (see BroadPhaseTreeLayout::Build)
+	static void					sBuildLayout(const AABox *inBounds, uint inNumBodies, BroadPhaseTreeLayout &outLayout);
+
 	/// Finalize adding bodies to the quadtree, supply the same number of bodies as in AddBodiesPrepare.
 	void						AddBodiesFinalize(TrackingVector &ioTracking, int inNumberBodies, const AddState &inState);
 
@@ -223,11 +251,14 @@ public:
 	void						RemoveBodies(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *ioBodyIDs, int inNumber);
 
 	/// Call whenever the aabb of a body changes.
-	void						NotifyBodiesAABBChanged(const BodyVector &inBodies, const TrackingVector &inTracking, const BodyID *ioBodyIDs, int inNumber);
+	void						NotifyBodiesAABBChanged(const BodyVector &inBodies, TrackingVector &ioTracking, const BodyID *ioBodyIDs, int inNumber);
 
 	/// Cast a ray and get the intersecting bodies in ioCollector.
 	void						CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
 
+	/// Cast a packet of rays and get the intersecting bodies in ioCollector.
+	void						CastRayPacket(const RayPacket4 &inRays, RayPacketBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
+
 	/// Get bodies intersecting with inBox in ioCollector
 	void						CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const ObjectLayerFilter &inObjectLayerFilter, const TrackingVector &inTracking) const;
 
@@ -276,8 +307,11 @@ private:
 	JPH_INLINE const RootNode &	GetCurrentRoot() const				{ return mRootNode[mRootNodeIndex]; }
 	JPH_INLINE RootNode &		GetCurrentRoot()					{ return mRootNode[mRootNodeIndex]; }
 
-	/// Depending on if inNodeID is a body or tree node return the bounding box
-	inline AABox				GetNodeOrBodyBounds(const BodyVector &inBodies, NodeID inNodeID) const;
+	/// Get the (enlarged) bounding box with which a body should be stored in the tree
+	inline AABox				GetEnlargedBodyBounds(const Body &inBody, bool inPredictMotion) const;
+
+	/// Depending on if inNodeID is a body or tree node return the bounding box (for bodies this is the enlarged bounding box stored in the tracking data)
+	inline AABox				GetNodeOrBodyBounds(const TrackingVector &inTracking, NodeID inNodeID) const;
 
 	/// Mark node and all of its parents as changed
 	inline void					MarkNodeAndParentsChanged(uint32 inNodeIndex);
@@ -295,7 +329,7 @@ private:
 	inline bool					TryCreateNewRoot(TrackingVector &ioTracking, atomic<uint32> &ioRootNodeIndex, NodeID inLeafID, const AABox &inLeafBounds, int inLeafNumBodies);
 
 	/// Build a tree for ioBodyIDs, returns the NodeID of the root (which will be the ID of a single body if inNumber = 1). All tree levels up to inMaxDepthMarkChanged will be marked as 'changed'.
-	NodeID						BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds);
+	NodeID						BuildTree(TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds);
 
 	/// Sorts ioNodeIDs spatially into 2 groups. Second groups starts at ioNodeIDs + outMidPoint.
 	/// After the function returns ioNodeIDs and ioNodeCenters will be shuffled
@@ -331,7 +365,7 @@ private:
 		uint64					mCollectorTicks = 0;
 	};
 	
-	using LayerToStats = map<string, Stat>;
+	using LayerToStats = map<string, Stat, less<string>, STLAllocator<pair<const string, Stat>, EMemoryTag::BroadPhase>>;
 
 	/// Trace the stats of a single query type to the TTY
 	void						ReportStats(const char *inName, const LayerToStats &inLayer) const;
@@ -372,6 +406,13 @@ private:
 
 	/// Flag to keep track of changes to the broadphase, if false, we don't need to UpdatePrepare/Finalize()
 	atomic<bool>				mIsDirty = false;
+
+	/// Flag that indicates that the next UpdatePrepare/Finalize() should rebuild the entire tree (see RequestFullRebuild)
+	atomic<bool>				mFullRebuildRequested = false;
+
+	/// Settings for enlarging the bounding boxes of moving bodies, see SetBodyBoundsMargin
+	float						mBodyBoundsMargin = 0.0f;
+	float						mBodyBoundsPredictionTime = 0.0f;
 };
 
 JPH_NAMESPACE_END
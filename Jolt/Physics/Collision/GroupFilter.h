@@ -16,6 +16,8 @@ class StreamOut;
 class GroupFilter : public SerializableObject, public RefTarget<GroupFilter>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	JPH_DECLARE_SERIALIZABLE_ABSTRACT(GroupFilter)
 
 	/// Virtual destructor
@@ -11,6 +11,8 @@
 #include <Jolt/Physics/Collision/CollideShape.h>
 #include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Geometry/RayPacket4.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -78,6 +80,100 @@ bool NarrowPhaseQuery::CastRay(const RayCast &inRay, RayCastResult &ioHit, const
 	return ioHit.mFraction <= 1.0f;
 }
 
+void NarrowPhaseQuery::CastRayPackets(const RayCast *inRays, int inNumRays, RayCastResult *ioHits, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, const BodyFilter &inBodyFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class MyCollector : public RayPacketBodyCollector
+	{
+	public:
+							MyCollector(const RayCast *inRays, int inNumRays, RayCastResult *ioHits, const BodyLockInterface &inBodyLockInterface, const BodyFilter &inBodyFilter) :
+			mRays(inRays),
+			mHits(ioHits),
+			mNumRays(inNumRays),
+			mBodyLockInterface(inBodyLockInterface),
+			mBodyFilter(inBodyFilter)
+		{
+			UpdateFractions();
+		}
+
+		virtual void		AddHit(const BodyID &inBodyID, Vec4Arg inFractions) override
+		{
+			// Only test shape if it passes the body filter
+			if (mBodyFilter.ShouldCollide(inBodyID))
+			{
+				// Lock the body
+				BodyLockRead lock(mBodyLockInterface, inBodyID);
+				if (lock.Succeeded())
+				{
+					const Body &body = lock.GetBody();
+
+					// Check body filter again now that we've locked the body
+					if (mBodyFilter.ShouldCollideLocked(body))
+					{
+						// Collect the transformed shape
+						TransformedShape ts = body.GetTransformedShape();
+
+						// Release the lock now, we have all the info we need in the transformed shape
+						lock.ReleaseLock();
+
+						// Collect the rays that hit the bounding box of the body
+						RayCast rays[RayPacket4::cNumRays];
+						RayCastResult hits[RayPacket4::cNumRays];
+						int ray_indices[RayPacket4::cNumRays];
+						int num_rays = 0;
+						for (int i = 0; i < mNumRays; ++i)
+							if (inFractions[i] != FLT_MAX)
+							{
+								JPH_ASSERT(inFractions[i] < mHits[i].mFraction, "This hit should not have been passed on to the collector");
+								rays[num_rays] = mRays[i];
+								hits[num_rays] = mHits[i];
+								ray_indices[num_rays] = i;
+								++num_rays;
+							}
+
+						// Do narrow phase collision check
+						uint hit_mask = ts.CastRayPacket(rays, num_rays, hits);
+						if (hit_mask != 0)
+						{
+							for (int i = 0; i < num_rays; ++i)
+								if (hit_mask & (1 << i))
+									mHits[ray_indices[i]] = hits[i];
+
+							// Update early out fractions based on narrow phase results
+							UpdateFractions();
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		/// Update the early out fractions from the hits, rays that are not in use get fraction 0
+		void				UpdateFractions()
+		{
+			Vec4 fractions = Vec4::sZero();
+			for (int i = 0; i < mNumRays; ++i)
+				fractions[i] = mHits[i].mFraction;
+			UpdateEarlyOutFractions(fractions);
+		}
+
+		const RayCast *				mRays;
+		RayCastResult *				mHits;
+		int							mNumRays;
+		const BodyLockInterface &	mBodyLockInterface;
+		const BodyFilter &			mBodyFilter;
+	};
+
+	for (int first = 0; first < inNumRays; first += RayPacket4::cNumRays)
+	{
+		// Do broadphase test
+		int num_rays = min(inNumRays - first, RayPacket4::cNumRays);
+		MyCollector collector(inRays + first, num_rays, ioHits + first, *mBodyLockInterface, inBodyFilter);
+		mBroadPhase->CastRayPacket(inRays + first, num_rays, collector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+	}
+}
+
 void NarrowPhaseQuery::CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, CastRayCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, const BodyFilter &inBodyFilter, const ShapeFilter &inShapeFilter) const
 {
 	JPH_PROFILE_FUNCTION();
@@ -412,4 +508,110 @@ void NarrowPhaseQuery::CollectTransformedShapes(const AABox &inBox, TransformedS
 	mBroadPhase->CollideAABox(inBox, collector, inBroadPhaseLayerFilter, inObjectLayerFilter);
 }
 
+/// Calls inFunction(query index) for all inNumQueries queries, spreading the queries over the threads of inJobSystem.
+/// Jobs take batches of queries from a shared counter so that a thread that gets cheap queries will help with the rest.
+template <class Function>
+static void sExecuteQueries(JobSystem &inJobSystem, int inNumQueries, const Function &inFunction)
+{
+	// Number of queries that a job takes at a time
+	constexpr int cQueriesPerBatch = 32;
+
+	int num_batches = (inNumQueries + cQueriesPerBatch - 1) / cQueriesPerBatch;
+	int num_jobs = min(num_batches, inJobSystem.GetMaxConcurrency());
+	if (num_jobs <= 1)
+	{
+		// Not worth starting jobs, execute on this thread
+		for (int q = 0; q < inNumQueries; ++q)
+			inFunction(q);
+		return;
+	}
+
+	atomic<int> next_batch { 0 };
+	auto job = [&next_batch, num_batches, inNumQueries, &inFunction]()
+	{
+		for (;;)
+		{
+			int batch = next_batch.fetch_add(1, memory_order_relaxed);
+			if (batch >= num_batches)
+				break;
+
+			for (int q = batch * cQueriesPerBatch, q_end = min(q + cQueriesPerBatch, inNumQueries); q < q_end; ++q)
+				inFunction(q);
+		}
+	};
+
+	JobSystem::Barrier *barrier = inJobSystem.CreateBarrier();
+	for (int j = 0; j < num_jobs; ++j)
+	{
+		JobSystem::JobHandle handle = inJobSystem.CreateJob("BatchedQuery", Color::sGreen, job);
+		barrier->AddJob(handle);
+	}
+	inJobSystem.WaitForJobs(barrier);
+	inJobSystem.DestroyBarrier(barrier);
+}
+
+void NarrowPhaseQuery::CastRays(const RayCast *inRays, int inNumRays, RayCastResult *outHits, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, const BodyFilter &inBodyFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	sExecuteQueries(inJobSystem, inNumRays, [this, inRays, outHits, &inBroadPhaseLayerFilter, &inObjectLayerFilter, &inBodyFilter](int inIndex)
+	{
+		RayCastResult &hit = outHits[inIndex];
+		hit = RayCastResult();
+		CastRay(inRays[inIndex], hit, inBroadPhaseLayerFilter, inObjectLayerFilter, inBodyFilter);
+	});
+}
+
+void NarrowPhaseQuery::CastShapes(const ShapeCast *inShapeCasts, int inNumShapeCasts, const ShapeCastSettings &inShapeCastSettings, ShapeCastResult *outHits, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, const BodyFilter &inBodyFilter, const ShapeFilter &inShapeFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	sExecuteQueries(inJobSystem, inNumShapeCasts, [this, inShapeCasts, &inShapeCastSettings, outHits, &inBroadPhaseLayerFilter, &inObjectLayerFilter, &inBodyFilter, &inShapeFilter](int inIndex)
+	{
+		ClosestHitCollisionCollector<CastShapeCollector> collector;
+		CastShape(inShapeCasts[inIndex], inShapeCastSettings, collector, inBroadPhaseLayerFilter, inObjectLayerFilter, inBodyFilter, inShapeFilter);
+		outHits[inIndex] = collector.HadHit()? collector.mHit : ShapeCastResult();
+	});
+}
+
+void NarrowPhaseQuery::CollideShapes(const CollideShapeQuery *inQueries, int inNumQueries, const CollideShapeSettings &inCollideShapeSettings, CollideShapeResult *outHits, int *outNumHits, int inMaxHitsPerQuery, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, const BodyFilter &inBodyFilter, const ShapeFilter &inShapeFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inMaxHitsPerQuery > 0);
+
+	// Collector that stores hits in a fixed size buffer and stops the query when the buffer is full
+	class MyCollector : public CollideShapeCollector
+	{
+	public:
+								MyCollector(CollideShapeResult *outHits, int inMaxHits) :
+			mHits(outHits),
+			mMaxHits(inMaxHits)
+		{
+		}
+
+		virtual void			AddHit(const CollideShapeResult &inResult) override
+		{
+			if (mNumHits < mMaxHits)
+			{
+				mHits[mNumHits++] = inResult;
+				if (mNumHits == mMaxHits)
+					ForceEarlyOut();
+			}
+		}
+
+		CollideShapeResult *	mHits;
+		int						mMaxHits;
+		int						mNumHits = 0;
+	};
+
+	sExecuteQueries(inJobSystem, inNumQueries, [this, inQueries, &inCollideShapeSettings, outHits, outNumHits, inMaxHitsPerQuery, &inBroadPhaseLayerFilter, &inObjectLayerFilter, &inBodyFilter, &inShapeFilter](int inIndex)
+	{
+		const CollideShapeQuery &query = inQueries[inIndex];
+		MyCollector collector(outHits + inIndex * inMaxHitsPerQuery, inMaxHitsPerQuery);
+		CollideShape(query.mShape, query.mShapeScale, query.mCenterOfMassTransform, inCollideShapeSettings, collector, inBroadPhaseLayerFilter, inObjectLayerFilter, inBodyFilter, inShapeFilter);
+		outNumHits[inIndex] = collector.mNumHits;
+	});
+}
+
 JPH_NAMESPACE_END
@@ -14,7 +14,13 @@ JPH_NAMESPACE_BEGIN
 
 class Shape;
 class CollideShapeSettings;
+class CollideShapeResult;
 class RayCastResult;
+class ShapeCastSettings;
+class ShapeCastResult;
+struct RayCast;
+struct ShapeCast;
+class JobSystem;
 
 /// Class that provides an interface for doing precise collision detection against the broad and then the narrow phase
 class NarrowPhaseQuery : public NonCopyable
@@ -28,6 +34,10 @@ public:
 	/// If you want the surface normal of the hit use Body::GetWorldSpaceSurfaceNormal(ioHit.mSubShapeID2, inRay.GetPointOnRay(ioHit.mFraction)) on body with ID ioHit.mBodyID.
 	bool						CastRay(const RayCast &inRay, RayCastResult &ioHit, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }) const;
 
+	/// Cast inNumRays rays and find the closest hit for each of them, see CastRay. ioHits[i] receives the hit for inRays[i] (hits further than ioHits[i].mFraction will not be considered).
+	/// The rays are traced through the broadphase and through mesh shapes in packets of RayPacket4::cNumRays consecutive rays, which is faster than casting the rays one by one when consecutive rays are coherent (e.g. a fan of sensor rays).
+	void						CastRayPackets(const RayCast *inRays, int inNumRays, RayCastResult *ioHits, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }) const;
+
 	/// Cast a ray, allows collecting multiple hits. Note that this version is more flexible but also slightly slower than the CastRay function that returns only a single hit.
 	/// If you want the surface normal of the hit use Body::GetWorldSpaceSurfaceNormal(collected sub shape ID, inRay.GetPointOnRay(collected fraction)) on body with collected body ID.
 	void						CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, CastRayCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }, const ShapeFilter &inShapeFilter = { }) const;
@@ -46,6 +56,32 @@ public:
 	/// Collect all leaf transformed shapes that fall inside world space box inBox
 	void						CollectTransformedShapes(const AABox &inBox, TransformedShapeCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }, const ShapeFilter &inShapeFilter = { }) const;
 
+	///@name Batched queries.
+	/// The queries are spread over the threads of inJobSystem and the function returns when all queries are done. The results are written to buffers provided by the caller so no memory is allocated per hit.
+	/// Note that the filters are shared by all queries in the batch, so they will be called from multiple threads at the same time.
+	///@{
+
+	/// Cast inNumRays rays and find the closest hit for each of them (see CastRay).
+	/// outHits[i] receives the closest hit for inRays[i], its mBodyID is invalid when the ray didn't hit anything.
+	void						CastRays(const RayCast *inRays, int inNumRays, RayCastResult *outHits, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }) const;
+
+	/// Cast inNumShapeCasts shapes and find the closest hit for each of them (see CastShape).
+	/// outHits[i] receives the closest hit for inShapeCasts[i], its mBodyID2 is invalid when the shape didn't hit anything.
+	void						CastShapes(const ShapeCast *inShapeCasts, int inNumShapeCasts, const ShapeCastSettings &inShapeCastSettings, ShapeCastResult *outHits, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }, const ShapeFilter &inShapeFilter = { }) const;
+
+	/// A shape that is collided with the system by CollideShapes
+	struct CollideShapeQuery
+	{
+		const Shape *			mShape;
+		Vec3					mShapeScale;
+		Mat44					mCenterOfMassTransform;
+	};
+
+	/// Collide inNumQueries shapes with the system (see CollideShape).
+	/// The hits for inQueries[i] are stored in outHits[i * inMaxHitsPerQuery + j] for j = [0, outNumHits[i]), when a query has more than inMaxHitsPerQuery hits the remaining hits are dropped.
+	void						CollideShapes(const CollideShapeQuery *inQueries, int inNumQueries, const CollideShapeSettings &inCollideShapeSettings, CollideShapeResult *outHits, int *outNumHits, int inMaxHitsPerQuery, JobSystem &inJobSystem, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter = { }, const ObjectLayerFilter &inObjectLayerFilter = { }, const BodyFilter &inBodyFilter = { }, const ShapeFilter &inShapeFilter = { }) const;
+	///@}
+
 private:
 	BodyLockInterface *			mBodyLockInterface = nullptr;
 	BroadPhase *				mBroadPhase = nullptr;
@@ -21,6 +21,8 @@ class StreamOut;
 class PhysicsMaterial : public SerializableObject, public RefTarget<PhysicsMaterial>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 	JPH_DECLARE_SERIALIZABLE_VIRTUAL(PhysicsMaterial)
 
 	/// Virtual destructor
@@ -46,6 +48,6 @@ protected:
 	virtual void							RestoreBinaryState(StreamIn &inStream);
 };
 
-using PhysicsMaterialList = vector<RefConst<PhysicsMaterial>>;
+using PhysicsMaterialList = TaggedVector<RefConst<PhysicsMaterial>, EMemoryTag::Shapes>;
 
 JPH_NAMESPACE_END
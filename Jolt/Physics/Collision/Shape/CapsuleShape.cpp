@@ -31,20 +31,20 @@ JPH_IMPLEMENT_SERIALIZABLE_VIRTUAL(CapsuleShapeSettings)
 
 static const int cCapsuleDetailLevel = 2;
 
-static const vector<Vec3> sCapsuleTopTriangles = []() { 
-	vector<Vec3> verts;	
+static const TaggedVector<Vec3, EMemoryTag::Shapes> sCapsuleTopTriangles = []() { 
+	TaggedVector<Vec3, EMemoryTag::Shapes> verts;	
 	GetTrianglesContextVertexList::sCreateHalfUnitSphereTop(verts, cCapsuleDetailLevel);
 	return verts;
 }();
 
-static const vector<Vec3> sCapsuleMiddleTriangles = []() { 
-	vector<Vec3> verts;
+static const TaggedVector<Vec3, EMemoryTag::Shapes> sCapsuleMiddleTriangles = []() { 
+	TaggedVector<Vec3, EMemoryTag::Shapes> verts;
 	GetTrianglesContextVertexList::sCreateUnitOpenCylinder(verts, cCapsuleDetailLevel);
 	return verts;
 }();
 
-static const vector<Vec3> sCapsuleBottomTriangles = []() { 
-	vector<Vec3> verts;	
+static const TaggedVector<Vec3, EMemoryTag::Shapes> sCapsuleBottomTriangles = []() { 
+	TaggedVector<Vec3, EMemoryTag::Shapes> verts;	
 	GetTrianglesContextVertexList::sCreateHalfUnitSphereBottom(verts, cCapsuleDetailLevel);
 	return verts;
 }();
@@ -38,7 +38,7 @@ public:
 		uint32						mUserData = 0;											///< User data value (can be used by the application for any purpose)
 	};
 
-	using SubShapes = vector<SubShapeSettings>;
+	using SubShapes = TaggedVector<SubShapeSettings, EMemoryTag::Shapes>;
 
 	SubShapes						mSubShapes;
 };
@@ -228,7 +228,7 @@ public:
 
 	static_assert(sizeof(SubShape) == (JPH_CPU_ADDRESS_BITS == 64? 40 : 36), "Compiler added unexpected padding");
 
-	using SubShapes = vector<SubShape>;
+	using SubShapes = TaggedVector<SubShape, EMemoryTag::Shapes>;
 
 	/// Access to the sub shapes of this compound
 	const SubShapes &				GetSubShapes() const									{ return mSubShapes; }
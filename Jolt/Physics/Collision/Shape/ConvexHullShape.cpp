@@ -46,7 +46,7 @@ ConvexHullShape::ConvexHullShape(const ConvexHullShapeSettings &inSettings, Shap
 {
 	using BuilderFace = ConvexHullBuilder::Face;
 	using Edge = ConvexHullBuilder::Edge;
-	using Faces = vector<BuilderFace *>;
+	using Faces = TaggedVector<BuilderFace *, EMemoryTag::Shapes>;
 	
 	// Check convex radius
 	if (mConvexRadius < 0.0f)
@@ -124,7 +124,7 @@ ConvexHullShape::ConvexHullShape(const ConvexHullShapeSettings &inSettings, Shap
 	mInertia = Mat44::sIdentity() * (covariance_matrix(0, 0) + covariance_matrix(1, 1) + covariance_matrix(2, 2)) - covariance_matrix;
 
 	// Convert polygons fron the builder to our internal representation
-	using VtxMap = unordered_map<int, uint8>;
+	using VtxMap = TaggedUnorderedMap<int, uint8, EMemoryTag::Shapes>;
 	VtxMap vertex_map;
 	for (BuilderFace *builder_face : builder_faces)
 	{
@@ -187,7 +187,7 @@ ConvexHullShape::ConvexHullShape(const ConvexHullShapeSettings &inSettings, Shap
 	for (int p = 0; p < (int)mPoints.size(); ++p)
 	{
 		// For each point, find faces that use the point
-		vector<int> faces;
+		TaggedVector<int, EMemoryTag::Shapes> faces;
 		for (int f = 0; f < (int)mFaces.size(); ++f)
 		{
 			const Face &face = mFaces[f];
@@ -380,7 +380,7 @@ Vec3 ConvexHullShape::GetSurfaceNormal(const SubShapeID &inSubShapeID, Vec3Arg i
 	float best_dist = abs(first_plane.SignedDistance(inLocalSurfacePosition));
 
 	// Find the face that has the shortest distance to the surface point
-	for (vector<Face>::size_type i = 1; i < mFaces.size(); ++i)
+	for (TaggedVector<Face, EMemoryTag::Shapes>::size_type i = 1; i < mFaces.size(); ++i)
 	{
 		const Plane &plane = mPlanes[i];
 		Vec3 plane_normal = plane.GetNormal();
@@ -683,7 +683,7 @@ void ConvexHullShape::GetSupportingFace(Vec3Arg inDirection, Vec3Arg inScale, Su
 	float best_dot = plane0_normal.Dot(inDirection) / plane0_normal.Length();
 	int best_face_idx = 0;
 
-	for (vector<Plane>::size_type i = 1; i < mPlanes.size(); ++i)
+	for (TaggedVector<Plane, EMemoryTag::Shapes>::size_type i = 1; i < mPlanes.size(); ++i)
 	{
 		Vec3 plane_normal = inv_scale * mPlanes[i].GetNormal();
 		float dot = plane_normal.Dot(inDirection) / plane_normal.Length();
@@ -804,7 +804,7 @@ void ConvexHullShape::Draw(DebugRenderer *inRenderer, Mat44Arg inCenterOfMassTra
 {
 	if (mGeometry == nullptr)
 	{
-		vector<DebugRenderer::Triangle> triangles;
+		TaggedVector<DebugRenderer::Triangle, EMemoryTag::Shapes> triangles;
 		for (const Face &f : mFaces)
 		{
 			const uint8 *first_vtx = mVertexIdx.data() + f.mFirstVertex;
@@ -32,10 +32,10 @@ JPH_IMPLEMENT_SERIALIZABLE_ABSTRACT(ConvexShapeSettings)
 	JPH_ADD_ATTRIBUTE(ConvexShapeSettings, mMaterial)
 }
 
-const vector<Vec3> ConvexShape::sUnitSphereTriangles = []() { 
+const TaggedVector<Vec3, EMemoryTag::Shapes> ConvexShape::sUnitSphereTriangles = []() { 
 	const int level = 2;
 
-	vector<Vec3> verts;	
+	TaggedVector<Vec3, EMemoryTag::Shapes> verts;	
 	GetTrianglesContextVertexList::sCreateHalfUnitSphereTop(verts, level);
 	GetTrianglesContextVertexList::sCreateHalfUnitSphereBottom(verts, level);
 	return verts;
@@ -493,7 +493,7 @@ void ConvexShape::DrawGetSupportFunction(DebugRenderer *inRenderer, Mat44Arg inC
 void ConvexShape::DrawGetSupportingFace(DebugRenderer *inRenderer, Mat44Arg inCenterOfMassTransform, Vec3Arg inScale) const
 {
 	// Sample directions and map which faces belong to which directions
-	using FaceToDirection = unordered_map<SupportingFace, vector<Vec3>>;
+	using FaceToDirection = TaggedUnorderedMap<SupportingFace, TaggedVector<Vec3, EMemoryTag::Shapes>, EMemoryTag::Shapes>;
 	FaceToDirection faces;
 	for (Vec3 v : Vec3::sUnitSphere)
 	{
@@ -142,7 +142,7 @@ protected:
 	virtual void					RestoreBinaryState(StreamIn &inStream) override;
 
 	/// Vertex list that forms a unit sphere
-	static const vector<Vec3>		sUnitSphereTriangles;
+	static const TaggedVector<Vec3, EMemoryTag::Shapes>	sUnitSphereTriangles;
 
 private:
 	// Class for GetTrianglesStart/Next
@@ -157,7 +157,7 @@ private:
 	float							mDensity = 1000.0f;											///< Uniform density of the interior of the convex object (kg / m^3)
 
 #ifdef JPH_DEBUG_RENDERER
-	mutable unordered_map<Vec3, DebugRenderer::GeometryRef> mGetSupportFunctionGeometry;
+	mutable TaggedUnorderedMap<Vec3, DebugRenderer::GeometryRef, EMemoryTag::Shapes> mGetSupportFunctionGeometry;
 #endif // JPH_DEBUG_RENDERER
 };
 
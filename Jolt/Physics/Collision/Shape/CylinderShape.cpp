@@ -43,8 +43,8 @@ static const Vec3 cTopFace[] =
 	Vec3(-cSin45,	1.0f,	cSin45)
 };
 
-static const vector<Vec3> sUnitCylinderTriangles = []() { 
-	vector<Vec3> verts;
+static const TaggedVector<Vec3, EMemoryTag::Shapes> sUnitCylinderTriangles = []() { 
+	TaggedVector<Vec3, EMemoryTag::Shapes> verts;
 
 	const Vec3 bottom_offset(0.0f, -2.0f, 0.0f);
 
@@ -217,7 +217,7 @@ void HeightFieldShape::CalculateActiveEdges()
 	memset(&mActiveEdges[0], 0, mActiveEdges.size());
 
 	// Calculate triangle normals and make normals zero for triangles that are missing
-	vector<Vec3> normals;
+	TaggedVector<Vec3, EMemoryTag::Shapes> normals;
 	normals.resize(2 * count_min_1_sq);
 	memset(&normals[0], 0, normals.size() * sizeof(Vec3));
 	for (uint y = 0; y < count_min_1; ++y)
@@ -269,7 +269,7 @@ void HeightFieldShape::CalculateActiveEdges()
 		}
 }
 
-void HeightFieldShape::StoreMaterialIndices(const vector<uint8> &inMaterialIndices)
+void HeightFieldShape::StoreMaterialIndices(const TaggedVector<uint8, EMemoryTag::Shapes> &inMaterialIndices)
 {
 	uint count_min_1 = mSampleCount - 1;
 
@@ -401,7 +401,7 @@ HeightFieldShape::HeightFieldShape(const HeightFieldShapeSettings &inSettings, S
 	}
 
 	// Quantize to uint16
-	vector<uint16> quantized_samples;
+	TaggedVector<uint16, EMemoryTag::Shapes> quantized_samples;
 	quantized_samples.reserve(mSampleCount * mSampleCount);
 	for (float h : inSettings.mHeightSamples)
 		if (h == cNoCollisionValue)
@@ -441,11 +441,11 @@ HeightFieldShape::HeightFieldShape(const HeightFieldShapeSettings &inSettings, S
 	};
 
 	// Reserve size for temporary range data + reserve 1 extra for a 1x1 grid that we won't store but use for calculating the bounding box
-	vector<vector<Range>> ranges;
+	TaggedVector<TaggedVector<Range, EMemoryTag::Shapes>, EMemoryTag::Shapes> ranges;
 	ranges.resize(max_level + 1);
 
 	// Calculate highest detail grid by combining mBlockSize x mBlockSize height samples
-	vector<Range> *cur_range_vector = &ranges.back();
+	TaggedVector<Range, EMemoryTag::Shapes> *cur_range_vector = &ranges.back();
 	cur_range_vector->resize(n * n);
 	Range *range_dst = &cur_range_vector->front();
 	for (uint y = 0; y < n; ++y)
@@ -891,7 +891,7 @@ void HeightFieldShape::Draw(DebugRenderer *inRenderer, Mat44Arg inCenterOfMassTr
 			for (uint32 bx = 0; bx < mSampleCount; bx += block_size)
 			{
 				// Create vertices for a block
-				vector<DebugRenderer::Triangle> triangles;
+				TaggedVector<DebugRenderer::Triangle, EMemoryTag::Shapes> triangles;
 				triangles.resize(block_size * block_size * 2);
 				DebugRenderer::Triangle *out_tri = &triangles[0];
 				for (uint32 y = by, max_y = min(by + block_size, mSampleCount - 1); y < max_y; ++y)
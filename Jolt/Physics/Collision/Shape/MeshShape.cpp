@@ -26,6 +26,10 @@
 #include <Jolt/Core/Profiler.h>
 #include <Jolt/Geometry/AABox4.h>
 #include <Jolt/Geometry/RayAABox.h>
+#if defined(JPH_MESH_SHAPE_OCT_TREE) && defined(JPH_USE_AVX)
+	#include <Jolt/Geometry/RayAABox8.h>
+#endif
+#include <Jolt/Geometry/RayPacket4.h>
 #include <Jolt/Geometry/Indexify.h>
 #include <Jolt/Geometry/Plane.h>
 #include <Jolt/Geometry/OrientedBox.h>
@@ -33,7 +37,11 @@
 #include <Jolt/AABBTree/AABBTreeBuilder.h>
 #include <Jolt/AABBTree/AABBTreeToBuffer.h>
 #include <Jolt/AABBTree/TriangleCodec/TriangleCodecIndexed8BitPackSOA4Flags.h>
-#include <Jolt/AABBTree/NodeCodec/NodeCodecQuadTreeHalfFloat.h>
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+	#include <Jolt/AABBTree/NodeCodec/NodeCodecOctTreeHalfFloat.h>
+#else
+	#include <Jolt/AABBTree/NodeCodec/NodeCodecQuadTreeHalfFloat.h>
+#endif // JPH_MESH_SHAPE_OCT_TREE
 #include <Jolt/ObjectStream/TypeDeclarations.h>
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
@@ -59,7 +67,30 @@ JPH_IMPLEMENT_SERIALIZABLE_VIRTUAL(MeshShapeSettings)
 
 // Codecs this mesh shape is using
 using TriangleCodec = TriangleCodecIndexed8BitPackSOA4Flags;
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+using NodeCodec = NodeCodecOctTreeHalfFloat<1>;
+#else
 using NodeCodec = NodeCodecQuadTreeHalfFloat<1>;
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
+// Stored in front of the tree in the binary state. The layout of the tree depends on the node codec (which is selected with JPH_MESH_SHAPE_OCT_TREE),
+// a tree that was saved with a different codec can't be used and is rejected when restoring. Increase the version in the low bits when the layout of a codec changes.
+static constexpr uint32 cTreeCodecTag = (uint32(NodeCodec::NumChildrenPerNode) << 16) | 1;
+
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+// Intersect the bounds of the 8 children of an oct tree node with a ray, returns the distances for the first and the last 4 children
+JPH_INLINE static void sRayChildBounds8(Vec3Arg inOrigin, const RayInvDirection &inInvDirection, const NodeCodec::ChildBounds &inBounds, Vec4 &outDistanceLo, Vec4 &outDistanceHi)
+{
+#ifdef JPH_USE_AVX
+	Vec8 distance = RayAABox8(inOrigin, inInvDirection, Vec8(inBounds.mMinX[0], inBounds.mMinX[1]), Vec8(inBounds.mMinY[0], inBounds.mMinY[1]), Vec8(inBounds.mMinZ[0], inBounds.mMinZ[1]), Vec8(inBounds.mMaxX[0], inBounds.mMaxX[1]), Vec8(inBounds.mMaxY[0], inBounds.mMaxY[1]), Vec8(inBounds.mMaxZ[0], inBounds.mMaxZ[1]));
+	outDistanceLo = distance.LowerVec4();
+	outDistanceHi = distance.UpperVec4();
+#else
+	outDistanceLo = RayAABox4(inOrigin, inInvDirection, inBounds.mMinX[0], inBounds.mMinY[0], inBounds.mMinZ[0], inBounds.mMaxX[0], inBounds.mMaxY[0], inBounds.mMaxZ[0]);
+	outDistanceHi = RayAABox4(inOrigin, inInvDirection, inBounds.mMinX[1], inBounds.mMinY[1], inBounds.mMinZ[1], inBounds.mMaxX[1], inBounds.mMaxY[1], inBounds.mMaxZ[1]);
+#endif // JPH_USE_AVX
+}
+#endif // JPH_MESH_SHAPE_OCT_TREE
 
 // Get header for tree
 static JPH_INLINE const NodeCodec::Header *sGetNodeHeader(const ByteBuffer &inTree)
@@ -92,7 +123,7 @@ MeshShapeSettings::MeshShapeSettings(const VertexList &inVertices, const Indexed
 void MeshShapeSettings::Sanitize()
 {
 	// Remove degenerate and duplicate triangles
-	unordered_set<IndexedTriangle> triangles;
+	TaggedUnorderedSet<IndexedTriangle, EMemoryTag::Shapes> triangles;
 	triangles.reserve(mIndexedTriangles.size());
 	for (int t = (int)mIndexedTriangles.size() - 1; t >= 0; --t)
 	{
@@ -253,7 +284,7 @@ void MeshShape::sFindActiveEdges(const VertexList &inVertices, IndexedTriangleLi
 	};
 
 	// Build a list of edge to triangles
-	using EdgeToTriangle = unordered_map<Edge, TriangleIndices, EdgeHash>;
+	using EdgeToTriangle = TaggedUnorderedMap<Edge, TriangleIndices, EMemoryTag::Shapes, EdgeHash>;
 	EdgeToTriangle edge_to_triangle;
 	edge_to_triangle.reserve(ioIndices.size() * 3);
 	for (uint triangle_idx = 0; triangle_idx < ioIndices.size(); ++triangle_idx)
@@ -437,6 +468,13 @@ JPH_INLINE void MeshShape::WalkTreePerTriangle(const SubShapeIDCreator &inSubSha
 			return mVisitor.VisitNodes(inBoundsMinX, inBoundsMinY, inBoundsMinZ, inBoundsMaxX, inBoundsMaxY, inBoundsMaxZ, ioProperties, inStackTop);
 		}
 
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			return NodeCodec::DecodingContext::sVisitNodes8(mVisitor, inBounds, inPropertiesLo, inPropertiesHi, outProperties, inStackTop);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
 		JPH_INLINE void		VisitTriangles(const TriangleCodec::DecodingContext &ioContext, const void *inTriangles, int inNumTriangles, uint32 inTriangleBlockID) 
 		{
 			// Create ID for triangle block
@@ -530,14 +568,14 @@ void MeshShape::Draw(DebugRenderer *inRenderer, Mat44Arg inCenterOfMassTransform
 				}
 			}
 
-			vector<DebugRenderer::Triangle> &		mTriangles;
+			TaggedVector<DebugRenderer::Triangle, EMemoryTag::Shapes> &	mTriangles;
 			const PhysicsMaterialList &				mMaterials;
 			bool									mUseMaterialColors;
 			bool									mDrawTriangleGroups;
 			int										mColorIdx = 0;
 		};
 		
-		vector<DebugRenderer::Triangle> triangles;
+		TaggedVector<DebugRenderer::Triangle, EMemoryTag::Shapes> triangles;
 		Visitor visitor { triangles, mMaterials, mCachedUseMaterialColors, mCachedTrianglesColoredPerGroup };
 		WalkTree(visitor);
 		mGeometry = new DebugRenderer::Geometry(inRenderer->CreateTriangleBatch(triangles), GetLocalBounds());
@@ -645,6 +683,18 @@ bool MeshShape::CastRay(const RayCast &inRay, const SubShapeIDCreator &inSubShap
 			return SortReverseAndStore(distance, mHit.mFraction, ioProperties, &mDistanceStack[inStackTop]);
 		}
 
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			// Test bounds of 8 children
+			Vec4 distance_lo, distance_hi;
+			sRayChildBounds8(mRayOrigin, mRayInvDirection, inBounds, distance_lo, distance_hi);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStore8(distance_lo, distance_hi, mHit.mFraction, inPropertiesLo, inPropertiesHi, outProperties, &mDistanceStack[inStackTop]);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
 		JPH_INLINE void		VisitTriangles(const TriangleCodec::DecodingContext &ioContext, const void *inTriangles, int inNumTriangles, uint32 inTriangleBlockID) 
 		{
 			// Test against triangles
@@ -679,6 +729,109 @@ bool MeshShape::CastRay(const RayCast &inRay, const SubShapeIDCreator &inSubShap
 	return visitor.mReturnValue;
 }
 
+uint MeshShape::CastRayPacket(const RayCast *inRays, int inNumRays, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult *ioHits) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumRays > 0 && inNumRays <= RayPacket4::cNumRays);
+
+	struct Visitor
+	{
+		JPH_INLINE explicit	Visitor(const RayCast *inRays, int inNumRays, RayCastResult *ioHits) :
+			mRays(inRays),
+			mHits(ioHits)
+		{
+			// Convert the rays to a packet
+			Vec3 origins[RayPacket4::cNumRays], directions[RayPacket4::cNumRays];
+			for (int i = 0; i < inNumRays; ++i)
+			{
+				origins[i] = inRays[i].mOrigin;
+				directions[i] = inRays[i].mDirection;
+			}
+			mPacket.Set(origins, directions, inNumRays);
+
+			// Rays that are not in use are done
+			mFractions = Vec4::sZero();
+			for (int i = 0; i < inNumRays; ++i)
+				mFractions[i] = ioHits[i].mFraction;
+			mDistanceStack[0] = Vec4::sSelect(Vec4::sReplicate(FLT_MAX), Vec4::sReplicate(-1.0f), mPacket.mIsValid);
+		}
+
+		JPH_INLINE bool		ShouldAbort() const
+		{
+			return Vec4::sLessOrEqual(mFractions, Vec4::sZero()).TestAllTrue();
+		}
+
+		JPH_INLINE bool		ShouldVisitNode(int inStackTop) const
+		{
+			// Remember which node is visited so that VisitTriangles knows which rays reached the triangles
+			mVisitStackTop = inStackTop;
+
+			return Vec4::sLess(mDistanceStack[inStackTop], mFractions).TestAnyTrue();
+		}
+
+		JPH_INLINE int		VisitNodes(Vec4Arg inBoundsMinX, Vec4Arg inBoundsMinY, Vec4Arg inBoundsMinZ, Vec4Arg inBoundsMaxX, Vec4Arg inBoundsMaxY, Vec4Arg inBoundsMaxZ, UVec4 &ioProperties, int inStackTop) 
+		{
+			// Test bounds of 4 children against all rays
+			Vec4 distances[4];
+			RayPacket4AABox4(mPacket, inBoundsMinX, inBoundsMinY, inBoundsMinZ, inBoundsMaxX, inBoundsMaxY, inBoundsMaxZ, distances);
+	
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStorePacket(distances, mFractions, ioProperties, &mDistanceStack[inStackTop]);
+		}
+
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			// Test bounds of 8 children against all rays
+			Vec4 distances[8];
+			RayPacket4AABox4(mPacket, inBounds.mMinX[0], inBounds.mMinY[0], inBounds.mMinZ[0], inBounds.mMaxX[0], inBounds.mMaxY[0], inBounds.mMaxZ[0], &distances[0]);
+			RayPacket4AABox4(mPacket, inBounds.mMinX[1], inBounds.mMinY[1], inBounds.mMinZ[1], inBounds.mMaxX[1], inBounds.mMaxY[1], inBounds.mMaxZ[1], &distances[4]);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStorePacket8(distances, mFractions, inPropertiesLo, inPropertiesHi, outProperties, &mDistanceStack[inStackTop]);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
+		JPH_INLINE void		VisitTriangles(const TriangleCodec::DecodingContext &ioContext, const void *inTriangles, int inNumTriangles, uint32 inTriangleBlockID) 
+		{
+			// Test the rays that can still hit the bounding box of the triangles
+			int rays_to_test = Vec4::sLess(mDistanceStack[mVisitStackTop], mFractions).GetTrues();
+			for (int i = 0; rays_to_test != 0; ++i, rays_to_test >>= 1)
+				if (rays_to_test & 1)
+				{
+					uint32 triangle_idx;
+					float fraction = ioContext.TestRay(mRays[i].mOrigin, mRays[i].mDirection, inTriangles, inNumTriangles, mFractions[i], triangle_idx);
+					if (fraction < mFractions[i])
+					{
+						mFractions[i] = fraction;
+						RayCastResult &hit = mHits[i];
+						hit.mFraction = fraction;
+						hit.mSubShapeID2 = mSubShapeIDCreator.PushID(inTriangleBlockID, mTriangleBlockIDBits).PushID(triangle_idx, NumTriangleBits).GetID();
+						mHitMask |= 1 << i;
+					}
+				}
+		}
+
+		const RayCast *		mRays;
+		RayCastResult *		mHits;
+		RayPacket4			mPacket;
+		Vec4				mFractions;
+		uint				mTriangleBlockIDBits;
+		SubShapeIDCreator	mSubShapeIDCreator;
+		uint				mHitMask = 0;
+		mutable int			mVisitStackTop = 0;
+		Vec4				mDistanceStack[NodeCodec::StackSize];
+	};
+
+	Visitor visitor(inRays, inNumRays, ioHits);
+	visitor.mTriangleBlockIDBits = NodeCodec::DecodingContext::sTriangleBlockIDBits(mTree);
+	visitor.mSubShapeIDCreator = inSubShapeIDCreator;
+	WalkTree(visitor);
+
+	return visitor.mHitMask;
+}
+
 void MeshShape::CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, const SubShapeIDCreator &inSubShapeIDCreator, CastRayCollector &ioCollector, const ShapeFilter &inShapeFilter) const
 {
 	JPH_PROFILE_FUNCTION();
@@ -713,6 +866,18 @@ void MeshShape::CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSe
 			return SortReverseAndStore(distance, mCollector.GetEarlyOutFraction(), ioProperties, &mDistanceStack[inStackTop]);
 		}
 
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			// Test bounds of 8 children
+			Vec4 distance_lo, distance_hi;
+			sRayChildBounds8(mRayOrigin, mRayInvDirection, inBounds, distance_lo, distance_hi);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStore8(distance_lo, distance_hi, mCollector.GetEarlyOutFraction(), inPropertiesLo, inPropertiesHi, outProperties, &mDistanceStack[inStackTop]);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
 		JPH_INLINE void		VisitTriangle(Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, [[maybe_unused]] uint8 inActiveEdges, SubShapeID inSubShapeID2) 
 		{
 			// Back facing check
@@ -817,6 +982,26 @@ void MeshShape::sCastConvexVsMesh(const ShapeCast &inShapeCast, const ShapeCastS
 			return SortReverseAndStore(distance, mCollector.GetEarlyOutFraction(), ioProperties, &mDistanceStack[inStackTop]);
 		}
 
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			// Scale the bounding boxes of this node and enlarge them by the casted shape's box extents
+			NodeCodec::ChildBounds bounds;
+			for (int i = 0; i < 2; ++i)
+			{
+				AABox4Scale(mScale, inBounds.mMinX[i], inBounds.mMinY[i], inBounds.mMinZ[i], inBounds.mMaxX[i], inBounds.mMaxY[i], inBounds.mMaxZ[i], bounds.mMinX[i], bounds.mMinY[i], bounds.mMinZ[i], bounds.mMaxX[i], bounds.mMaxY[i], bounds.mMaxZ[i]);
+				AABox4EnlargeWithExtent(mBoxExtent, bounds.mMinX[i], bounds.mMinY[i], bounds.mMinZ[i], bounds.mMaxX[i], bounds.mMaxY[i], bounds.mMaxZ[i]);
+			}
+
+			// Test bounds of 8 children
+			Vec4 distance_lo, distance_hi;
+			sRayChildBounds8(mBoxCenter, mInvDirection, bounds, distance_lo, distance_hi);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStore8(distance_lo, distance_hi, mCollector.GetEarlyOutFraction(), inPropertiesLo, inPropertiesHi, outProperties, &mDistanceStack[inStackTop]);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
 		JPH_INLINE void		VisitTriangle(Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, uint8 inActiveEdges, SubShapeID inSubShapeID2) 
 		{
 			Cast(inV0, inV1, inV2, inActiveEdges, inSubShapeID2);
@@ -872,6 +1057,26 @@ void MeshShape::sCastSphereVsMesh(const ShapeCast &inShapeCast, const ShapeCastS
 			return SortReverseAndStore(distance, mCollector.GetEarlyOutFraction(), ioProperties, &mDistanceStack[inStackTop]);
 		}
 
+#ifdef JPH_MESH_SHAPE_OCT_TREE
+		JPH_INLINE int		VisitNodes8(const NodeCodec::ChildBounds &inBounds, UVec4Arg inPropertiesLo, UVec4Arg inPropertiesHi, uint32 *outProperties, int inStackTop)
+		{
+			// Scale the bounding boxes of this node and enlarge them by the radius of the sphere
+			NodeCodec::ChildBounds bounds;
+			for (int i = 0; i < 2; ++i)
+			{
+				AABox4Scale(mScale, inBounds.mMinX[i], inBounds.mMinY[i], inBounds.mMinZ[i], inBounds.mMaxX[i], inBounds.mMaxY[i], inBounds.mMaxZ[i], bounds.mMinX[i], bounds.mMinY[i], bounds.mMinZ[i], bounds.mMaxX[i], bounds.mMaxY[i], bounds.mMaxZ[i]);
+				AABox4EnlargeWithExtent(Vec3::sReplicate(mRadius), bounds.mMinX[i], bounds.mMinY[i], bounds.mMinZ[i], bounds.mMaxX[i], bounds.mMaxY[i], bounds.mMaxZ[i]);
+			}
+
+			// Test bounds of 8 children
+			Vec4 distance_lo, distance_hi;
+			sRayChildBounds8(mStart, mInvDirection, bounds, distance_lo, distance_hi);
+
+			// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+			return SortReverseAndStore8(distance_lo, distance_hi, mCollector.GetEarlyOutFraction(), inPropertiesLo, inPropertiesHi, outProperties, &mDistanceStack[inStackTop]);
+		}
+#endif // JPH_MESH_SHAPE_OCT_TREE
+
 		JPH_INLINE void		VisitTriangle(Vec3Arg inV0, Vec3Arg inV1, Vec3Arg inV2, uint8 inActiveEdges, SubShapeID inSubShapeID2) 
 		{
 			Cast(inV0, inV1, inV2, inActiveEdges, inSubShapeID2);
@@ -1118,6 +1323,7 @@ void MeshShape::SaveBinaryState(StreamOut &inStream) const
 {
 	Shape::SaveBinaryState(inStream);
 
+	inStream.Write(cTreeCodecTag);
 	inStream.Write(static_cast<const ByteBufferVector &>(mTree)); // Make sure we use the vector<> overload
 }
 
@@ -1125,7 +1331,22 @@ void MeshShape::RestoreBinaryState(StreamIn &inStream)
 {
 	Shape::RestoreBinaryState(inStream);
 
+	uint32 tree_codec_tag = 0;
+	inStream.Read(tree_codec_tag);
 	inStream.Read(static_cast<ByteBufferVector &>(mTree)); // Make sure we use the vector<> overload
+
+	// A tree that was written with a different codec can't be decoded, leave it empty so that GetRestoreBinaryStateError rejects the shape
+	if (tree_codec_tag != cTreeCodecTag)
+		mTree.clear();
+}
+
+const char *MeshShape::GetRestoreBinaryStateError() const
+{
+	// A valid tree always contains the node and triangle headers
+	if (mTree.size() < size_t(NodeCodec::HeaderSize + TriangleCodec::TriangleHeaderSize))
+		return "Mesh shape tree is invalid or was saved with a different tree codec";
+
+	return nullptr;
 }
 
 void MeshShape::SaveMaterialState(PhysicsMaterialList &outMaterials) const
@@ -91,6 +91,7 @@ public:
 
 	// See Shape::CastRay
 	virtual bool					CastRay(const RayCast &inRay, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult &ioHit) const override;
+	virtual uint					CastRayPacket(const RayCast *inRays, int inNumRays, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult *ioHits) const override;
 	virtual void					CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, const SubShapeIDCreator &inSubShapeIDCreator, CastRayCollector &ioCollector, const ShapeFilter &inShapeFilter = { }) const override;
 
 	/// See: Shape::CollidePoint
@@ -131,6 +132,9 @@ protected:
 	// See: Shape::RestoreBinaryState
 	virtual void					RestoreBinaryState(StreamIn &inStream) override;
 
+	// See: Shape::GetRestoreBinaryStateError
+	virtual const char *			GetRestoreBinaryStateError() const override;
+
 private:
 	struct							MSGetTrianglesContext;										///< Context class for GetTrianglesStart/Next
 
@@ -8,6 +8,8 @@
 #include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #include <Jolt/Physics/Collision/TransformedShape.h>
 #include <Jolt/Physics/Collision/PhysicsMaterial.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Core/StreamIn.h>
 #include <Jolt/Core/StreamOut.h>
 #include <Jolt/Core/Factory.h>
@@ -50,6 +52,15 @@ void Shape::CollectTransformedShapes(const AABox &inBox, Vec3Arg inPositionCOM,
 	ioCollector.AddHit(ts);
 }
 
+uint Shape::CastRayPacket(const RayCast *inRays, int inNumRays, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult *ioHits) const
+{
+	uint hit_mask = 0;
+	for (int i = 0; i < inNumRays; ++i)
+		if (CastRay(inRays[i], inSubShapeIDCreator, ioHits[i]))
+			hit_mask |= 1 << i;
+	return hit_mask;
+}
+
 void Shape::TransformShape(Mat44Arg inCenterOfMassTransform, TransformedShapeCollector &ioCollector) const
 {
 	Vec3 scale;
@@ -92,6 +103,12 @@ Shape::ShapeResult Shape::sRestoreFromBinaryState(StreamIn &inStream)
 		result.SetError("Failed to restore shape");
 		return result;
 	}
+	const char *error = shape->GetRestoreBinaryStateError();
+	if (error != nullptr)
+	{
+		result.SetError(error);
+		return result;
+	}
 
 	result.Set(shape);
 	return result;
@@ -302,7 +319,7 @@ Shape::ShapeResult Shape::ScaleShape(Vec3Arg inScale) const
 			mShapes.push_back(inResult);
 		}
 
-		vector<TransformedShape>	mShapes;
+		TaggedVector<TransformedShape, EMemoryTag::Shapes>	mShapes;
 	};
 	Collector collector;
 	TransformShape(Mat44::sScale(inScale) * Mat44::sTranslation(GetCenterOfMass()), collector);
@@ -12,6 +12,7 @@
 #include <Jolt/Core/Color.h>
 #include <Jolt/Core/Result.h>
 #include <Jolt/Core/NonCopyable.h>
+#include <Jolt/Core/Memory.h>
 #include <Jolt/ObjectStream/SerializableObject.h>
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
@@ -48,9 +49,9 @@ using CollideShapeCollector = CollisionCollector<CollideShapeResult, CollisionCo
 using TransformedShapeCollector = CollisionCollector<TransformedShape, CollisionCollectorTraitsCollideShape>;
 
 using ShapeRefC = RefConst<Shape>;
-using ShapeList = vector<ShapeRefC>;
+using ShapeList = TaggedVector<ShapeRefC, EMemoryTag::Shapes>;
 using PhysicsMaterialRefC = RefConst<PhysicsMaterial>;
-using PhysicsMaterialList = vector<PhysicsMaterialRefC>;
+using PhysicsMaterialList = TaggedVector<PhysicsMaterialRefC, EMemoryTag::Shapes>;
 
 /// Shapes are categorized in groups, each shape can return which group it belongs to through its Shape::GetType function.
 enum class EShapeType : uint8
@@ -126,6 +127,8 @@ static_assert(size(sSubShapeTypeNames) == NumSubShapeTypes);
 class ShapeSettings : public SerializableObject, public RefTarget<ShapeSettings>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 	JPH_DECLARE_SERIALIZABLE_ABSTRACT(ShapeSettings)
 
 	using ShapeResult = Result<Ref<Shape>>;
@@ -161,6 +164,8 @@ private:
 class Shape : public RefTarget<Shape>, public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Shapes)
+
 	using ShapeResult = ShapeSettings::ShapeResult;
 
 	/// Constructor
@@ -247,6 +252,10 @@ public:
 	/// If you want the surface normal of the hit use GetSurfaceNormal(ioHit.mSubShapeID2, inRay.GetPointOnRay(ioHit.mFraction)).
 	virtual bool					CastRay(const RayCast &inRay, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult &ioHit) const = 0;
 
+	/// Cast a packet of up to RayPacket4::cNumRays rays against this shape, see CastRay. Returns a bit mask of the rays for which a hit closer than ioHits[i].mFraction was found (ioHits[i] is updated for these rays).
+	/// The default implementation casts the rays one by one, shapes that contain a tree trace the rays through it together so the rays should be coherent.
+	virtual uint					CastRayPacket(const RayCast *inRays, int inNumRays, const SubShapeIDCreator &inSubShapeIDCreator, RayCastResult *ioHits) const;
+
 	/// Cast a ray against this shape. Allows returning multiple hits through ioCollector. Note that this version is more flexible but also slightly slower than the CastRay function that returns only a single hit.
 	/// If you want the surface normal of the hit use GetSurfaceNormal(collected sub shape ID, inRay.GetPointOnRay(collected faction)).
 	virtual void					CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, const SubShapeIDCreator &inSubShapeIDCreator, CastRayCollector &ioCollector, const ShapeFilter &inShapeFilter = { }) const = 0;
@@ -318,10 +327,10 @@ public:
 	/// Restore the shape references after calling sRestoreFromBinaryState. Note that the exact same shapes need to be provided in the same order as returned by SaveSubShapeState.
 	virtual void					RestoreSubShapeState(const ShapeRefC *inSubShapes, uint inNumShapes) { JPH_ASSERT(inNumShapes == 0); }
 
-	using ShapeToIDMap = unordered_map<const Shape *, uint32>;
-	using MaterialToIDMap = unordered_map<const PhysicsMaterial *, uint32>;
-	using IDToShapeMap = vector<Ref<Shape>>;
-	using IDToMaterialMap = vector<Ref<PhysicsMaterial>>;
+	using ShapeToIDMap = TaggedUnorderedMap<const Shape *, uint32, EMemoryTag::Shapes>;
+	using MaterialToIDMap = TaggedUnorderedMap<const PhysicsMaterial *, uint32, EMemoryTag::Shapes>;
+	using IDToShapeMap = TaggedVector<Ref<Shape>, EMemoryTag::Shapes>;
+	using IDToMaterialMap = TaggedVector<Ref<PhysicsMaterial>, EMemoryTag::Shapes>;
 
 	/// Save this shape, all its children and its materials. Pass in an empty map in ioShapeMap / ioMaterialMap or reuse the same map while saving multiple shapes to the same stream in order to avoid writing duplicates.
 	void							SaveWithChildren(StreamOut &inStream, ShapeToIDMap &ioShapeMap, MaterialToIDMap &ioMaterialMap) const;
@@ -343,7 +352,7 @@ public:
 	/// Get stats of this shape. Use for logging / data collection purposes only. Does not add values from child shapes, use GetStatsRecursive for this.
 	virtual Stats					GetStats() const = 0;
 
-	using VisitedShapes = unordered_set<const Shape *>;
+	using VisitedShapes = TaggedUnorderedSet<const Shape *, EMemoryTag::Shapes>;
 
 	/// Get the combined stats of this shape and its children.
 	/// @param ioVisitedShapes is used to track which shapes have already been visited, to avoid calculating the wrong memory size.
@@ -365,6 +374,9 @@ protected:
 	/// This function should not be called directly, it is used by sRestoreFromBinaryState.
 	virtual void					RestoreBinaryState(StreamIn &inStream);
 
+	/// Called by sRestoreFromBinaryState after RestoreBinaryState, returns an error when the restored state can't be used (e.g. because it was saved with a different data layout) or nullptr when it can.
+	virtual const char *			GetRestoreBinaryStateError() const									{ return nullptr; }
+
 private:
 	uint64							mUserData = 0;
 	EShapeType						mShapeType;
@@ -30,6 +30,113 @@ JPH_INLINE int SortReverseAndStore(Vec4Arg inValues, float inMaxValue, UVec4 &io
 	return num_results;
 }
 
+/// Version of SortReverseAndStore for a packet of rays: children that none of the rays can hit are dropped and the remaining children are sorted on the distance of their closest ray from high to low
+/// @param inValues For each of the 4 children the values for each ray in the packet
+/// @param inMaxValues Per ray, values need to be less than this to keep them
+/// @param ioIdentifiers 4 identifiers that will be sorted in the same way as the values
+/// @param outValues The values of the children that are kept are stored here from high to low
+/// @return The number of children that were kept
+JPH_INLINE int SortReverseAndStorePacket(const Vec4 *inValues, Vec4Arg inMaxValues, UVec4 &ioIdentifiers, Vec4 *outValues)
+{
+	// Determine for each child the distance of the closest ray that can still hit it
+	Vec4 flt_max = Vec4::sReplicate(FLT_MAX);
+	Vec4 closest;
+	for (int i = 0; i < 4; ++i)
+		closest[i] = Vec4::sSelect(flt_max, inValues[i], Vec4::sLess(inValues[i], inMaxValues)).ReduceMin();
+
+	// Sort so that highest values are first (we want to first process closer hits and we process stack top to bottom)
+	UVec4 index(0, 1, 2, 3);
+	Vec4::sSort4Reverse(closest, index);
+
+	// The children that can be hit are at the end, move them to the front
+	int num_results = Vec4::sLess(closest, flt_max).CountTrues();
+	UVec4 identifiers = ioIdentifiers;
+	for (int src = 4 - num_results, dst = 0; src < 4; ++src, ++dst)
+	{
+		uint32 child = index[src];
+		ioIdentifiers[dst] = identifiers[child];
+		outValues[dst] = inValues[child];
+	}
+
+	return num_results;
+}
+
+/// Version of SortReverseAndStore for 8 values that are passed as 2 groups of 4, the values of both groups are sorted together
+/// @param inValuesLo Values of the first 4 identifiers
+/// @param inValuesHi Values of the last 4 identifiers
+/// @param inMaxValue Values need to be less than this to keep them
+/// @param inIdentifiersLo First 4 identifiers
+/// @param inIdentifiersHi Last 4 identifiers
+/// @param outIdentifiers The identifiers of the values that are kept are stored here from high to low value
+/// @param outValues The values that are kept are stored here from high to low
+/// @return The number of values that were kept
+JPH_INLINE int SortReverseAndStore8(Vec4Arg inValuesLo, Vec4Arg inValuesHi, float inMaxValue, UVec4Arg inIdentifiersLo, UVec4Arg inIdentifiersHi, uint32 *outIdentifiers, float *outValues)
+{
+	// Sort both groups so that highest values are first
+	Vec4 values_lo = inValuesLo, values_hi = inValuesHi;
+	UVec4 identifiers_lo = inIdentifiersLo, identifiers_hi = inIdentifiersHi;
+	Vec4::sSort4Reverse(values_lo, identifiers_lo);
+	Vec4::sSort4Reverse(values_hi, identifiers_hi);
+
+	// The values that are less than the max value are at the end of each group
+	Vec4 max_value = Vec4::sReplicate(inMaxValue);
+	int lo = 4 - Vec4::sLess(values_lo, max_value).CountTrues();
+	int hi = 4 - Vec4::sLess(values_hi, max_value).CountTrues();
+	int num_results = 8 - lo - hi;
+
+	alignas(16) float values[8];
+	alignas(16) uint32 identifiers[8];
+	values_lo.StoreFloat4((Float4 *)&values[0]);
+	values_hi.StoreFloat4((Float4 *)&values[4]);
+	identifiers_lo.StoreInt4(&identifiers[0]);
+	identifiers_hi.StoreInt4(&identifiers[4]);
+
+	// Merge the kept values of both groups from high to low
+	hi += 4;
+	for (int i = 0; i < num_results; ++i)
+	{
+		int src = hi == 8 || (lo < 4 && values[lo] >= values[hi])? lo++ : hi++;
+		outIdentifiers[i] = identifiers[src];
+		outValues[i] = values[src];
+	}
+
+	return num_results;
+}
+
+/// Version of SortReverseAndStorePacket for 8 children that are passed as 2 groups of 4, the children of both groups are sorted together
+/// @param inValues For each of the 8 children the values for each ray in the packet
+/// @param inMaxValues Per ray, values need to be less than this to keep them
+/// @param inIdentifiersLo First 4 identifiers
+/// @param inIdentifiersHi Last 4 identifiers
+/// @param outIdentifiers The identifiers of the children that are kept are stored here from high to low value
+/// @param outValues The values of the children that are kept are stored here from high to low
+/// @return The number of children that were kept
+JPH_INLINE int SortReverseAndStorePacket8(const Vec4 *inValues, Vec4Arg inMaxValues, UVec4Arg inIdentifiersLo, UVec4Arg inIdentifiersHi, uint32 *outIdentifiers, Vec4 *outValues)
+{
+	// Determine for each child the distance of the closest ray that can still hit it
+	Vec4 flt_max = Vec4::sReplicate(FLT_MAX);
+	Vec4 closest[2];
+	for (int i = 0; i < 8; ++i)
+		closest[i >> 2][i & 3] = Vec4::sSelect(flt_max, inValues[i], Vec4::sLess(inValues[i], inMaxValues)).ReduceMin();
+
+	// Sort the children that can be hit so that highest values are first
+	uint32 index[8];
+	float distance[8];
+	int num_results = SortReverseAndStore8(closest[0], closest[1], FLT_MAX, UVec4(0, 1, 2, 3), UVec4(4, 5, 6, 7), index, distance);
+
+	alignas(16) uint32 identifiers[8];
+	inIdentifiersLo.StoreInt4(&identifiers[0]);
+	inIdentifiersHi.StoreInt4(&identifiers[4]);
+	for (int i = 0; i < num_results; ++i)
+	{
+		uint32 child = index[i];
+		outIdentifiers[i] = identifiers[child];
+		outValues[i] = inValues[child];
+	}
+
+	return num_results;
+}
+
 /// Shift the elements so that the identifiers that correspond with the trues in inValue come first
 /// @param inValue Values to test for true or false
 /// @param ioIdentifiers the identifiers that are shifted, on return they are shifted
@@ -10,6 +10,7 @@
 #include <Jolt/Physics/Collision/Shape/SubShapeID.h>
 #include <Jolt/Physics/Collision/CollisionDispatch.h>
 #include <Jolt/Geometry/OrientedBox.h>
+#include <Jolt/Geometry/RayPacket4.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -39,6 +40,37 @@ bool TransformedShape::CastRay(const RayCast &inRay, RayCastResult &ioHit) const
 	return false;
 }
 
+uint TransformedShape::CastRayPacket(const RayCast *inRays, int inNumRays, RayCastResult *ioHits) const
+{
+	if (mShape == nullptr)
+		return 0;
+
+	JPH_ASSERT(inNumRays <= RayPacket4::cNumRays);
+
+	// Transform the rays to local space and scale them
+	Mat44 inv_com = GetInverseCenterOfMassTransform();
+	Vec3 inv_scale = GetShapeScale().Reciprocal();
+	RayCast rays[RayPacket4::cNumRays];
+	for (int i = 0; i < inNumRays; ++i)
+	{
+		RayCast &ray = rays[i];
+		ray = inRays[i].Transformed(inv_com);
+		ray.mOrigin *= inv_scale;
+		ray.mDirection *= inv_scale;
+	}
+
+	// Cast the rays on the shape
+	SubShapeIDCreator sub_shape_id(mSubShapeIDCreator);
+	uint hit_mask = mShape->CastRayPacket(rays, inNumRays, sub_shape_id, ioHits);
+
+	// Set body ID on the hit results
+	for (int i = 0; i < inNumRays; ++i)
+		if (hit_mask & (1 << i))
+			ioHits[i].mBodyID = mBodyID;
+
+	return hit_mask;
+}
+
 void TransformedShape::CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, CastRayCollector &ioCollector, const ShapeFilter &inShapeFilter) const
 {
 	if (mShape != nullptr)
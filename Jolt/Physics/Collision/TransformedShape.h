@@ -32,6 +32,10 @@ public:
 	/// If you want the surface normal of the hit use GetWorldSpaceSurfaceNormal(ioHit.mSubShapeID2, inRay.GetPointOnRay(ioHit.mFraction)) on this object.
 	bool						CastRay(const RayCast &inRay, RayCastResult &ioHit) const;
 
+	/// Cast a packet of up to RayPacket4::cNumRays coherent rays and find the closest hit for each of them, see CastRay.
+	/// Returns a bit mask of the rays for which a hit closer than ioHits[i].mFraction was found (ioHits[i] is updated for these rays).
+	uint						CastRayPacket(const RayCast *inRays, int inNumRays, RayCastResult *ioHits) const;
+
 	/// Cast a ray, allows collecting multiple hits. Note that this version is more flexible but also slightly slower than the CastRay function that returns only a single hit.
 	/// If you want the surface normal of the hit use GetWorldSpaceSurfaceNormal(collected sub shape ID, inRay.GetPointOnRay(collected fraction)) on this object.
 	void						CastRay(const RayCast &inRay, const RayCastSettings &inRayCastSettings, CastRayCollector &ioCollector, const ShapeFilter &inShapeFilter = { }) const;
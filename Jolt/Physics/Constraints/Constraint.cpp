@@ -5,6 +5,7 @@
 
 #include <Jolt/Physics/Constraints/Constraint.h>
 #include <Jolt/Physics/StateRecorder.h>
+#include <Jolt/Physics/LargeIslandSplitter.h>
 #include <Jolt/ObjectStream/TypeDeclarations.h>
 #include <Jolt/Core/StreamIn.h>
 #include <Jolt/Core/StreamOut.h>
@@ -68,6 +69,11 @@ ConstraintSettings::ConstraintResult ConstraintSettings::sRestoreFromBinaryState
 	return result;
 }
 
+uint Constraint::BuildIslandSplits(LargeIslandSplitter &ioSplitter) const
+{
+	return ioSplitter.AssignToNonParallelSplit();
+}
+
 void Constraint::SaveState(StateRecorder &inStream) const
 {
 	inStream.Write(mEnabled);
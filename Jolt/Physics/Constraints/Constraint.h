@@ -5,12 +5,14 @@
 
 #include <Jolt/Core/Reference.h>
 #include <Jolt/Core/NonCopyable.h>
+#include <Jolt/Core/Memory.h>
 #include <Jolt/Core/Result.h>
 #include <Jolt/ObjectStream/SerializableObject.h>
 
 JPH_NAMESPACE_BEGIN
 
 class IslandBuilder;
+class LargeIslandSplitter;
 class BodyManager;
 class StateRecorder;
 class StreamIn;
@@ -58,6 +60,8 @@ enum class EConstraintSpace
 class ConstraintSettings : public SerializableObject, public RefTarget<ConstraintSettings>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	JPH_DECLARE_SERIALIZABLE_VIRTUAL(ConstraintSettings)
 
 	using ConstraintResult = Result<Ref<ConstraintSettings>>;
@@ -83,6 +87,8 @@ protected:
 class Constraint : public RefTarget<Constraint>, public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	/// Constructor
 	explicit					Constraint(const ConstraintSettings &inSettings) :
 #ifdef JPH_DEBUG_RENDERER
@@ -122,6 +128,10 @@ public:
 	/// Link bodies that are connected by this constraint in the island builder
 	virtual void				BuildIslands(uint32 inConstraintIndex, IslandBuilder &ioBuilder, BodyManager &inBodyManager) = 0;
 
+	/// Assign the bodies that are modified by this constraint to a split of a large island, returns the split index.
+	/// By default the constraint is solved by a single job (see LargeIslandSplitter::AssignToNonParallelSplit).
+	virtual uint				BuildIslandSplits(LargeIslandSplitter &ioSplitter) const;
+
 #ifdef JPH_DEBUG_RENDERER
 	// Drawing interface
 	virtual void				DrawConstraint(DebugRenderer *inRenderer) const = 0;
@@ -162,6 +172,9 @@ private:
 
 	/// If this constraint is currently enabled
 	bool						mEnabled = true;
+
+	/// If this constraint was active the last time ConstraintManager::GetActiveConstraints was called
+	bool						mWasActive = false;
 };
 
 JPH_NAMESPACE_END
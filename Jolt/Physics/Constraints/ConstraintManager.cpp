@@ -65,7 +65,7 @@ Constraints ConstraintManager::GetConstraints() const
 	return copy;
 }
 
-void ConstraintManager::GetActiveConstraints(uint32 inStartConstraintIdx, uint32 inEndConstraintIdx, Constraint **outActiveConstraints, uint32 &outNumActiveConstraints) const
+void ConstraintManager::GetActiveConstraints(uint32 inStartConstraintIdx, uint32 inEndConstraintIdx, Constraint **outActiveConstraints, uint32 &outNumActiveConstraints, IslandBuilder &ioBuilder) const
 {
 	JPH_PROFILE_FUNCTION();
 
@@ -80,6 +80,13 @@ void ConstraintManager::GetActiveConstraints(uint32 inStartConstraintIdx, uint32
 		{
 			*(outActiveConstraints++) = c;
 			num_active_constraints++;
+			c->mWasActive = true;
+		}
+		else if (c->mWasActive)
+		{
+			// The bodies may have been linked by this constraint in the previous step
+			ioBuilder.RequestSplitIslands();
+			c->mWasActive = false;
 		}
 	}
 
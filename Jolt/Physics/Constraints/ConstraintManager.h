@@ -16,7 +16,7 @@ class DebugRenderer;
 #endif // JPH_DEBUG_RENDERER
 
 /// A list of constraints
-using Constraints = vector<Ref<Constraint>>;
+using Constraints = TaggedVector<Ref<Constraint>, EMemoryTag::Constraints>;
 
 /// A constraint manager manages all constraints of the same type
 class ConstraintManager : public NonCopyable
@@ -36,8 +36,9 @@ public:
 	/// Get total number of constraints
 	inline uint32			GetNumConstraints() const					{ return (uint32)mConstraints.size(); }
 
-	/// Determine the active constraints of a subset of the constraints
-	void					GetActiveConstraints(uint32 inStartConstraintIdx, uint32 inEndConstraintIdx, Constraint **outActiveConstraints, uint32 &outNumActiveConstraints) const;
+	/// Determine the active constraints of a subset of the constraints.
+	/// When a constraint that was active is no longer active (e.g. because it was disabled) the islands are split, since the bodies it connected may no longer be connected.
+	void					GetActiveConstraints(uint32 inStartConstraintIdx, uint32 inEndConstraintIdx, Constraint **outActiveConstraints, uint32 &outNumActiveConstraints, IslandBuilder &ioBuilder) const;
 
 	/// Link bodies to form islands
 	static void				sBuildIslands(Constraint **inActiveConstraints, uint32 inNumActiveConstraints, IslandBuilder &ioBuilder, BodyManager &inBodyManager);
@@ -267,6 +267,63 @@ public:
 		return ApplyVelocityStep<Type1, Type2>(ioMotionProperties1, ioMotionProperties2, inWorldSpaceAxis, lambda);
 	}
 
+	/// Solve the velocity constraint of a batch of constraint parts at the same time, lane i of VecN (Vec4 or Vec8) solves ioParts[i].
+	/// All parts must be between two dynamic bodies and a body can only be used by one lane.
+	/// Vectors are passed transposed, e.g. ioLinearVelocity1[0] contains the X component of the linear velocity of body 1 for all lanes.
+	/// @return True if any of the parts applied an impulse
+	template <class VecN>
+	static JPH_INLINE bool		sSolveVelocityConstraintBatch(AxisConstraintPart *const *ioParts, const VecN &inInvMass1, VecN *ioLinearVelocity1, VecN *ioAngularVelocity1, const VecN &inInvMass2, VecN *ioLinearVelocity2, VecN *ioAngularVelocity2, const VecN *inWorldSpaceAxis, const VecN &inMinLambda, const VecN &inMaxLambda)
+	{
+		constexpr uint cNumLanes = sizeof(VecN) / sizeof(float);
+
+		// Gather the constraint properties
+		VecN r1_plus_u_x_axis[3], r2_x_axis[3], invi1_r1_plus_u_x_axis[3], invi2_r2_x_axis[3], effective_mass, bias, total_lambda;
+		for (uint i = 0; i < cNumLanes; ++i)
+		{
+			const AxisConstraintPart &part = *ioParts[i];
+			for (int c = 0; c < 3; ++c)
+			{
+				r1_plus_u_x_axis[c][i] = part.mR1PlusUxAxis[c];
+				r2_x_axis[c][i] = part.mR2xAxis[c];
+				invi1_r1_plus_u_x_axis[c][i] = part.mInvI1_R1PlusUxAxis[c];
+				invi2_r2_x_axis[c][i] = part.mInvI2_R2xAxis[c];
+			}
+			effective_mass[i] = part.mEffectiveMass;
+			bias[i] = part.mSpringPart.GetBias(part.mTotalLambda);
+			total_lambda[i] = part.mTotalLambda;
+		}
+
+		// Calculate jacobian multiplied by velocity
+		VecN jv = VecN::sZero();
+		for (int c = 0; c < 3; ++c)
+			jv = jv + inWorldSpaceAxis[c] * (ioLinearVelocity1[c] - ioLinearVelocity2[c]) + r1_plus_u_x_axis[c] * ioAngularVelocity1[c] - r2_x_axis[c] * ioAngularVelocity2[c];
+
+		// Calculate and clamp the lagrange multiplier, see TemplatedSolveVelocityConstraint
+		VecN lambda = effective_mass * (jv - bias);
+		VecN new_lambda = VecN::sMin(VecN::sMax(total_lambda + lambda, inMinLambda), inMaxLambda);
+		lambda = new_lambda - total_lambda;
+
+		// Apply the impulse to the velocities
+		VecN lambda_inv_mass1 = lambda * inInvMass1;
+		VecN lambda_inv_mass2 = lambda * inInvMass2;
+		for (int c = 0; c < 3; ++c)
+		{
+			ioLinearVelocity1[c] = ioLinearVelocity1[c] - lambda_inv_mass1 * inWorldSpaceAxis[c];
+			ioAngularVelocity1[c] = ioAngularVelocity1[c] - lambda * invi1_r1_plus_u_x_axis[c];
+			ioLinearVelocity2[c] = ioLinearVelocity2[c] + lambda_inv_mass2 * inWorldSpaceAxis[c];
+			ioAngularVelocity2[c] = ioAngularVelocity2[c] + lambda * invi2_r2_x_axis[c];
+		}
+
+		// Store accumulated impulse
+		bool any_impulse_applied = false;
+		for (uint i = 0; i < cNumLanes; ++i)
+		{
+			ioParts[i]->mTotalLambda = new_lambda[i];
+			any_impulse_applied |= lambda[i] != 0.0f;
+		}
+		return any_impulse_applied;
+	}
+
 	/// Iteratively update the velocity constraint. Makes sure d/dt C(...) = 0, where C is the constraint equation.
 	/// @param ioBody1 The first body that this constraint is attached to
 	/// @param ioBody2 The second body that this constraint is attached to
@@ -9,6 +9,9 @@
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/IslandBuilder.h>
 #include <Jolt/Core/TempAllocator.h>
+#ifdef JPH_USE_AVX2
+	#include <Jolt/Math/Vec8.h>
+#endif
 #ifdef JPH_DEBUG_RENDERER
 	#include <Jolt/Renderer/DebugRenderer.h>
 #endif // JPH_DEBUG_RENDERER
@@ -213,9 +216,12 @@ void ContactConstraintManager::CachedBodyPair::RestoreState(StateRecorder &inStr
 
 void ContactConstraintManager::ManifoldCache::Init(uint inMaxBodyPairs, uint inMaxContactConstraints, uint inCachedManifoldsSize)
 {
-	mAllocator.Init(inMaxBodyPairs * sizeof(BodyPairMap::KeyValue) + inCachedManifoldsSize);
-	mCachedManifolds.Init(GetNextPowerOf2(inMaxContactConstraints));
-	mCachedBodyPairs.Init(GetNextPowerOf2(inMaxBodyPairs));
+	mAllocator.Init(inMaxBodyPairs * sizeof(BodyPairMap::KeyValue) + inCachedManifoldsSize, EMemoryTag::Contacts);
+	mCachedManifolds.Init(GetNextPowerOf2(inMaxContactConstraints), EMemoryTag::Contacts);
+	mCachedBodyPairs.Init(GetNextPowerOf2(inMaxBodyPairs), EMemoryTag::Contacts);
+
+	// Start with the minimal amount of buckets, the buckets will grow with the amount of contacts
+	Prepare(0, 0);
 }
 
 void ContactConstraintManager::ManifoldCache::Clear()
@@ -242,6 +248,18 @@ void ContactConstraintManager::ManifoldCache::Prepare(uint inExpectedNumBodyPair
 	mCachedBodyPairs.SetNumBuckets(min(max(cMinBuckets, GetNextPowerOf2(inExpectedNumBodyPairs)), mCachedBodyPairs.GetMaxBuckets()));
 }
 
+ContactConstraintManager::ContactCacheStats ContactConstraintManager::ManifoldCache::GetStats() const
+{
+	ContactCacheStats stats;
+	stats.mBodyPairs = mCachedBodyPairs.GetStats();
+	stats.mManifolds = mCachedManifolds.GetStats();
+	stats.mNumBytesUsed = mAllocator.GetNumBytesUsed();
+	stats.mNumBytesAllocated = mAllocator.GetNumBytesAllocated();
+	stats.mMaxBytes = mAllocator.GetMaxBytes();
+	stats.mNumFailedAllocations = mAllocator.GetNumFailedAllocations();
+	return stats;
+}
+
 const ContactConstraintManager::MKeyValue *ContactConstraintManager::ManifoldCache::Find(const SubShapeIDPair &inKey, size_t inKeyHash) const
 {
 	JPH_ASSERT(mIsFinalized);
@@ -302,7 +320,7 @@ ContactConstraintManager::BPKeyValue *ContactConstraintManager::ManifoldCache::C
 	return kv;
 }
 
-void ContactConstraintManager::ManifoldCache::GetAllBodyPairsSorted(vector<const BPKeyValue *> &outAll) const
+void ContactConstraintManager::ManifoldCache::GetAllBodyPairsSorted(TaggedVector<const BPKeyValue *, EMemoryTag::Contacts> &outAll) const
 {
 	JPH_ASSERT(mIsFinalized);
 	mCachedBodyPairs.GetAllKeyValues(outAll);
@@ -313,7 +331,7 @@ void ContactConstraintManager::ManifoldCache::GetAllBodyPairsSorted(vector<const
 	});
 }
 
-void ContactConstraintManager::ManifoldCache::GetAllManifoldsSorted(const CachedBodyPair &inBodyPair, vector<const MKeyValue *> &outAll) const
+void ContactConstraintManager::ManifoldCache::GetAllManifoldsSorted(const CachedBodyPair &inBodyPair, TaggedVector<const MKeyValue *, EMemoryTag::Contacts> &outAll) const
 {
 	JPH_ASSERT(mIsFinalized);
 
@@ -330,7 +348,7 @@ void ContactConstraintManager::ManifoldCache::GetAllManifoldsSorted(const Cached
 	});
 }
 
-void ContactConstraintManager::ManifoldCache::GetAllCCDManifoldsSorted(vector<const MKeyValue *> &outAll) const
+void ContactConstraintManager::ManifoldCache::GetAllCCDManifoldsSorted(TaggedVector<const MKeyValue *, EMemoryTag::Contacts> &outAll) const
 {
 	mCachedManifolds.GetAllKeyValues(outAll);
 
@@ -347,11 +365,20 @@ void ContactConstraintManager::ManifoldCache::GetAllCCDManifoldsSorted(vector<co
 	});
 }
 
-void ContactConstraintManager::ManifoldCache::ContactPointRemovedCallbacks(ContactListener *inListener)
+bool ContactConstraintManager::ManifoldCache::ContactPointRemovedCallbacks(ContactListener *inListener)
 {
+	bool links_removed = false;
 	for (MKeyValue &kv : mCachedManifolds)
-		if ((kv.GetValue().mFlags & uint16(CachedManifold::EFlags::ContactPersisted)) == 0)
-			inListener->OnContactRemoved(kv.GetKey());
+	{
+		uint16 flags = kv.GetValue().mFlags;
+		if ((flags & uint16(CachedManifold::EFlags::ContactPersisted)) == 0)
+		{
+			if (inListener != nullptr)
+				inListener->OnContactRemoved(kv.GetKey());
+			links_removed |= (flags & uint16(CachedManifold::EFlags::LinksBodies)) != 0;
+		}
+	}
+	return links_removed;
 }
 
 #ifdef JPH_ENABLE_ASSERTS
@@ -375,7 +402,7 @@ void ContactConstraintManager::ManifoldCache::SaveState(StateRecorder &inStream)
 	JPH_ASSERT(mIsFinalized);
 
 	// Get contents of cache
-	vector<const BPKeyValue *> all_bp;
+	TaggedVector<const BPKeyValue *, EMemoryTag::Contacts> all_bp;
 	GetAllBodyPairsSorted(all_bp);
 
 	// Write amount of body pairs
@@ -393,7 +420,7 @@ void ContactConstraintManager::ManifoldCache::SaveState(StateRecorder &inStream)
 		bp.SaveState(inStream);
 
 		// Get attached manifolds
-		vector<const MKeyValue *> all_m;
+		TaggedVector<const MKeyValue *, EMemoryTag::Contacts> all_m;
 		GetAllManifoldsSorted(bp, all_m);
 
 		// Write num manifolds
@@ -421,7 +448,7 @@ void ContactConstraintManager::ManifoldCache::SaveState(StateRecorder &inStream)
 	}
 
 	// Get CCD manifolds
-	vector<const MKeyValue *> all_m;
+	TaggedVector<const MKeyValue *, EMemoryTag::Contacts> all_m;
 	GetAllCCDManifoldsSorted(all_m);
 
 	// Write num CCD manifolds
@@ -443,7 +470,7 @@ bool ContactConstraintManager::ManifoldCache::RestoreState(const ManifoldCache &
 	ContactAllocator contact_allocator(GetContactAllocator());
 
 	// When validating, get all existing body pairs
-	vector<const BPKeyValue *> all_bp;
+	TaggedVector<const BPKeyValue *, EMemoryTag::Contacts> all_bp;
 	if (inStream.IsValidating())
 		inReadCache.GetAllBodyPairsSorted(all_bp);
 
@@ -479,7 +506,7 @@ bool ContactConstraintManager::ManifoldCache::RestoreState(const ManifoldCache &
 		bp.RestoreState(inStream);
 
 		// When validating, get all existing manifolds
-		vector<const MKeyValue *> all_m;
+		TaggedVector<const MKeyValue *, EMemoryTag::Contacts> all_m;
 		if (inStream.IsValidating())
 			inReadCache.GetAllManifoldsSorted(all_bp[i]->GetValue(), all_m);
 
@@ -531,7 +558,7 @@ bool ContactConstraintManager::ManifoldCache::RestoreState(const ManifoldCache &
 	}
 
 	// When validating, get all existing CCD manifolds
-	vector<const MKeyValue *> all_m;
+	TaggedVector<const MKeyValue *, EMemoryTag::Contacts> all_m;
 	if (inStream.IsValidating())
 		inReadCache.GetAllCCDManifoldsSorted(all_m);
 
@@ -767,6 +794,7 @@ void ContactConstraintManager::GetContactsFromCache(ContactAllocator &ioContactA
 			break; // Out of cache space
 		CachedManifold *output_cm = &output_kv->GetValue();
 		memcpy(output_cm, &input_cm, CachedManifold::sGetRequiredTotalSize(input_cm.mNumContactPoints));
+		output_cm->mFlags &= ~uint16(CachedManifold::EFlags::LinksBodies);
 
 		// Link the object under the body pairs
 		output_cm->mNextWithSameBodyPair = output_handle;
@@ -844,6 +872,8 @@ void ContactConstraintManager::GetContactsFromCache(ContactAllocator &ioContactA
 
 			// Notify island builder
 			mUpdateContext->mIslandBuilder->LinkContact(constraint_idx, body1->GetIndexInActiveBodiesInternal(), body2->GetIndexInActiveBodiesInternal());
+			if (body1->IsDynamic() && body2->IsDynamic())
+				output_cm->mFlags |= uint16(CachedManifold::EFlags::LinksBodies);
 
 		#ifdef JPH_DEBUG_RENDERER
 			// Draw the manifold
@@ -1023,6 +1053,8 @@ bool ContactConstraintManager::TemplatedAddContactConstraint(ContactAllocator &i
 
 		// Notify island builder
 		mUpdateContext->mIslandBuilder->LinkContact(constraint_idx, inBody1.GetIndexInActiveBodiesInternal(), inBody2.GetIndexInActiveBodiesInternal());
+		if (inBody1.IsDynamic() && inBody2.IsDynamic())
+			new_manifold->mFlags |= uint16(CachedManifold::EFlags::LinksBodies);
 
 		// Get time step
 		float delta_time = mUpdateContext->mSubStepDeltaTime;
@@ -1289,19 +1321,22 @@ void ContactConstraintManager::FinalizeContactCache(uint inExpectedNumBodyPairs,
 	mCache[mCacheWriteIdx].Prepare(inExpectedNumBodyPairs, inExpectedNumManifolds);
 }
 
-void ContactConstraintManager::ContactPointRemovedCallbacks()
+bool ContactConstraintManager::ContactPointRemovedCallbacks(bool inFindRemovedLinks)
 {
 	JPH_PROFILE_FUNCTION();
 
 	// Get the read cache
 	ManifoldCache &read_cache = mCache[mCacheWriteIdx ^ 1];
 
-	// Call the actual callbacks
-	if (mContactListener != nullptr)
-		read_cache.ContactPointRemovedCallbacks(mContactListener);
+	// Call the actual callbacks and find removed links
+	bool links_removed = false;
+	if (mContactListener != nullptr || inFindRemovedLinks)
+		links_removed = read_cache.ContactPointRemovedCallbacks(mContactListener);
 
 	// We're done with the cache now
 	read_cache.Clear();
+
+	return links_removed;
 }
 
 void ContactConstraintManager::SetupVelocityConstraints(const uint32 *inConstraintIdxBegin, const uint32 *inConstraintIdxEnd, float inDeltaTime)
@@ -1421,15 +1456,166 @@ JPH_INLINE bool ContactConstraintManager::sSolveVelocityConstraint(ContactConstr
 	return any_impulse_applied;
 }
 
+#ifdef JPH_USE_AVX2
+	using ContactBatchVec = Vec8;
+#else
+	using ContactBatchVec = Vec4;
+#endif
+
+/// Store a vector in lane inLane of a transposed vector
+static JPH_INLINE void sSetLane(ContactBatchVec *outV, uint inLane, Vec3Arg inValue)
+{
+	outV[0][inLane] = inValue.GetX();
+	outV[1][inLane] = inValue.GetY();
+	outV[2][inLane] = inValue.GetZ();
+}
+
+/// Get the vector in lane inLane of a transposed vector
+static JPH_INLINE Vec3 sGetLane(const ContactBatchVec *inV, uint inLane)
+{
+	return Vec3(inV[0][inLane], inV[1][inLane], inV[2][inLane]);
+}
+
+bool ContactConstraintManager::CanSolveVelocityConstraintsAsBatch(const uint32 *inConstraintIdxBegin) const
+{
+	const Body *bodies[2 * cBatchSize];
+	uint num_contact_points = mConstraints[*inConstraintIdxBegin].mContactPoints.size();
+
+	for (uint i = 0; i < cBatchSize; ++i)
+	{
+		const ContactConstraint &constraint = mConstraints[inConstraintIdxBegin[i]];
+
+		// Only constraints between two dynamic bodies with the same amount of contact points can be batched
+		const Body *body1 = constraint.mBody1;
+		const Body *body2 = constraint.mBody2;
+		if (!body1->IsDynamic() || !body2->IsDynamic() || constraint.mContactPoints.size() != num_contact_points)
+			return false;
+
+		// All lanes need to solve friction
+		for (const WorldContactPoint &wcp : constraint.mContactPoints)
+			if (!wcp.mFrictionConstraint1.IsActive())
+				return false;
+
+		// A body can only be modified by a single lane, this also ensures that the result is the same as solving the constraints one by one
+		for (uint j = 0; j < 2 * i; ++j)
+			if (bodies[j] == body1 || bodies[j] == body2)
+				return false;
+		bodies[2 * i] = body1;
+		bodies[2 * i + 1] = body2;
+	}
+
+	return true;
+}
+
+bool ContactConstraintManager::SolveVelocityConstraintsBatch(const uint32 *inConstraintIdxBegin)
+{
+	static_assert(sizeof(ContactBatchVec) / sizeof(float) == cBatchSize, "Each lane solves one contact constraint");
+	JPH_ASSERT(CanSolveVelocityConstraintsAsBatch(inConstraintIdxBegin));
+
+	// Gather the velocities of the bodies and the constraint axis, each lane solves one contact constraint
+	ContactConstraint *constraints[cBatchSize];
+	MotionProperties *motion_properties1[cBatchSize], *motion_properties2[cBatchSize];
+	ContactBatchVec inv_mass1, inv_mass2, combined_friction;
+	ContactBatchVec linear_velocity1[3], angular_velocity1[3], linear_velocity2[3], angular_velocity2[3];
+	ContactBatchVec normal[3], tangent1[3], tangent2[3];
+	for (uint i = 0; i < cBatchSize; ++i)
+	{
+		ContactConstraint &constraint = mConstraints[inConstraintIdxBegin[i]];
+		constraints[i] = &constraint;
+
+		MotionProperties *mp1 = constraint.mBody1->GetMotionPropertiesUnchecked();
+		motion_properties1[i] = mp1;
+		inv_mass1[i] = mp1->GetInverseMass();
+		sSetLane(linear_velocity1, i, mp1->GetLinearVelocity());
+		sSetLane(angular_velocity1, i, mp1->GetAngularVelocity());
+
+		MotionProperties *mp2 = constraint.mBody2->GetMotionPropertiesUnchecked();
+		motion_properties2[i] = mp2;
+		inv_mass2[i] = mp2->GetInverseMass();
+		sSetLane(linear_velocity2, i, mp2->GetLinearVelocity());
+		sSetLane(angular_velocity2, i, mp2->GetAngularVelocity());
+
+		Vec3 t1, t2;
+		constraint.GetTangents(t1, t2);
+		sSetLane(normal, i, constraint.mWorldSpaceNormal);
+		sSetLane(tangent1, i, t1);
+		sSetLane(tangent2, i, t2);
+		combined_friction[i] = constraint.mCombinedFriction;
+	}
+
+	bool any_impulse_applied = false;
+	AxisConstraintPart *parts[cBatchSize];
+	uint num_contact_points = constraints[0]->mContactPoints.size();
+
+	// First apply all friction constraints (non-penetration is more important than friction), see sSolveVelocityConstraint
+	for (uint p = 0; p < num_contact_points; ++p)
+	{
+		// Calculate max impulse that can be applied using the non-penetration impulse from the previous iteration
+		ContactBatchVec non_penetration_lambda;
+		for (uint i = 0; i < cBatchSize; ++i)
+			non_penetration_lambda[i] = constraints[i]->mContactPoints[p].mNonPenetrationConstraint.GetTotalLambda();
+		ContactBatchVec max_lambda_f = combined_friction * non_penetration_lambda;
+		ContactBatchVec min_lambda_f = ContactBatchVec::sZero() - max_lambda_f;
+
+		// Solve friction velocities
+		for (uint i = 0; i < cBatchSize; ++i)
+			parts[i] = &constraints[i]->mContactPoints[p].mFrictionConstraint1;
+		if (AxisConstraintPart::sSolveVelocityConstraintBatch(parts, inv_mass1, linear_velocity1, angular_velocity1, inv_mass2, linear_velocity2, angular_velocity2, tangent1, min_lambda_f, max_lambda_f))
+			any_impulse_applied = true;
+		for (uint i = 0; i < cBatchSize; ++i)
+			parts[i] = &constraints[i]->mContactPoints[p].mFrictionConstraint2;
+		if (AxisConstraintPart::sSolveVelocityConstraintBatch(parts, inv_mass1, linear_velocity1, angular_velocity1, inv_mass2, linear_velocity2, angular_velocity2, tangent2, min_lambda_f, max_lambda_f))
+			any_impulse_applied = true;
+	}
+
+	// Then apply all non-penetration constraints
+	ContactBatchVec min_lambda_n = ContactBatchVec::sZero();
+	ContactBatchVec max_lambda_n = ContactBatchVec::sReplicate(FLT_MAX);
+	for (uint p = 0; p < num_contact_points; ++p)
+	{
+		for (uint i = 0; i < cBatchSize; ++i)
+			parts[i] = &constraints[i]->mContactPoints[p].mNonPenetrationConstraint;
+		if (AxisConstraintPart::sSolveVelocityConstraintBatch(parts, inv_mass1, linear_velocity1, angular_velocity1, inv_mass2, linear_velocity2, angular_velocity2, normal, min_lambda_n, max_lambda_n))
+			any_impulse_applied = true;
+	}
+
+	// Scatter the velocity changes back to the bodies
+	if (any_impulse_applied)
+		for (uint i = 0; i < cBatchSize; ++i)
+		{
+			MotionProperties *mp1 = motion_properties1[i];
+			mp1->AddLinearVelocityStep(sGetLane(linear_velocity1, i) - mp1->GetLinearVelocity());
+			mp1->AddAngularVelocityStep(sGetLane(angular_velocity1, i) - mp1->GetAngularVelocity());
+
+			MotionProperties *mp2 = motion_properties2[i];
+			mp2->AddLinearVelocityStep(sGetLane(linear_velocity2, i) - mp2->GetLinearVelocity());
+			mp2->AddAngularVelocityStep(sGetLane(angular_velocity2, i) - mp2->GetAngularVelocity());
+		}
+
+	return any_impulse_applied;
+}
+
 bool ContactConstraintManager::SolveVelocityConstraints(const uint32 *inConstraintIdxBegin, const uint32 *inConstraintIdxEnd)
 {
 	JPH_PROFILE_FUNCTION();
 
 	bool any_impulse_applied = false;
 
-	for (const uint32 *constraint_idx = inConstraintIdxBegin; constraint_idx < inConstraintIdxEnd; ++constraint_idx)
+	bool use_batches = mPhysicsSettings.mUseBatchedContactSolver;
+
+	for (const uint32 *constraint_idx = inConstraintIdxBegin; constraint_idx < inConstraintIdxEnd; )
 	{
-		ContactConstraint &constraint = mConstraints[*constraint_idx];
+		// Solve multiple constraints at the same time if they don't share any bodies
+		if (use_batches
+			&& inConstraintIdxEnd - constraint_idx >= cBatchSize
+			&& CanSolveVelocityConstraintsAsBatch(constraint_idx))
+		{
+			any_impulse_applied |= SolveVelocityConstraintsBatch(constraint_idx);
+			constraint_idx += cBatchSize;
+			continue;
+		}
+
+		ContactConstraint &constraint = mConstraints[*constraint_idx++];
 
 		// Fetch bodies
 		Body &body1 = *constraint.mBody1;
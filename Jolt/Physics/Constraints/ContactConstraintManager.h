@@ -142,11 +142,30 @@ public:
 	void						FinalizeContactCache(uint inExpectedNumBodyPairs, uint inExpectedNumManifolds);
 
 	/// Notifies the listener of any contact points that were removed. Needs to be callsed after FinalizeContactCache().
-	void						ContactPointRemovedCallbacks();
+	/// When inFindRemovedLinks is true, this returns if one of the removed contacts linked two dynamic bodies in the island builder.
+	bool						ContactPointRemovedCallbacks(bool inFindRemovedLinks);
+
+	/// Statistics of the contact cache
+	struct ContactCacheStats
+	{
+		LockFreeHashMapStats	mBodyPairs;									///< Stats of the body pair hash map
+		LockFreeHashMapStats	mManifolds;									///< Stats of the manifold hash map
+		uint32					mNumBytesUsed = 0;							///< Amount of bytes used to store body pairs and manifolds
+		uint32					mNumBytesAllocated = 0;						///< Amount of bytes allocated to store body pairs and manifolds
+		uint32					mMaxBytes = 0;								///< Max amount of bytes that can be used to store body pairs and manifolds
+		uint32					mNumFailedAllocations = 0;					///< Amount of body pairs / manifolds that could not be stored because the cache was full
+	};
+
+	/// Get stats about the contact cache of the last simulation step (slow, iterates through all cached body pairs and manifolds).
+	/// Should not be called while the simulation is running.
+	ContactCacheStats			GetContactCacheStats() const										{ return mCache[mCacheWriteIdx ^ 1].GetStats(); }
 
 	/// Get the number of contact constraints that were found
 	uint32						GetNumConstraints() const											{ return min<uint32>(mNumConstraints, mMaxConstraints); }
 
+	/// Get the bodies that are affected by a contact constraint
+	void						GetAffectedBodies(uint32 inConstraintIdx, const Body *&outBody1, const Body *&outBody2) const { const ContactConstraint &constraint = mConstraints[inConstraintIdx]; outBody1 = constraint.mBody1; outBody2 = constraint.mBody2; }
+
 	/// Sort contact constraints deterministically
 	void						SortContacts(uint32 *inConstraintIdxBegin, uint32 *inConstraintIdxEnd) const;
 
@@ -284,7 +303,8 @@ private:
 		enum class EFlags : uint16
 		{
 			ContactPersisted	= 1,																///< If this cache entry was reused in the next simulation update
-			CCDContact			= 2																	///< This is a cached manifold reported by continuous collision detection and was only used to create a contact callback
+			CCDContact			= 2,																///< This is a cached manifold reported by continuous collision detection and was only used to create a contact callback
+			LinksBodies			= 4																	///< The contact constraint of this manifold linked two dynamic bodies in the island builder
 		};
 
 		/// @see EFlags
@@ -359,10 +379,14 @@ private:
 		/// Find / create entry for BodyPair -> CachedBodyPair
 		const BPKeyValue *		Find(const BodyPair &inKey, size_t inKeyHash) const;
 		BPKeyValue *			Create(ContactAllocator &ioContactAllocator, const BodyPair &inKey, size_t inKeyHash);
-		void					GetAllBodyPairsSorted(vector<const BPKeyValue *> &outAll) const;
-		void					GetAllManifoldsSorted(const CachedBodyPair &inBodyPair, vector<const MKeyValue *> &outAll) const;
-		void					GetAllCCDManifoldsSorted(vector<const MKeyValue *> &outAll) const;
-		void					ContactPointRemovedCallbacks(ContactListener *inListener);
+		void					GetAllBodyPairsSorted(TaggedVector<const BPKeyValue *, EMemoryTag::Contacts> &outAll) const;
+		void					GetAllManifoldsSorted(const CachedBodyPair &inBodyPair, TaggedVector<const MKeyValue *, EMemoryTag::Contacts> &outAll) const;
+		void					GetAllCCDManifoldsSorted(TaggedVector<const MKeyValue *, EMemoryTag::Contacts> &outAll) const;
+		/// Returns if one of the removed contacts linked two dynamic bodies, inListener can be null
+		bool					ContactPointRemovedCallbacks(ContactListener *inListener);
+
+		/// Get stats about the hash maps and storage of this cache
+		ContactCacheStats		GetStats() const;
 
 #ifdef JPH_ENABLE_ASSERTS
 		/// Get the amount of manifolds in the cache
@@ -464,6 +488,19 @@ private:
 	template <EMotionType Type1, EMotionType Type2>
 	JPH_INLINE static bool		sSolveVelocityConstraint(ContactConstraint &ioConstraint, MotionProperties *ioMotionProperties1, MotionProperties *ioMotionProperties2);
 
+	/// Number of contact constraints that are solved at the same time by SolveVelocityConstraintsBatch (one per SIMD lane)
+#ifdef JPH_USE_AVX2
+	static constexpr uint		cBatchSize = 8;
+#else
+	static constexpr uint		cBatchSize = 4;
+#endif
+
+	/// Check if the cBatchSize contact constraints starting at inConstraintIdxBegin can be solved as a batch
+	bool						CanSolveVelocityConstraintsAsBatch(const uint32 *inConstraintIdxBegin) const;
+
+	/// Solve cBatchSize contact constraints at the same time, CanSolveVelocityConstraintsAsBatch must have returned true for them
+	bool						SolveVelocityConstraintsBatch(const uint32 *inConstraintIdxBegin);
+
 	/// The main physics settings instance
 	const PhysicsSettings &		mPhysicsSettings;
 
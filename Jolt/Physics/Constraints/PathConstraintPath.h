@@ -19,6 +19,8 @@ class DebugRenderer;
 class PathConstraintPath : public SerializableObject, public RefTarget<PathConstraintPath>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	JPH_DECLARE_SERIALIZABLE_ABSTRACT(PathConstraintPath)
 
 	using PathResult = Result<Ref<PathConstraintPath>>;
@@ -50,6 +50,9 @@ public:
 	/// Link bodies that are connected by this constraint in the island builder
 	virtual void				BuildIslands(uint32 inConstraintIndex, IslandBuilder &ioBuilder, BodyManager &inBodyManager) override;
 
+	/// Assign the two bodies to a split of a large island
+	virtual uint				BuildIslandSplits(LargeIslandSplitter &ioSplitter) const override;
+
 protected:
 	/// The two bodies involved
 	Body *						mBody1;
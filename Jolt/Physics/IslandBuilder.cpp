@@ -10,6 +10,10 @@
 #include <Jolt/Core/Atomics.h>
 #include <Jolt/Core/TempAllocator.h>
 
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
 JPH_NAMESPACE_BEGIN
 
 IslandBuilder::~IslandBuilder()
@@ -23,8 +27,11 @@ IslandBuilder::~IslandBuilder()
 	JPH_ASSERT(mContactIslands == nullptr);
 	JPH_ASSERT(mContactIslandEnds == nullptr);
 	JPH_ASSERT(mIslandsSorted == nullptr);
+	JPH_ASSERT(mIslandCounters == nullptr);
+	JPH_ASSERT(mBatchSums == nullptr);
 
-	delete [] mBodyLinks;
+	Free(mBodyLinks, mMaxActiveBodies * sizeof(BodyLink), EMemoryTag::Bodies);
+	Free(mLinkedBodies, mMaxActiveBodies * sizeof(BodyID), EMemoryTag::Bodies);
 }
 
 void IslandBuilder::Init(uint32 inMaxActiveBodies)
@@ -33,9 +40,40 @@ void IslandBuilder::Init(uint32 inMaxActiveBodies)
 
 	// Link each body to itself, BuildBodyIslands() will restore this so that we don't need to do this each step
 	JPH_ASSERT(mBodyLinks == nullptr);
-	mBodyLinks = new BodyLink [mMaxActiveBodies];
+	mBodyLinks = static_cast<BodyLink *>(Allocate(mMaxActiveBodies * sizeof(BodyLink), EMemoryTag::Bodies));
 	for (uint32 i = 0; i < mMaxActiveBodies; ++i)
-		mBodyLinks[i].mLinkedTo.store(i, memory_order_relaxed);
+		new (&mBodyLinks[i].mLinkedTo) atomic<uint32>(i);
+
+	JPH_ASSERT(mLinkedBodies == nullptr);
+	mLinkedBodies = static_cast<BodyID *>(Allocate(mMaxActiveBodies * sizeof(BodyID), EMemoryTag::Bodies));
+}
+
+void IslandBuilder::PrepareBodyLinks(const BodyID *inActiveBodies, uint32 inNumActiveBodies, bool inUsePersistentLinks)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Need to call Init first
+	JPH_ASSERT(mBodyLinks != nullptr);
+
+	// Check that the builder has been reset
+	JPH_ASSERT(mNumIslands == 0);
+
+	// The links are stored by index in the active bodies list. Bodies that are activated are added at the end of the list so they don't
+	// invalidate the links, but when a body is deactivated another body takes its place and we need to start over.
+	bool split_requested = mSplitIslandsRequested.exchange(false, memory_order_relaxed);
+	if (mNumLinkedBodies > 0
+		&& (!inUsePersistentLinks
+			|| split_requested
+			|| inNumActiveBodies < mNumLinkedBodies
+			|| memcmp(inActiveBodies, mLinkedBodies, mNumLinkedBodies * sizeof(BodyID)) != 0))
+	{
+		for (uint32 i = 0; i < mNumLinkedBodies; ++i)
+			mBodyLinks[i].mLinkedTo.store(i, memory_order_relaxed);
+		mNumLinkedBodies = 0;
+	}
+
+	mKeepLinks = inUsePersistentLinks;
+	mIslandsIncludePreviousLinks = mNumLinkedBodies > 0;
 }
 
 void IslandBuilder::PrepareContactConstraints(uint32 inMaxContacts, TempAllocator *inTempAllocator)
@@ -203,125 +241,6 @@ void IslandBuilder::ValidateIslands(uint32 inNumActiveBodies) const
 
 #endif
 
-void IslandBuilder::BuildBodyIslands(const BodyID *inActiveBodies, uint32 inNumActiveBodies, TempAllocator *inTempAllocator)
-{
-	JPH_PROFILE_FUNCTION();
-
-	// Store the amount of active bodies
-	mNumActiveBodies = inNumActiveBodies;
-
-	// Create output arrays for body ID's, don't call constructors
-	JPH_ASSERT(mBodyIslands == nullptr);
-	mBodyIslands = (BodyID *)inTempAllocator->Allocate(inNumActiveBodies * sizeof(BodyID));
-
-	// Create output array for start index of each island. At this point we don't know how many islands there will be, but we know it cannot be more than inNumActiveBodies.
-	// Note: We allocate 1 extra entry because we always increment the count of the next island.
-	uint32 *body_island_starts = (uint32 *)inTempAllocator->Allocate((inNumActiveBodies + 1) * sizeof(uint32));
-
-	// First island always starts at 0
-	body_island_starts[0] = 0;
-
-	// Calculate island index for all bodies
-	JPH_ASSERT(mNumIslands == 0);
-	for (uint32 i = 0; i < inNumActiveBodies; ++i)
-	{
-		BodyLink &link = mBodyLinks[i];
-		uint32 s = link.mLinkedTo.load(memory_order_relaxed);
-		if (s != i)
-		{
-			// Links to another body, take island index from other body (this must have been filled in already since we're looping from low to high)
-			JPH_ASSERT(s < uint32(i));
-			uint32 island_index = mBodyLinks[s].mIslandIndex;
-			link.mIslandIndex = island_index;
-
-			// Increment the start of the next island
-			body_island_starts[island_index + 1]++;
-		}
-		else
-		{
-			// Does not link to other body, this is the start of a new island
-			link.mIslandIndex = mNumIslands;
-			++mNumIslands;
-
-			// Set the start of the next island to 1
-			body_island_starts[mNumIslands] = 1;
-		}
-	}
-
-#ifdef JPH_VALIDATE_ISLAND_BUILDER
-	ValidateIslands(inNumActiveBodies);
-#endif
-
-	// Make the start array absolute (so far we only counted)
-	for (uint32 island = 1; island < mNumIslands; ++island)
-		body_island_starts[island] += body_island_starts[island - 1];
-
-	// Convert the to a linear list grouped by island
-	for (uint32 i = 0; i < inNumActiveBodies; ++i)
-	{
-		BodyLink &link = mBodyLinks[i];
-
-		// Copy the body to the correct location in the array and increment it
-		uint32 &start = body_island_starts[link.mIslandIndex];
-		mBodyIslands[start] = inActiveBodies[i];
-		start++;
-
-		// Reset linked to field for the next update
-		link.mLinkedTo.store(i, memory_order_relaxed);
-	}
-
-	// We should now have a full array
-	JPH_ASSERT(mNumIslands == 0 || body_island_starts[mNumIslands - 1] == inNumActiveBodies);
-
-	// We've incremented all body indices so that they now point at the end instead of the starts
-	JPH_ASSERT(mBodyIslandEnds == nullptr);
-	mBodyIslandEnds = body_island_starts;
-}
-
-void IslandBuilder::BuildConstraintIslands(const uint32 *inConstraintToBody, uint32 inNumConstraints, uint32 *&outConstraints, uint32 *&outConstraintsEnd, TempAllocator *inTempAllocator) const
-{
-	JPH_PROFILE_FUNCTION();
-
-	// Check if there's anything to do
-	if (inNumConstraints == 0)
-		return;
-
-	// Create output arrays for constraints
-	// Note: For the end indices we allocate 1 extra entry so we don't have to do an if in the inner loop
-	uint32 *constraints = (uint32 *)inTempAllocator->Allocate(inNumConstraints * sizeof(uint32));
-	uint32 *constraint_ends = (uint32 *)inTempAllocator->Allocate((mNumIslands + 1) * sizeof(uint32));
-
-	// Reset sizes
-	for (uint32 island = 0; island < mNumIslands; ++island)
-		constraint_ends[island] = 0;
-
-	// Loop over array and increment start relative position for the next island
-	for (uint32 constraint = 0; constraint < inNumConstraints; ++constraint)
-	{
-		uint32 body_idx = inConstraintToBody[constraint];
-		uint32 next_island_idx = mBodyLinks[body_idx].mIslandIndex + 1;
-		JPH_ASSERT(next_island_idx <= mNumIslands);
-		constraint_ends[next_island_idx]++;
-	}
-
-	// Make start positions absolute
-	for (uint32 island = 1; island < mNumIslands; ++island)
-		constraint_ends[island] += constraint_ends[island - 1];
-
-	// Loop over array and collect constraints
-	for (uint32 constraint = 0; constraint < inNumConstraints; ++constraint)
-	{
-		uint32 body_idx = inConstraintToBody[constraint];
-		uint32 island_idx = mBodyLinks[body_idx].mIslandIndex;
-		constraints[constraint_ends[island_idx]++] = constraint;
-	}
-
-	JPH_ASSERT(outConstraints == nullptr);
-	outConstraints = constraints;
-	JPH_ASSERT(outConstraintsEnd == nullptr);
-	outConstraintsEnd = constraint_ends;
-}
-
 void IslandBuilder::SortIslands(TempAllocator *inTempAllocator)
 {
 	JPH_PROFILE_FUNCTION();
@@ -368,16 +287,441 @@ void IslandBuilder::SortIslands(TempAllocator *inTempAllocator)
 	}
 }
 
-void IslandBuilder::Finalize(const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator)
+uint32 IslandBuilder::GetNumFinalizeBatches(EFinalizePhase inPhase) const
+{
+	auto num_batches = [](uint32 inNumItems) { return (inNumItems + cFinalizeBatchSize - 1) / cFinalizeBatchSize; };
+
+	switch (inPhase)
+	{
+	case EFinalizePhase::Allocate:
+		return 1;
+
+	case EFinalizePhase::FindRoots:
+	case EFinalizePhase::NumberIslands:
+		return num_batches(mNumActiveBodies);
+
+	case EFinalizePhase::CountIslandSizes:
+	case EFinalizePhase::Scatter:
+		return num_batches(mNumActiveBodies) + num_batches(mNumConstraints) + num_batches(mNumContacts);
+
+	case EFinalizePhase::SumIslandSizes:
+	case EFinalizePhase::CalculateIslandStarts:
+	case EFinalizePhase::OrderBodies:
+		return num_batches(mNumIslands);
+
+	case EFinalizePhase::Done:
+	default:
+		JPH_ASSERT(false);
+		return 0;
+	}
+}
+
+void IslandBuilder::ProcessFinalizeBatch(EFinalizePhase inPhase, uint32 inBatch, const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator)
+{
+	// Determine which items this batch covers. In the CountIslandSizes and Scatter phases the batches for bodies are followed by the batches for constraints and then contacts.
+	uint32 num_body_batches = (mNumActiveBodies + cFinalizeBatchSize - 1) / cFinalizeBatchSize;
+	uint32 num_constraint_batches = (mNumConstraints + cFinalizeBatchSize - 1) / cFinalizeBatchSize;
+	uint32 begin = inBatch * cFinalizeBatchSize;
+	uint32 end = begin + cFinalizeBatchSize;
+
+	switch (inPhase)
+	{
+	case EFinalizePhase::Allocate:
+		{
+			JPH_PROFILE("Allocate");
+
+			// Store the amount of active bodies and contacts
+			mNumActiveBodies = inNumActiveBodies;
+			mNumContacts = inNumContacts;
+
+			// Create output arrays, don't call constructors.
+			// At this point we don't know how many islands there will be, but we know it cannot be more than the number of active bodies.
+			JPH_ASSERT(mBodyIslands == nullptr);
+			mBodyIslands = (BodyID *)inTempAllocator->Allocate(mNumActiveBodies * sizeof(BodyID));
+			mBodyIslandEnds = (uint32 *)inTempAllocator->Allocate(mNumActiveBodies * sizeof(uint32));
+			if (mNumConstraints > 0)
+			{
+				mConstraintIslands = (uint32 *)inTempAllocator->Allocate(mNumConstraints * sizeof(uint32));
+				mConstraintIslandEnds = (uint32 *)inTempAllocator->Allocate(mNumActiveBodies * sizeof(uint32));
+			}
+			if (mNumContacts > 0)
+			{
+				mContactIslands = (uint32 *)inTempAllocator->Allocate(mNumContacts * sizeof(uint32));
+				mContactIslandEnds = (uint32 *)inTempAllocator->Allocate(mNumActiveBodies * sizeof(uint32));
+			}
+
+			// Create scratch arrays, these are freed when the islands are done
+			mIslandCounters = (atomic<uint32> *)inTempAllocator->Allocate(3 * mNumActiveBodies * sizeof(atomic<uint32>));
+			mBatchSums = (uint32 *)inTempAllocator->Allocate(3 * ((mNumActiveBodies + cFinalizeBatchSize - 1) / cFinalizeBatchSize) * sizeof(uint32));
+			break;
+		}
+
+	case EFinalizePhase::FindRoots:
+		{
+			JPH_PROFILE("FindRoots");
+
+			end = min(end, mNumActiveBodies);
+			uint32 num_islands = 0;
+			for (uint32 i = begin; i < end; ++i)
+			{
+				// Point directly to the lowest body so that the next phases don't need to follow the chain
+				uint32 lowest = GetLowestBodyIndex(i);
+				mBodyLinks[i].mLinkedTo.store(lowest, memory_order_relaxed);
+
+				// Bodies that link to themselves start a new island
+				if (lowest == i)
+					++num_islands;
+
+				// Reset the island counters, there can't be more islands than bodies
+				for (uint32 c = 0; c < 3; ++c)
+					new (&mIslandCounters[c * mNumActiveBodies + i]) atomic<uint32>(0);
+			}
+			mBatchSums[inBatch] = num_islands;
+			break;
+		}
+
+	case EFinalizePhase::NumberIslands:
+		{
+			JPH_PROFILE("NumberIslands");
+
+			// Islands are numbered in order of their lowest body so that the island indices don't depend on the amount of jobs
+			end = min(end, mNumActiveBodies);
+			uint32 island_index = mBatchSums[inBatch];
+			for (uint32 i = begin; i < end; ++i)
+			{
+				BodyLink &link = mBodyLinks[i];
+				if (link.mLinkedTo.load(memory_order_relaxed) == i)
+					link.mIslandIndex = island_index++;
+			}
+			break;
+		}
+
+	case EFinalizePhase::CountIslandSizes:
+		{
+			JPH_PROFILE("CountIslandSizes");
+
+			// Select the items to count, we only have the lowest body of every island available since other jobs are updating the other bodies
+			const uint32 *links;
+			uint32 counter_offset;
+			if (inBatch < num_body_batches)
+			{
+				end = min(end, mNumActiveBodies);
+				links = nullptr;
+				counter_offset = 0;
+			}
+			else if (inBatch < num_body_batches + num_constraint_batches)
+			{
+				begin -= num_body_batches * cFinalizeBatchSize;
+				end = min(end - num_body_batches * cFinalizeBatchSize, mNumConstraints);
+				links = mConstraintLinks;
+				counter_offset = mNumActiveBodies;
+			}
+			else
+			{
+				begin -= (num_body_batches + num_constraint_batches) * cFinalizeBatchSize;
+				end = min(end - (num_body_batches + num_constraint_batches) * cFinalizeBatchSize, mNumContacts);
+				links = mContactLinks;
+				counter_offset = 2 * mNumActiveBodies;
+			}
+
+			// Count consecutive items that are in the same island at once, this avoids contention on the counters of large islands
+			uint32 run_island = 0, run_length = 0;
+			for (uint32 i = begin; i < end; ++i)
+			{
+				uint32 island_index;
+				if (links == nullptr)
+				{
+					BodyLink &link = mBodyLinks[i];
+					uint32 lowest = link.mLinkedTo.load(memory_order_relaxed);
+					if (lowest != i)
+						link.mIslandIndex = mBodyLinks[lowest].mIslandIndex;
+					island_index = mBodyLinks[lowest].mIslandIndex;
+				}
+				else
+					island_index = mBodyLinks[mBodyLinks[links[i]].mLinkedTo.load(memory_order_relaxed)].mIslandIndex;
+
+				if (island_index != run_island)
+				{
+					if (run_length > 0)
+						mIslandCounters[counter_offset + run_island].fetch_add(run_length, memory_order_relaxed);
+					run_island = island_index;
+					run_length = 0;
+				}
+				++run_length;
+			}
+			if (run_length > 0)
+				mIslandCounters[counter_offset + run_island].fetch_add(run_length, memory_order_relaxed);
+			break;
+		}
+
+	case EFinalizePhase::SumIslandSizes:
+		{
+			JPH_PROFILE("SumIslandSizes");
+
+			end = min(end, mNumIslands);
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				const atomic<uint32> *counters = mIslandCounters + c * mNumActiveBodies;
+				uint32 sum = 0;
+				for (uint32 island = begin; island < end; ++island)
+					sum += counters[island].load(memory_order_relaxed);
+				mBatchSums[3 * inBatch + c] = sum;
+			}
+			break;
+		}
+
+	case EFinalizePhase::CalculateIslandStarts:
+		{
+			JPH_PROFILE("CalculateIslandStarts");
+
+			end = min(end, mNumIslands);
+			uint32 *island_ends[] = { mBodyIslandEnds, mConstraintIslandEnds, mContactIslandEnds };
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				uint32 *ends = island_ends[c];
+				if (ends == nullptr)
+					continue;
+
+				// Turn the count into the start of the island (which is used as write position in the scatter phase) and store the end
+				atomic<uint32> *counters = mIslandCounters + c * mNumActiveBodies;
+				uint32 start = mBatchSums[3 * inBatch + c];
+				for (uint32 island = begin; island < end; ++island)
+				{
+					uint32 count = counters[island].load(memory_order_relaxed);
+					counters[island].store(start, memory_order_relaxed);
+					start += count;
+					ends[island] = start;
+				}
+			}
+			break;
+		}
+
+	case EFinalizePhase::Scatter:
+		{
+			JPH_PROFILE("Scatter");
+
+			// Select the items to copy
+			const uint32 *links;
+			uint32 *output;
+			uint32 counter_offset;
+			if (inBatch < num_body_batches)
+			{
+				end = min(end, mNumActiveBodies);
+				links = nullptr;
+				output = reinterpret_cast<uint32 *>(mBodyIslands); // Bodies are written as index in the active bodies list, the OrderBodies phase converts them to body IDs
+				counter_offset = 0;
+			}
+			else if (inBatch < num_body_batches + num_constraint_batches)
+			{
+				begin -= num_body_batches * cFinalizeBatchSize;
+				end = min(end - num_body_batches * cFinalizeBatchSize, mNumConstraints);
+				links = mConstraintLinks;
+				output = mConstraintIslands;
+				counter_offset = mNumActiveBodies;
+			}
+			else
+			{
+				begin -= (num_body_batches + num_constraint_batches) * cFinalizeBatchSize;
+				end = min(end - (num_body_batches + num_constraint_batches) * cFinalizeBatchSize, mNumContacts);
+				links = mContactLinks;
+				output = mContactIslands;
+				counter_offset = 2 * mNumActiveBodies;
+			}
+
+			// Copy consecutive items that are in the same island at once, this avoids contention on the write positions of large islands.
+			// Note that the order of the items within an island depends on the order in which the batches are processed.
+			uint32 run_island = 0, run_begin = begin;
+			auto flush_run = [this, output, counter_offset, &run_island, &run_begin](uint32 inRunEnd)
+			{
+				if (run_begin == inRunEnd)
+					return;
+				uint32 write_idx = mIslandCounters[counter_offset + run_island].fetch_add(inRunEnd - run_begin, memory_order_relaxed);
+				for (uint32 i = run_begin; i < inRunEnd; ++i)
+					output[write_idx++] = i;
+			};
+
+			for (uint32 i = begin; i < end; ++i)
+			{
+				uint32 island_index = mBodyLinks[links != nullptr? links[i] : i].mIslandIndex;
+				if (island_index != run_island)
+				{
+					flush_run(i);
+					run_island = island_index;
+					run_begin = i;
+				}
+			}
+			flush_run(end);
+
+			if (links == nullptr)
+			{
+				if (mKeepLinks)
+				{
+					// Remember which bodies the links belong to so we can check if they're still valid in the next update
+					memcpy(mLinkedBodies + begin, inActiveBodies + begin, (end - begin) * sizeof(BodyID));
+				}
+				else
+				{
+					// Reset linked to field for the next update
+					for (uint32 i = begin; i < end; ++i)
+						mBodyLinks[i].mLinkedTo.store(i, memory_order_relaxed);
+				}
+			}
+			break;
+		}
+
+	case EFinalizePhase::OrderBodies:
+		{
+			JPH_PROFILE("OrderBodies");
+
+			// Sort the bodies of every island by body ID. This makes the order independent of the amount of jobs and of the order of the active bodies list,
+			// which is not deterministic because islands are deactivated in parallel (constraints and contacts are sorted later by their users)
+			end = min(end, mNumIslands);
+			static_assert(sizeof(BodyID) == sizeof(uint32), "The Scatter phase stores the active body indices in mBodyIslands");
+			uint32 *indices = reinterpret_cast<uint32 *>(mBodyIslands);
+			for (uint32 island = begin; island < end; ++island)
+			{
+				uint32 *island_begin = indices + (island > 0? mBodyIslandEnds[island - 1] : 0);
+				uint32 *island_end = indices + mBodyIslandEnds[island];
+
+				// Convert to body IDs
+				for (uint32 *i = island_begin; i < island_end; ++i)
+					*reinterpret_cast<BodyID *>(i) = inActiveBodies[*i];
+
+				BodyID *bodies_begin = reinterpret_cast<BodyID *>(island_begin);
+				BodyID *bodies_end = reinterpret_cast<BodyID *>(island_end);
+				if (!is_sorted(bodies_begin, bodies_end))
+					sort(bodies_begin, bodies_end);
+			}
+			break;
+		}
+
+	case EFinalizePhase::Done:
+	default:
+		JPH_ASSERT(false);
+		break;
+	}
+}
+
+void IslandBuilder::FinishFinalizePhase(EFinalizePhase inPhase, TempAllocator *inTempAllocator)
+{
+	switch (inPhase)
+	{
+	case EFinalizePhase::FindRoots:
+		{
+			// Calculate the first island index for every batch of bodies
+			uint32 num_body_batches = (mNumActiveBodies + cFinalizeBatchSize - 1) / cFinalizeBatchSize;
+			JPH_ASSERT(mNumIslands == 0);
+			for (uint32 batch = 0; batch < num_body_batches; ++batch)
+			{
+				uint32 num_islands = mBatchSums[batch];
+				mBatchSums[batch] = mNumIslands;
+				mNumIslands += num_islands;
+			}
+			break;
+		}
+
+	case EFinalizePhase::CountIslandSizes:
+	#ifdef JPH_VALIDATE_ISLAND_BUILDER
+		ValidateIslands(mNumActiveBodies);
+	#endif
+		break;
+
+	case EFinalizePhase::SumIslandSizes:
+		{
+			// Calculate where the first island of every batch of islands starts
+			uint32 num_island_batches = (mNumIslands + cFinalizeBatchSize - 1) / cFinalizeBatchSize;
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				uint32 start = 0;
+				for (uint32 batch = 0; batch < num_island_batches; ++batch)
+				{
+					uint32 sum = mBatchSums[3 * batch + c];
+					mBatchSums[3 * batch + c] = start;
+					start += sum;
+				}
+			}
+			break;
+		}
+
+	case EFinalizePhase::Scatter:
+		{
+			// We should now have full arrays
+			JPH_ASSERT(mNumIslands == 0 || mBodyIslandEnds[mNumIslands - 1] == mNumActiveBodies);
+			JPH_ASSERT(mConstraintIslandEnds == nullptr || mConstraintIslandEnds[mNumIslands - 1] == mNumConstraints);
+			JPH_ASSERT(mContactIslandEnds == nullptr || mContactIslandEnds[mNumIslands - 1] == mNumContacts);
+			break;
+		}
+
+	case EFinalizePhase::OrderBodies:
+		{
+			// Free scratch memory
+			uint32 num_body_batches = (mNumActiveBodies + cFinalizeBatchSize - 1) / cFinalizeBatchSize;
+			inTempAllocator->Free(mBatchSums, 3 * num_body_batches * sizeof(uint32));
+			mBatchSums = nullptr;
+			inTempAllocator->Free(mIslandCounters, 3 * mNumActiveBodies * sizeof(atomic<uint32>));
+			mIslandCounters = nullptr;
+
+			// Links of all active bodies are now valid for the next update
+			if (mKeepLinks)
+				mNumLinkedBodies = mNumActiveBodies;
+
+			SortIslands(inTempAllocator);
+			break;
+		}
+
+	case EFinalizePhase::Allocate:
+	case EFinalizePhase::NumberIslands:
+	case EFinalizePhase::CalculateIslandStarts:
+		break;
+
+	case EFinalizePhase::Done:
+	default:
+		JPH_ASSERT(false);
+		break;
+	}
+}
+
+IslandBuilder::EFinalizeResult IslandBuilder::Finalize(const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator)
 {
 	JPH_PROFILE_FUNCTION();
 
-	mNumContacts = inNumContacts;
+	for (;;)
+	{
+		uint32 phase = mFinalizePhase.load(memory_order_acquire);
+		if (phase == uint32(EFinalizePhase::Done))
+			return EFinalizeResult::NoMoreWork;
+
+		// Try to claim a batch of the current phase, if all batches have been claimed the jobs that process them will continue with the next phase
+		uint32 batch = mFinalizeNextBatch[phase].fetch_add(1, memory_order_relaxed);
+		uint32 num_batches = GetNumFinalizeBatches(EFinalizePhase(phase));
+		if (batch >= num_batches)
+			return EFinalizeResult::NoMoreWork;
+
+		ProcessFinalizeBatch(EFinalizePhase(phase), batch, inActiveBodies, inNumActiveBodies, inNumContacts, inTempAllocator);
 
-	BuildBodyIslands(inActiveBodies, inNumActiveBodies, inTempAllocator);
-	BuildConstraintIslands(mConstraintLinks, mNumConstraints, mConstraintIslands, mConstraintIslandEnds, inTempAllocator);
-	BuildConstraintIslands(mContactLinks, mNumContacts, mContactIslands, mContactIslandEnds, inTempAllocator);
-	SortIslands(inTempAllocator);
+		// If we processed the last batch of the phase, finish the phase and move on to the next phase that has work
+		if (mFinalizeBatchesDone[phase].fetch_add(1, memory_order_acq_rel) + 1 == num_batches)
+		{
+			do
+			{
+				FinishFinalizePhase(EFinalizePhase(phase), inTempAllocator);
+				++phase;
+			}
+			while (phase < uint32(EFinalizePhase::Done) && GetNumFinalizeBatches(EFinalizePhase(phase)) == 0);
+
+			if (phase == uint32(EFinalizePhase::Done))
+			{
+				mFinalizePhase.store(phase, memory_order_release);
+				return EFinalizeResult::Done;
+			}
+
+			// Let the caller start helpers before other callers can see the next phase
+			mFinalizeNextPhase = EFinalizePhase(phase);
+			if (GetNumFinalizeBatches(EFinalizePhase(phase)) > 1)
+				return EFinalizeResult::NextPhase;
+			StartNextFinalizePhase();
+		}
+	}
 }
 
 void IslandBuilder::GetBodiesInIsland(uint32 inIslandIndex, BodyID *&outBodiesBegin, BodyID *&outBodiesEnd) const
@@ -436,7 +780,7 @@ void IslandBuilder::ResetIslands(TempAllocator *inTempAllocator)
 
 	if (mContactIslands != nullptr)
 	{
-		inTempAllocator->Free(mContactIslandEnds, (mNumIslands + 1) * sizeof(uint32));
+		inTempAllocator->Free(mContactIslandEnds, mNumActiveBodies * sizeof(uint32));
 		mContactIslandEnds = nullptr;
 		inTempAllocator->Free(mContactIslands, mNumContacts * sizeof(uint32));
 		mContactIslands = nullptr;
@@ -444,13 +788,13 @@ void IslandBuilder::ResetIslands(TempAllocator *inTempAllocator)
 	
 	if (mConstraintIslands != nullptr)
 	{
-		inTempAllocator->Free(mConstraintIslandEnds, (mNumIslands + 1) * sizeof(uint32));
+		inTempAllocator->Free(mConstraintIslandEnds, mNumActiveBodies * sizeof(uint32));
 		mConstraintIslandEnds = nullptr;
 		inTempAllocator->Free(mConstraintIslands, mNumConstraints * sizeof(uint32));
 		mConstraintIslands = nullptr;
 	}
 	
-	inTempAllocator->Free(mBodyIslandEnds, (mNumActiveBodies + 1) * sizeof(uint32));
+	inTempAllocator->Free(mBodyIslandEnds, mNumActiveBodies * sizeof(uint32));
 	mBodyIslandEnds = nullptr;
 	inTempAllocator->Free(mBodyIslands, mNumActiveBodies * sizeof(uint32));
 	mBodyIslands = nullptr;
@@ -471,6 +815,14 @@ void IslandBuilder::ResetIslands(TempAllocator *inTempAllocator)
 	mMaxContacts = 0;
 	mNumContacts = 0;
 	mNumIslands = 0;
+
+	// Reset the finalize state for the next update
+	mFinalizePhase.store(uint32(EFinalizePhase::Allocate), memory_order_relaxed);
+	for (uint32 phase = 0; phase < cNumFinalizePhases; ++phase)
+	{
+		mFinalizeNextBatch[phase].store(0, memory_order_relaxed);
+		mFinalizeBatchesDone[phase].store(0, memory_order_relaxed);
+	}
 }
 
 JPH_NAMESPACE_END
@@ -26,6 +26,12 @@ public:
 	/// Initialize the island builder with the maximum amount of bodies that could be active						
 	void					Init(uint32 inMaxActiveBodies);
 
+	/// Prepare the links between bodies for a simulation step, call before any bodies are linked.
+	/// When inUsePersistentLinks is true, the links of the previous step are kept so that bodies that stay in contact don't need to be relinked.
+	/// This means that an island can contain bodies that are no longer connected. Islands are split (by starting over with unlinked bodies) when
+	/// RequestSplitIslands was called or when the links can no longer be used because a body was removed from the active bodies list.
+	void					PrepareBodyLinks(const BodyID *inActiveBodies, uint32 inNumActiveBodies, bool inUsePersistentLinks);
+
 	/// Prepare for simulation step by allocating space for the contact constraints
 	void					PrepareContactConstraints(uint32 inMaxContactConstraints, TempAllocator *inTempAllocator);
 
@@ -41,8 +47,27 @@ public:
 	/// Link a contact to a body by their index in the BodyManager::mActiveBodies
 	void					LinkContact(uint32 inContactIndex, uint32 inFirst, uint32 inSecond);
 
-	/// Finalize the islands after all bodies have been Link()-ed
-	void					Finalize(const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator);
+	/// Number of bodies, constraints, contacts or islands that Finalize processes as a single batch
+	static constexpr uint32	cFinalizeBatchSize = 1024;
+
+	/// Result of Finalize
+	enum class EFinalizeResult
+	{
+		NoMoreWork,																///< All batches of the current phase have been claimed, the callers that process them will continue
+		NextPhase,																///< The caller finished a phase and the next phase has multiple batches, start helpers if needed, then call StartNextFinalizePhase and Finalize again
+		Done,																	///< The caller finished the last batch of work, the islands are ready
+	};
+
+	/// Finalize the islands after all bodies have been Link()-ed.
+	/// This function can be called by multiple jobs at the same time (with the same parameters) to divide the work, it never waits for other jobs.
+	/// The caller that finishes the last batch of a phase continues with the next phase, so a single caller that keeps calling Finalize while it returns NextPhase will finish the islands.
+	EFinalizeResult			Finalize(const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator);
+
+	/// After Finalize returned NextPhase: the number of batches in the next phase (the amount of jobs that can help)
+	uint32					GetNumNextFinalizePhaseBatches() const			{ return GetNumFinalizeBatches(mFinalizeNextPhase); }
+
+	/// After Finalize returned NextPhase: allow other callers of Finalize to start working on the next phase
+	void					StartNextFinalizePhase()						{ mFinalizePhase.store(uint32(mFinalizeNextPhase), memory_order_release); }
 
 	/// Get the amount of islands formed
 	uint32					GetNumIslands() const							{ return mNumIslands; }
@@ -55,6 +80,12 @@ public:
 	/// After you're done calling the three functions above, call this function to free associated data
 	void					ResetIslands(TempAllocator *inTempAllocator);
 
+	/// If the islands of this step were built on top of links of a previous step (in which case islands may consist of multiple unconnected groups of bodies)
+	bool					IslandsIncludePreviousLinks() const				{ return mIslandsIncludePreviousLinks; }
+
+	/// Request that the islands are rebuilt from scratch in the next simulation step, can be called from multiple threads
+	void					RequestSplitIslands()							{ mSplitIslandsRequested.store(true, memory_order_relaxed); }
+
 private:
 	/// Returns the index of the lowest body in the group
 	uint32					GetLowestBodyIndex(uint32 inActiveBodyIndex) const;
@@ -64,9 +95,26 @@ private:
 	void					ValidateIslands(uint32 inNumActiveBodies) const;
 #endif
 
-	// Helper functions to build various islands
-	void					BuildBodyIslands(const BodyID *inActiveBodies, uint32 inNumActiveBodies, TempAllocator *inTempAllocator);
-	void					BuildConstraintIslands(const uint32 *inConstraintToBody, uint32 inNumConstraints, uint32 *&outConstraints, uint32 *&outConstraintsEnd, TempAllocator *inTempAllocator) const;
+	/// Phases of Finalize, each phase is divided in batches that can be processed by different jobs
+	enum class EFinalizePhase : uint32
+	{
+		Allocate,																///< Allocate the output arrays (a single batch)
+		FindRoots,																///< Find the lowest body in the island for every body and count the islands per batch of bodies
+		NumberIslands,															///< Assign an island index to the lowest body of every island
+		CountIslandSizes,														///< Assign the island index to all other bodies and count the bodies, constraints and contacts per island
+		SumIslandSizes,															///< Sum the island sizes per batch of islands
+		CalculateIslandStarts,													///< Calculate where every island starts in the output arrays
+		Scatter,																///< Copy the active body indices, constraints and contacts to the output arrays
+		OrderBodies,															///< Sort the bodies of every island by active body index so that the order doesn't depend on the amount of jobs and convert them to body IDs
+		Done
+	};
+
+	static constexpr uint32	cNumFinalizePhases = uint32(EFinalizePhase::Done);
+
+	/// Helper functions to finalize the islands
+	uint32					GetNumFinalizeBatches(EFinalizePhase inPhase) const;
+	void					ProcessFinalizeBatch(EFinalizePhase inPhase, uint32 inBatch, const BodyID *inActiveBodies, uint32 inNumActiveBodies, uint32 inNumContacts, TempAllocator *inTempAllocator);
+	void					FinishFinalizePhase(EFinalizePhase inPhase, TempAllocator *inTempAllocator);
 
 	/// Sorts the islands so that the islands with most constraints go first
 	void					SortIslands(TempAllocator *inTempAllocator);
@@ -95,6 +143,21 @@ private:
 
 	uint32 *				mIslandsSorted = nullptr;						///< A list of island indices in order of most constraints first
 
+	// Finalize state
+	atomic<uint32>			mFinalizePhase { 0 };							///< Current EFinalizePhase
+	EFinalizePhase			mFinalizeNextPhase = EFinalizePhase::Allocate;	///< Phase that StartNextFinalizePhase starts
+	atomic<uint32>			mFinalizeNextBatch[cNumFinalizePhases] { };		///< Next batch to process for each phase
+	atomic<uint32>			mFinalizeBatchesDone[cNumFinalizePhases] { };	///< Number of batches that have been processed for each phase
+	atomic<uint32> *		mIslandCounters = nullptr;						///< Per island the number of bodies, constraints and contacts, later used as write position (3 arrays of mNumActiveBodies entries)
+	uint32 *				mBatchSums = nullptr;							///< Number of islands per batch of bodies, later the sum of island sizes per batch of islands
+
+	// Persistent links
+	BodyID *				mLinkedBodies = nullptr;						///< The active bodies list at the time the links in mBodyLinks were finalized
+	uint32					mNumLinkedBodies = 0;							///< Number of bodies in mLinkedBodies, all links from mNumLinkedBodies onwards point to themselves
+	bool					mKeepLinks = false;								///< If the links should be kept after Finalize for the next simulation step
+	bool					mIslandsIncludePreviousLinks = false;			///< If the links of a previous step were used in this step
+	atomic<bool>			mSplitIslandsRequested { false };				///< If RequestSplitIslands was called
+
 	// Counters
 	uint32					mMaxActiveBodies;								///< Maximum size of the active bodies list (see BodyManager::mActiveBodies)
 	uint32					mNumActiveBodies = 0;							///< Number of active bodies passed to 
@@ -0,0 +1,337 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Physics/LargeIslandSplitter.h>
+#include <Jolt/Physics/IslandBuilder.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Constraints/Constraint.h>
+#include <Jolt/Physics/Constraints/ContactConstraintManager.h>
+#include <Jolt/Core/Profiler.h>
+#include <Jolt/Core/TempAllocator.h>
+
+JPH_NAMESPACE_BEGIN
+
+LargeIslandSplitter::~LargeIslandSplitter()
+{
+	JPH_ASSERT(mSplitMasks == nullptr);
+	JPH_ASSERT(mSplitIslands == nullptr);
+	JPH_ASSERT(mScratch == nullptr);
+}
+
+uint LargeIslandSplitter::IslandSplits::GetNextNonEmptySplit(uint inSplit) const
+{
+	for (uint s = inSplit; s < cNumSplits; ++s)
+		if (mSplits[s].GetNumItems() > 0)
+			return s;
+	return cNumSplits;
+}
+
+void LargeIslandSplitter::Prepare(const IslandBuilder &inIslandBuilder, uint32 inNumActiveBodies, TempAllocator *inTempAllocator)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Check that the splitter has been reset
+	JPH_ASSERT(mNumSplitIslands == 0);
+	JPH_ASSERT(mScratchSize == 0);
+
+	// Islands are sorted by number of constraints + contacts, so the islands that need splitting are the first islands.
+	// For each island we need scratch space for the split index of each item and a copy of the item.
+	for (uint32 num_islands = inIslandBuilder.GetNumIslands(); mNumSplitIslands < num_islands; ++mNumSplitIslands)
+	{
+		uint32 *constraints_begin, *constraints_end, *contacts_begin, *contacts_end;
+		inIslandBuilder.GetConstraintsInIsland(mNumSplitIslands, constraints_begin, constraints_end);
+		inIslandBuilder.GetContactsInIsland(mNumSplitIslands, contacts_begin, contacts_end);
+		uint32 num_items = uint32(constraints_end - constraints_begin + contacts_end - contacts_begin);
+		if (num_items < cLargeIslandThreshold)
+			break;
+		mScratchSize += 2 * num_items;
+	}
+	if (mNumSplitIslands == 0)
+		return;
+
+	// Allocate the split masks, they're initialized when the island is split
+	mNumActiveBodies = inNumActiveBodies;
+	mSplitMasks = (uint32 *)inTempAllocator->Allocate(mNumActiveBodies * sizeof(uint32));
+
+	// Allocate scratch memory
+	mScratch = (uint32 *)inTempAllocator->Allocate(mScratchSize * sizeof(uint32));
+
+	// Allocate the split islands
+	mSplitIslands = (IslandSplits *)inTempAllocator->Allocate(mNumSplitIslands * sizeof(IslandSplits));
+	uint32 *scratch = mScratch;
+	for (uint32 i = 0; i < mNumSplitIslands; ++i)
+	{
+		IslandSplits *island = new (&mSplitIslands[i]) IslandSplits;
+		island->mStatus.store(sGetStatus(cIterationNotStarted, 0, 0), memory_order_relaxed);
+		island->mItemsProcessed.store(0, memory_order_relaxed);
+		island->mNumIterations = 0;
+		island->mScratch = scratch;
+
+		uint32 *constraints_begin, *constraints_end, *contacts_begin, *contacts_end;
+		inIslandBuilder.GetConstraintsInIsland(i, constraints_begin, constraints_end);
+		inIslandBuilder.GetContactsInIsland(i, contacts_begin, contacts_end);
+		scratch += 2 * (constraints_end - constraints_begin + contacts_end - contacts_begin);
+	}
+	JPH_ASSERT(scratch == mScratch + mScratchSize);
+}
+
+uint LargeIslandSplitter::AssignSplit(const Body *inBody1, const Body *inBody2)
+{
+	// Only dynamic bodies are modified by the solver, so static and kinematic bodies can be shared between constraints in a split
+	uint32 idx1 = inBody1->IsDynamic()? inBody1->GetIndexInActiveBodiesInternal() : Body::cInactiveIndex;
+	uint32 idx2 = inBody2->IsDynamic()? inBody2->GetIndexInActiveBodiesInternal() : Body::cInactiveIndex;
+	JPH_ASSERT(idx1 == Body::cInactiveIndex || idx1 < mNumActiveBodies);
+	JPH_ASSERT(idx2 == Body::cInactiveIndex || idx2 < mNumActiveBodies);
+
+	// Find the first split that neither body is in (the non parallel split bit is never set so we always find a split)
+	uint32 mask1 = idx1 != Body::cInactiveIndex? mSplitMasks[idx1] : 0;
+	uint32 mask2 = idx2 != Body::cInactiveIndex? mSplitMasks[idx2] : 0;
+	uint split = CountTrailingZeros(~(mask1 | mask2));
+	if (split == cNonParallelSplitIdx)
+		return split;
+
+	// Mark the bodies as being in this split
+	uint32 bit = uint32(1) << split;
+	if (idx1 != Body::cInactiveIndex)
+		mSplitMasks[idx1] = mask1 | bit;
+	if (idx2 != Body::cInactiveIndex)
+		mSplitMasks[idx2] = mask2 | bit;
+	return split;
+}
+
+void LargeIslandSplitter::SplitIsland(uint32 inIslandIndex, IslandBuilder &ioIslandBuilder, const BodyManager &inBodyManager, const ContactConstraintManager &inContactManager, Constraint **inActiveConstraints)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inIslandIndex < mNumSplitIslands);
+	IslandSplits &island = mSplitIslands[inIslandIndex];
+
+	// Reset the split masks of the bodies in this island (other islands don't touch these bodies so this can be done in parallel)
+	BodyID *bodies_begin, *bodies_end;
+	ioIslandBuilder.GetBodiesInIsland(inIslandIndex, bodies_begin, bodies_end);
+	for (const BodyID *body_id = bodies_begin; body_id < bodies_end; ++body_id)
+	{
+		uint32 idx = inBodyManager.GetBody(*body_id).GetIndexInActiveBodiesInternal();
+		if (idx != Body::cInactiveIndex)
+			mSplitMasks[idx] = 0;
+	}
+
+	// Get the constraints and contacts of this island
+	uint32 *constraints_begin, *constraints_end, *contacts_begin, *contacts_end;
+	ioIslandBuilder.GetConstraintsInIsland(inIslandIndex, constraints_begin, constraints_end);
+	ioIslandBuilder.GetContactsInIsland(inIslandIndex, contacts_begin, contacts_end);
+	uint num_constraints = uint(constraints_end - constraints_begin);
+	uint num_contacts = uint(contacts_end - contacts_begin);
+
+	// Assign a split to each constraint and contact, since these have been sorted the result is deterministic
+	uint32 *constraint_split = island.mScratch;
+	uint32 *contact_split = constraint_split + num_constraints;
+	uint num_constraints_in_split[cNumSplits] = { };
+	uint num_contacts_in_split[cNumSplits] = { };
+	for (uint i = 0; i < num_constraints; ++i)
+	{
+		uint split = inActiveConstraints[constraints_begin[i]]->BuildIslandSplits(*this);
+		constraint_split[i] = split;
+		++num_constraints_in_split[split];
+	}
+	for (uint i = 0; i < num_contacts; ++i)
+	{
+		const Body *body1, *body2;
+		inContactManager.GetAffectedBodies(contacts_begin[i], body1, body2);
+		uint split = AssignSplit(body1, body2);
+		contact_split[i] = split;
+		++num_contacts_in_split[split];
+	}
+
+	// Merge splits that are too small to be worth the synchronization into the non parallel split
+	uint remap[cNumSplits];
+	for (uint s = 0; s < cNonParallelSplitIdx; ++s)
+		if (num_constraints_in_split[s] + num_contacts_in_split[s] < cSplitCombineThreshold)
+		{
+			remap[s] = cNonParallelSplitIdx;
+			num_constraints_in_split[cNonParallelSplitIdx] += num_constraints_in_split[s];
+			num_constraints_in_split[s] = 0;
+			num_contacts_in_split[cNonParallelSplitIdx] += num_contacts_in_split[s];
+			num_contacts_in_split[s] = 0;
+		}
+		else
+			remap[s] = s;
+	remap[cNonParallelSplitIdx] = cNonParallelSplitIdx;
+
+	// Determine the range of each split
+	uint32 *constraint_write[cNumSplits], *contact_write[cNumSplits];
+	uint32 *next_constraint = constraints_begin, *next_contact = contacts_begin;
+	for (uint s = 0; s < cNumSplits; ++s)
+	{
+		Split &split = island.mSplits[s];
+		split.mConstraintsBegin = constraint_write[s] = next_constraint;
+		next_constraint += num_constraints_in_split[s];
+		split.mConstraintsEnd = next_constraint;
+		split.mContactsBegin = contact_write[s] = next_contact;
+		next_contact += num_contacts_in_split[s];
+		split.mContactsEnd = next_contact;
+	}
+	JPH_ASSERT(next_constraint == constraints_end);
+	JPH_ASSERT(next_contact == contacts_end);
+
+	// Reorder the constraints and contacts so that each split is a contiguous range, within a split the sorted order is kept
+	uint32 *copy = contact_split + num_contacts;
+	if (num_constraints > 0)
+	{
+		memcpy(copy, constraints_begin, num_constraints * sizeof(uint32));
+		for (uint i = 0; i < num_constraints; ++i)
+			*constraint_write[remap[constraint_split[i]]]++ = copy[i];
+	}
+	if (num_contacts > 0)
+	{
+		memcpy(copy, contacts_begin, num_contacts * sizeof(uint32));
+		for (uint i = 0; i < num_contacts; ++i)
+			*contact_write[remap[contact_split[i]]]++ = copy[i];
+	}
+}
+
+void LargeIslandSplitter::ResetStatus()
+{
+	for (uint32 i = 0; i < mNumSplitIslands; ++i)
+	{
+		IslandSplits &island = mSplitIslands[i];
+		island.mStatus.store(sGetStatus(cIterationNotStarted, 0, 0), memory_order_relaxed);
+		island.mItemsProcessed.store(0, memory_order_relaxed);
+	}
+}
+
+bool LargeIslandSplitter::StartIsland(uint32 inSplitIslandIndex, uint inNumIterations)
+{
+	JPH_ASSERT(inSplitIslandIndex < mNumSplitIslands);
+	IslandSplits &island = mSplitIslands[inSplitIslandIndex];
+	JPH_ASSERT(sGetIteration(island.mStatus.load(memory_order_relaxed)) == cIterationNotStarted);
+
+	if (inNumIterations == 0)
+		return false;
+
+	// The island is large, so there is at least one split with items
+	uint split = island.GetNextNonEmptySplit(0);
+	JPH_ASSERT(split < cNumSplits);
+
+	// Publish the island so that other jobs can start fetching batches
+	island.mNumIterations = inNumIterations;
+	island.mItemsProcessed.store(0, memory_order_relaxed);
+	island.mStatus.store(sGetStatus(0, split, 0), memory_order_release);
+	return true;
+}
+
+LargeIslandSplitter::EStatus LargeIslandSplitter::FetchNextBatch(uint32 &outSplitIslandIndex, uint32 *&outConstraintsBegin, uint32 *&outConstraintsEnd, uint32 *&outContactsBegin, uint32 *&outContactsEnd, bool &outFirstIteration, bool &outLastIteration)
+{
+	bool all_done = true;
+
+	for (uint32 i = 0; i < mNumSplitIslands; ++i)
+	{
+		IslandSplits &island = mSplitIslands[i];
+
+		uint64 status = island.mStatus.load(memory_order_acquire);
+		for (;;)
+		{
+			// Check if the island is finished
+			uint iteration = sGetIteration(status);
+			if (iteration == cIterationDone)
+				break;
+			all_done = false;
+
+			// Check if the island has been started and still has iterations left
+			if (iteration == cIterationNotStarted || iteration >= island.mNumIterations)
+				break;
+
+			// Check if there are items left in this split, if not we need to wait for the other jobs to finish the split
+			uint split_idx = sGetSplit(status);
+			const Split &split = island.mSplits[split_idx];
+			uint num_items = split.GetNumItems();
+			uint32 item = sGetItem(status);
+			if (item >= num_items)
+				break;
+
+			// The non parallel split is solved by a single job
+			uint batch_size = split_idx == cNonParallelSplitIdx? num_items - item : min(cBatchSize, num_items - item);
+			if (island.mStatus.compare_exchange_weak(status, status + batch_size, memory_order_acquire, memory_order_acquire))
+			{
+				// Batch is a range of items where the constraints come before the contacts
+				uint num_constraints = uint(split.mConstraintsEnd - split.mConstraintsBegin);
+				uint end = item + batch_size;
+				outSplitIslandIndex = i;
+				outConstraintsBegin = split.mConstraintsBegin + min(item, num_constraints);
+				outConstraintsEnd = split.mConstraintsBegin + min(end, num_constraints);
+				outContactsBegin = split.mContactsBegin + (max(item, num_constraints) - num_constraints);
+				outContactsEnd = split.mContactsBegin + (max(end, num_constraints) - num_constraints);
+				outFirstIteration = iteration == 0;
+				outLastIteration = iteration == island.mNumIterations - 1;
+				return EStatus::BatchRetrieved;
+			}
+		}
+	}
+
+	return all_done? EStatus::AllBatchesDone : EStatus::WaitingForBatch;
+}
+
+void LargeIslandSplitter::MarkBatchProcessed(uint32 inSplitIslandIndex, uint inNumProcessed, bool &outLastBatch)
+{
+	JPH_ASSERT(inSplitIslandIndex < mNumSplitIslands);
+	IslandSplits &island = mSplitIslands[inSplitIslandIndex];
+
+	// The iteration and split can't change until we have marked our batch as processed
+	uint64 status = island.mStatus.load(memory_order_relaxed);
+	uint split_idx = sGetSplit(status);
+	uint num_items = island.mSplits[split_idx].GetNumItems();
+
+	// Check if we were the last job to finish a batch of this split
+	uint processed = island.mItemsProcessed.fetch_add(inNumProcessed, memory_order_acq_rel) + inNumProcessed;
+	JPH_ASSERT(processed <= num_items);
+	if (processed < num_items)
+	{
+		outLastBatch = false;
+		return;
+	}
+
+	// Go to the next split, or to the first split of the next iteration
+	uint iteration = sGetIteration(status);
+	uint next_split_idx = island.GetNextNonEmptySplit(split_idx + 1);
+	if (next_split_idx == cNumSplits)
+	{
+		++iteration;
+		next_split_idx = island.GetNextNonEmptySplit(0);
+	}
+	outLastBatch = iteration == island.mNumIterations;
+
+	// Release the next split to the other jobs, this also makes the results of this split visible to them
+	island.mItemsProcessed.store(0, memory_order_relaxed);
+	island.mStatus.store(sGetStatus(iteration, next_split_idx, 0), memory_order_release);
+}
+
+void LargeIslandSplitter::MarkIslandDone(uint32 inSplitIslandIndex)
+{
+	JPH_ASSERT(inSplitIslandIndex < mNumSplitIslands);
+	mSplitIslands[inSplitIslandIndex].mStatus.store(sGetStatus(cIterationDone, 0, 0), memory_order_release);
+}
+
+void LargeIslandSplitter::Reset(TempAllocator *inTempAllocator)
+{
+	JPH_PROFILE_FUNCTION();
+
+	if (mNumSplitIslands > 0)
+	{
+		inTempAllocator->Free(mSplitIslands, mNumSplitIslands * sizeof(IslandSplits));
+		mSplitIslands = nullptr;
+
+		inTempAllocator->Free(mScratch, mScratchSize * sizeof(uint32));
+		mScratch = nullptr;
+
+		inTempAllocator->Free(mSplitMasks, mNumActiveBodies * sizeof(uint32));
+		mSplitMasks = nullptr;
+	}
+
+	mNumSplitIslands = 0;
+	mNumActiveBodies = 0;
+	mScratchSize = 0;
+}
+
+JPH_NAMESPACE_END
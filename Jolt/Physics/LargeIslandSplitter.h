@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/NonCopyable.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <atomic>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+class Body;
+class BodyManager;
+class Constraint;
+class ContactConstraintManager;
+class IslandBuilder;
+class TempAllocator;
+
+/// Splits large islands into batches of constraints and contacts that can be solved in parallel.
+///
+/// Constraints and contacts are assigned a split (a color in graph coloring terms) so that within a split no two constraints
+/// touch the same dynamic body. The solver iterates over the splits in order and all constraints in a split can be solved
+/// at the same time by multiple jobs. Constraints that can't be assigned to a split go to a non parallel split that is solved
+/// by a single job. The splits only depend on the contents of the island, so the simulation stays deterministic regardless
+/// of the amount of threads that are used.
+///
+/// Large islands are always the first islands in the IslandBuilder since the islands are sorted by number of constraints,
+/// so the index of a split island equals the island index.
+class LargeIslandSplitter : public NonCopyable
+{
+public:
+	static constexpr uint	cNumSplits = 32;								///< Maximum number of splits, the last one is the non parallel split
+	static constexpr uint	cNonParallelSplitIdx = cNumSplits - 1;			///< Index of the split that contains all constraints that could not be put in another split
+	static constexpr uint	cLargeIslandThreshold = 128;					///< Islands with at least this many constraints + contacts will be split
+	static constexpr uint	cSplitCombineThreshold = 32;					///< If a split has fewer constraints + contacts than this, it is merged into the non parallel split to reduce the amount of synchronization
+	static constexpr uint	cBatchSize = 16;								///< Number of constraints + contacts that a job takes from a split at a time
+
+	/// Status of FetchNextBatch
+	enum class EStatus
+	{
+		WaitingForBatch,													///< Work is expected to be available later (another job is splitting an island or finishing the current split)
+		BatchRetrieved,														///< Work is being returned
+		AllBatchesDone,														///< No further work is expected from this splitter
+	};
+
+	/// Destructor
+							~LargeIslandSplitter();
+
+	/// Determine which islands need to be split and allocate the memory for splitting them, call after IslandBuilder::Finalize
+	void					Prepare(const IslandBuilder &inIslandBuilder, uint32 inNumActiveBodies, TempAllocator *inTempAllocator);
+
+	/// Get the number of islands that are split, these are the islands with index [0, GetNumSplitIslands())
+	uint32					GetNumSplitIslands() const						{ return mNumSplitIslands; }
+
+	/// Assign two bodies to the same split so that no other constraint in the split touches the bodies, returns the split index
+	uint					AssignSplit(const Body *inBody1, const Body *inBody2);
+
+	/// Force a constraint to be solved by a single job, returns the split index
+	uint					AssignToNonParallelSplit()						{ return cNonParallelSplitIdx; }
+
+	/// Split an island, the constraints and contacts of the island need to have been sorted so that the splits are deterministic.
+	/// This reorders the constraints and contacts of the island in the island builder so that each split is a contiguous range.
+	void					SplitIsland(uint32 inIslandIndex, IslandBuilder &ioIslandBuilder, const BodyManager &inBodyManager, const ContactConstraintManager &inContactManager, Constraint **inActiveConstraints);
+
+	/// Reset all split islands to the not started state, needs to be called when no jobs are solving split islands (before switching from velocity to position solving or to the next sub step)
+	void					ResetStatus();
+
+	/// Make a split island available for other jobs to solve, inNumIterations is the amount of times every split needs to be solved.
+	/// Returns false if there's nothing to solve (inNumIterations = 0), in which case the caller needs to call MarkIslandDone.
+	bool					StartIsland(uint32 inSplitIslandIndex, uint inNumIterations);
+
+	/// Fetch the next batch of constraints and contacts to solve
+	EStatus					FetchNextBatch(uint32 &outSplitIslandIndex, uint32 *&outConstraintsBegin, uint32 *&outConstraintsEnd, uint32 *&outContactsBegin, uint32 *&outContactsEnd, bool &outFirstIteration, bool &outLastIteration);
+
+	/// Mark a batch as processed, if outLastBatch is true this was the last batch of the island and the caller needs to call MarkIslandDone (after finishing any per island work)
+	void					MarkBatchProcessed(uint32 inSplitIslandIndex, uint inNumProcessed, bool &outLastBatch);
+
+	/// Mark a split island as fully processed
+	void					MarkIslandDone(uint32 inSplitIslandIndex);
+
+	/// Free the memory allocated in Prepare
+	void					Reset(TempAllocator *inTempAllocator);
+
+private:
+	/// A range of constraints and contacts that can be solved in parallel
+	struct Split
+	{
+		uint				GetNumItems() const								{ return mConstraintsEnd - mConstraintsBegin + mContactsEnd - mContactsBegin; }
+
+		uint32 *			mConstraintsBegin;								///< Constraints in this split (index in the active constraints array)
+		uint32 *			mConstraintsEnd;
+		uint32 *			mContactsBegin;									///< Contacts in this split (index in the contact constraint manager)
+		uint32 *			mContactsEnd;
+	};
+
+	/// An island that has been split
+	struct IslandSplits
+	{
+		/// Find the first split with items starting at inSplit, returns cNumSplits if there are none
+		uint				GetNextNonEmptySplit(uint inSplit) const;
+
+		atomic<uint64>		mStatus;										///< Combination of iteration, split and item index, see sGetStatus
+		atomic<uint32>		mItemsProcessed;								///< Number of items that were processed in the current split
+		uint				mNumIterations;									///< Number of iterations the splits need to be solved for
+		uint32 *			mScratch;										///< Scratch memory used while splitting the island
+		Split				mSplits[cNumSplits];							///< The splits of this island
+	};
+
+	/// Helper functions to create and decode the status of a split island
+	static constexpr uint	cIterationNotStarted = 0xffff;					///< Iteration index used when the island has not been started by StartIsland
+	static constexpr uint	cIterationDone = 0xfffe;						///< Iteration index used when the island has been marked done
+	static inline uint64	sGetStatus(uint inIteration, uint inSplit, uint32 inItem) { return (uint64(inIteration) << 48) | (uint64(inSplit) << 32) | inItem; }
+	static inline uint		sGetIteration(uint64 inStatus)					{ return uint(inStatus >> 48); }
+	static inline uint		sGetSplit(uint64 inStatus)						{ return uint(inStatus >> 32) & 0xffff; }
+	static inline uint32	sGetItem(uint64 inStatus)						{ return uint32(inStatus); }
+
+	uint32 *				mSplitMasks = nullptr;							///< Per active body a bit mask of the splits that the body is in
+	uint32					mNumActiveBodies = 0;							///< Size of mSplitMasks
+	IslandSplits *			mSplitIslands = nullptr;						///< Islands that will be split
+	uint32					mNumSplitIslands = 0;							///< Number of islands that will be split
+	uint32 *				mScratch = nullptr;								///< Scratch memory for all split islands
+	uint32					mScratchSize = 0;								///< Size of mScratch
+};
+
+JPH_NAMESPACE_END
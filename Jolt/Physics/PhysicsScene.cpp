@@ -55,6 +55,51 @@ bool PhysicsScene::FixInvalidScales()
 	return success;
 }
 
+/// Build a broadphase tree for the static bodies of every object layer in inBodies
+static void sBuildStaticBodyTrees(const TaggedVector<BodyCreationSettings> &inBodies, TaggedVector<PhysicsScene::StaticBodyTree> &outTrees)
+{
+	outTrees.clear();
+
+	// Collect all static bodies and sort them on object layer
+	TaggedVector<uint32> static_bodies;
+	for (uint32 i = 0; i < (uint32)inBodies.size(); ++i)
+		if (inBodies[i].mMotionType == EMotionType::Static && inBodies[i].GetShape() != nullptr)
+			static_bodies.push_back(i);
+	sort(static_bodies.begin(), static_bodies.end(), [&inBodies](uint32 inLHS, uint32 inRHS) { return inBodies[inLHS].mObjectLayer < inBodies[inRHS].mObjectLayer || (inBodies[inLHS].mObjectLayer == inBodies[inRHS].mObjectLayer && inLHS < inRHS); });
+
+	TaggedVector<AABox> bounds;
+	for (TaggedVector<uint32>::const_iterator b_start = static_bodies.begin(), b_end = static_bodies.end(); b_start < b_end; )
+	{
+		// Find first body with different layer
+		ObjectLayer object_layer = inBodies[*b_start].mObjectLayer;
+		TaggedVector<uint32>::const_iterator b_mid = upper_bound(b_start, b_end, object_layer, [&inBodies](ObjectLayer inLayer, uint32 inBody) { return inLayer < inBodies[inBody].mObjectLayer; });
+
+		// Calculate the world space bounds in the same way as the Body does
+		bounds.clear();
+		for (TaggedVector<uint32>::const_iterator b = b_start; b < b_mid; ++b)
+		{
+			const BodyCreationSettings &settings = inBodies[*b];
+			const Shape *shape = settings.GetShape();
+			Vec3 center_of_mass = settings.mPosition + settings.mRotation * shape->GetCenterOfMass();
+			bounds.push_back(shape->GetWorldSpaceBounds(Mat44::sRotationTranslation(settings.mRotation, center_of_mass), Vec3::sReplicate(1.0f)));
+		}
+
+		// Build the tree
+		PhysicsScene::StaticBodyTree &tree = outTrees.emplace_back();
+		tree.mBodies.assign(b_start, b_mid);
+		tree.mLayout.Build(bounds.data(), (uint)bounds.size());
+		tree.mObjectLayer = object_layer;
+
+		// Repeat
+		b_start = b_mid;
+	}
+}
+
+void PhysicsScene::BuildStaticBodyTrees()
+{
+	sBuildStaticBodyTrees(mBodies, mStaticBodyTrees);
+}
+
 bool PhysicsScene::CreateBodies(PhysicsSystem *inSystem) const
 {
 	BodyInterface &bi = inSystem->GetBodyInterface();
@@ -70,10 +115,43 @@ bool PhysicsScene::CreateBodies(PhysicsSystem *inSystem) const
 		body_ids.push_back(body->GetID());
 	}
 
-	// Batch add bodies
-	BodyIDVector temp_body_ids = body_ids; // Body ID's get shuffled by AddBodiesPrepare
-	BodyInterface::AddState add_state = bi.AddBodiesPrepare(temp_body_ids.data(), (int)temp_body_ids.size());
-	bi.AddBodiesFinalize(temp_body_ids.data(), (int)temp_body_ids.size(), add_state, EActivation::Activate);
+	// Add the bodies for which a broadphase tree has been built in advance
+	TaggedVector<bool> body_added(body_ids.size(), false);
+	BodyIDVector temp_body_ids;
+	for (const StaticBodyTree &tree : mStaticBodyTrees)
+	{
+		// Check that all bodies in the tree have been created, have not been added by another tree and are still static bodies in the layer that the tree was built for
+		bool valid = !tree.mBodies.empty() && tree.mLayout.mNumBodies == (uint32)tree.mBodies.size();
+		for (uint32 b : tree.mBodies)
+			if (!valid || b >= body_ids.size() || body_added[b]
+				|| mBodies[b].mMotionType != EMotionType::Static || mBodies[b].mObjectLayer != tree.mObjectLayer)
+			{
+				valid = false;
+				break;
+			}
+		if (!valid)
+			continue;
+
+		temp_body_ids.clear();
+		for (uint32 b : tree.mBodies)
+		{
+			temp_body_ids.push_back(body_ids[b]);
+			body_added[b] = true;
+		}
+		BodyInterface::AddState add_state = bi.AddBodiesPrepare(temp_body_ids.data(), (int)temp_body_ids.size(), tree.mLayout);
+		bi.AddBodiesFinalize(temp_body_ids.data(), (int)temp_body_ids.size(), add_state, EActivation::DontActivate);
+	}
+
+	// Batch add the remaining bodies
+	temp_body_ids.clear();
+	for (size_t b = 0; b < body_ids.size(); ++b)
+		if (!body_added[b])
+			temp_body_ids.push_back(body_ids[b]); // Body ID's get shuffled by AddBodiesPrepare
+	if (!temp_body_ids.empty())
+	{
+		BodyInterface::AddState add_state = bi.AddBodiesPrepare(temp_body_ids.data(), (int)temp_body_ids.size());
+		bi.AddBodiesFinalize(temp_body_ids.data(), (int)temp_body_ids.size(), add_state, EActivation::Activate);
+	}
 
 	// If not all bodies are created, creating constraints will be unreliable
 	if (body_ids.size() != mBodies.size())
@@ -92,7 +170,7 @@ bool PhysicsScene::CreateBodies(PhysicsSystem *inSystem) const
 	return true;
 }
 
-void PhysicsScene::SaveBinaryState(StreamOut &inStream, bool inSaveShapes, bool inSaveGroupFilter) const
+void PhysicsScene::SaveBinaryState(StreamOut &inStream, bool inSaveShapes, bool inSaveGroupFilter, bool inSaveStaticBodyTrees) const
 {
 	BodyCreationSettings::ShapeToIDMap shape_to_id;
 	BodyCreationSettings::MaterialToIDMap material_to_id;
@@ -111,6 +189,25 @@ void PhysicsScene::SaveBinaryState(StreamOut &inStream, bool inSaveShapes, bool
 		inStream.Write(cc.mBody1);
 		inStream.Write(cc.mBody2);
 	}
+
+	// Save broadphase trees
+	if (inSaveStaticBodyTrees)
+	{
+		TaggedVector<StaticBodyTree> built_trees;
+		if (mStaticBodyTrees.empty())
+			sBuildStaticBodyTrees(mBodies, built_trees);
+		const TaggedVector<StaticBodyTree> &trees = mStaticBodyTrees.empty()? built_trees : mStaticBodyTrees;
+
+		inStream.Write((uint32)trees.size());
+		for (const StaticBodyTree &tree : trees)
+		{
+			inStream.Write(tree.mBodies);
+			inStream.Write(tree.mObjectLayer);
+			tree.mLayout.SaveBinaryState(inStream);
+		}
+	}
+	else
+		inStream.Write(uint32(0));
 }
 
 PhysicsScene::PhysicsSceneResult PhysicsScene::sRestoreFromBinaryState(StreamIn &inStream)
@@ -162,6 +259,27 @@ PhysicsScene::PhysicsSceneResult PhysicsScene::sRestoreFromBinaryState(StreamIn
 		inStream.Read(cc.mBody2);
 	}
 
+	// Read broadphase trees
+	len = 0;
+	inStream.Read(len);
+	scene->mStaticBodyTrees.resize(len);
+	for (StaticBodyTree &tree : scene->mStaticBodyTrees)
+	{
+		inStream.Read(tree.mBodies);
+		inStream.Read(tree.mObjectLayer);
+		tree.mLayout.RestoreBinaryState(inStream);
+
+		// Validate the tree
+		bool valid = tree.mLayout.mNumBodies == (uint32)tree.mBodies.size() && tree.mLayout.IsValid();
+		for (uint32 b : tree.mBodies)
+			valid &= b < (uint32)scene->mBodies.size();
+		if (!valid || inStream.IsFailed())
+		{
+			result.SetError("Invalid broadphase tree");
+			return result;
+		}
+	}
+
 	result.Set(scene);
 	return result;
 }
@@ -169,7 +287,7 @@ PhysicsScene::PhysicsSceneResult PhysicsScene::sRestoreFromBinaryState(StreamIn
 void PhysicsScene::FromPhysicsSystem(const PhysicsSystem *inSystem)
 {
 	// This map will track where each body went in mBodies
-	using BodyIDToIdxMap = unordered_map<BodyID, uint32>;
+	using BodyIDToIdxMap = TaggedUnorderedMap<BodyID, uint32>;
 	BodyIDToIdxMap body_id_to_idx;
 
 	// Map invalid ID
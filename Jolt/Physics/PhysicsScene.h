@@ -6,6 +6,7 @@
 #include <Jolt/Core/Reference.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Constraints/TwoBodyConstraint.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseTreeLayout.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -15,6 +16,8 @@ class PhysicsSystem;
 class PhysicsScene : public RefTarget<PhysicsScene>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	JPH_DECLARE_SERIALIZABLE_NON_VIRTUAL(PhysicsScene)
 
 	/// Add a body to the scene
@@ -33,8 +36,8 @@ public:
 	size_t									GetNumBodies() const							{ return mBodies.size(); }
 
 	/// Access to the body settings for this scene
-	const vector<BodyCreationSettings> &	GetBodies() const								{ return mBodies; }
-	vector<BodyCreationSettings> &			GetBodies()										{ return mBodies; }
+	const TaggedVector<BodyCreationSettings> &	GetBodies() const								{ return mBodies; }
+	TaggedVector<BodyCreationSettings> &		GetBodies()										{ return mBodies; }
 
 	/// A constraint and how it is connected to the bodies in the scene
 	class ConnectedConstraint
@@ -54,8 +57,26 @@ public:
 	size_t									GetNumConstraints() const						{ return mConstraints.size(); }
 
 	/// Access to the constraints for this scene
-	const vector<ConnectedConstraint> &		GetConstraints() const							{ return mConstraints; }
-	vector<ConnectedConstraint> &			GetConstraints()								{ return mConstraints; }
+	const TaggedVector<ConnectedConstraint> &	GetConstraints() const							{ return mConstraints; }
+	TaggedVector<ConnectedConstraint> &			GetConstraints()								{ return mConstraints; }
+
+	/// Broadphase tree that has been built in advance for the static bodies in an object layer
+	class StaticBodyTree
+	{
+	public:
+		TaggedVector<uint32>				mBodies;										///< Indices in mBodies of the bodies in the tree, in the order that the layout was built for
+		BroadPhaseTreeLayout				mLayout;										///< Structure of the tree
+		ObjectLayer							mObjectLayer = cObjectLayerInvalid;				///< Object layer of the bodies when the tree was built
+	};
+
+	/// Build the broadphase trees for the static bodies in advance (one per object layer), CreateBodies will insert these trees directly into the broadphase
+	/// so that the broadphase doesn't need to build them and PhysicsSystem::OptimizeBroadPhase doesn't need to be called for the static bodies.
+	/// Note that when bodies are moved afterwards the trees remain usable but they may no longer be optimal. When a body in a tree is no longer static
+	/// or has moved to another object layer, CreateBodies ignores the tree and adds its bodies in the normal way.
+	void									BuildStaticBodyTrees();
+
+	/// Access to the prebuilt broadphase trees for this scene
+	const TaggedVector<StaticBodyTree> &	GetStaticBodyTrees() const						{ return mStaticBodyTrees; }
 
 	/// Instantiate all bodies, returns false if not all bodies could be created
 	bool									CreateBodies(PhysicsSystem *inSystem) const;
@@ -68,7 +89,8 @@ public:
 	/// @param inStream The stream to save the state to
 	/// @param inSaveShapes If the shapes should be saved as well (these could be shared between physics scenes, in which case the calling application may want to write custom code to restore them)
 	/// @param inSaveGroupFilter If the group filter should be saved as well (these could be shared)
-	void									SaveBinaryState(StreamOut &inStream, bool inSaveShapes, bool inSaveGroupFilter) const;
+	/// @param inSaveStaticBodyTrees If the prebuilt broadphase trees for the static bodies should be saved as well (they're built if BuildStaticBodyTrees hasn't been called)
+	void									SaveBinaryState(StreamOut &inStream, bool inSaveShapes, bool inSaveGroupFilter, bool inSaveStaticBodyTrees = false) const;
 
 	using PhysicsSceneResult = Result<Ref<PhysicsScene>>;
 
@@ -80,10 +102,13 @@ public:
 
 private:
 	/// The bodies that are part of this scene
-	vector<BodyCreationSettings>			mBodies;
+	TaggedVector<BodyCreationSettings>		mBodies;
 
 	/// Constraints that are part of this scene
-	vector<ConnectedConstraint>				mConstraints;
+	TaggedVector<ConnectedConstraint>		mConstraints;
+
+	/// Prebuilt broadphase trees for the static bodies, see BuildStaticBodyTrees
+	TaggedVector<StaticBodyTree>			mStaticBodyTrees;
 };
 
 JPH_NAMESPACE_END
@@ -43,6 +43,23 @@ struct PhysicsSettings
 	/// step which may not be the actual closest points by the time the two objects hit (unit: meters)
 	float		mSpeculativeContactDistance = 0.02f;
 
+	/// Distance by which the bounding boxes of moving bodies are enlarged in the broadphase (unit: meters).
+	/// The broadphase only needs to be modified when a body moves outside of its enlarged bounding box, so this reduces the amount of broadphase updates
+	/// at the cost of finding more body pairs that don't actually overlap (these are rejected before the narrow phase). See also mBroadPhaseBoundsPredictionTime.
+	float		mBroadPhaseBoundsMargin = 0.0f;
+
+	/// When a body leaves its enlarged bounding box in the broadphase, the new bounding box is also extended by the distance the body travels in this amount of time at its current linear velocity (unit: seconds)
+	float		mBroadPhaseBoundsPredictionTime = 0.0f;
+
+	/// Amount of time the broadphase may spend per collision step on rebuilding its trees (unit: seconds).
+	/// The rebuild happens in a background job that runs in parallel with collision detection. When this is 0 at most 1 tree is rebuilt per step.
+	/// Increasing this allows PhysicsSystem::OptimizeBroadPhaseInBackground to finish in fewer steps.
+	float		mBroadPhaseUpdateTimeBudget = 0.0f;
+
+	/// Every this many steps, bodies that fell asleep are moved to a separate broadphase tree per layer that is only rebuilt when bodies are moved into it (0 means never).
+	/// Bodies that wake up are moved back at the start of the next step. This keeps the trees that are updated every step proportional to the number of active bodies.
+	int			mBroadPhaseDormantInterval = 0;
+
 	/// How much bodies are allowed to sink into eachother (unit: meters)
 	float		mPenetrationSlop = 0.02f;
 
@@ -86,6 +103,37 @@ struct PhysicsSettings
 	/// Velocity of points on bounding box of object below which an object can be considered sleeping (unit: m/s)
 	float		mPointVelocitySleepThreshold = 0.03f;
 
+	/// Keep the jobs of an update alive and reset them in the next update instead of building a new job graph every update.
+	/// The job graph is rebuilt when the amount of jobs changes (e.g. because the number of active bodies changes a lot or the job system is swapped).
+	/// Note that the cached jobs stay allocated in the JobSystem, so the JobSystem needs to outlive the PhysicsSystem (or PhysicsSystem::ReleaseCachedJobGraph needs to be called first).
+	bool		mCacheJobGraph = false;
+
+	/// Split islands with many constraints and contacts into batches that can be solved by multiple jobs (see LargeIslandSplitter).
+	/// Split islands always run mNumVelocitySteps / mNumPositionSteps iterations (they don't stop early when no impulses are applied).
+	/// Off by default because split islands are solved in a different order, which changes the simulation results.
+	bool		mUseLargeIslandSplitter = false;
+
+	/// Solve contact constraints between dynamic bodies that don't share a body in batches of 4 (8 with AVX2) using SIMD.
+	/// Consecutive contact constraints are only batched when they don't touch the same body, so the order in which impulses are applied is unchanged.
+	/// Batches are only found when mUseLargeIslandSplitter is on, because the splitter orders constraints so that consecutive ones don't share bodies.
+	/// Off by default because it changes the rounding of the results and the velocities are gathered into and scattered out of SIMD registers in every iteration.
+	bool		mUseBatchedContactSolver = false;
+
+	/// Apply gravity and integrate velocities of batches of bodies using SIMD, 4 bodies at a time, on a structure of arrays copy of their state (see BodyStateSoA).
+	/// The results are close to but not bit exact with integrating the bodies one by one.
+	bool		mUseVectorizedIntegration = false;
+
+	/// Keep the links between bodies that form the simulation islands from one step to the next instead of rebuilding the islands every step.
+	/// Bodies that stay in contact then don't need to be linked again. The islands are rebuilt in the next step when a contact between two dynamic bodies is removed,
+	/// when a constraint is disabled or removed, when some of the bodies in an island want to go to sleep or when a body is deactivated or removed.
+	/// Note that the islands are not part of the saved state (see PhysicsSystem::SaveState), so a restored simulation can deviate when this is turned on.
+	bool		mUsePersistentIslands = false;
+
+	/// Every this many steps the active bodies are reordered along a Morton curve through the centers of their bounds (0 means never).
+	/// The collision detection jobs take consecutive batches of active bodies, so this makes each job work on bodies that are close to each
+	/// other which means they touch the same parts of the broadphase tree and contact cache. Note that this invalidates the persistent islands.
+	int			mSortActiveBodiesInterval = 0;
+
 	///@name These variables are mainly for debugging purposes, they allow turning on/off certain subsystems. You probably want to leave them alone.
 	///@{
 
@@ -7,8 +7,10 @@
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsUpdateContext.h>
 #include <Jolt/Physics/PhysicsStepListener.h>
+#include <Jolt/Physics/Body/BodyStateSoA.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBruteForce.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuadTree.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseSAP.h>
 #include <Jolt/Physics/Collision/CollisionDispatch.h>
 #include <Jolt/Physics/Collision/AABoxCast.h>
 #include <Jolt/Physics/Collision/ShapeCast.h>
@@ -21,8 +23,13 @@
 #include <Jolt/Physics/Constraints/ConstraintPart/AxisConstraintPart.h>
 #include <Jolt/Geometry/RayAABox.h>
 #include <Jolt/Core/JobSystem.h>
+#include <Jolt/Core/ScratchArena.h>
 #include <Jolt/Core/TempAllocator.h>
 
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
 JPH_NAMESPACE_BEGIN
 
 #ifdef JPH_DEBUG_RENDERER
@@ -52,14 +59,18 @@ static const Color cColorSolvePositionConstraints = Color::sGetDistinctColor(17)
 static const Color cColorStartNextSubStep = Color::sGetDistinctColor(18);
 static const Color cColorFindCCDContacts = Color::sGetDistinctColor(19);
 static const Color cColorStepListeners = Color::sGetDistinctColor(20);
+static const Color cColorUpdateDone = Color::sGetDistinctColor(21);
 
 PhysicsSystem::~PhysicsSystem()
 {
+	// Release jobs that we kept alive
+	ReleaseCachedJobGraph();
+
 	// Remove broadphase
 	delete mBroadPhase;
 }
 
-void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter)
+void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter, EBroadPhaseType inBroadPhaseType)
 { 
 	mObjectVsBroadPhaseLayerFilter = inObjectVsBroadPhaseLayerFilter;
 	mObjectLayerPairFilter = inObjectLayerPairFilter;
@@ -68,8 +79,13 @@ void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBody
 	mBodyManager.Init(inMaxBodies, inNumBodyMutexes, inBroadPhaseLayerInterface); 
 
 	// Create broadphase
-	mBroadPhase = new BROAD_PHASE();
+	if (inBroadPhaseType == EBroadPhaseType::SweepAndPrune)
+		mBroadPhase = new BroadPhaseSAP();
+	else
+		mBroadPhase = new BROAD_PHASE();
 	mBroadPhase->Init(&mBodyManager, inBroadPhaseLayerInterface);
+	mBroadPhase->SetBodyBoundsMargin(mPhysicsSettings.mBroadPhaseBoundsMargin, mPhysicsSettings.mBroadPhaseBoundsPredictionTime);
+	mBroadPhase->SetUpdateTimeBudget(mPhysicsSettings.mBroadPhaseUpdateTimeBudget);
 
 	// Init contact constraint manager
 	mContactManager.Init(inMaxBodyPairs, inMaxContactConstraints);
@@ -86,11 +102,28 @@ void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBody
 	mNarrowPhaseQueryNoLock.Init(mBodyLockInterfaceNoLock, *mBroadPhase);
 }
 
+void PhysicsSystem::SetPhysicsSettings(const PhysicsSettings &inSettings)
+{
+	mPhysicsSettings = inSettings;
+
+	// Pass on the settings that the broadphase needs
+	if (mBroadPhase != nullptr)
+	{
+		mBroadPhase->SetBodyBoundsMargin(mPhysicsSettings.mBroadPhaseBoundsMargin, mPhysicsSettings.mBroadPhaseBoundsPredictionTime);
+		mBroadPhase->SetUpdateTimeBudget(mPhysicsSettings.mBroadPhaseUpdateTimeBudget);
+	}
+}
+
 void PhysicsSystem::OptimizeBroadPhase()
 {
 	mBroadPhase->Optimize();
 }
 
+void PhysicsSystem::OptimizeBroadPhaseInBackground()
+{
+	mBroadPhase->OptimizeInBackground();
+}
+
 void PhysicsSystem::AddStepListener(PhysicsStepListener *inListener)
 {
 	lock_guard lock(mStepListenersMutex);
@@ -109,9 +142,16 @@ void PhysicsSystem::RemoveStepListener(PhysicsStepListener *inListener)
 }
 
 void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem)
+{
+	PhysicsUpdateHandle handle = StartUpdate(inDeltaTime, inCollisionSteps, inIntegrationSubSteps, inTempAllocator, inJobSystem);
+	WaitForUpdate(handle);
+}
+
+PhysicsUpdateHandle PhysicsSystem::StartUpdate(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem)
 {	
 	JPH_PROFILE_FUNCTION();
 
+	JPH_ASSERT(mUpdateContext == nullptr, "Previous update is still in flight, call WaitForUpdate first");
 	JPH_ASSERT(inDeltaTime >= 0.0f);
 	JPH_ASSERT(inIntegrationSubSteps <= PhysicsUpdateContext::cMaxSubSteps);
 
@@ -131,11 +171,11 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 		mBroadPhase->UnlockModifications();
 
 		// Call contact removal callbacks from contacts that existed in the previous update
-		mContactManager.ContactPointRemovedCallbacks();
+		mContactManager.ContactPointRemovedCallbacks(false);
 		mContactManager.FinalizeContactCache(0, 0);
 
 		mBodyManager.UnlockAllBodies();
-		return;
+		return PhysicsUpdateHandle();
 	}
 
 	// Calculate ratio between current and previous frame delta time to scale initial constraint forces
@@ -143,28 +183,30 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 	float warm_start_impulse_ratio = mPhysicsSettings.mConstraintWarmStart && mPreviousSubStepDeltaTime > 0.0f? sub_step_delta_time / mPreviousSubStepDeltaTime : 0.0f;
 	mPreviousSubStepDeltaTime = sub_step_delta_time;
 
-	// Create the context used for passing information between jobs
-	PhysicsUpdateContext context(*inTempAllocator);
-	context.mPhysicsSystem = this;
-	context.mJobSystem = inJobSystem;
-	context.mBarrier = inJobSystem->CreateBarrier();
-	context.mIslandBuilder = &mIslandBuilder;
-	context.mStepDeltaTime = inDeltaTime / inCollisionSteps;
-	context.mSubStepDeltaTime = sub_step_delta_time;
-	context.mWarmStartImpulseRatio = warm_start_impulse_ratio;
-	context.mSteps.resize(inCollisionSteps);
-
-	// Allocate space for body pairs
-	JPH_ASSERT(context.mBodyPairs == nullptr);
-	context.mBodyPairs = static_cast<BodyPair *>(inTempAllocator->Allocate(sizeof(BodyPair) * mPhysicsSettings.mMaxInFlightBodyPairs));
-
 	// Lock all bodies for write so that we can freely touch them
 	mStepListenersMutex.lock();
 	mBodyManager.LockAllBodies();
 	mBroadPhase->LockModifications();
 
+	// Periodically reorder the active bodies so that the collision detection jobs work on spatially coherent batches
+	if (mPhysicsSettings.mSortActiveBodiesInterval > 0
+		&& ++mStepsSinceActiveBodiesSorted >= mPhysicsSettings.mSortActiveBodiesInterval)
+	{
+		mBodyManager.SortActiveBodiesSpatially(inTempAllocator);
+		mStepsSinceActiveBodiesSorted = 0;
+	}
+
+	// Move bodies that woke up out of the broadphase trees for sleeping bodies and periodically move the bodies that fell asleep into them
+	if (mPhysicsSettings.mBroadPhaseDormantInterval > 0)
+	{
+		bool move_sleeping_bodies = ++mStepsSinceDormantBodiesMoved >= mPhysicsSettings.mBroadPhaseDormantInterval;
+		if (move_sleeping_bodies)
+			mStepsSinceDormantBodiesMoved = 0;
+		mBroadPhase->UpdateDormantBodies(move_sleeping_bodies);
+	}
+
 	// Get max number of concurrent jobs
-	int max_concurrency = context.GetMaxConcurrency(); 
+	int max_concurrency = min((int)PhysicsUpdateContext::cMaxConcurrency, inJobSystem->GetMaxConcurrency());
 
 	// Calculate how many step listener jobs we spawn
 	int num_step_listener_jobs = mStepListeners.empty()? 0 : max(1, min((int)mStepListeners.size() / mPhysicsSettings.mStepListenersBatchSize / mPhysicsSettings.mStepListenerBatchesPerJob, max_concurrency));
@@ -184,9 +226,96 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 	// Number of integrate velocity jobs depends on number of active bodies.
 	int num_integrate_velocity_jobs = max(1, min(((int)num_active_bodies + cIntegrateVelocityBatchSize - 1) / cIntegrateVelocityBatchSize, max_concurrency));
 
+	// Determine the layout of the job graph
+	PhysicsUpdateContext::JobGraphLayout layout;
+	layout.mJobSystem = inJobSystem;
+	layout.mNumCollisionSteps = inCollisionSteps;
+	layout.mNumIntegrationSubSteps = inIntegrationSubSteps;
+	layout.mMaxConcurrency = max_concurrency;
+	layout.mNumStepListenerJobs = num_step_listener_jobs;
+	layout.mNumApplyGravityJobs = num_apply_gravity_jobs;
+	layout.mNumDetermineActiveConstraintsJobs = num_determine_active_constraints_jobs;
+	layout.mNumFindCollisionsJobs = num_find_collisions_jobs;
+	layout.mNumIntegrateVelocityJobs = num_integrate_velocity_jobs;
+
+	// The cached job graph can only be reused when it has the same layout and when the job system no longer references its jobs
+	// (a job that was executed by the barrier can e.g. still be in the queue of a worker thread, after resetting the job that thread could run it again)
+	bool cache_job_graph = mPhysicsSettings.mCacheJobGraph;
+	if (mCachedJobGraph != nullptr && (!cache_job_graph || mCachedJobGraph->mJobGraphLayout != layout || !mCachedJobGraph->CanResetCachedJobs()))
+		ReleaseCachedJobGraph();
+
+	// Check if we need to build the jobs
+	bool build_jobs = true;
+	if (cache_job_graph)
+	{
+		if (mCachedJobGraph == nullptr)
+		{
+			mCachedJobGraph = new PhysicsUpdateContext(mCachedJobGraphAllocator);
+			mCachedJobGraph->mJobGraphLayout = layout;
+		}
+		else
+			build_jobs = false;
+	}
+
+	// Create the context used for passing information between jobs (or take the context of the cached job graph).
+	// The context needs to stay alive until WaitForUpdate so it is allocated from the temp allocator (as first allocation of the update so it is freed last).
+	if (cache_job_graph)
+		mUpdateContext = mCachedJobGraph;
+	else
+		mUpdateContext = new (inTempAllocator->Allocate(sizeof(PhysicsUpdateContext))) PhysicsUpdateContext(*inTempAllocator);
+	PhysicsUpdateContext &context = *mUpdateContext;
+	context.mPhysicsSystem = this;
+	context.mTempAllocator = inTempAllocator;
+	context.mJobSystem = inJobSystem;
+	context.mBarrier = inJobSystem->CreateBarrier();
+	context.mIslandBuilder = &mIslandBuilder;
+	context.mStepDeltaTime = inDeltaTime / inCollisionSteps;
+	context.mSubStepDeltaTime = sub_step_delta_time;
+	context.mWarmStartImpulseRatio = warm_start_impulse_ratio;
+	if (build_jobs)
+		context.mSteps.resize(inCollisionSteps);
+
+	// Allocate space for body pairs
+	JPH_ASSERT(context.mBodyPairs == nullptr);
+	context.mBodyPairs = static_cast<BodyPair *>(inTempAllocator->Allocate(sizeof(BodyPair) * mPhysicsSettings.mMaxInFlightBodyPairs));
+
+#ifdef JPH_ENABLE_ASSERTS
+	// Don't allow write operations to the active bodies list
+	mBodyManager.SetActiveBodiesLocked(true);
+#endif
+
+	// Store the number of active bodies at the start of the first step
+	context.mSteps[0].mNumActiveBodiesAtStepStart = mBodyManager.GetNumActiveBodies();
+
+	// Lock all constraints
+	mConstraintManager.LockAllConstraints();
+
+	// Allocate memory for storing the active constraints
+	JPH_ASSERT(context.mActiveConstraints == nullptr);
+	context.mActiveConstraints = static_cast<Constraint **>(inTempAllocator->Allocate(mConstraintManager.GetNumConstraints() * sizeof(Constraint *)));
+
+	// Prepare contact buffer
+	mContactManager.PrepareConstraintBuffer(&context);
+
+	// Setup island builder
+	mIslandBuilder.PrepareBodyLinks(mBodyManager.GetActiveBodiesUnsafe(), mBodyManager.GetNumActiveBodies(), mPhysicsSettings.mUsePersistentIslands);
+	mIslandBuilder.PrepareContactConstraints(mContactManager.GetMaxConstraints(), context.mTempAllocator);
+
+	if (build_jobs)
 	{
 		JPH_PROFILE("Build Jobs");
 
+		// When caching the job graph, every job gets an extra dependency so that nothing starts while we're building.
+		// This allows us to record how many dependencies each job has when the graph is complete.
+		uint32 hold_dependency = cache_job_graph? 1 : 0;
+		auto create_job = [inJobSystem, &context, hold_dependency](const char *inName, ColorArg inColor, const JobSystem::JobFunction &inJobFunction, uint32 inNumDependencies)
+		{
+			JobHandle job = inJobSystem->CreateJob(inName, inColor, inJobFunction, inNumDependencies + hold_dependency);
+			if (hold_dependency > 0)
+				context.mCachedJobs.push_back(job);
+			return job;
+		};
+
 		// Iterate over collision steps
 		for (int step_idx = 0; step_idx < inCollisionSteps; ++step_idx)
 		{
@@ -199,7 +328,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 
 			// Create job to do broadphase finalization
 			// This job must finish before integrating velocities. Until then the positions will not be updated neither will bodies be added / removed.
-			step.mUpdateBroadphaseFinalize = inJobSystem->CreateJob("UpdateBroadPhaseFinalize", cColorUpdateBroadPhaseFinalize, [&context, &step]() 
+			step.mUpdateBroadphaseFinalize = create_job("UpdateBroadPhaseFinalize", cColorUpdateBroadPhaseFinalize, [&context, &step]() 
 				{ 
 					// Validate that all find collision jobs have stopped
 					JPH_ASSERT(step.mActiveFindCollisionJobs == 0);
@@ -217,7 +346,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 			// Start job immediately: Start the prepare broadphase
 			// Must be done under body lock protection since the order is body locks then broadphase mutex
 			// If this is turned around the RemoveBody call will hang since it locks in that order
-			step.mBroadPhasePrepare = inJobSystem->CreateJob("UpdateBroadPhasePrepare", cColorUpdateBroadPhasePrepare, [&context, &step]() 
+			step.mBroadPhasePrepare = create_job("UpdateBroadPhasePrepare", cColorUpdateBroadPhasePrepare, [&context, &step]() 
 				{ 
 					// Prepare the broadphase update
 					step.mBroadPhaseUpdateState = context.mPhysicsSystem->mBroadPhase->UpdatePrepare();
@@ -233,40 +362,16 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 			step.mFindCollisions.resize(num_find_collisions_jobs);
 			for (int i = 0; i < num_find_collisions_jobs; ++i)
 			{
-				step.mFindCollisions[i] = inJobSystem->CreateJob("FindCollisions", cColorFindCollisions, [&step, i]() 
+				step.mFindCollisions[i] = create_job("FindCollisions", cColorFindCollisions, [&step, i]() 
 					{ 
 						step.mContext->mPhysicsSystem->JobFindCollisions(&step, i); 
 					}, num_apply_gravity_jobs + num_determine_active_constraints_jobs + 1); // depends on: apply gravity, determine active constraints, finish building jobs
 			}
 
-			if (is_first_step)
-			{
-			#ifdef JPH_ENABLE_ASSERTS
-				// Don't allow write operations to the active bodies list
-				mBodyManager.SetActiveBodiesLocked(true);
-			#endif
-
-				// Store the number of active bodies at the start of the step
-				step.mNumActiveBodiesAtStepStart = mBodyManager.GetNumActiveBodies();
-
-				// Lock all constraints
-				mConstraintManager.LockAllConstraints();
-
-				// Allocate memory for storing the active constraints
-				JPH_ASSERT(context.mActiveConstraints == nullptr);
-				context.mActiveConstraints = static_cast<Constraint **>(inTempAllocator->Allocate(mConstraintManager.GetNumConstraints() * sizeof(Constraint *)));
-
-				// Prepare contact buffer
-				mContactManager.PrepareConstraintBuffer(&context);
-
-				// Setup island builder
-				mIslandBuilder.PrepareContactConstraints(mContactManager.GetMaxConstraints(), context.mTempAllocator);
-			}
-
 			// This job applies gravity to all active bodies
 			step.mApplyGravity.resize(num_apply_gravity_jobs);
 			for (int i = 0; i < num_apply_gravity_jobs; ++i)
-				step.mApplyGravity[i] = inJobSystem->CreateJob("ApplyGravity", cColorApplyGravity, [&context, &step]() 
+				step.mApplyGravity[i] = create_job("ApplyGravity", cColorApplyGravity, [&context, &step]() 
 					{ 
 						context.mPhysicsSystem->JobApplyGravity(&context, &step); 
 
@@ -274,7 +379,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 					}, num_step_listener_jobs > 0? num_step_listener_jobs : previous_step_dependency_count); // depends on: step listeners (or previous step if no step listeners)
 	
 			// This job will setup velocity constraints for non-collision constraints
-			step.mSetupVelocityConstraints = inJobSystem->CreateJob("SetupVelocityConstraints", cColorSetupVelocityConstraints, [&context, &step]() 
+			step.mSetupVelocityConstraints = create_job("SetupVelocityConstraints", cColorSetupVelocityConstraints, [&context, &step]() 
 				{ 
 					context.mPhysicsSystem->JobSetupVelocityConstraints(context.mSubStepDeltaTime, &step);
 
@@ -282,17 +387,17 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				}, num_determine_active_constraints_jobs + 1); // depends on: determine active constraints, finish building jobs
 
 			// This job will build islands from constraints
-			step.mBuildIslandsFromConstraints = inJobSystem->CreateJob("BuildIslandsFromConstraints", cColorBuildIslandsFromConstraints, [&context, &step]() 
+			step.mBuildIslandsFromConstraints = create_job("BuildIslandsFromConstraints", cColorBuildIslandsFromConstraints, [&context, &step]() 
 				{ 
 					context.mPhysicsSystem->JobBuildIslandsFromConstraints(&context, &step);
 
-					step.mFinalizeIslands.RemoveDependency(); 
+					step.mFinalizeIslands.RemoveDependency();
 				}, num_determine_active_constraints_jobs + 1); // depends on: determine active constraints, finish building jobs
 
 			// This job determines active constraints
 			step.mDetermineActiveConstraints.resize(num_determine_active_constraints_jobs);
 			for (int i = 0; i < num_determine_active_constraints_jobs; ++i)
-				step.mDetermineActiveConstraints[i] = inJobSystem->CreateJob("DetermineActiveConstraints", cColorDetermineActiveConstraints, [&context, &step]() 
+				step.mDetermineActiveConstraints[i] = create_job("DetermineActiveConstraints", cColorDetermineActiveConstraints, [&context, &step]() 
 					{ 
 						context.mPhysicsSystem->JobDetermineActiveConstraints(&step); 
 
@@ -306,7 +411,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 			// This job calls the step listeners
 			step.mStepListeners.resize(num_step_listener_jobs);
 			for (int i = 0; i < num_step_listener_jobs; ++i)
-				step.mStepListeners[i] = inJobSystem->CreateJob("StepListeners", cColorStepListeners, [&context, &step]()
+				step.mStepListeners[i] = create_job("StepListeners", cColorStepListeners, [&context, &step]()
 					{
 						// Call the step listeners
 						context.mPhysicsSystem->JobStepListeners(&step);
@@ -321,12 +426,12 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				context.mSteps[step_idx - 1].mStartNextStep.RemoveDependency();
 
 			// This job will finalize the simulation islands
-			step.mFinalizeIslands = inJobSystem->CreateJob("FinalizeIslands", cColorFinalizeIslands, [&context, &step]() 
+			step.mFinalizeIslands = create_job("FinalizeIslands", cColorFinalizeIslands, [&context, &step]() 
 				{ 
 					// Validate that all find collision jobs have stopped
 					JPH_ASSERT(step.mActiveFindCollisionJobs == 0);
 
-					context.mPhysicsSystem->JobFinalizeIslands(&context); 
+					context.mPhysicsSystem->JobFinalizeIslands(&step);
 
 					JobHandle::sRemoveDependencies(step.mSubSteps[0].mSolveVelocityConstraints);
 					step.mBodySetIslandIndex.RemoveDependency();
@@ -337,29 +442,27 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 			step.mBuildIslandsFromConstraints.RemoveDependency();
 
 			// This job will call the contact removed callbacks
-			step.mContactRemovedCallbacks = inJobSystem->CreateJob("ContactRemovedCallbacks", cColorContactRemovedCallbacks, [&context, &step]()
+			step.mContactRemovedCallbacks = create_job("ContactRemovedCallbacks", cColorContactRemovedCallbacks, [&context, &step]()
 				{
 					context.mPhysicsSystem->JobContactRemovedCallbacks(&step);
 
-					if (step.mStartNextStep.IsValid())
-						step.mStartNextStep.RemoveDependency();
+					step.mStartNextStep.RemoveDependency();
 				}, 1); // depends on the find ccd contacts of the last sub step
 
 			// This job will set the island index on each body (only used for debug drawing purposes)
 			// It will also delete any bodies that have been destroyed in the last frame
-			step.mBodySetIslandIndex = inJobSystem->CreateJob("BodySetIslandIndex", cColorBodySetIslandIndex, [&context, &step]() 
+			step.mBodySetIslandIndex = create_job("BodySetIslandIndex", cColorBodySetIslandIndex, [&context, &step]() 
 				{ 
 					context.mPhysicsSystem->JobBodySetIslandIndex(); 
 
-					if (step.mStartNextStep.IsValid())
-						step.mStartNextStep.RemoveDependency();
+					step.mStartNextStep.RemoveDependency();
 				}, 1); // depends on: finalize islands
 
 			// Job to start the next collision step
 			if (!is_last_step)
 			{
 				PhysicsUpdateContext::Step *next_step = &context.mSteps[step_idx + 1];
-				step.mStartNextStep = inJobSystem->CreateJob("StartNextStep", cColorStartNextStep, [this, next_step]() 
+				step.mStartNextStep = create_job("StartNextStep", cColorStartNextStep, [this, next_step]() 
 					{ 
 					#ifdef _DEBUG
 						// Validate that the cached bounds are correct
@@ -371,9 +474,11 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 
 						// Clear the island builder
 						TempAllocator *temp_allocator = next_step->mContext->mTempAllocator;
+						mLargeIslandSplitter.Reset(temp_allocator);
 						mIslandBuilder.ResetIslands(temp_allocator);
 
 						// Setup island builder
+						mIslandBuilder.PrepareBodyLinks(mBodyManager.GetActiveBodiesUnsafe(), mBodyManager.GetNumActiveBodies(), mPhysicsSettings.mUsePersistentIslands);
 						mIslandBuilder.PrepareContactConstraints(mContactManager.GetMaxConstraints(), temp_allocator);
 						
 						// Restart the contact manager
@@ -394,6 +499,11 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 						}
 					}, max_concurrency + 3); // depends on: solve position constraints of the last step, body set island index, contact removed callbacks, finish building the previous step
 			}
+			else
+			{
+				// For the last step, this job signals that all other jobs have finished (used to poll if the update is done)
+				step.mStartNextStep = create_job("UpdateDone", cColorUpdateDone, []() { }, max_concurrency + 2); // depends on: solve position constraints of the last step, body set island index, contact removed callbacks
+			}
 
 			// Create solve jobs for each of the integration sub steps
 			for (int sub_step_idx = 0; sub_step_idx < inIntegrationSubSteps; ++sub_step_idx)
@@ -411,7 +521,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				int num_dependencies_solve_velocity_constraints = is_first_sub_step? 3 : 2; // in first sub step depends on: finalize islands, setup velocity constraints, in later sub steps depends on: previous sub step finished. For both: finish building jobs.
 				sub_step.mSolveVelocityConstraints.resize(max_concurrency);
 				for (int i = 0; i < max_concurrency; ++i)
-					sub_step.mSolveVelocityConstraints[i] = inJobSystem->CreateJob("SolveVelocityConstraints", cColorSolveVelocityConstraints, [&context, &sub_step]() 
+					sub_step.mSolveVelocityConstraints[i] = create_job("SolveVelocityConstraints", cColorSolveVelocityConstraints, [&context, &sub_step]() 
 						{ 
 							context.mPhysicsSystem->JobSolveVelocityConstraints(&context, &sub_step); 
 
@@ -435,7 +545,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 
 				// This job will prepare the position update of all active bodies
 				int num_dependencies_integrate_velocity = is_first_sub_step? 2 + max_concurrency : 1 + max_concurrency;  // depends on: broadphase update finalize in first step, solve velocity constraints in all steps. For both: finish building jobs.
-				sub_step.mPreIntegrateVelocity = inJobSystem->CreateJob("PreIntegrateVelocity", cColorPreIntegrateVelocity, [&context, &sub_step]() 
+				sub_step.mPreIntegrateVelocity = create_job("PreIntegrateVelocity", cColorPreIntegrateVelocity, [&context, &sub_step]() 
 					{ 
 						context.mPhysicsSystem->JobPreIntegrateVelocity(&context, &sub_step);
 
@@ -450,7 +560,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				// This job will update the positions of all active bodies
 				sub_step.mIntegrateVelocity.resize(num_integrate_velocity_jobs);
 				for (int i = 0; i < num_integrate_velocity_jobs; ++i)
-					sub_step.mIntegrateVelocity[i] = inJobSystem->CreateJob("IntegrateVelocity", cColorIntegrateVelocity, [&context, &sub_step]() 
+					sub_step.mIntegrateVelocity[i] = create_job("IntegrateVelocity", cColorIntegrateVelocity, [&context, &sub_step]() 
 						{ 
 							context.mPhysicsSystem->JobIntegrateVelocity(&context, &sub_step);
 
@@ -461,7 +571,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				sub_step.mPreIntegrateVelocity.RemoveDependency();
 
 				// This job will finish the position update of all active bodies
-				sub_step.mPostIntegrateVelocity = inJobSystem->CreateJob("PostIntegrateVelocity", cColorPostIntegrateVelocity, [&context, &sub_step]() 
+				sub_step.mPostIntegrateVelocity = create_job("PostIntegrateVelocity", cColorPostIntegrateVelocity, [&context, &sub_step]() 
 					{ 
 						context.mPhysicsSystem->JobPostIntegrateVelocity(&context, &sub_step);
 
@@ -472,7 +582,7 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				JobHandle::sRemoveDependencies(sub_step.mIntegrateVelocity);
 
 				// This job will update the positions and velocities for all bodies that need continuous collision detection
-				sub_step.mResolveCCDContacts = inJobSystem->CreateJob("ResolveCCDContacts", cColorResolveCCDContacts, [&context, &sub_step]()
+				sub_step.mResolveCCDContacts = create_job("ResolveCCDContacts", cColorResolveCCDContacts, [&context, &sub_step]()
 					{
 						context.mPhysicsSystem->JobResolveCCDContacts(&context, &sub_step);
 
@@ -485,13 +595,12 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				// Fixes up drift in positions and updates the broadphase with new body positions
 				sub_step.mSolvePositionConstraints.resize(max_concurrency);
 				for (int i = 0; i < max_concurrency; ++i)
-					sub_step.mSolvePositionConstraints[i] = inJobSystem->CreateJob("SolvePositionConstraints", cColorSolvePositionConstraints, [&context, &sub_step]() 
+					sub_step.mSolvePositionConstraints[i] = create_job("SolvePositionConstraints", cColorSolvePositionConstraints, [&context, &sub_step]() 
 						{ 
 							context.mPhysicsSystem->JobSolvePositionConstraints(&context, &sub_step); 
 			
 							// Kick the next sub step
-							if (sub_step.mStartNextSubStep.IsValid())
-								sub_step.mStartNextSubStep.RemoveDependency();
+							sub_step.mStartNextSubStep.RemoveDependency();
 						}, 2); // depends on: resolve ccd contacts, finish building jobs.
 
 				// Unblock previous job.
@@ -501,8 +610,11 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				if (!is_last_sub_step)
 				{
 					PhysicsUpdateContext::SubStep &next_sub_step = step.mSubSteps[sub_step_idx + 1];
-					sub_step.mStartNextSubStep = inJobSystem->CreateJob("StartNextSubStep", cColorStartNextSubStep, [&next_sub_step]() 
+					sub_step.mStartNextSubStep = create_job("StartNextSubStep", cColorStartNextSubStep, [this, &next_sub_step]() 
 						{ 			
+							// All position constraints have been solved, prepare the split islands for solving the velocity constraints
+							mLargeIslandSplitter.ResetStatus();
+
 							// Kick velocity constraint solving for the next sub step
 							JobHandle::sRemoveDependencies(next_sub_step.mSolveVelocityConstraints);
 						}, max_concurrency + 1); // depends on: solve position constraints, finish building jobs.
@@ -515,12 +627,41 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 			}
 		}
 	}
-	
-	// Build the list of jobs to wait for
+	else
+	{
+		JPH_PROFILE("Reset Jobs");
+
+		// Reset the state that the jobs use
+		context.ResetSteps(mPhysicsSettings.mMaxInFlightBodyPairs);
+
+		// Reset the jobs, they will get an extra dependency that we remove below
+		for (size_t i = 0; i < context.mCachedJobs.size(); ++i)
+			context.mCachedJobs[i].Reset(context.mCachedJobInfo[i].mNumDependencies + 1);
+	}
+
 	JobSystem::Barrier *barrier = context.mBarrier;
+	if (cache_job_graph)
+	{
+		JPH_PROFILE("Kick cached jobs");
+
+		// Record the amount of dependencies of each job after building, none of the jobs can have started since they all have an extra dependency.
+		// Since none of the jobs have been queued or added to the barrier yet, the reference count is the amount of handles we hold.
+		if (build_jobs)
+		{
+			context.mCachedJobInfo.reserve(context.mCachedJobs.size());
+			for (const JobHandle &h : context.mCachedJobs)
+				context.mCachedJobInfo.push_back({ h.GetNumDependencies() - 1, h.GetRefCount() });
+		}
+
+		// Wait for all jobs and remove the extra dependency to start them
+		barrier->AddJobs(context.mCachedJobs.data(), (uint)context.mCachedJobs.size());
+		JobHandle::sRemoveDependencies(context.mCachedJobs.data(), (uint)context.mCachedJobs.size());
+	}
+	else
 	{
 		JPH_PROFILE("Build job barrier");
 
+		// Build the list of jobs to wait for
 		StaticArray<JobHandle, cMaxPhysicsJobs> handles;
 		for (const PhysicsUpdateContext::Step &step : context.mSteps)
 		{
@@ -551,23 +692,45 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 				handles.push_back(sub_step.mResolveCCDContacts);
 				for (const JobHandle &h : sub_step.mSolvePositionConstraints)
 					handles.push_back(h);
-				if (sub_step.mStartNextSubStep.IsValid())
-					handles.push_back(sub_step.mStartNextSubStep);
+				handles.push_back(sub_step.mStartNextSubStep);
 			}
 			handles.push_back(step.mContactRemovedCallbacks);
 		}
 		barrier->AddJobs(handles.data(), handles.size());
 	}
 
+	// Return the last job so that the caller can poll if the update is done
+	PhysicsUpdateHandle handle;
+	handle.mUpdateDone = context.mSteps.back().mStartNextStep;
+	return handle;
+}
+
+void PhysicsSystem::WaitForUpdate(PhysicsUpdateHandle &ioHandle)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Check if an update is in flight (StartUpdate doesn't start jobs when there's nothing to simulate)
+	if (!ioHandle.IsValid())
+	{
+		JPH_ASSERT(mUpdateContext == nullptr);
+		return;
+	}
+	JPH_ASSERT(mUpdateContext != nullptr);
+	ioHandle.mUpdateDone = JobHandle();
+
+	PhysicsUpdateContext &context = *mUpdateContext;
+	TempAllocator *temp_allocator = context.mTempAllocator;
+	JobSystem::Barrier *barrier = context.mBarrier;
+
 	// Wait until all jobs finish
 	// Note we don't just wait for the last job. If we would and another job
 	// would be scheduled in between there is the possibility of a deadlock.
 	// The other job could try to e.g. add/remove a body which would try to
 	// lock a body mutex while this thread has already locked the mutex
-	inJobSystem->WaitForJobs(barrier);
+	context.mJobSystem->WaitForJobs(barrier);
 
 	// We're done with the barrier for this update
-	inJobSystem->DestroyBarrier(barrier);
+	context.mJobSystem->DestroyBarrier(barrier);
 
 #ifdef _DEBUG
 	// Validate that the cached bounds are correct
@@ -575,18 +738,27 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 #endif // _DEBUG
 	
 	// Clear the island builder
-	mIslandBuilder.ResetIslands(inTempAllocator);
+	mLargeIslandSplitter.Reset(temp_allocator);
+	mIslandBuilder.ResetIslands(temp_allocator);
 
 	// Clear the contact manager
 	mContactManager.FinishConstraintBuffer();
 
 	// Free active constraints
-	inTempAllocator->Free(context.mActiveConstraints, mConstraintManager.GetNumConstraints() * sizeof(Constraint *));
+	temp_allocator->Free(context.mActiveConstraints, mConstraintManager.GetNumConstraints() * sizeof(Constraint *));
 	context.mActiveConstraints = nullptr;
 
 	// Free body pairs
-	inTempAllocator->Free(context.mBodyPairs, sizeof(BodyPair) * mPhysicsSettings.mMaxInFlightBodyPairs);
+	temp_allocator->Free(context.mBodyPairs, sizeof(BodyPair) * mPhysicsSettings.mMaxInFlightBodyPairs);
 	context.mBodyPairs = nullptr;
+
+	// Free the context (unless it belongs to the cached job graph)
+	if (mUpdateContext != mCachedJobGraph)
+	{
+		mUpdateContext->~PhysicsUpdateContext();
+		temp_allocator->Free(mUpdateContext, sizeof(PhysicsUpdateContext));
+	}
+	mUpdateContext = nullptr;
 	
 	// Unlock the broadphase
 	mBroadPhase->UnlockModifications();
@@ -606,6 +778,14 @@ void PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, int inIntegr
 	mStepListenersMutex.unlock();
 }
 
+void PhysicsSystem::ReleaseCachedJobGraph()
+{
+	JPH_ASSERT(mUpdateContext == nullptr, "Can't release the job graph while an update is in flight");
+
+	delete mCachedJobGraph;
+	mCachedJobGraph = nullptr;
+}
+
 void PhysicsSystem::JobStepListeners(PhysicsUpdateContext::Step *ioStep)
 {
 #ifdef JPH_ENABLE_ASSERTS
@@ -631,7 +811,7 @@ void PhysicsSystem::JobStepListeners(PhysicsUpdateContext::Step *ioStep)
 	}
 }
 
-void PhysicsSystem::JobDetermineActiveConstraints(PhysicsUpdateContext::Step *ioStep) const
+void PhysicsSystem::JobDetermineActiveConstraints(PhysicsUpdateContext::Step *ioStep)
 {
 #ifdef JPH_ENABLE_ASSERTS
 	// No body access
@@ -653,7 +833,7 @@ void PhysicsSystem::JobDetermineActiveConstraints(PhysicsUpdateContext::Step *io
 		uint32 constraint_idx_end = min(num_constraints, constraint_idx + cDetermineActiveConstraintsBatchSize);
 
 		// Store the active constraints at the start of the step (bodies get activated during the step which in turn may activate constraints leading to an inconsistent shapshot)
-		mConstraintManager.GetActiveConstraints(constraint_idx, constraint_idx_end, active_constraints, num_active_constraints);
+		mConstraintManager.GetActiveConstraints(constraint_idx, constraint_idx_end, active_constraints, num_active_constraints, mIslandBuilder);
 
 		// Copy the block of active constraints to the global list of active constraints
 		if (num_active_constraints > 0)
@@ -693,12 +873,29 @@ void PhysicsSystem::JobApplyGravity(const PhysicsUpdateContext *ioContext, Physi
 		uint32 active_body_idx_end = min(num_active_bodies_at_step_start, active_body_idx + cApplyGravityBatchSize);
 
 		// Process the batch
-		while (active_body_idx < active_body_idx_end)
+		if (mPhysicsSettings.mUseVectorizedIntegration)
 		{
-			Body &body = mBodyManager.GetBody(active_bodies[active_body_idx]);
-			if (body.IsDynamic())
-				body.GetMotionProperties()->ApplyForceTorqueAndDragInternal(body.GetRotation(), mGravity, delta_time);
-			active_body_idx++;
+			// Collect the dynamic bodies and integrate them together
+			static_assert(cApplyGravityBatchSize <= BodyStateSoA::cMaxBodies, "Batch doesn't fit");
+			Body *dynamic_bodies[cApplyGravityBatchSize];
+			int num_dynamic_bodies = 0;
+			for (; active_body_idx < active_body_idx_end; ++active_body_idx)
+			{
+				Body &body = mBodyManager.GetBody(active_bodies[active_body_idx]);
+				if (body.IsDynamic())
+					dynamic_bodies[num_dynamic_bodies++] = &body;
+			}
+			BodyStateSoA::sApplyForceTorqueAndDrag(dynamic_bodies, num_dynamic_bodies, mGravity, delta_time);
+		}
+		else
+		{
+			while (active_body_idx < active_body_idx_end)
+			{
+				Body &body = mBodyManager.GetBody(active_bodies[active_body_idx]);
+				if (body.IsDynamic())
+					body.GetMotionProperties()->ApplyForceTorqueAndDragInternal(body.GetRotation(), mGravity, delta_time);
+				active_body_idx++;
+			}
 		}
 	}
 }
@@ -974,8 +1171,10 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 				Vec3				mFirstWorldSpaceNormal;
 			};
 
-			// A temporary structure that allows us to keep track of the all manifolds between this body pair
-			using Manifolds = StaticArray<MyManifold, 32>;
+			// A temporary structure that allows us to keep track of the all manifolds between this body pair.
+			// Each manifold can store 64 contact points so this is too big for the stack, take it from the scratch arena of this thread instead.
+			using Manifolds = ScratchArray<MyManifold>;
+			static constexpr uint cMaxManifolds = 32;
 
 			// Create collector
 			class ReductionCollideShapeCollector : public CollideShapeCollector
@@ -984,7 +1183,8 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 								ReductionCollideShapeCollector(PhysicsSystem *inSystem, const Body *inBody1, const Body *inBody2) : 
 					mSystem(inSystem), 
 					mBody1(inBody1),
-					mBody2(inBody2)
+					mBody2(inBody2),
+					mManifolds(cMaxManifolds)
 				{ 
 				}
 
@@ -1109,7 +1309,8 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 					mContactAllocator(ioContactAllocator),
 					mBody1(inBody1),
 					mBody2(inBody2),
-					mBodyPairHandle(inPairHandle)
+					mBodyPairHandle(inPairHandle),
+					mManifold(1)
 				{ 
 				}
 
@@ -1145,7 +1346,9 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 					}
 
 					// Determine contact points
-					ContactManifold manifold;
+					mManifold.clear();
+					mManifold.emplace_back();
+					ContactManifold &manifold = mManifold[0];
 					const PhysicsSettings &settings = mSystem->mPhysicsSettings;
 					ManifoldBetweenTwoFaces(inResult.mContactPointOn1, inResult.mContactPointOn2, inResult.mPenetrationAxis, Square(settings.mSpeculativeContactDistance) + settings.mManifoldToleranceSq, inResult.mShape1Face, inResult.mShape2Face, manifold.mWorldSpaceContactPointsOn1, manifold.mWorldSpaceContactPointsOn2);
 
@@ -1174,6 +1377,7 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 				ContactConstraintManager::BodyPairHandle mBodyPairHandle;
 				bool				mValidateBodyPair = true;
 				bool				mConstraintCreated = false;
+				ScratchArray<ContactManifold> mManifold;	///< A manifold can store 64 contact points, so it is taken from the scratch arena rather than the stack
 			};
 			NonReductionCollideShapeCollector collector(this, ioContactAllocator, body1, body2, body_pair_handle);
 
@@ -1203,15 +1407,60 @@ void PhysicsSystem::ProcessBodyPair(ContactAllocator &ioContactAllocator, const
 	}
 }
 
-void PhysicsSystem::JobFinalizeIslands(PhysicsUpdateContext *ioContext)
+void PhysicsSystem::JobFinalizeIslands(PhysicsUpdateContext::Step *ioStep)
 {
 #ifdef JPH_ENABLE_ASSERTS
 	// We only touch island data
 	BodyAccess::Grant grant(BodyAccess::EAccess::None, BodyAccess::EAccess::None);
 #endif
 
-	// Finish collecting the islands, at this point the active body list doesn't change so it's safe to access
-	mIslandBuilder.Finalize(mBodyManager.GetActiveBodiesUnsafe(), mBodyManager.GetNumActiveBodies(), mContactManager.GetNumConstraints(), ioContext->mTempAllocator);
+	PhysicsUpdateContext *context = ioStep->mContext;
+
+	for (;;)
+	{
+		// Finish collecting the islands, at this point the active body list doesn't change so it's safe to access
+		switch (mIslandBuilder.Finalize(mBodyManager.GetActiveBodiesUnsafe(), mBodyManager.GetNumActiveBodies(), mContactManager.GetNumConstraints(), context->mTempAllocator))
+		{
+		case IslandBuilder::EFinalizeResult::NoMoreWork:
+			return;
+
+		case IslandBuilder::EFinalizeResult::NextPhase:
+			{
+				// Start a helper job for every batch of the next phase that we can't process in parallel ourselves
+				int num_helpers = min((int)mIslandBuilder.GetNumNextFinalizePhaseBatches(), context->GetMaxConcurrency()) - 1;
+				if (num_helpers > 0)
+				{
+					// Add dependencies from the helper jobs to the next jobs, this needs to happen before the next phase starts as other jobs may finish the islands
+					for (JobHandle &h : ioStep->mSubSteps[0].mSolveVelocityConstraints)
+						h.AddDependency(num_helpers);
+					ioStep->mBodySetIslandIndex.AddDependency(num_helpers);
+				}
+				mIslandBuilder.StartNextFinalizePhase();
+
+				// Start the helper jobs
+				for (int i = 0; i < num_helpers; ++i)
+				{
+					JobHandle job = context->mJobSystem->CreateJob("FinalizeIslands", cColorFinalizeIslands, [step = ioStep]() 
+						{
+							step->mContext->mPhysicsSystem->JobFinalizeIslands(step);
+
+							JobHandle::sRemoveDependencies(step->mSubSteps[0].mSolveVelocityConstraints);
+							step->mBodySetIslandIndex.RemoveDependency();
+						});
+
+					// Add the job to the job barrier so the main updating thread can execute the job too
+					context->mBarrier->AddJob(job);
+				}
+				break;
+			}
+
+		case IslandBuilder::EFinalizeResult::Done:
+			// Determine which islands are large enough to be split
+			if (mPhysicsSettings.mUseLargeIslandSplitter)
+				mLargeIslandSplitter.Prepare(mIslandBuilder, mBodyManager.GetNumActiveBodies(), context->mTempAllocator);
+			return;
+		}
+	}
 }
 
 void PhysicsSystem::JobBodySetIslandIndex()
@@ -1245,36 +1494,86 @@ void PhysicsSystem::JobSolveVelocityConstraints(PhysicsUpdateContext *ioContext,
 	bool first_sub_step = ioSubStep->mIsFirst;
 	bool last_sub_step = ioSubStep->mIsLast;
 
+	uint32 num_islands = mIslandBuilder.GetNumIslands();
+	uint32 num_split_islands = mLargeIslandSplitter.GetNumSplitIslands();
+	bool no_more_islands = false;
+
 	for (;;)
 	{
+		// First help solving the large islands that have been split
+		uint32 split_island_idx;
+		uint32 *constraints_begin, *constraints_end;
+		uint32 *contacts_begin, *contacts_end;
+		bool first_iteration, last_iteration;
+		LargeIslandSplitter::EStatus split_status = mLargeIslandSplitter.FetchNextBatch(split_island_idx, constraints_begin, constraints_end, contacts_begin, contacts_end, first_iteration, last_iteration);
+		if (split_status == LargeIslandSplitter::EStatus::BatchRetrieved)
+		{
+			if (first_iteration)
+			{
+				// Prepare velocity constraints. In the first step this is done when adding the contact constraints.
+				if (!first_sub_step)
+				{
+					ConstraintManager::sSetupVelocityConstraints(active_constraints, constraints_begin, constraints_end, delta_time);
+					mContactManager.SetupVelocityConstraints(contacts_begin, contacts_end, delta_time);
+				}
+
+				// Warm start
+				ConstraintManager::sWarmStartVelocityConstraints(active_constraints, constraints_begin, constraints_end, warm_start_impulse_ratio);
+				mContactManager.WarmStartVelocityConstraints(contacts_begin, contacts_end, warm_start_impulse_ratio);
+			}
+			else
+			{
+				// Solve
+				ConstraintManager::sSolveVelocityConstraints(active_constraints, constraints_begin, constraints_end, delta_time);
+				mContactManager.SolveVelocityConstraints(contacts_begin, contacts_end);
+			}
+
+			// Save back the lambdas in the contact cache for the warm start of the next physics update
+			if (last_iteration && last_sub_step)
+				mContactManager.StoreAppliedImpulses(contacts_begin, contacts_end);
+
+			bool last_batch;
+			mLargeIslandSplitter.MarkBatchProcessed(split_island_idx, uint(constraints_end - constraints_begin + contacts_end - contacts_begin), last_batch);
+			if (last_batch)
+				mLargeIslandSplitter.MarkIslandDone(split_island_idx);
+			continue;
+		}
+
 		// Next island
-		uint32 island_idx = ioSubStep->mSolveVelocityConstraintsNextIsland++;
-		if (island_idx >= mIslandBuilder.GetNumIslands())
-			break;
+		uint32 island_idx = no_more_islands? num_islands : ioSubStep->mSolveVelocityConstraintsNextIsland++;
+		if (island_idx >= num_islands)
+		{
+			if (split_status == LargeIslandSplitter::EStatus::AllBatchesDone)
+				break;
+
+			// Other jobs are still working on a split island, wait for more work
+			no_more_islands = true;
+			this_thread::yield();
+			continue;
+		}
 
 		JPH_PROFILE("Island");
 
 		// Get iterators
-		uint32 *constraints_begin, *constraints_end;
 		bool has_constraints = mIslandBuilder.GetConstraintsInIsland(island_idx, constraints_begin, constraints_end);
-		uint32 *contacts_begin, *contacts_end;
 		bool has_contacts = mIslandBuilder.GetContactsInIsland(island_idx, contacts_begin, contacts_end);
 		
 		if (first_sub_step)
 		{
 			// If we don't have any contacts or constraints, we know that none of the following islands have any contacts or constraints
-			// (because they're sorted by most constraints first). This means we're done.
+			// (because they're sorted by most constraints first). This means we only need to help with the split islands.
 			if (!has_contacts && !has_constraints)
 			{
 			#ifdef JPH_ENABLE_ASSERTS
 				// Validate our assumption that the next islands don't have any constraints or contacts
-				for (; island_idx < mIslandBuilder.GetNumIslands(); ++island_idx)
+				for (; island_idx < num_islands; ++island_idx)
 				{
 					JPH_ASSERT(!mIslandBuilder.GetConstraintsInIsland(island_idx, constraints_begin, constraints_end));
 					JPH_ASSERT(!mIslandBuilder.GetContactsInIsland(island_idx, contacts_begin, contacts_end));
 				}
 			#endif // JPH_ENABLE_ASSERTS
-				return;
+				no_more_islands = true;
+				continue;
 			}
 
 			// Sort constraints to give a deterministic simulation
@@ -1282,6 +1581,14 @@ void PhysicsSystem::JobSolveVelocityConstraints(PhysicsUpdateContext *ioContext,
 
 			// Sort contacts to give a deterministic simulation
 			mContactManager.SortContacts(contacts_begin, contacts_end);
+
+			// Split large islands and let all jobs solve them
+			if (island_idx < num_split_islands)
+			{
+				mLargeIslandSplitter.SplitIsland(island_idx, mIslandBuilder, mBodyManager, mContactManager, active_constraints);
+				mLargeIslandSplitter.StartIsland(island_idx, 1 + mPhysicsSettings.mNumVelocitySteps);
+				continue;
+			}
 		}
 		else
 		{
@@ -1306,6 +1613,13 @@ void PhysicsSystem::JobSolveVelocityConstraints(PhysicsUpdateContext *ioContext,
 			if (!has_contacts && !has_constraints)
 				continue;
 
+			// Let all jobs solve large islands (these have already been split in the first sub step)
+			if (island_idx < num_split_islands)
+			{
+				mLargeIslandSplitter.StartIsland(island_idx, 1 + mPhysicsSettings.mNumVelocitySteps);
+				continue;
+			}
+
 			// Prepare velocity constraints. In the first step this is done when adding the contact constraints.
 			ConstraintManager::sSetupVelocityConstraints(active_constraints, constraints_begin, constraints_end, delta_time);
 			mContactManager.SetupVelocityConstraints(contacts_begin, contacts_end, delta_time);
@@ -1330,8 +1644,11 @@ void PhysicsSystem::JobSolveVelocityConstraints(PhysicsUpdateContext *ioContext,
 	}
 }
 
-void PhysicsSystem::JobPreIntegrateVelocity(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep) const
+void PhysicsSystem::JobPreIntegrateVelocity(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep)
 {
+	// All velocity constraints have been solved, prepare the split islands for solving the position constraints
+	mLargeIslandSplitter.ResetStatus();
+
 	// Reserve enough space for all bodies that may need a cast
 	TempAllocator *temp_allocator = ioContext->mTempAllocator;
 	JPH_ASSERT(ioSubStep->mCCDBodies == nullptr);
@@ -1371,6 +1688,18 @@ void PhysicsSystem::JobIntegrateVelocity(const PhysicsUpdateContext *ioContext,
 		// Calculate the end of the batch
 		uint32 active_body_idx_end = min(num_active_bodies, active_body_idx + cIntegrateVelocityBatchSize);
 
+		// Clamp velocities and update rotations for the entire batch at once
+		bool vectorized = mPhysicsSettings.mUseVectorizedIntegration;
+		if (vectorized)
+		{
+			static_assert(cIntegrateVelocityBatchSize <= BodyStateSoA::cMaxBodies, "Batch doesn't fit");
+			Body *bodies[cIntegrateVelocityBatchSize];
+			int num_bodies = 0;
+			for (uint32 i = active_body_idx; i < active_body_idx_end; ++i)
+				bodies[num_bodies++] = &mBodyManager.GetBody(active_bodies[i]);
+			BodyStateSoA::sClampVelocitiesAndIntegrateRotation(bodies, num_bodies, delta_time);
+		}
+
 		// Process the batch
 		while (active_body_idx < active_body_idx_end)
 		{
@@ -1383,7 +1712,7 @@ void PhysicsSystem::JobIntegrateVelocity(const PhysicsUpdateContext *ioContext,
 			MotionProperties *mp = body.GetMotionProperties();
 
 			// Clamp velocities (not for kinematic bodies)
-			if (body.IsDynamic())
+			if (body.IsDynamic() && !vectorized)
 			{
 				mp->ClampLinearVelocity();
 				mp->ClampAngularVelocity();
@@ -1400,7 +1729,8 @@ void PhysicsSystem::JobIntegrateVelocity(const PhysicsUpdateContext *ioContext,
 			// time step) resulting in a lot of stolen time and the body appearing to be frozen in an unnatural pose (like it is glued at an angle to the surface). (2) obviously has some negative side effects
 			// too as simulating the rotation first may cause it to tunnel through a small object that the linear cast might have otherwise dectected. In any case a linear cast is not good for detecting
 			// tunneling due to angular rotation, so we don't care about that too much (you'd need a full cast to take angular effects into account).
-			body.AddRotationStep(body.GetAngularVelocity() * delta_time);
+			if (!vectorized)
+				body.AddRotationStep(body.GetAngularVelocity() * delta_time);
 
 			// Get delta position
 			Vec3 delta_pos = body.GetLinearVelocity() * delta_time;
@@ -1557,6 +1887,9 @@ void PhysicsSystem::JobFindCCDContacts(const PhysicsUpdateContext *ioContext, Ph
 	settings.mReturnDeepestPoint = true;
 	settings.mCollectFacesMode = ECollectFacesMode::CollectFaces;
 	settings.mActiveEdgeMode = mPhysicsSettings.mCheckActiveEdges? EActiveEdgeMode::CollideOnlyWithActive : EActiveEdgeMode::CollideWithAll;
+
+	// A manifold can store 64 contact points, take it from the scratch arena of this thread rather than the stack
+	ScratchArray<ContactManifold> manifold_buffer(1);
 										
 	for (;;)
 	{
@@ -1783,7 +2116,9 @@ void PhysicsSystem::JobFindCCDContacts(const PhysicsUpdateContext *ioContext, Ph
 			const Body &body2 = mBodyManager.GetBody(ccd_body.mBodyID2);
 
 			// Determine contact manifold
-			ContactManifold manifold;
+			manifold_buffer.clear();
+			manifold_buffer.emplace_back();
+			ContactManifold &manifold = manifold_buffer[0];
 			ManifoldBetweenTwoFaces(cast_shape_result.mContactPointOn1, cast_shape_result.mContactPointOn2, cast_shape_result.mPenetrationAxis, mPhysicsSettings.mManifoldToleranceSq, cast_shape_result.mShape1Face, cast_shape_result.mShape2Face, manifold.mWorldSpaceContactPointsOn1, manifold.mWorldSpaceContactPointsOn2);
 			manifold.mSubShapeID1 = cast_shape_result.mSubShapeID1;
 			manifold.mSubShapeID2 = cast_shape_result.mSubShapeID2;
@@ -1823,7 +2158,6 @@ void PhysicsSystem::JobResolveCCDContacts(PhysicsUpdateContext *ioContext, Physi
 #endif
 
 	uint32 num_active_bodies_after_find_collisions = ioSubStep->mStep->mActiveBodyReadIdx;
-	TempAllocator *temp_allocator = ioContext->mTempAllocator;
 
 	// Check if there's anything to do
 	uint num_ccd_bodies = ioSubStep->mNumCCDBodies;
@@ -1833,19 +2167,16 @@ void PhysicsSystem::JobResolveCCDContacts(PhysicsUpdateContext *ioContext, Physi
 		// This is needed to make the simulation deterministic and also to be able to stop contact processing
 		// between body pairs if an earlier hit was found involving the body by another CCD body 
 		// (if it's body ID < this CCD body's body ID - see filtering logic in CCDBroadPhaseCollector)
-		CCDBody **sorted_ccd_bodies = (CCDBody **)temp_allocator->Allocate(num_ccd_bodies * sizeof(CCDBody *));
+		ScratchArray<CCDBody *> sorted_ccd_bodies(num_ccd_bodies);
 		{
 			JPH_PROFILE("Sort");
 
 			// We don't want to copy the entire struct (it's quite big), so we create a pointer array first
-			CCDBody *src_ccd_bodies = ioSubStep->mCCDBodies;
-			CCDBody **dst_ccd_bodies = sorted_ccd_bodies;
-			CCDBody **dst_ccd_bodies_end = dst_ccd_bodies + num_ccd_bodies;
-			while (dst_ccd_bodies < dst_ccd_bodies_end)
-				*(dst_ccd_bodies++) = src_ccd_bodies++;
+			for (CCDBody *ccd_body = ioSubStep->mCCDBodies, *ccd_body_end = ccd_body + num_ccd_bodies; ccd_body < ccd_body_end; ++ccd_body)
+				sorted_ccd_bodies.push_back(ccd_body);
 
 			// Which we then sort
-			sort(sorted_ccd_bodies, sorted_ccd_bodies + num_ccd_bodies, [](const CCDBody *inBody1, const CCDBody *inBody2) 
+			sort(sorted_ccd_bodies.begin(), sorted_ccd_bodies.end(), [](const CCDBody *inBody1, const CCDBody *inBody2) 
 				{ 
 					if (inBody1->mFractionPlusSlop != inBody2->mFractionPlusSlop)
 						return inBody1->mFractionPlusSlop < inBody2->mFractionPlusSlop;
@@ -1856,17 +2187,14 @@ void PhysicsSystem::JobResolveCCDContacts(PhysicsUpdateContext *ioContext, Physi
 
 		// We can collide with bodies that are not active, we track them here so we can activate them in one go at the end.
 		// This is also needed because we can't modify the active body array while we iterate it.
-		static constexpr int cBodiesBatch = 64;
-		BodyID *bodies_to_activate = (BodyID *)JPH_STACK_ALLOC(cBodiesBatch * sizeof(BodyID));
-		int num_bodies_to_activate = 0;
+		static constexpr uint cBodiesBatch = 64;
+		ScratchArray<BodyID> bodies_to_activate(cBodiesBatch);
 
 		// We can move bodies that are not part of an island. In this case we need to notify the broadphase of the movement.
-		BodyID *bodies_to_update_bounds = (BodyID *)JPH_STACK_ALLOC(cBodiesBatch * sizeof(BodyID));
-		int num_bodies_to_update_bounds = 0;
+		ScratchArray<BodyID> bodies_to_update_bounds(cBodiesBatch);
 
-		for (uint i = 0; i < num_ccd_bodies; ++i)
+		for (const CCDBody *ccd_body : sorted_ccd_bodies)
 		{
-			const CCDBody *ccd_body = sorted_ccd_bodies[i];
 			Body &body1 = mBodyManager.GetBody(ccd_body->mBodyID1);
 			MotionProperties *body_mp = body1.GetMotionProperties();
 
@@ -1948,12 +2276,12 @@ void PhysicsSystem::JobResolveCCDContacts(PhysicsUpdateContext *ioContext, Physi
 						// Activate the body if it is not already active
 						if (!body2.IsActive())
 						{
-							bodies_to_activate[num_bodies_to_activate++] = ccd_body->mBodyID2;
-							if (num_bodies_to_activate == cBodiesBatch)
+							bodies_to_activate.push_back(ccd_body->mBodyID2);
+							if (bodies_to_activate.size() == cBodiesBatch)
 							{
 								// Batch is full, activate now
-								mBodyManager.ActivateBodies(bodies_to_activate, num_bodies_to_activate);
-								num_bodies_to_activate = 0;
+								mBodyManager.ActivateBodies(bodies_to_activate.data(), (int)bodies_to_activate.size());
+								bodies_to_activate.clear();
 							}
 						}
 					}
@@ -1990,29 +2318,28 @@ void PhysicsSystem::JobResolveCCDContacts(PhysicsUpdateContext *ioContext, Physi
 			if (body_mp->GetIndexInActiveBodiesInternal() >= num_active_bodies_after_find_collisions)
 			{
 				body1.CalculateWorldSpaceBoundsInternal();
-				bodies_to_update_bounds[num_bodies_to_update_bounds++] = body1.GetID();
-				if (num_bodies_to_update_bounds == cBodiesBatch)
+				bodies_to_update_bounds.push_back(body1.GetID());
+				if (bodies_to_update_bounds.size() == cBodiesBatch)
 				{
 					// Buffer full, flush now
-					mBroadPhase->NotifyBodiesAABBChanged(bodies_to_update_bounds, num_bodies_to_update_bounds);
-					num_bodies_to_update_bounds = 0;
+					mBroadPhase->NotifyBodiesAABBChanged(bodies_to_update_bounds.data(), (int)bodies_to_update_bounds.size());
+					bodies_to_update_bounds.clear();
 				}
 			}
 		}
 
 		// Activate the requested bodies
-		if (num_bodies_to_activate > 0)
-			mBodyManager.ActivateBodies(bodies_to_activate, num_bodies_to_activate);
+		if (!bodies_to_activate.empty())
+			mBodyManager.ActivateBodies(bodies_to_activate.data(), (int)bodies_to_activate.size());
 
 		// Notify change bounds on requested bodies
-		if (num_bodies_to_update_bounds > 0)
-			mBroadPhase->NotifyBodiesAABBChanged(bodies_to_update_bounds, num_bodies_to_update_bounds, false);
-
-		// Free the sorted ccd bodies
-		temp_allocator->Free(sorted_ccd_bodies, num_ccd_bodies * sizeof(CCDBody *));
+		if (!bodies_to_update_bounds.empty())
+			mBroadPhase->NotifyBodiesAABBChanged(bodies_to_update_bounds.data(), (int)bodies_to_update_bounds.size(), false);
 	}
 
+	// The CCD bodies are shared between the jobs of this sub step, so they live in the temp allocator rather than in a scratch arena.
 	// Ensure we free the CCD bodies array now, will not call the destructor!
+	TempAllocator *temp_allocator = ioContext->mTempAllocator;
 	temp_allocator->Free(ioSubStep->mActiveBodyToCCDBody, ioSubStep->mNumActiveBodyToCCDBody * sizeof(int));
 	ioSubStep->mActiveBodyToCCDBody = nullptr;
 	ioSubStep->mNumActiveBodyToCCDBody = 0;
@@ -2031,8 +2358,10 @@ void PhysicsSystem::JobContactRemovedCallbacks(const PhysicsUpdateContext::Step
 	// Reset the Body::EFlags::InvalidateContactCache flag for all bodies
 	mBodyManager.ValidateContactCacheForAllBodies();
 
-	// Trigger all contact removed callbacks by looking at last step contact points that have not been flagged as reused
-	mContactManager.ContactPointRemovedCallbacks();
+	// Trigger all contact removed callbacks by looking at last step contact points that have not been flagged as reused.
+	// When islands are kept between steps, a removed contact between two dynamic bodies means that the bodies may no longer be connected.
+	if (mContactManager.ContactPointRemovedCallbacks(mPhysicsSettings.mUsePersistentIslands))
+		mIslandBuilder.RequestSplitIslands();
 
 	// Finalize the contact cache (this swaps the read and write versions of the contact cache)
 	mContactManager.FinalizeContactCache(ioStep->mNumBodyPairs, ioStep->mNumManifolds);
@@ -2041,37 +2370,80 @@ void PhysicsSystem::JobContactRemovedCallbacks(const PhysicsUpdateContext::Step
 void PhysicsSystem::JobSolvePositionConstraints(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep)
 {
 #ifdef JPH_ENABLE_ASSERTS
-	// We fix up position errors
-	BodyAccess::Grant grant(BodyAccess::EAccess::None, BodyAccess::EAccess::ReadWrite);
+	// We fix up position errors, velocities are only read by the broadphase to predict the bounds of moving bodies
+	BodyAccess::Grant grant(BodyAccess::EAccess::Read, BodyAccess::EAccess::ReadWrite);
 
 	// Can only deactivate bodies
 	BodyManager::GrantActiveBodiesAccess grant_active(false, true);
 #endif
 
 	float delta_time = ioContext->mSubStepDeltaTime;
+	float baumgarte = mPhysicsSettings.mBaumgarte;
 	Constraint **active_constraints = ioContext->mActiveConstraints;
 
+	uint32 num_islands = mIslandBuilder.GetNumIslands();
+	uint32 num_split_islands = mLargeIslandSplitter.GetNumSplitIslands();
+	bool no_more_islands = false;
+
 	for (;;)
 	{
+		// First help solving the large islands that have been split
+		uint32 split_island_idx;
+		uint32 *constraints_begin, *constraints_end;
+		uint32 *contacts_begin, *contacts_end;
+		bool first_iteration, last_iteration;
+		LargeIslandSplitter::EStatus split_status = mLargeIslandSplitter.FetchNextBatch(split_island_idx, constraints_begin, constraints_end, contacts_begin, contacts_end, first_iteration, last_iteration);
+		if (split_status == LargeIslandSplitter::EStatus::BatchRetrieved)
+		{
+			// Correct positions
+			ConstraintManager::sSolvePositionConstraints(active_constraints, constraints_begin, constraints_end, delta_time, baumgarte);
+			mContactManager.SolvePositionConstraints(contacts_begin, contacts_end);
+
+			// The job that finishes the last batch updates the bodies of the island
+			bool last_batch;
+			mLargeIslandSplitter.MarkBatchProcessed(split_island_idx, uint(constraints_end - constraints_begin + contacts_end - contacts_begin), last_batch);
+			if (last_batch)
+			{
+				CheckSleepAndUpdateBounds(split_island_idx, ioContext, ioSubStep);
+				mLargeIslandSplitter.MarkIslandDone(split_island_idx);
+			}
+			continue;
+		}
+
 		// Next island
-		uint32 island_idx = ioSubStep->mSolvePositionConstraintsNextIsland++;
-		if (island_idx >= mIslandBuilder.GetNumIslands())
-			break;
+		uint32 island_idx = no_more_islands? num_islands : ioSubStep->mSolvePositionConstraintsNextIsland++;
+		if (island_idx >= num_islands)
+		{
+			if (split_status == LargeIslandSplitter::EStatus::AllBatchesDone)
+				break;
+
+			// Other jobs are still working on a split island, wait for more work
+			no_more_islands = true;
+			this_thread::yield();
+			continue;
+		}
 
 		JPH_PROFILE("Island");
 
+		// Let all jobs solve large islands
+		if (island_idx < num_split_islands)
+		{
+			if (!mLargeIslandSplitter.StartIsland(island_idx, mPhysicsSettings.mNumPositionSteps))
+			{
+				// No position steps, only update the bodies
+				CheckSleepAndUpdateBounds(island_idx, ioContext, ioSubStep);
+				mLargeIslandSplitter.MarkIslandDone(island_idx);
+			}
+			continue;
+		}
+
 		// Get iterators for this island
-		BodyID *bodies_begin, *bodies_end;
-		mIslandBuilder.GetBodiesInIsland(island_idx, bodies_begin, bodies_end);
-		uint32 *constraints_begin, *constraints_end;
 		bool has_constraints = mIslandBuilder.GetConstraintsInIsland(island_idx, constraints_begin, constraints_end);
-		uint32 *contacts_begin, *contacts_end;
 		bool has_contacts = mIslandBuilder.GetContactsInIsland(island_idx, contacts_begin, contacts_end);
 
 		// Correct positions
 		if (has_contacts || has_constraints)
 		{
-			float baumgarte = mPhysicsSettings.mBaumgarte;
 			for (int position_step = 0; position_step < mPhysicsSettings.mNumPositionSteps; ++position_step)
 			{
 				bool constraint_impulse = ConstraintManager::sSolvePositionConstraints(active_constraints, constraints_begin, constraints_end, delta_time, baumgarte);
@@ -2081,53 +2453,71 @@ void PhysicsSystem::JobSolvePositionConstraints(PhysicsUpdateContext *ioContext,
 			}
 		}
 
-		// Only check sleeping in the last sub step of the last step
-		// Also resets force and torque used during the apply gravity phase
-		if (ioSubStep->mIsLastOfAll)
-		{
-			JPH_PROFILE("Check Sleeping");
+		CheckSleepAndUpdateBounds(island_idx, ioContext, ioSubStep);
+	}
+}
 
-			static_assert(int(Body::ECanSleep::CannotSleep) == 0 && int(Body::ECanSleep::CanSleep) == 1, "Loop below makes this assumption");
-			int all_can_sleep = mPhysicsSettings.mAllowSleeping? int(Body::ECanSleep::CanSleep) : int(Body::ECanSleep::CannotSleep);
+void PhysicsSystem::CheckSleepAndUpdateBounds(uint32 inIslandIndex, const PhysicsUpdateContext *ioContext, const PhysicsUpdateContext::SubStep *ioSubStep)
+{
+	// Get bodies in this island
+	BodyID *bodies_begin, *bodies_end;
+	mIslandBuilder.GetBodiesInIsland(inIslandIndex, bodies_begin, bodies_end);
 
-			float time_before_sleep = mPhysicsSettings.mTimeBeforeSleep;
-			float max_movement = mPhysicsSettings.mPointVelocitySleepThreshold * time_before_sleep;
+	// Only check sleeping in the last sub step of the last step
+	// Also resets force and torque used during the apply gravity phase
+	if (ioSubStep->mIsLastOfAll)
+	{
+		JPH_PROFILE("Check Sleeping");
 
-			for (const BodyID *body_id = bodies_begin; body_id < bodies_end; ++body_id)
-			{
-				Body &body = mBodyManager.GetBody(*body_id);
+		static_assert(int(Body::ECanSleep::CannotSleep) == 0 && int(Body::ECanSleep::CanSleep) == 1, "Loop below makes this assumption");
+		int all_can_sleep = mPhysicsSettings.mAllowSleeping? int(Body::ECanSleep::CanSleep) : int(Body::ECanSleep::CannotSleep);
+		int any_can_sleep = int(Body::ECanSleep::CannotSleep);
 
-				// Update bounding box
-				body.CalculateWorldSpaceBoundsInternal();
+		float time_before_sleep = mPhysicsSettings.mTimeBeforeSleep;
+		float max_movement = mPhysicsSettings.mPointVelocitySleepThreshold * time_before_sleep;
 
-				// Update sleeping
-				all_can_sleep &= int(body.UpdateSleepStateInternal(ioContext->mSubStepDeltaTime, max_movement, time_before_sleep));
+		for (const BodyID *body_id = bodies_begin; body_id < bodies_end; ++body_id)
+		{
+			Body &body = mBodyManager.GetBody(*body_id);
 
-				// Reset force and torque
-				body.GetMotionProperties()->ResetForceAndTorqueInternal();
-			}
+			// Update bounding box
+			body.CalculateWorldSpaceBoundsInternal();
 
-			// If all bodies indicate they can sleep we can deactivate them
-			if (all_can_sleep == int(Body::ECanSleep::CanSleep))
-				mBodyManager.DeactivateBodies(bodies_begin, int(bodies_end - bodies_begin));
+			// Update sleeping
+			int can_sleep = int(body.UpdateSleepStateInternal(ioContext->mSubStepDeltaTime, max_movement, time_before_sleep));
+			all_can_sleep &= can_sleep;
+			any_can_sleep |= can_sleep;
+
+			// Reset force and torque
+			body.GetMotionProperties()->ResetForceAndTorqueInternal();
 		}
-		else
-		{
-			JPH_PROFILE("Update Bounds");
 
-			// Update bounding box only for all other sub steps
-			for (const BodyID *body_id = bodies_begin; body_id < bodies_end; ++body_id)
-			{
-				Body &body = mBodyManager.GetBody(*body_id);
-				body.CalculateWorldSpaceBoundsInternal();
-			}
+		// If all bodies indicate they can sleep we can deactivate them
+		if (all_can_sleep == int(Body::ECanSleep::CanSleep))
+			mBodyManager.DeactivateBodies(bodies_begin, int(bodies_end - bodies_begin));
+		else if (any_can_sleep == int(Body::ECanSleep::CanSleep) && mPhysicsSettings.mAllowSleeping && mIslandBuilder.IslandsIncludePreviousLinks())
+		{
+			// Some bodies want to sleep but are kept awake by other bodies in the island. Since this island was built using links from
+			// previous steps, the bodies may no longer be connected, so rebuild the islands from scratch next step.
+			mIslandBuilder.RequestSplitIslands();
 		}
+	}
+	else
+	{
+		JPH_PROFILE("Update Bounds");
 
-		// Notify broadphase of changed objects (find ccd contacts can do linear casts in the next step, so
-		// we need to do this every sub step)
-		// Note: Shuffles the BodyID's around!!!
-		mBroadPhase->NotifyBodiesAABBChanged(bodies_begin, int(bodies_end - bodies_begin), false);
+		// Update bounding box only for all other sub steps
+		for (const BodyID *body_id = bodies_begin; body_id < bodies_end; ++body_id)
+		{
+			Body &body = mBodyManager.GetBody(*body_id);
+			body.CalculateWorldSpaceBoundsInternal();
+		}
 	}
+
+	// Notify broadphase of changed objects (find ccd contacts can do linear casts in the next step, so
+	// we need to do this every sub step)
+	// Note: Shuffles the BodyID's around!!!
+	mBroadPhase->NotifyBodiesAABBChanged(bodies_begin, int(bodies_end - bodies_begin), false);
 }
 
 void PhysicsSystem::SaveState(StateRecorder &inStream) const
@@ -2161,13 +2551,16 @@ bool PhysicsSystem::RestoreState(StateRecorder &inStream)
 		return false;
 
 	// Update bounding boxes for all bodies in the broadphase
-	vector<BodyID> bodies;
+	TaggedVector<BodyID> bodies;
 	for (const Body *b : mBodyManager.GetBodies())
 		if (BodyManager::sIsValidBodyPointer(b) && b->IsInBroadPhase())
 			bodies.push_back(b->GetID());
 	if (!bodies.empty())
 		mBroadPhase->NotifyBodiesAABBChanged(&bodies[0], (int)bodies.size());
 
+	// The links between bodies from previous steps don't belong to the restored state
+	mIslandBuilder.RequestSplitIslands();
+
 	return true;
 }
 
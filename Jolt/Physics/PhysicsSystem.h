@@ -9,7 +9,9 @@
 #include <Jolt/Physics/Constraints/ContactConstraintManager.h>
 #include <Jolt/Physics/Constraints/ConstraintManager.h>
 #include <Jolt/Physics/IslandBuilder.h>
+#include <Jolt/Physics/LargeIslandSplitter.h>
 #include <Jolt/Physics/PhysicsUpdateContext.h>
+#include <Jolt/Core/TempAllocator.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -18,12 +20,38 @@ class StateRecorder;
 class TempAllocator;
 class PhysicsStepListener;
 
+/// Broadphase implementation that is used by the PhysicsSystem
+enum class EBroadPhaseType
+{
+	QuadTree,																				///< BroadPhaseQuadTree, a good default for most scenes
+	SweepAndPrune,																			///< BroadPhaseSAP, keeps the bodies sorted along all 3 axes which can be faster for scenes where most bodies move every step
+};
+
+/// Handle to a physics update that was started through PhysicsSystem::StartUpdate and that may still be running
+class PhysicsUpdateHandle
+{
+public:
+	/// Check if the update is still in flight, if so PhysicsSystem::WaitForUpdate needs to be called before the PhysicsSystem can be used again
+	bool						IsValid() const												{ return mUpdateDone.IsValid(); }
+
+	/// Check if all jobs of the update have finished executing, if so PhysicsSystem::WaitForUpdate will return almost immediately.
+	/// Note that if the JobSystem has no worker threads the jobs will only execute when PhysicsSystem::WaitForUpdate is called.
+	bool						IsDone() const												{ return !mUpdateDone.IsValid() || mUpdateDone.IsDone(); }
+
+private:
+	friend class PhysicsSystem;
+
+	JobHandle					mUpdateDone;												///< Last job of the update, finishes when all other jobs have finished
+};
+
 /// The main class for the physics system. It contains all rigid bodies and simulates them.
 ///
 /// The main simulation is performed by the Update() call on multiple threads (if the JobSystem is configured to use them). Please refer to the general architecture overview in the Docs folder for more information.
 class PhysicsSystem : public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	/// Constructor / Destructor
 								PhysicsSystem()												: mContactManager(mPhysicsSettings) { }
 								~PhysicsSystem();
@@ -36,7 +64,8 @@ public:
 	/// @param inBroadPhaseLayerInterface Information on the mapping of object layers to broad phase layers, note since this is a virtual interface, the instance needs to stay alive during the lifetime of the PhysicsSystem
 	/// @param inObjectVsBroadPhaseLayerFilter Filter callback function that is used to determine if an object layer collides with a broad phase layer.
 	/// @param inObjectLayerPairFilter Filter callback function that is used to determine if two object layers collide.
-	void						Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter);
+	/// @param inBroadPhaseType Which broadphase implementation to use.
+	void						Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, ObjectVsBroadPhaseLayerFilter inObjectVsBroadPhaseLayerFilter, ObjectLayerPairFilter inObjectLayerPairFilter, EBroadPhaseType inBroadPhaseType = EBroadPhaseType::QuadTree);
 	
 	/// Listener that is notified whenever a body is activated/deactivated
 	void						SetBodyActivationListener(BodyActivationListener *inListener) { mBodyManager.SetBodyActivationListener(inListener); }
@@ -55,7 +84,7 @@ public:
 	void						SetCombineRestitution(ContactConstraintManager::CombineFunction inCombineRestition) { mContactManager.SetCombineRestitution(inCombineRestition); }
 
 	/// Control the main constants of the physics simulation
-	void						SetPhysicsSettings(const PhysicsSettings &inSettings)		{ mPhysicsSettings = inSettings; }
+	void						SetPhysicsSettings(const PhysicsSettings &inSettings);
 	const PhysicsSettings &		GetPhysicsSettings() const									{ return mPhysicsSettings; }
 
 	/// Access to the body interface. This interface allows to to create / remove bodies and to change their properties.
@@ -74,14 +103,14 @@ public:
 	/// Add constraint to the world
 	void						AddConstraint(Constraint *inConstraint)						{ mConstraintManager.Add(&inConstraint, 1); }
 	
-	/// Remove constraint from the world
-	void						RemoveConstraint(Constraint *inConstraint)					{ mConstraintManager.Remove(&inConstraint, 1); }
+	/// Remove constraint from the world (the islands are rebuilt in the next step since the constrained bodies may no longer be connected)
+	void						RemoveConstraint(Constraint *inConstraint)					{ mConstraintManager.Remove(&inConstraint, 1); mIslandBuilder.RequestSplitIslands(); }
 
 	/// Batch add constraints. Note that the inConstraints array is allowed to have nullptrs, these will be ignored.
 	void						AddConstraints(Constraint **inConstraints, int inNumber)	{ mConstraintManager.Add(inConstraints, inNumber); }
 
 	/// Batch remove constraints. Note that the inConstraints array is allowed to have nullptrs, these will be ignored.
-	void						RemoveConstraints(Constraint **inConstraints, int inNumber)	{ mConstraintManager.Remove(inConstraints, inNumber); }
+	void						RemoveConstraints(Constraint **inConstraints, int inNumber)	{ mConstraintManager.Remove(inConstraints, inNumber); mIslandBuilder.RequestSplitIslands(); }
 
 	/// Get a list of all constraints
 	Constraints					GetConstraints() const										{ return mConstraintManager.GetConstraints(); }
@@ -89,6 +118,10 @@ public:
 	/// Optimize the broadphase, needed only if you've added many bodies prior to calling Update() for the first time.
 	void						OptimizeBroadPhase();
 
+	/// Optimize the broadphase over the next calls to Update() instead of immediately (e.g. after streaming in many bodies while the simulation is running).
+	/// The broadphase trees are rebuilt in a background job during the update and swapped in when done, see PhysicsSettings::mBroadPhaseUpdateTimeBudget.
+	void						OptimizeBroadPhaseInBackground();
+
 	/// Adds a new step listener
 	void						AddStepListener(PhysicsStepListener *inListener);
 
@@ -98,8 +131,31 @@ public:
 	/// Simulate the system.
 	/// The world steps for a total of inDeltaTime seconds. This is divided in inCollisionSteps iterations. Each iteration
 	/// consists of collision detection followed by inIntegrationSubSteps integration steps.
+	/// This function blocks until the simulation is done, it is equivalent to calling StartUpdate followed by WaitForUpdate.
 	void						Update(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem);
 
+	/// Start simulating the system (see Update), this kicks off the physics jobs and returns without waiting for them to finish.
+	/// This allows the calling thread to do other work (e.g. AI or animation) while the simulation is running.
+	/// Until WaitForUpdate has been called the following rules apply:
+	/// - The calling thread holds all body locks, the broadphase lock and the step listener lock so it cannot call any function on
+	///   the PhysicsSystem, BodyInterface (locking or non locking), BodyLockInterface, NarrowPhaseQuery or BroadPhaseQuery,
+	///   cannot add / remove constraints or step listeners and cannot read or write bodies directly.
+	///   The lock order validation in debug builds is per thread, so the calling thread can't lock bodies of another PhysicsSystem either.
+	/// - Other threads can't access the physics system either, functions that lock bodies will block until the update finishes.
+	/// - inTempAllocator is in use by the simulation and cannot be used.
+	/// - The JobSystem can be used to run other jobs. Note that if it has no worker threads the simulation only runs in WaitForUpdate.
+	/// - Only one update can be in flight at a time and WaitForUpdate must be called from the thread that called StartUpdate.
+	/// @return Handle that can be polled to see if the simulation is done, it needs to be passed to WaitForUpdate.
+	PhysicsUpdateHandle			StartUpdate(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem);
+
+	/// Wait for an update that was started through StartUpdate to finish and release all locks, this makes the handle invalid.
+	/// While waiting, the calling thread will help executing the physics jobs.
+	void						WaitForUpdate(PhysicsUpdateHandle &ioHandle);
+
+	/// Release the jobs that are kept alive between updates when PhysicsSettings::mCacheJobGraph is set.
+	/// This needs to be called before destroying the JobSystem that was passed to Update (the destructor of the PhysicsSystem calls this too).
+	void						ReleaseCachedJobGraph();
+
 	/// Saving state for replay
 	void						SaveState(StateRecorder &inStream) const;
 
@@ -154,6 +210,12 @@ public:
 	/// Get stats about the bodies in the body manager (slow, iterates through all bodies)
 	BodyStats					GetBodyStats() const										{ return mBodyManager.GetBodyStats(); }
 
+	/// Helper struct that contains statistics about the contact cache
+	using ContactCacheStats = ContactConstraintManager::ContactCacheStats;
+
+	/// Get stats about the contact cache of the last simulation step (slow, iterates through all cached body pairs and manifolds)
+	ContactCacheStats			GetContactCacheStats() const								{ return mContactManager.GetContactCacheStats(); }
+
 	/// Get copy of the list of all bodies under protection of a lock.
 	/// @param outBodyIDs On return, this will contain the list of BodyIDs
 	void						GetBodies(BodyIDVector &outBodyIDs) const					{ return mBodyManager.GetBodyIDs(outBodyIDs); }
@@ -172,15 +234,15 @@ private:
 
 	// Various job entry points
 	void						JobStepListeners(PhysicsUpdateContext::Step *ioStep);
-	void						JobDetermineActiveConstraints(PhysicsUpdateContext::Step *ioStep) const;
+	void						JobDetermineActiveConstraints(PhysicsUpdateContext::Step *ioStep);
 	void						JobApplyGravity(const PhysicsUpdateContext *ioContext, PhysicsUpdateContext::Step *ioStep);	
 	void						JobSetupVelocityConstraints(float inDeltaTime, PhysicsUpdateContext::Step *ioStep) const;
 	void						JobBuildIslandsFromConstraints(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::Step *ioStep);
 	void						JobFindCollisions(PhysicsUpdateContext::Step *ioStep, int inJobIndex);
-	void						JobFinalizeIslands(PhysicsUpdateContext *ioContext);
+	void						JobFinalizeIslands(PhysicsUpdateContext::Step *ioStep);
 	void						JobBodySetIslandIndex();
 	void						JobSolveVelocityConstraints(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep);
-	void						JobPreIntegrateVelocity(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep) const;
+	void						JobPreIntegrateVelocity(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep);
 	void						JobIntegrateVelocity(const PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep);
 	void						JobPostIntegrateVelocity(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep) const;
 	void						JobFindCCDContacts(const PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep);
@@ -188,6 +250,9 @@ private:
 	void						JobContactRemovedCallbacks(const PhysicsUpdateContext::Step *ioStep);
 	void						JobSolvePositionConstraints(PhysicsUpdateContext *ioContext, PhysicsUpdateContext::SubStep *ioSubStep);
 
+	/// Update the bounds and sleep state of the bodies in an island after solving its position constraints and notify the broadphase
+	void						CheckSleepAndUpdateBounds(uint32 inIslandIndex, const PhysicsUpdateContext *ioContext, const PhysicsUpdateContext::SubStep *ioSubStep);
+
 	/// Tries to spawn a new FindCollisions job if max concurrency hasn't been reached yet
 	void						TrySpawnJobFindCollisions(PhysicsUpdateContext::Step *ioStep) const;
 
@@ -238,6 +303,9 @@ private:
 	/// The broadphase does quick collision detection between body pairs
 	BroadPhase *				mBroadPhase = nullptr;
 
+	/// Simulation settings (declared before mContactManager since it keeps a reference to it)
+	PhysicsSettings				mPhysicsSettings;
+
 	/// The contact manager resolves all contacts during a simulation step
 	ContactConstraintManager	mContactManager;
 
@@ -247,11 +315,14 @@ private:
 	/// Keeps track of connected bodies and builds islands for multithreaded velocity/position update
 	IslandBuilder				mIslandBuilder;
 
+	/// Splits large islands so that multiple jobs can solve them
+	LargeIslandSplitter			mLargeIslandSplitter;
+
 	/// Mutex protecting mStepListeners
 	Mutex						mStepListenersMutex;
 
 	/// List of physics step listeners
-	using StepListeners = vector<PhysicsStepListener *>;
+	using StepListeners = TaggedVector<PhysicsStepListener *>;
 	StepListeners				mStepListeners;
 
 	/// This is the global gravity vector
@@ -260,8 +331,20 @@ private:
 	/// Previous frame's delta time of one sub step to allow scaling previous frame's constraint impulses
 	float						mPreviousSubStepDeltaTime = 0.0f;
 
-	/// Simulation settings
-	PhysicsSettings				mPhysicsSettings;
+	/// Number of steps since the active bodies were sorted (see PhysicsSettings::mSortActiveBodiesInterval)
+	int							mStepsSinceActiveBodiesSorted = 0;
+
+	/// Number of steps since the sleeping bodies were moved to the dormant broadphase trees (see PhysicsSettings::mBroadPhaseDormantInterval)
+	int							mStepsSinceDormantBodiesMoved = 0;
+
+	/// Context of the update that is in flight (between StartUpdate and WaitForUpdate)
+	PhysicsUpdateContext *		mUpdateContext = nullptr;
+
+	/// Job graph of the previous update, only kept alive when PhysicsSettings::mCacheJobGraph is set
+	PhysicsUpdateContext *		mCachedJobGraph = nullptr;
+
+	/// Allocator for the steps of the cached job graph (these need to outlive an update so we can't use the temp allocator that is passed to Update)
+	TempAllocatorMalloc			mCachedJobGraphAllocator;
 };
 
 JPH_NAMESPACE_END
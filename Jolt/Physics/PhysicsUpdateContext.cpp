@@ -19,4 +19,43 @@ PhysicsUpdateContext::~PhysicsUpdateContext()
 	JPH_ASSERT(mActiveConstraints == nullptr);
 }
 
+bool PhysicsUpdateContext::CanResetCachedJobs() const
+{
+	for (size_t i = 0; i < mCachedJobs.size(); ++i)
+		if (mCachedJobs[i].GetRefCount() != mCachedJobInfo[i].mRefCount)
+			return false;
+	return true;
+}
+
+void PhysicsUpdateContext::ResetSteps(int inMaxInFlightBodyPairs)
+{
+	for (Step &step : mSteps)
+	{
+		step.mConstraintReadIdx = 0;
+		step.mNumActiveConstraints = 0;
+		step.mStepListenerReadIdx = 0;
+		step.mApplyGravityReadIdx = 0;
+		step.mActiveBodyReadIdx = 0;
+		for (BodyPairQueue &queue : step.mBodyPairQueues)
+		{
+			queue.mWriteIdx = 0;
+			queue.mReadIdx = 0;
+		}
+		step.mMaxBodyPairsPerQueue = inMaxInFlightBodyPairs / (int)step.mBodyPairQueues.size();
+		step.mActiveFindCollisionJobs = ~JobMask(0) >> (sizeof(JobMask) * 8 - step.mFindCollisions.size());
+		step.mNumBodyPairs = 0;
+		step.mNumManifolds = 0;
+
+		for (SubStep &sub_step : step.mSubSteps)
+		{
+			JPH_ASSERT(sub_step.mCCDBodies == nullptr && sub_step.mActiveBodyToCCDBody == nullptr);
+			sub_step.mSolveVelocityConstraintsNextIsland = 0;
+			sub_step.mSolvePositionConstraintsNextIsland = 0;
+			sub_step.mIntegrateVelocityReadIdx = 0;
+			sub_step.mNumCCDBodies = 0;
+			sub_step.mNextCCDBody = 0;
+		}
+	}
+}
+
 JPH_NAMESPACE_END
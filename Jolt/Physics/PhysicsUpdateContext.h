@@ -9,6 +9,7 @@
 #include <Jolt/Core/StaticArray.h>
 #include <Jolt/Core/JobSystem.h>
 #include <Jolt/Core/STLTempAllocator.h>
+#include <Jolt/Core/STLAllocator.h>
 
 JPH_NAMESPACE_BEGIN
 
@@ -21,6 +22,8 @@ class TempAllocator;
 class PhysicsUpdateContext : public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Jobs)
+
 	/// Destructor
 	explicit				PhysicsUpdateContext(TempAllocator &inTempAllocator);
 							~PhysicsUpdateContext();
@@ -130,15 +133,57 @@ public:
 		JobHandle			mUpdateBroadphaseFinalize;								///< Swap the newly built tree with the current tree
 		JobHandle			mSetupVelocityConstraints;								///< Calculate properties for all constraints in the constraint manager
 		JobHandle			mBuildIslandsFromConstraints;							///< Go over all constraints and assign the bodies they're attached to to an island
-		JobHandle			mFinalizeIslands;										///< Finalize calculation simulation islands
+		JobHandle			mFinalizeIslands;										///< Finalize calculation simulation islands (spawns more jobs when a phase has multiple batches of work)
 		JobHandle			mBodySetIslandIndex;									///< Set the current island index on each body (not used by the simulation, only for drawing purposes)
 		SubSteps			mSubSteps;												///< Integration sub steps
 		JobHandle			mContactRemovedCallbacks;								///< Calls the contact removed callbacks
-		JobHandle			mStartNextStep;											///< Job that kicks the next step (empty for the last step)
+		JobHandle			mStartNextStep;											///< Job that kicks the next step (for the last step this job signals that the update is done)
 	};
 
 	using Steps = vector<Step, STLTempAllocator<Step>>;
 
+	/// Describes the shape of the job graph, if this doesn't change between updates the jobs of the previous update can be reused (see PhysicsSettings::mCacheJobGraph)
+	struct JobGraphLayout
+	{
+		bool				operator == (const JobGraphLayout &inRHS) const
+		{
+			return mJobSystem == inRHS.mJobSystem
+				&& mNumCollisionSteps == inRHS.mNumCollisionSteps
+				&& mNumIntegrationSubSteps == inRHS.mNumIntegrationSubSteps
+				&& mMaxConcurrency == inRHS.mMaxConcurrency
+				&& mNumStepListenerJobs == inRHS.mNumStepListenerJobs
+				&& mNumApplyGravityJobs == inRHS.mNumApplyGravityJobs
+				&& mNumDetermineActiveConstraintsJobs == inRHS.mNumDetermineActiveConstraintsJobs
+				&& mNumFindCollisionsJobs == inRHS.mNumFindCollisionsJobs
+				&& mNumIntegrateVelocityJobs == inRHS.mNumIntegrateVelocityJobs;
+		}
+
+		bool				operator != (const JobGraphLayout &inRHS) const		{ return !(*this == inRHS); }
+
+		JobSystem *			mJobSystem = nullptr;									///< Job system that the jobs were created in
+		int					mNumCollisionSteps = 0;									///< Number of collision steps
+		int					mNumIntegrationSubSteps = 0;							///< Number of integration sub steps per collision step
+		int					mMaxConcurrency = 0;									///< Maximum amount of concurrent jobs
+		int					mNumStepListenerJobs = 0;								///< Number of jobs that call the step listeners
+		int					mNumApplyGravityJobs = 0;								///< Number of jobs that apply gravity
+		int					mNumDetermineActiveConstraintsJobs = 0;					///< Number of jobs that determine the active constraints
+		int					mNumFindCollisionsJobs = 0;								///< Number of jobs that find collisions (at the start of a step)
+		int					mNumIntegrateVelocityJobs = 0;							///< Number of jobs that integrate velocities
+	};
+
+	/// Information needed to reset a job of a cached job graph
+	struct CachedJob
+	{
+		uint32				mNumDependencies;										///< Amount of dependencies the job has after the job graph has been built
+		uint32				mRefCount;												///< Amount of references to the job when the job system doesn't reference it
+	};
+
+	/// Check if the jobs of the cached job graph can be reset, this is not possible when the job system still holds a reference to one of them
+	bool					CanResetCachedJobs() const;
+
+	/// Reset the state of all steps so that the jobs of a cached job graph can be executed again
+	void					ResetSteps(int inMaxInFlightBodyPairs);
+
 	/// Maximum amount of concurrent jobs on this machine
 	int						GetMaxConcurrency() const								{ const int max_concurrency = PhysicsUpdateContext::cMaxConcurrency; return min(max_concurrency, mJobSystem->GetMaxConcurrency()); } ///< Need to put max concurrency in temp var as min requires a reference
 
@@ -158,6 +203,10 @@ public:
 	IslandBuilder *			mIslandBuilder;											///< Keeps track of connected bodies and builds islands for multithreaded velocity/position update
 
 	Steps					mSteps;
+
+	JobGraphLayout			mJobGraphLayout;										///< Layout of the job graph (only used when the job graph is cached)
+	TaggedVector<JobHandle, EMemoryTag::Jobs> mCachedJobs;											///< All jobs of the job graph in creation order (only used when the job graph is cached)
+	TaggedVector<CachedJob, EMemoryTag::Jobs> mCachedJobInfo;											///< For each job in mCachedJobs the information needed to reset it
 };
 
 JPH_NAMESPACE_END
@@ -20,6 +20,8 @@ class PhysicsSystem;
 class RagdollSettings : public RefTarget<RagdollSettings>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	JPH_DECLARE_SERIALIZABLE_NON_VIRTUAL(RagdollSettings)
 
 	/// Stabilize the constraints of the ragdoll
@@ -63,7 +65,7 @@ public:
 	void								CalculateBodyIndexToConstraintIndex();
 
 	/// Get table that maps a body index to the constraint index with which it is connected to its parent. -1 if there is no constraint associated with the body.
-	const vector<int> &					GetBodyIndexToConstraintIndex() const							{ return mBodyIndexToConstraintIndex; }
+	const TaggedVector<int> &			GetBodyIndexToConstraintIndex() const							{ return mBodyIndexToConstraintIndex; }
 
 	/// Map a single body index to a constraint index
 	int									GetConstraintIndexForBodyIndex(int inBodyIndex) const			{ return mBodyIndexToConstraintIndex[inBodyIndex]; }
@@ -74,7 +76,7 @@ public:
 	using BodyIdxPair = pair<int, int>;
 
 	/// Table that maps a constraint index (index in mConstraints) to the indices of the bodies that the constraint is connected to (index in mBodyIDs)
-	const vector<BodyIdxPair> &			GetConstraintIndexToBodyIdxPair() const							{ return mConstraintIndexToBodyIdxPair; }
+	const TaggedVector<BodyIdxPair> &	GetConstraintIndexToBodyIdxPair() const							{ return mConstraintIndexToBodyIdxPair; }
 
 	/// Map a single constraint index (index in mConstraints) to the indices of the bodies that the constraint is connected to (index in mBodyIDs)
 	BodyIdxPair							GetBodyIndicesForConstraintIndex(int inConstraintIndex) const	{ return mConstraintIndexToBodyIdxPair[inConstraintIndex]; }
@@ -89,7 +91,7 @@ public:
 	};
 
 	/// List of ragdoll parts
-	using PartVector = vector<Part>;																	///< The constraint that connects this part to its parent part (should be null for the root)
+	using PartVector = TaggedVector<Part>;																///< The constraint that connects this part to its parent part (should be null for the root)
 
 	/// The skeleton for this ragdoll
 	Ref<Skeleton>						mSkeleton;
@@ -99,16 +101,18 @@ public:
 
 private:
 	/// Table that maps a body index (index in mBodyIDs) to the constraint index with which it is connected to its parent. -1 if there is no constraint associated with the body.
-	vector<int>							mBodyIndexToConstraintIndex;
+	TaggedVector<int>					mBodyIndexToConstraintIndex;
 
 	/// Table that maps a constraint index (index in mConstraints) to the indices of the bodies that the constraint is connected to (index in mBodyIDs)
-	vector<BodyIdxPair>					mConstraintIndexToBodyIdxPair;
+	TaggedVector<BodyIdxPair>			mConstraintIndexToBodyIdxPair;
 };
 
 /// Runtime ragdoll information
 class Ragdoll : public RefTarget<Ragdoll>, public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	/// Constructor
 	explicit							Ragdoll(PhysicsSystem *inSystem) : mSystem(inSystem) { }
 
@@ -164,7 +168,7 @@ public:
 	BodyID								GetBodyID(int inBodyIndex) const						{ return mBodyIDs[inBodyIndex]; }
 
 	/// Access to the array of body IDs
-	const vector<BodyID> &				GetBodyIDs() const										{ return mBodyIDs; }
+	const TaggedVector<BodyID> &		GetBodyIDs() const										{ return mBodyIDs; }
 
 	/// Get number of constraints in the ragdoll
 	size_t								GetConstraintCount() const								{ return mConstraints.size(); }
@@ -189,10 +193,10 @@ private:
 	RefConst<RagdollSettings>			mRagdollSettings;
 
 	/// The bodies and constraints that this ragdoll consists of (1-on-1 with mRagdollSettings->mParts)
-	vector<BodyID>						mBodyIDs;
+	TaggedVector<BodyID>				mBodyIDs;
 
 	/// Array of constraints that connect the bodies together
-	vector<Ref<TwoBodyConstraint>>		mConstraints;
+	TaggedVector<Ref<TwoBodyConstraint>>	mConstraints;
 
 	/// Cached physics system
 	PhysicsSystem *						mSystem;
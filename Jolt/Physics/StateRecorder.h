@@ -13,6 +13,8 @@ JPH_NAMESPACE_BEGIN
 class StateRecorder : public StreamIn, public StreamOut
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	/// Constructor
 						StateRecorder() = default;
 						StateRecorder(const StateRecorder &inRHS)					: mIsValidating(inRHS.mIsValidating) { }
@@ -16,6 +16,8 @@ class VehicleController;
 class VehicleControllerSettings : public SerializableObject, public RefTarget<VehicleControllerSettings>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	JPH_DECLARE_SERIALIZABLE_ABSTRACT(VehicleControllerSettings)
 
 	/// Saves the contents of the controller settings in binary form to inStream.
@@ -32,6 +34,8 @@ public:
 class VehicleController : public RefTarget<VehicleController>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	/// Constructor / destructor
 	explicit					VehicleController(VehicleConstraint &inConstraint) : mConstraint(inConstraint) { }
 	virtual						~VehicleController() = default;
@@ -17,6 +17,8 @@ class VehicleConstraint;
 class WheelSettings : public SerializableObject, public RefTarget<WheelSettings>, public NonCopyable
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	JPH_DECLARE_SERIALIZABLE_VIRTUAL(WheelSettings)
 
 	/// Saves the contents in binary form to inStream.
@@ -40,6 +42,8 @@ public:
 class Wheel
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::Constraints)
+
 	/// Constructor / destructor
 	explicit				Wheel(const WheelSettings &inSettings);
 	virtual					~Wheel() = default;
@@ -136,6 +140,6 @@ protected:
 	AxisConstraintPart		mLateralPart;								///< Controls movement sideways (slip)
 };
 
-using Wheels = vector<Wheel *>;
+using Wheels = TaggedVector<Wheel *, EMemoryTag::Constraints>;
 
 JPH_NAMESPACE_END
@@ -293,7 +293,7 @@ void DebugRenderer::DrawWireUnitSphereRecursive(Mat44Arg inMatrix, ColorArg inCo
 	}
 }
 
-void DebugRenderer::Create8thSphereRecursive(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inDir1, uint32 &ioIdx1, Vec3Arg inDir2, uint32 &ioIdx2, Vec3Arg inDir3, uint32 &ioIdx3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel)
+void DebugRenderer::Create8thSphereRecursive(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inDir1, uint32 &ioIdx1, Vec3Arg inDir2, uint32 &ioIdx2, Vec3Arg inDir3, uint32 &ioIdx3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel)
 {
 	if (inLevel == 0)
 	{
@@ -345,7 +345,7 @@ void DebugRenderer::Create8thSphereRecursive(vector<uint32> &ioIndices, vector<V
 	}
 }
 
-void DebugRenderer::Create8thSphere(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel)
+void DebugRenderer::Create8thSphere(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel)
 {
 	uint32 idx1 = 0xffffffff;
 	uint32 idx2 = 0xffffffff;
@@ -354,7 +354,7 @@ void DebugRenderer::Create8thSphere(vector<uint32> &ioIndices, vector<Vertex> &i
 	Create8thSphereRecursive(ioIndices, ioVertices, inDir1, idx1, inDir2, idx2, inDir3, idx3, inUV, inGetSupport, inLevel);
 }
 
-void DebugRenderer::CreateQuad(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inV1, Vec3Arg inV2, Vec3Arg inV3, Vec3Arg inV4)
+void DebugRenderer::CreateQuad(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inV1, Vec3Arg inV2, Vec3Arg inV3, Vec3Arg inV4)
 {
 	// Make room
 	uint32 start_idx = uint32(ioVertices.size());
@@ -396,8 +396,8 @@ void DebugRenderer::Initialize()
 {
 	// Box
 	{
-		vector<Vertex> box_vertices;
-		vector<uint32> box_indices;
+		TaggedVector<Vertex> box_vertices;
+		TaggedVector<uint32> box_indices;
 
 		// Get corner points
 		Vec3 v0 = Vec3(-1,  1, -1);
@@ -452,8 +452,8 @@ void DebugRenderer::Initialize()
 
 		// Capsule bottom half sphere
 		{
-			vector<Vertex> capsule_bottom_vertices;
-			vector<uint32> capsule_bottom_indices;
+			TaggedVector<Vertex> capsule_bottom_vertices;
+			TaggedVector<uint32> capsule_bottom_indices;
 			Create8thSphere(capsule_bottom_indices, capsule_bottom_vertices, -Vec3::sAxisX(), -Vec3::sAxisY(),  Vec3::sAxisZ(), Float2(0.25f, 0.25f), sphere_support, level);
 			Create8thSphere(capsule_bottom_indices, capsule_bottom_vertices, -Vec3::sAxisY(),  Vec3::sAxisX(),  Vec3::sAxisZ(), Float2(0.25f, 0.75f), sphere_support, level);
 			Create8thSphere(capsule_bottom_indices, capsule_bottom_vertices,  Vec3::sAxisX(), -Vec3::sAxisY(), -Vec3::sAxisZ(), Float2(0.25f, 0.25f), sphere_support, level);
@@ -463,8 +463,8 @@ void DebugRenderer::Initialize()
 
 		// Capsule top half sphere
 		{
-			vector<Vertex> capsule_top_vertices;
-			vector<uint32> capsule_top_indices;
+			TaggedVector<Vertex> capsule_top_vertices;
+			TaggedVector<uint32> capsule_top_indices;
 			Create8thSphere(capsule_top_indices, capsule_top_vertices,  Vec3::sAxisX(),  Vec3::sAxisY(),  Vec3::sAxisZ(), Float2(0.25f, 0.75f), sphere_support, level);
 			Create8thSphere(capsule_top_indices, capsule_top_vertices,  Vec3::sAxisY(), -Vec3::sAxisX(),  Vec3::sAxisZ(), Float2(0.25f, 0.25f), sphere_support, level);
 			Create8thSphere(capsule_top_indices, capsule_top_vertices,  Vec3::sAxisY(),  Vec3::sAxisX(), -Vec3::sAxisZ(), Float2(0.25f, 0.25f), sphere_support, level);
@@ -474,8 +474,8 @@ void DebugRenderer::Initialize()
 
 		// Capsule middle part
 		{
-			vector<Vertex> capsule_mid_vertices;
-			vector<uint32> capsule_mid_indices;
+			TaggedVector<Vertex> capsule_mid_vertices;
+			TaggedVector<uint32> capsule_mid_indices;
 			for (int q = 0; q < 4; ++q)
 			{
 				Float2 uv = (q & 1) == 0? Float2(0.25f, 0.25f) : Float2(0.25f, 0.75f);
@@ -514,8 +514,8 @@ void DebugRenderer::Initialize()
 
 		// Open cone
 		{
-			vector<Vertex> open_cone_vertices;
-			vector<uint32> open_cone_indices;
+			TaggedVector<Vertex> open_cone_vertices;
+			TaggedVector<uint32> open_cone_indices;
 			for (int q = 0; q < 4; ++q)
 			{
 				Float2 uv = (q & 1) == 0? Float2(0.25f, 0.25f) : Float2(0.25f, 0.75f);
@@ -556,8 +556,8 @@ void DebugRenderer::Initialize()
 
 		// Cylinder
 		{
-			vector<Vertex> cylinder_vertices;
-			vector<uint32> cylinder_indices;
+			TaggedVector<Vertex> cylinder_vertices;
+			TaggedVector<uint32> cylinder_indices;
 			for (int q = 0; q < 4; ++q)
 			{
 				Float2 uv = (q & 1) == 0? Float2(0.25f, 0.75f) : Float2(0.25f, 0.25f);
@@ -628,7 +628,7 @@ DebugRenderer::Batch DebugRenderer::CreateTriangleBatch(const VertexList &inVert
 {
 	JPH_PROFILE_FUNCTION();
 
-	vector<Vertex> vertices;
+	TaggedVector<Vertex> vertices;
 
 	// Create render vertices
 	vertices.resize(inVertices.size());
@@ -667,8 +667,8 @@ DebugRenderer::Batch DebugRenderer::CreateTriangleBatchForConvex(SupportFunction
 {
 	JPH_PROFILE_FUNCTION();
 
-	vector<Vertex> vertices;
-	vector<uint32> indices;
+	TaggedVector<Vertex> vertices;
+	TaggedVector<uint32> indices;
 	Create8thSphere(indices, vertices,  Vec3::sAxisX(),  Vec3::sAxisY(),  Vec3::sAxisZ(), Float2(0.25f, 0.25f), inGetSupport, inLevel);
 	Create8thSphere(indices, vertices,  Vec3::sAxisY(), -Vec3::sAxisX(),  Vec3::sAxisZ(), Float2(0.25f, 0.75f), inGetSupport, inLevel);
 	Create8thSphere(indices, vertices, -Vec3::sAxisY(),  Vec3::sAxisX(),  Vec3::sAxisZ(), Float2(0.25f, 0.75f), inGetSupport, inLevel);
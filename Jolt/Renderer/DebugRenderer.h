@@ -169,12 +169,14 @@ public:
 	class Geometry : public RefTarget<Geometry>
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 		/// Constructor
 										Geometry(const AABox &inBounds) : mBounds(inBounds) { }
 										Geometry(const Batch &inBatch, const AABox &inBounds) : mBounds(inBounds) { mLODs.push_back({ inBatch, FLT_MAX }); }
 
 		/// All level of details for this mesh
-		vector<LOD>						mLODs;
+		TaggedVector<LOD>				mLODs;
 
 		/// Bounding box that encapsulates all LODs
 		AABox							mBounds;
@@ -189,8 +191,10 @@ public:
 	/// Create a batch of triangles that can be drawn efficiently
 	virtual Batch						CreateTriangleBatch(const Triangle *inTriangles, int inTriangleCount) = 0;
 	virtual Batch						CreateTriangleBatch(const Vertex *inVertices, int inVertexCount, const uint32 *inIndices, int inIndexCount) = 0;
-	Batch								CreateTriangleBatch(const vector<Triangle> &inTriangles) { return CreateTriangleBatch(inTriangles.empty()? nullptr : &inTriangles[0], (int)inTriangles.size()); }
-	Batch								CreateTriangleBatch(const vector<Vertex> &inVertices, const vector<uint32> &inIndices) { return CreateTriangleBatch(inVertices.empty()? nullptr : &inVertices[0], (int)inVertices.size(), inIndices.empty()? nullptr : &inIndices[0], (int)inIndices.size()); }
+	template <class Allocator>
+	Batch								CreateTriangleBatch(const vector<Triangle, Allocator> &inTriangles) { return CreateTriangleBatch(inTriangles.empty()? nullptr : &inTriangles[0], (int)inTriangles.size()); }
+	template <class VertexAllocator, class IndexAllocator>
+	Batch								CreateTriangleBatch(const vector<Vertex, VertexAllocator> &inVertices, const vector<uint32, IndexAllocator> &inIndices) { return CreateTriangleBatch(inVertices.empty()? nullptr : &inVertices[0], (int)inVertices.size(), inIndices.empty()? nullptr : &inIndices[0], (int)inIndices.size()); }
 	Batch								CreateTriangleBatch(const VertexList &inVertices, const IndexedTriangleNoMaterialList &inTriangles);
 
 	/// Create a primitive for a convex shape using its support function
@@ -230,11 +234,11 @@ private:
 	void								DrawWireUnitSphereRecursive(Mat44Arg inMatrix, ColorArg inColor, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, int inLevel);
 
 	/// Helper functions to create a box
-	void								CreateQuad(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inV1, Vec3Arg inV2, Vec3Arg inV3, Vec3Arg inV4);
+	void								CreateQuad(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inV1, Vec3Arg inV2, Vec3Arg inV3, Vec3Arg inV4);
 
 	/// Helper functions to create a vertex and index buffer for a sphere
-	void								Create8thSphereRecursive(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inDir1, uint32 &ioIdx1, Vec3Arg inDir2, uint32 &ioIdx2, Vec3Arg inDir3, uint32 &ioIdx3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel);
-	void								Create8thSphere(vector<uint32> &ioIndices, vector<Vertex> &ioVertices, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel);
+	void								Create8thSphereRecursive(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inDir1, uint32 &ioIdx1, Vec3Arg inDir2, uint32 &ioIdx2, Vec3Arg inDir3, uint32 &ioIdx3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel);
+	void								Create8thSphere(TaggedVector<uint32> &ioIndices, TaggedVector<Vertex> &ioVertices, Vec3Arg inDir1, Vec3Arg inDir2, Vec3Arg inDir3, const Float2 &inUV, SupportFunction inGetSupport, int inLevel);
 
 	// Predefined shapes
 	GeometryRef							mBox;
@@ -255,10 +259,10 @@ private:
 
 	JPH_MAKE_HASH_STRUCT(SwingLimits, SwingLimitsHasher, t.mSwingYHalfAngle, t.mSwingZHalfAngle)
 
-	using SwingBatches = unordered_map<SwingLimits, GeometryRef, SwingLimitsHasher>;
+	using SwingBatches = TaggedUnorderedMap<SwingLimits, GeometryRef, EMemoryTag::General, SwingLimitsHasher>;
 	SwingBatches						mSwingLimits;
 
-	using PieBatces = unordered_map<float, GeometryRef>;
+	using PieBatces = TaggedUnorderedMap<float, GeometryRef>;
 	PieBatces							mPieLimits;
 };
 
@@ -30,12 +30,11 @@ void DebugRendererPlayback::Parse(StreamIn &inStream)
 			uint32 triangle_count;
 			inStream.Read(triangle_count);
 		
-			DebugRenderer::Triangle *triangles = new DebugRenderer::Triangle [triangle_count];
-			inStream.ReadBytes(triangles, triangle_count * sizeof(DebugRenderer::Triangle));
+			TaggedVector<DebugRenderer::Triangle> triangles;
+			triangles.resize(triangle_count);
+			inStream.ReadBytes(triangles.data(), triangle_count * sizeof(DebugRenderer::Triangle));
 		
-			mBatches.insert({ id, mRenderer.CreateTriangleBatch(triangles, triangle_count) });
-		
-			delete [] triangles;
+			mBatches.insert({ id, mRenderer.CreateTriangleBatch(triangles.data(), triangle_count) });
 		}
 		else if (command == ECommand::CreateBatchIndexed)
 		{	
@@ -45,19 +44,18 @@ void DebugRendererPlayback::Parse(StreamIn &inStream)
 			uint32 vertex_count;
 			inStream.Read(vertex_count);
 		
-			DebugRenderer::Vertex *vertices = new DebugRenderer::Vertex [vertex_count];
-			inStream.ReadBytes(vertices, vertex_count * sizeof(DebugRenderer::Vertex));
+			TaggedVector<DebugRenderer::Vertex> vertices;
+			vertices.resize(vertex_count);
+			inStream.ReadBytes(vertices.data(), vertex_count * sizeof(DebugRenderer::Vertex));
 
 			uint32 index_count;
 			inStream.Read(index_count);
 
-			uint32 *indices = new uint32 [index_count];
-			inStream.ReadBytes(indices, index_count * sizeof(uint32));
-		
-			mBatches.insert({ id, mRenderer.CreateTriangleBatch(vertices, vertex_count, indices, index_count) });
+			TaggedVector<uint32> indices;
+			indices.resize(index_count);
+			inStream.ReadBytes(indices.data(), index_count * sizeof(uint32));
 		
-			delete [] indices;
-			delete [] vertices;
+			mBatches.insert({ id, mRenderer.CreateTriangleBatch(vertices.data(), vertex_count, indices.data(), index_count) });
 		}
 		else if (command == ECommand::CreateGeometry)
 		{
@@ -37,14 +37,14 @@ private:
 	DebugRenderer &						mRenderer;
 
 	/// Mapping of ID to batch
-	map<uint32, DebugRenderer::Batch>	mBatches;
+	map<uint32, DebugRenderer::Batch, less<uint32>, STLAllocator<pair<const uint32, DebugRenderer::Batch>>> mBatches;
 
 	/// Mapping of ID to geometry
-	map<uint32, DebugRenderer::GeometryRef> mGeometries;
+	map<uint32, DebugRenderer::GeometryRef, less<uint32>, STLAllocator<pair<const uint32, DebugRenderer::GeometryRef>>> mGeometries;
 
 	/// The list of parsed frames
 	using Frame = DebugRendererRecorder::Frame;
-	vector<Frame>						mFrames;
+	TaggedVector<Frame>					mFrames;
 };
 
 JPH_NAMESPACE_END
@@ -87,10 +87,10 @@ public:
 	/// All information for a single frame
 	struct Frame
 	{
-		vector<LineBlob>				mLines;
-		vector<TriangleBlob>			mTriangles;
-		vector<TextBlob>				mTexts;
-		vector<GeometryBlob>			mGeometries;
+		TaggedVector<LineBlob>			mLines;
+		TaggedVector<TriangleBlob>		mTriangles;
+		TaggedVector<TextBlob>			mTexts;
+		TaggedVector<GeometryBlob>		mGeometries;
 	};
 
 private:
@@ -98,6 +98,8 @@ private:
 	class BatchImpl : public RefTargetVirtual
 	{
 	public:
+		JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 										BatchImpl(uint32 inID)		: mID(inID) {  }
 
 		virtual void					AddRef() override			{ ++mRefCount; }
@@ -118,7 +120,7 @@ private:
 	uint32								mNextGeometryID = 1;
 
 	/// Cached geometries and their IDs
-	map<GeometryRef, uint32>			mGeometries;
+	map<GeometryRef, uint32, less<GeometryRef>, STLAllocator<pair<const GeometryRef, uint32>>> mGeometries;
 
 	/// Data that is being accumulated for the current frame
 	Frame								mCurrentFrame;
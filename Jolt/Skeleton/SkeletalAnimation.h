@@ -14,6 +14,8 @@ class SkeletonPose;
 class SkeletalAnimation : public RefTarget<SkeletalAnimation>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	JPH_DECLARE_SERIALIZABLE_NON_VIRTUAL(SkeletalAnimation)
 
 	/// Constains the current state of a joint, a local space transformation relative to its parent joint
@@ -41,7 +43,7 @@ public:
 		float							mTime = 0.0f;										///< Time of keyframe in seconds
 	};
 
-	using KeyframeVector = vector<Keyframe>;
+	using KeyframeVector = TaggedVector<Keyframe>;
 
 	/// Contains the animation for a single joint
 	class AnimatedJoint
@@ -53,7 +55,7 @@ public:
 		KeyframeVector					mKeyframes;											///< List of keyframes over time
 	};
 
-	using AnimatedJointVector = vector<AnimatedJoint>;
+	using AnimatedJointVector = TaggedVector<AnimatedJoint>;
 
 	/// Get the length (in seconds) of this animation
 	float								GetDuration() const;
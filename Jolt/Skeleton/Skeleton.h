@@ -16,6 +16,8 @@ class StreamOut;
 class Skeleton : public RefTarget<Skeleton>
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	JPH_DECLARE_SERIALIZABLE_NON_VIRTUAL(Skeleton)
 
 	using SkeletonResult = Result<Ref<Skeleton>>;
@@ -34,7 +36,7 @@ public:
 		int					mParentJointIndex = -1;														///< Index of parent joint (in mJoints) or -1 if it has no parent
 	};
 
-	using JointVector = vector<Joint>;
+	using JointVector = TaggedVector<Joint>;
 
 	///@name Access to the joints
 	///@{
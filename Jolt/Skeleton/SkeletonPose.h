@@ -16,9 +16,11 @@ class DebugRenderer;
 class SkeletonPose
 {
 public:
+	JPH_OVERRIDE_NEW_DELETE(EMemoryTag::General)
+
 	using JointState = SkeletalAnimation::JointState;
-	using JointStateVector = vector<JointState>;
-	using Mat44Vector = vector<Mat44>;
+	using JointStateVector = TaggedVector<JointState>;
+	using Mat44Vector = TaggedVector<Mat44>;
 
 	///@name Skeleton
 	///@{
@@ -19,7 +19,7 @@ public:
 	/// @param inTriangles The list of indexed triangles (indexes into inVertices)
 	/// @param inGroupSize How big each group should be
 	/// @param outGroupedTriangleIndices An ordered list of indices (indexing into inTriangles), contains groups of inGroupSize large worth of indices to triangles that are grouped together. If the triangle count is not an exact multiple of inGroupSize the last batch will be smaller.
-	virtual void			Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, vector<uint> &outGroupedTriangleIndices) = 0;
+	virtual void			Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, TaggedVector<uint, EMemoryTag::Shapes> &outGroupedTriangleIndices) = 0;
 };
 
 JPH_NAMESPACE_END
@@ -8,12 +8,12 @@
 
 JPH_NAMESPACE_BEGIN
 
-void TriangleGrouperClosestCentroid::Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, vector<uint> &outGroupedTriangleIndices)
+void TriangleGrouperClosestCentroid::Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, TaggedVector<uint, EMemoryTag::Shapes> &outGroupedTriangleIndices)
 {
 	const uint triangle_count = (uint)inTriangles.size();
 	const uint num_batches = (triangle_count + inGroupSize - 1) / inGroupSize;
 
-	vector<Vec3> centroids;
+	TaggedVector<Vec3, EMemoryTag::Shapes> centroids;
 	centroids.resize(triangle_count);
 
 	outGroupedTriangleIndices.resize(triangle_count);
@@ -27,21 +27,21 @@ void TriangleGrouperClosestCentroid::Group(const VertexList &inVertices, const I
 		outGroupedTriangleIndices[t] = t;
 	}
 
-	vector<uint>::iterator triangles_end = outGroupedTriangleIndices.end();
+	TaggedVector<uint, EMemoryTag::Shapes>::iterator triangles_end = outGroupedTriangleIndices.end();
 
 	// Sort per batch
 	for (uint b = 0; b < num_batches - 1; ++b)
 	{
 		// Get iterators
-		vector<uint>::iterator batch_begin = outGroupedTriangleIndices.begin() + b * inGroupSize;
-		vector<uint>::iterator batch_end = batch_begin + inGroupSize;
-		vector<uint>::iterator batch_begin_plus_1 = batch_begin + 1;
-		vector<uint>::iterator batch_end_minus_1 = batch_end - 1;
+		TaggedVector<uint, EMemoryTag::Shapes>::iterator batch_begin = outGroupedTriangleIndices.begin() + b * inGroupSize;
+		TaggedVector<uint, EMemoryTag::Shapes>::iterator batch_end = batch_begin + inGroupSize;
+		TaggedVector<uint, EMemoryTag::Shapes>::iterator batch_begin_plus_1 = batch_begin + 1;
+		TaggedVector<uint, EMemoryTag::Shapes>::iterator batch_end_minus_1 = batch_end - 1;
 
 		// Find triangle with centroid with lowest X coordinate
-		vector<uint>::iterator lowest_iter = batch_begin;
+		TaggedVector<uint, EMemoryTag::Shapes>::iterator lowest_iter = batch_begin;
 		float lowest_val = centroids[*lowest_iter].GetX();
-		for (vector<uint>::iterator other = batch_begin; other != triangles_end; ++other)
+		for (TaggedVector<uint, EMemoryTag::Shapes>::iterator other = batch_begin; other != triangles_end; ++other)
 		{
 			float val = centroids[*other].GetX();
 			if (val < lowest_val)
@@ -64,7 +64,7 @@ void TriangleGrouperClosestCentroid::Group(const VertexList &inVertices, const I
 			
 		// Loop over remaining triangles
 		float furthest_dist = (centroids[*batch_end_minus_1] - first_centroid).LengthSq();
-		for (vector<uint>::iterator other = batch_end; other != triangles_end; ++other)
+		for (TaggedVector<uint, EMemoryTag::Shapes>::iterator other = batch_end; other != triangles_end; ++other)
 		{
 			// Check if this triangle is closer than the furthest triangle in the batch
 			float dist = (centroids[*other] - first_centroid).LengthSq();
@@ -75,7 +75,7 @@ void TriangleGrouperClosestCentroid::Group(const VertexList &inVertices, const I
 				*other = *batch_end_minus_1;
 
 				// Find first element that is bigger than this one and insert the current item before it
-				vector<uint>::iterator upper = upper_bound(batch_begin_plus_1, batch_end, dist, 
+				TaggedVector<uint, EMemoryTag::Shapes>::iterator upper = upper_bound(batch_begin_plus_1, batch_end, dist, 
 					[&first_centroid, &centroids](float inLHS, uint inRHS)
 					{
 						return inLHS < (centroids[inRHS] - first_centroid).LengthSq(); 
@@ -14,7 +14,7 @@ class TriangleGrouperClosestCentroid : public TriangleGrouper
 {
 public:
 	// See: TriangleGrouper::Group
-	virtual void			Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, vector<uint> &outGroupedTriangleIndices) override;
+	virtual void			Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, TaggedVector<uint, EMemoryTag::Shapes> &outGroupedTriangleIndices) override;
 };
 
 JPH_NAMESPACE_END
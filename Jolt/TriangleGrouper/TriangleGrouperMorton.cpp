@@ -8,11 +8,11 @@
 
 JPH_NAMESPACE_BEGIN
 
-void TriangleGrouperMorton::Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, vector<uint> &outGroupedTriangleIndices)
+void TriangleGrouperMorton::Group(const VertexList &inVertices, const IndexedTriangleList &inTriangles, int inGroupSize, TaggedVector<uint, EMemoryTag::Shapes> &outGroupedTriangleIndices)
 {
 	const uint triangle_count = (uint)inTriangles.size();
 
-	vector<Vec3> centroids;
+	TaggedVector<Vec3, EMemoryTag::Shapes> centroids;
 	centroids.resize(triangle_count);
 
 	outGroupedTriangleIndices.resize(triangle_count);
@@ -35,7 +35,7 @@ void TriangleGrouperMorton::Group(const VertexList &inVertices, const IndexedTri
 	centroid_bounds.EnsureMinimalEdgeLength(1.0e-5f);
 
 	// Calculate morton code for each centroid
-	vector<uint32> morton_codes;
+	TaggedVector<uint32, EMemoryTag::Shapes> morton_codes;
 	morton_codes.resize(triangle_count);
 	for (uint t = 0; t < triangle_count; ++t)
 		morton_codes[t] = MortonCode::sGetMortonCode(centroids[t], centroid_bounds);
@@ -25,7 +25,7 @@ public:
 
 private:
 	// Precalculated Morton codes
-	vector<uint32>			mMortonCodes;
+	TaggedVector<uint32, EMemoryTag::Shapes>	mMortonCodes;
 };
 
 JPH_NAMESPACE_END
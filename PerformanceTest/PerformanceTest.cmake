@@ -8,6 +8,7 @@ set(PERFORMANCE_TEST_SRC_FILES
 	${PERFORMANCE_TEST_ROOT}/PerformanceTestScene.h
 	${PERFORMANCE_TEST_ROOT}/RagdollScene.h
 	${PERFORMANCE_TEST_ROOT}/ConvexVsMeshScene.h
+	${PERFORMANCE_TEST_ROOT}/PyramidScene.h
 	${PERFORMANCE_TEST_ROOT}/Layers.h
 )
 
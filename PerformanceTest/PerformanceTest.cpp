@@ -7,9 +7,12 @@
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
 #include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWorkStealing.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/NarrowPhaseStats.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
 #ifdef JPH_DEBUG_RENDERER
 	#include <Jolt/Renderer/DebugRendererRecorder.h>
 	#include <Jolt/Core/StreamWrapper.h>
@@ -21,6 +24,7 @@
 #include <chrono>
 #include <memory>
 #include <cstdarg>
+#include <random>
 
 using namespace JPH;
 using namespace std;
@@ -31,6 +35,7 @@ JPH_SUPPRESS_WARNINGS
 // Local includes
 #include "RagdollScene.h"
 #include "ConvexVsMeshScene.h"
+#include "PyramidScene.h"
 
 // Time step for physics
 constexpr float cDeltaTime = 1.0f / 60.0f;
@@ -53,9 +58,22 @@ int main(int argc, char** argv)
 	// Parse command line parameters
 	int specified_quality = -1;
 	int specified_threads = -1;
+	bool use_work_stealing = false;
 	uint max_iterations = 500;
 	bool disable_sleep = false;
+	bool cache_job_graph = false;
+	bool use_large_island_splitter = false;
+	bool use_persistent_islands = false;
+	bool use_vectorized_integration = false;
+	bool use_batched_contact_solver = false;
+	int sort_active_bodies_interval = 0;
+	float broad_phase_bounds_margin = 0.0f;
+	int broad_phase_dormant_interval = 0;
+	bool optimize_in_background = false;
+	int num_rays = 0;
+	vector<EBroadPhaseType> broad_phase_types = { EBroadPhaseType::QuadTree };
 	bool enable_profiler = false;
+	uint num_trace_frames = 0;
 #ifdef JPH_DEBUG_RENDERER
 	bool enable_debug_renderer = false;
 #endif // JPH_DEBUG_RENDERER
@@ -72,6 +90,8 @@ int main(int argc, char** argv)
 				scene = unique_ptr<PerformanceTestScene>(new RagdollScene);
 			else if (strcmp(arg + 3, "ConvexVsMesh") == 0)
 				scene = unique_ptr<PerformanceTestScene>(new ConvexVsMeshScene);
+			else if (strcmp(arg + 3, "Pyramid") == 0)
+				scene = unique_ptr<PerformanceTestScene>(new PyramidScene);
 			else
 			{
 				cerr << "Invalid scene" << endl;
@@ -101,14 +121,91 @@ int main(int argc, char** argv)
 			// Parse threads
 			specified_threads = atoi(arg + 3);
 		}
+		else if (strncmp(arg, "-js=", 4) == 0)
+		{
+			// Parse job system
+			if (strcmp(arg + 4, "ThreadPool") == 0)
+				use_work_stealing = false;
+			else if (strcmp(arg + 4, "WorkStealing") == 0)
+				use_work_stealing = true;
+			else
+			{
+				cerr << "Invalid job system" << endl;
+				return 1;
+			}
+		}
 		else if (strcmp(arg, "-no_sleep") == 0)
 		{
 			disable_sleep = true;
 		}
+		else if (strcmp(arg, "-cache_jobs") == 0)
+		{
+			cache_job_graph = true;
+		}
+		else if (strcmp(arg, "-split") == 0)
+		{
+			use_large_island_splitter = true;
+		}
+		else if (strcmp(arg, "-persistent_islands") == 0)
+		{
+			use_persistent_islands = true;
+		}
+		else if (strcmp(arg, "-vectorize_integration") == 0)
+		{
+			use_vectorized_integration = true;
+		}
+		else if (strcmp(arg, "-batch_contacts") == 0)
+		{
+			use_batched_contact_solver = true;
+		}
+		else if (strncmp(arg, "-sort_active=", 13) == 0)
+		{
+			// Parse sort interval
+			sort_active_bodies_interval = atoi(arg + 13);
+		}
+		else if (strncmp(arg, "-bounds_margin=", 15) == 0)
+		{
+			// Parse broadphase bounds margin
+			broad_phase_bounds_margin = float(atof(arg + 15));
+		}
+		else if (strncmp(arg, "-dormant=", 9) == 0)
+		{
+			// Parse dormant interval
+			broad_phase_dormant_interval = atoi(arg + 9);
+		}
+		else if (strncmp(arg, "-rays=", 6) == 0)
+		{
+			// Parse amount of rays to cast per step
+			num_rays = atoi(arg + 6);
+		}
+		else if (strcmp(arg, "-optimize_in_background") == 0)
+		{
+			optimize_in_background = true;
+		}
+		else if (strncmp(arg, "-bp=", 4) == 0)
+		{
+			// Parse broadphase type
+			if (strcmp(arg + 4, "QuadTree") == 0)
+				broad_phase_types = { EBroadPhaseType::QuadTree };
+			else if (strcmp(arg + 4, "SAP") == 0)
+				broad_phase_types = { EBroadPhaseType::SweepAndPrune };
+			else if (strcmp(arg + 4, "All") == 0)
+				broad_phase_types = { EBroadPhaseType::QuadTree, EBroadPhaseType::SweepAndPrune };
+			else
+			{
+				cerr << "Invalid broadphase" << endl;
+				return 1;
+			}
+		}
 		else if (strcmp(arg, "-p") == 0)
 		{
 			enable_profiler = true;
 		}
+		else if (strncmp(arg, "-trace=", 7) == 0)
+		{
+			// Parse amount of physics steps to write to the trace
+			num_trace_frames = (uint)atoi(arg + 7);
+		}
 	#ifdef JPH_DEBUG_RENDERER
 		else if (strcmp(arg, "-r") == 0)
 		{
@@ -123,14 +220,27 @@ int main(int argc, char** argv)
 		{
 			// Print usage
 			cerr << "Usage:" << endl
-				 << "-s=<scene>: Select scene (Ragdoll, ConvexVsMesh)" << endl
+				 << "-s=<scene>: Select scene (Ragdoll, ConvexVsMesh, Pyramid)" << endl
 				 << "-i=<num physics steps>: Number of physics steps to simulate (default 500)" << endl
 				 << "-q=<quality>: Test only with specified quality (Discrete, LinearCast)" << endl
 				 << "-t=<num threads>: Test only with N threads (default is to iterate over 1 .. num hardware threads)" << endl
+				 << "-js=<job system>: Select job system (ThreadPool (default), WorkStealing)" << endl
 				 << "-p: Write out profiles" << endl
+				 << "-trace=<num physics steps>: Write the last <num physics steps> physics steps to a timeline that can be loaded in chrome://tracing or Perfetto" << endl
 				 << "-r: Record debug renderer output for JoltViewer" << endl
 				 << "-f: Record per frame timings" << endl
-				 << "-no_sleep: Disable sleeping" << endl;
+				 << "-no_sleep: Disable sleeping" << endl
+				 << "-cache_jobs: Reuse the job graph of the previous physics update" << endl
+				 << "-split: Split large islands so that multiple jobs can solve them" << endl
+				 << "-persistent_islands: Keep the simulation islands from one physics step to the next" << endl
+				 << "-vectorize_integration: Integrate bodies 4 at a time using SIMD" << endl
+				 << "-batch_contacts: Solve contact constraints that don't share bodies in SIMD batches" << endl
+				 << "-sort_active=<num steps>: Reorder the active bodies spatially every <num steps> physics steps" << endl
+				 << "-bounds_margin=<meters>: Enlarge the bounds of moving bodies in the broadphase by <meters> plus the distance traveled in 2 physics steps" << endl
+				 << "-dormant=<num steps>: Move sleeping bodies to separate broadphase trees every <num steps> physics steps" << endl
+				 << "-rays=<num rays>: After every physics step cast <num rays> rays in a batch using NarrowPhaseQuery::CastRays and report the amount of rays / second" << endl
+				 << "-optimize_in_background: Optimize the broadphase during the first physics updates instead of before the first update" << endl
+				 << "-bp=<broadphase>: Select broadphase (QuadTree (default), SAP, All to run the test for every broadphase)" << endl;
 			return 0;
 		}
 	}
@@ -155,6 +265,8 @@ int main(int argc, char** argv)
 
 	// Output scene we're running
 	cout << "Running scene: " << scene->GetName() << endl;
+	cout << "Job system: " << (use_work_stealing? "WorkStealing" : "ThreadPool") << endl;
+	cout << "Cache job graph: " << (cache_job_graph? "Yes" : "No") << endl;
 
 	// Create mapping table from object layer to broadphase layer
 	BPLayerInterfaceImpl broad_phase_layer_interface;
@@ -163,139 +275,213 @@ int main(int argc, char** argv)
 	JPH_PROFILE_THREAD_START("Main");
 
 	// Trace header
-	cout << "Motion Quality, Thread Count, Steps / Second, Hash" << endl;
-
-	// Iterate motion qualities
-	for (uint mq = 0; mq < 2; ++mq)
+	cout << "Broad Phase, Motion Quality, Thread Count, Steps / Second, Hash";
+	if (num_rays > 0)
+		cout << ", Rays / Second";
+	cout << endl;
+
+	// Create the rays to cast every step, the rays start at random points around the origin and have a random direction
+	vector<RayCast> rays;
+	vector<RayCastResult> ray_hits(num_rays);
 	{
-		// Skip quality if another was specified
-		if (specified_quality != -1 && mq != (uint)specified_quality)
-			continue;
-
-		// Determine motion quality
-		EMotionQuality motion_quality = mq == 0? EMotionQuality::Discrete : EMotionQuality::LinearCast;
-		string motion_quality_str = mq == 0? "Discrete" : "LinearCast";
-
-		// Determine which thread counts to test
-		vector<uint> thread_permutations;
-		if (specified_threads > 0)
-			thread_permutations.push_back((uint)specified_threads - 1);
-		else
-			for (uint num_threads = 0; num_threads < thread::hardware_concurrency(); ++num_threads)
-				thread_permutations.push_back(num_threads);
-
-		// Test thread permutations
-		for (uint num_threads : thread_permutations)
+		mt19937 random;
+		uniform_real_distribution<float> position(-50.0f, 50.0f);
+		uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		for (int r = 0; r < num_rays; ++r)
 		{
-			// Create job system with desired number of threads
-			JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, num_threads);
+			Vec3 origin(position(random), 0.5f * position(random) + 25.0f, position(random));
+			Vec3 dir(direction(random), direction(random), direction(random));
+			rays.push_back({ origin, 100.0f * dir.NormalizedOr(Vec3::sAxisY()) });
+		}
+	}
 
-			// Create physics system
-			PhysicsSystem physics_system;
-			physics_system.Init(10240, 0, 65536, 10240, broad_phase_layer_interface, BroadPhaseCanCollide, ObjectCanCollide);
+	// Iterate broadphases
+	for (EBroadPhaseType broad_phase_type : broad_phase_types)
+	{
+		string broad_phase_str = broad_phase_type == EBroadPhaseType::QuadTree? "QuadTree" : "SAP";
 
-			// Start test scene
-			scene->StartTest(physics_system, motion_quality);
+		// Iterate motion qualities
+		for (uint mq = 0; mq < 2; ++mq)
+		{
+			// Skip quality if another was specified
+			if (specified_quality != -1 && mq != (uint)specified_quality)
+				continue;
+
+			// Determine motion quality
+			EMotionQuality motion_quality = mq == 0? EMotionQuality::Discrete : EMotionQuality::LinearCast;
+			string motion_quality_str = mq == 0? "Discrete" : "LinearCast";
+
+			// Determine which thread counts to test
+			vector<uint> thread_permutations;
+			if (specified_threads > 0)
+				thread_permutations.push_back((uint)specified_threads - 1);
+			else
+				for (uint num_threads = 0; num_threads < thread::hardware_concurrency(); ++num_threads)
+					thread_permutations.push_back(num_threads);
 
-			// Disable sleeping if requested
-			if (disable_sleep)
+			// Test thread permutations
+			for (uint num_threads : thread_permutations)
 			{
-				const BodyLockInterface &bli = physics_system.GetBodyLockInterfaceNoLock();
-				BodyIDVector body_ids;
-				physics_system.GetBodies(body_ids);
-				for (BodyID id : body_ids)
+				// Create job system with desired number of threads
+				unique_ptr<JobSystem> job_system;
+				if (use_work_stealing)
+					job_system = make_unique<JobSystemWorkStealing>(cMaxPhysicsJobs, cMaxPhysicsBarriers, num_threads);
+				else
+					job_system = make_unique<JobSystemThreadPool>(cMaxPhysicsJobs, cMaxPhysicsBarriers, num_threads);
+
+				// Create physics system
+				PhysicsSystem physics_system;
+				physics_system.Init(10240, 0, 65536, 10240, broad_phase_layer_interface, BroadPhaseCanCollide, ObjectCanCollide, broad_phase_type);
+
+				// Apply the requested solver settings
 				{
-					BodyLockWrite lock(bli, id);
-					if (lock.Succeeded())
+					PhysicsSettings settings = physics_system.GetPhysicsSettings();
+					settings.mCacheJobGraph = cache_job_graph;
+					settings.mUseLargeIslandSplitter = use_large_island_splitter;
+					settings.mUsePersistentIslands = use_persistent_islands;
+					settings.mUseVectorizedIntegration = use_vectorized_integration;
+					settings.mUseBatchedContactSolver = use_batched_contact_solver;
+					settings.mSortActiveBodiesInterval = sort_active_bodies_interval;
+					settings.mBroadPhaseBoundsMargin = broad_phase_bounds_margin;
+					settings.mBroadPhaseBoundsPredictionTime = broad_phase_bounds_margin > 0.0f? 2.0f * cDeltaTime : 0.0f;
+					settings.mBroadPhaseDormantInterval = broad_phase_dormant_interval;
+					physics_system.SetPhysicsSettings(settings);
+				}
+
+				// Start test scene
+				scene->StartTest(physics_system, motion_quality);
+
+				// Disable sleeping if requested
+				if (disable_sleep)
+				{
+					const BodyLockInterface &bli = physics_system.GetBodyLockInterfaceNoLock();
+					BodyIDVector body_ids;
+					physics_system.GetBodies(body_ids);
+					for (BodyID id : body_ids)
 					{
-						Body &body = lock.GetBody();
-						if (!body.IsStatic())
-							body.SetAllowSleeping(false);
+						BodyLockWrite lock(bli, id);
+						if (lock.Succeeded())
+						{
+							Body &body = lock.GetBody();
+							if (!body.IsStatic())
+								body.SetAllowSleeping(false);
+						}
 					}
 				}
-			}
 
-			// Optimize the broadphase to prevent an expensive first frame
-			physics_system.OptimizeBroadPhase();
+				// Optimize the broadphase to prevent an expensive first frame
+				if (optimize_in_background)
+					physics_system.OptimizeBroadPhaseInBackground();
+				else
+					physics_system.OptimizeBroadPhase();
 
-			// A tag used to identify the test
-			string tag = ToLower(motion_quality_str) + "_th" + ConvertToString(num_threads + 1);
+				// A tag used to identify the test
+				string tag = ToLower(motion_quality_str) + "_th" + ConvertToString(num_threads + 1);
+				if (broad_phase_types.size() > 1)
+					tag = ToLower(broad_phase_str) + "_" + tag;
 					     
-		#ifdef JPH_DEBUG_RENDERER
-			// Open renderer output
-			ofstream renderer_file;
-			if (enable_debug_renderer)
-				renderer_file.open(("performance_test_" + tag + ".jor").c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
-			StreamOutWrapper renderer_stream(renderer_file);
-			DebugRendererRecorder renderer(renderer_stream);
-		#endif // JPH_DEBUG_RENDERER
-
-			// Open per frame timing output
-			ofstream per_frame_file;
-			if (enable_per_frame_recording)
-			{
-				per_frame_file.open(("per_frame_" + tag + ".csv").c_str(), ofstream::out | ofstream::trunc);
-				per_frame_file << "Frame, Time (ms)" << endl;
-			}
+			#ifdef JPH_DEBUG_RENDERER
+				// Open renderer output
+				ofstream renderer_file;
+				if (enable_debug_renderer)
+					renderer_file.open(("performance_test_" + tag + ".jor").c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+				StreamOutWrapper renderer_stream(renderer_file);
+				DebugRendererRecorder renderer(renderer_stream);
+			#endif // JPH_DEBUG_RENDERER
 
-			chrono::nanoseconds total_duration(0);
+				// Open per frame timing output
+				ofstream per_frame_file;
+				if (enable_per_frame_recording)
+				{
+					per_frame_file.open(("per_frame_" + tag + ".csv").c_str(), ofstream::out | ofstream::trunc);
+					per_frame_file << "Frame, Time (ms)" << endl;
+				}
 
-			// Step the world for a fixed amount of iterations
-			for (uint iterations = 0; iterations < max_iterations; ++iterations)
-			{
-				JPH_PROFILE_NEXTFRAME();
+				chrono::nanoseconds total_duration(0);
+				chrono::nanoseconds total_ray_duration(0);
 
-				// Start measuring
-				chrono::high_resolution_clock::time_point clock_start = chrono::high_resolution_clock::now();
+				// Start capturing the timeline
+				if (num_trace_frames > 0)
+				{
+					JPH_PROFILE_CAPTURE_TRACE(num_trace_frames);
+				}
 
-				// Do a physics step
-				physics_system.Update(cDeltaTime, 1, 1, &temp_allocator, &job_system);
+				// Step the world for a fixed amount of iterations
+				for (uint iterations = 0; iterations < max_iterations; ++iterations)
+				{
+					JPH_PROFILE_NEXTFRAME();
 
-				// Stop measuring
-				chrono::high_resolution_clock::time_point clock_end = chrono::high_resolution_clock::now();
-				chrono::nanoseconds duration = chrono::duration_cast<chrono::nanoseconds>(clock_end - clock_start);
-				total_duration += duration;
+					// Start measuring
+					chrono::high_resolution_clock::time_point clock_start = chrono::high_resolution_clock::now();
 
-			#ifdef JPH_DEBUG_RENDERER
-				if (enable_debug_renderer)
-				{
-					// Draw the state of the world
-					BodyManager::DrawSettings settings;
-					physics_system.DrawBodies(settings, &renderer);
+					// Do a physics step
+					physics_system.Update(cDeltaTime, 1, 1, &temp_allocator, job_system.get());
 
-					// Mark end of frame
-					renderer.EndFrame();
-				}
-			#endif // JPH_DEBUG_RENDERER
+					// Stop measuring
+					chrono::high_resolution_clock::time_point clock_end = chrono::high_resolution_clock::now();
+					chrono::nanoseconds duration = chrono::duration_cast<chrono::nanoseconds>(clock_end - clock_start);
+					total_duration += duration;
 
-				// Record time taken this iteration
-				if (enable_per_frame_recording)
-					per_frame_file << iterations << ", " << (1.0e-6 * duration.count()) << endl;
+					// Cast the rays
+					if (num_rays > 0)
+					{
+						chrono::high_resolution_clock::time_point ray_start = chrono::high_resolution_clock::now();
+						physics_system.GetNarrowPhaseQueryNoLock().CastRays(rays.data(), num_rays, ray_hits.data(), *job_system);
+						total_ray_duration += chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - ray_start);
+					}
 
-				// Dump profile information every 100 iterations
-				if (enable_profiler && iterations % 100 == 0)
+				#ifdef JPH_DEBUG_RENDERER
+					if (enable_debug_renderer)
+					{
+						// Draw the state of the world
+						BodyManager::DrawSettings settings;
+						physics_system.DrawBodies(settings, &renderer);
+
+						// Mark end of frame
+						renderer.EndFrame();
+					}
+				#endif // JPH_DEBUG_RENDERER
+
+					// Record time taken this iteration
+					if (enable_per_frame_recording)
+						per_frame_file << iterations << ", " << (1.0e-6 * duration.count()) << endl;
+
+					// Dump profile information every 100 iterations
+					if (enable_profiler && iterations % 100 == 0)
+					{
+						JPH_PROFILE_DUMP(tag + "_it" + ConvertToString(iterations));
+					}
+				}
+
+				// Write the timeline of the last physics steps
+				if (num_trace_frames > 0)
 				{
-					JPH_PROFILE_DUMP(tag + "_it" + ConvertToString(iterations));
+					JPH_PROFILE_DUMP_TRACE(tag);
+					JPH_PROFILE_NEXTFRAME();
+					JPH_PROFILE_CAPTURE_TRACE(0);
 				}
-			}
 
-			// Calculate hash of all positions and rotations of the bodies
-			size_t hash = 0;
-			BodyInterface &bi = physics_system.GetBodyInterfaceNoLock();
-			BodyIDVector body_ids;
-			physics_system.GetBodies(body_ids);
-			for (BodyID id : body_ids)
-			{
-				Vec3 pos = bi.GetPosition(id);
-				Quat rot = bi.GetRotation(id);
-				hash_combine(hash, pos.GetX(), pos.GetY(), pos.GetZ(), rot.GetX(), rot.GetY(), rot.GetZ(), rot.GetW());
-			}
+				// Calculate hash of all positions and rotations of the bodies
+				size_t hash = 0;
+				BodyInterface &bi = physics_system.GetBodyInterfaceNoLock();
+				BodyIDVector body_ids;
+				physics_system.GetBodies(body_ids);
+				for (BodyID id : body_ids)
+				{
+					Vec3 pos = bi.GetPosition(id);
+					Quat rot = bi.GetRotation(id);
+					hash_combine(hash, pos.GetX(), pos.GetY(), pos.GetZ(), rot.GetX(), rot.GetY(), rot.GetZ(), rot.GetW());
+				}
 
-			// Stop test scene
-			scene->StopTest(physics_system);
+				// Stop test scene
+				scene->StopTest(physics_system);
 
-			// Trace stat line
-			cout << motion_quality_str << ", " << num_threads + 1 << ", " << double(max_iterations) / (1.0e-9 * total_duration.count()) << ", " << hash << endl;
+				// Trace stat line
+				cout << broad_phase_str << ", " << motion_quality_str << ", " << num_threads + 1 << ", " << double(max_iterations) / (1.0e-9 * total_duration.count()) << ", " << hash;
+				if (num_rays > 0)
+					cout << ", " << double(max_iterations) * num_rays / (1.0e-9 * total_ray_duration.count());
+				cout << endl;
+			}
 		}
 	}
 
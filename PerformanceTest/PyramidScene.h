@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// Jolt includes
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+
+// Local includes
+#include "PerformanceTestScene.h"
+#include "Layers.h"
+
+// A scene that creates a single pyramid of boxes, all boxes are in the same island so this tests how well a single large island is solved
+class PyramidScene : public PerformanceTestScene
+{
+public:
+	virtual const char *	GetName() const override
+	{
+		return "Pyramid";
+	}
+
+	virtual void			StartTest(PhysicsSystem &inPhysicsSystem, EMotionQuality inMotionQuality) override
+	{
+		BodyInterface &bi = inPhysicsSystem.GetBodyInterface();
+
+		// Floor
+		bi.CreateAndAddBody(BodyCreationSettings(new BoxShape(Vec3(50.0f, 1.0f, 50.0f), 0.0f), Vec3(0, -1, 0), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING), EActivation::DontActivate);
+
+		// Pyramid of boxes
+		const float cBoxSize = 2.0f;
+		const float cBoxSeparation = 0.5f;
+		const float cHalfBoxSize = 0.5f * cBoxSize;
+		const int cPyramidHeight = 15;
+		RefConst<Shape> box_shape = new BoxShape(Vec3::sReplicate(cHalfBoxSize));
+		for (int i = 0; i < cPyramidHeight; ++i)
+			for (int j = i / 2; j < cPyramidHeight - (i + 1) / 2; ++j)
+				for (int k = i / 2; k < cPyramidHeight - (i + 1) / 2; ++k)
+				{
+					Vec3 position(-cPyramidHeight + cBoxSize * j + (i & 1? cHalfBoxSize : 0.0f), 1.0f + (cBoxSize + cBoxSeparation) * i, -cPyramidHeight + cBoxSize * k + (i & 1? cHalfBoxSize : 0.0f));
+					BodyCreationSettings settings(box_shape, position, Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
+					settings.mMotionQuality = inMotionQuality;
+					bi.CreateAndAddBody(settings, EActivation::Activate);
+				}
+	}
+};
@@ -304,7 +304,7 @@ void PhysicsStudio::StartTest(const RTTI *inRTTI)
 	
 	// 清除所有物体
 	BodyInterface &body_interface = mPhysicsSystem->GetBodyInterface();
-	vector<BodyID> body_ids;
+	BodyIDVector body_ids;
 	mPhysicsSystem->GetBodies(body_ids);
 	for (BodyID id : body_ids)
 	{
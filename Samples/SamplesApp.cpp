@@ -469,7 +469,7 @@ SamplesApp::SamplesApp()
 
 	// Get test name from commandline
 	string cmd_line = ToLower(GetCommandLineA());
-	vector<string> args;
+	TaggedVector<string> args;
 	StringToVector(cmd_line, args, " ");
 	if (args.size() == 2)
 	{
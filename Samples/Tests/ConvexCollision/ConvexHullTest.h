@@ -4,6 +4,7 @@
 #pragma once
 
 #include <Tests/Test.h>
+#include <Jolt/Geometry/ConvexHullBuilder.h>
 
 // Simple test to create a convex hull
 class ConvexHullTest : public Test
@@ -19,7 +20,7 @@ public:
 
 private:
 	// A list of predefined points to feed the convex hull algorithm
-	using Points = vector<Vec3>;
+	using Points = ConvexHullBuilder::Positions;
 	vector<Points>			mPoints;
 
 	// Which index in the list we're currently using
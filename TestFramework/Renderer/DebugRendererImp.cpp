@@ -212,7 +212,7 @@ void DebugRendererImp::DrawInstances(const Geometry *inGeometry, const vector<in
 	if (!inStartIdx.empty())
 	{
 		// Get LODs
-		const vector<LOD> &geometry_lods = inGeometry->mLODs;
+		const TaggedVector<LOD> &geometry_lods = inGeometry->mLODs;
 
 		// Write instances for all LODS
 		int next_start_idx = inStartIdx.front();
@@ -289,7 +289,7 @@ void DebugRendererImp::DrawTriangles()
 			for (InstanceMap::value_type &v : *primitive_map)
 			{
 				// Get LODs
-				const vector<LOD> &geometry_lods = v.first->mLODs;
+				const TaggedVector<LOD> &geometry_lods = v.first->mLODs;
 				size_t num_lods = geometry_lods.size();
 				JPH_ASSERT(num_lods > 0);
 
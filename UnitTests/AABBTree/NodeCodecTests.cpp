@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/AABBTree/AABBTreeBuilder.h>
+#include <Jolt/AABBTree/AABBTreeToBuffer.h>
+#include <Jolt/AABBTree/TriangleCodec/TriangleCodecIndexed8BitPackSOA4Flags.h>
+#include <Jolt/AABBTree/NodeCodec/NodeCodecQuadTreeHalfFloat.h>
+#include <Jolt/AABBTree/NodeCodec/NodeCodecOctTreeHalfFloat.h>
+#include <Jolt/TriangleSplitter/TriangleSplitterBinning.h>
+#include <Jolt/Geometry/AABox4.h>
+#include <Jolt/Physics/Collision/SortReverseAndStore.h>
+#include <random>
+
+TEST_SUITE("NodeCodecTests")
+{
+	using TriangleCodec = TriangleCodecIndexed8BitPackSOA4Flags;
+
+	static constexpr int cMaxTrianglesPerLeaf = 8;
+
+	// Collects the centers of all triangles that overlap with a box
+	class CollectTrianglesVisitor
+	{
+	public:
+		explicit		CollectTrianglesVisitor(const AABox &inBox) : mBox(inBox) { }
+
+		bool			ShouldAbort() const
+		{
+			return false;
+		}
+
+		bool			ShouldVisitNode([[maybe_unused]] int inStackTop) const
+		{
+			return true;
+		}
+
+		int				VisitNodes(Vec4Arg inBoundsMinX, Vec4Arg inBoundsMinY, Vec4Arg inBoundsMinZ, Vec4Arg inBoundsMaxX, Vec4Arg inBoundsMaxY, Vec4Arg inBoundsMaxZ, UVec4 &ioProperties, [[maybe_unused]] int inStackTop)
+		{
+			UVec4 collides = AABox4VsBox(mBox, inBoundsMinX, inBoundsMinY, inBoundsMinZ, inBoundsMaxX, inBoundsMaxY, inBoundsMaxZ);
+			return CountAndSortTrues(collides, ioProperties);
+		}
+
+		void			VisitTriangles(const TriangleCodec::DecodingContext &ioContext, const void *inTriangles, int inNumTriangles, [[maybe_unused]] uint32 inTriangleBlockID)
+		{
+			CHECK(inNumTriangles <= cMaxTrianglesPerLeaf);
+			Vec3 vertices[cMaxTrianglesPerLeaf * 3];
+			ioContext.Unpack(inTriangles, inNumTriangles, vertices);
+
+			for (const Vec3 *v = vertices, *v_end = vertices + inNumTriangles * 3; v < v_end; v += 3)
+			{
+				AABox bounds;
+				bounds.Encapsulate(v[0]);
+				bounds.Encapsulate(v[1]);
+				bounds.Encapsulate(v[2]);
+				if (bounds.Overlaps(mBox))
+				{
+					Vec3 center = (v[0] + v[1] + v[2]) / 3.0f;
+					mHits.push_back(Float3(center.GetX(), center.GetY(), center.GetZ()));
+				}
+			}
+		}
+
+		AABox			mBox;
+		vector<Float3>	mHits;
+	};
+
+	// Convert a tree to a buffer with NodeCodec and return the sorted centers of the triangles that overlap inBox
+	template <class NodeCodec>
+	static vector<Float3> sCollectTriangles(const VertexList &inVertices, const AABBTreeBuilder::Node *inRoot, const AABox &inBox)
+	{
+		AABBTreeToBuffer<TriangleCodec, NodeCodec> buffer;
+		const char *error = nullptr;
+		CHECK(buffer.Convert(inVertices, inRoot, error));
+
+		typename NodeCodec::DecodingContext node_ctx(buffer.GetNodeHeader());
+		const TriangleCodec::DecodingContext triangle_ctx(buffer.GetTriangleHeader());
+		CollectTrianglesVisitor visitor(inBox);
+		node_ctx.WalkTree(&buffer.GetBuffer()[0], triangle_ctx, visitor);
+		CHECK(node_ctx.IsDoneWalking());
+
+		sort(visitor.mHits.begin(), visitor.mHits.end(), [](const Float3 &inLHS, const Float3 &inRHS) { return inLHS.x < inRHS.x || (inLHS.x == inRHS.x && (inLHS.y < inRHS.y || (inLHS.y == inRHS.y && inLHS.z < inRHS.z))); });
+		return visitor.mHits;
+	}
+
+	TEST_CASE("TestOctTreeMatchesQuadTree")
+	{
+		UnitTestRandom random;
+		uniform_real_distribution<float> position(-10.0f, 10.0f);
+		uniform_real_distribution<float> offset(-0.5f, 0.5f);
+
+		// Create a soup of small triangles
+		constexpr uint cNumTriangles = 2000;
+		VertexList vertices;
+		IndexedTriangleList triangles;
+		for (uint i = 0; i < cNumTriangles; ++i)
+		{
+			Vec3 center(position(random), position(random), position(random));
+			for (int v = 0; v < 3; ++v)
+			{
+				Vec3 vertex = center + Vec3(offset(random), offset(random), offset(random));
+				vertices.push_back(Float3(vertex.GetX(), vertex.GetY(), vertex.GetZ()));
+			}
+			triangles.push_back(IndexedTriangle(3 * i, 3 * i + 1, 3 * i + 2, 0));
+		}
+
+		// Build the tree
+		TriangleSplitterBinning splitter(vertices, triangles);
+		AABBTreeBuilder builder(splitter, cMaxTrianglesPerLeaf);
+		AABBTreeBuilderStats builder_stats;
+		AABBTreeBuilder::Node *root = builder.Build(builder_stats);
+
+		// A box that contains everything should return all triangles
+		AABox everything(Vec3::sReplicate(-20.0f), Vec3::sReplicate(20.0f));
+		CHECK(sCollectTriangles<NodeCodecQuadTreeHalfFloat<1>>(vertices, root, everything).size() == cNumTriangles);
+		CHECK(sCollectTriangles<NodeCodecOctTreeHalfFloat<1>>(vertices, root, everything).size() == cNumTriangles);
+
+		// Both codecs should find exactly the same triangles
+		for (int i = 0; i < 100; ++i)
+		{
+			Vec3 min(position(random), position(random), position(random));
+			AABox box(min, min + Vec3::sReplicate(2.0f));
+			vector<Float3> quad_hits = sCollectTriangles<NodeCodecQuadTreeHalfFloat<1>>(vertices, root, box);
+			vector<Float3> oct_hits = sCollectTriangles<NodeCodecOctTreeHalfFloat<1>>(vertices, root, box);
+			CHECK(quad_hits == oct_hits);
+		}
+
+		delete root;
+	}
+
+	TEST_CASE("TestSortReverseAndStore8")
+	{
+		UnitTestRandom random;
+		uniform_real_distribution<float> value(0.0f, 1.0f);
+
+		for (int i = 0; i < 100; ++i)
+		{
+			float values[8];
+			for (float &v : values)
+				v = value(random);
+			constexpr float cMaxValue = 0.5f;
+
+			uint32 identifiers[8];
+			float sorted_values[8];
+			int num_results = SortReverseAndStore8(Vec4(values[0], values[1], values[2], values[3]), Vec4(values[4], values[5], values[6], values[7]), cMaxValue, UVec4(10, 11, 12, 13), UVec4(14, 15, 16, 17), identifiers, sorted_values);
+
+			// All values less than the max value should be kept, sorted from high to low across both groups
+			int expected_num_results = 0;
+			for (float v : values)
+				if (v < cMaxValue)
+					++expected_num_results;
+			CHECK(num_results == expected_num_results);
+			for (int r = 0; r < num_results; ++r)
+			{
+				CHECK(sorted_values[r] < cMaxValue);
+				CHECK(sorted_values[r] == values[identifiers[r] - 10]);
+				if (r > 0)
+					CHECK(sorted_values[r - 1] >= sorted_values[r]);
+			}
+		}
+	}
+}
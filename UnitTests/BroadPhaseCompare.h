@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Geometry/OrientedBox.h>
+#include "Layers.h"
+
+/// Helper functions that compare the results of a broadphase with the results of a reference broadphase (usually BroadPhaseBruteForce)
+
+/// Get the body IDs of a list of hits in a consistent order
+template <class Collector>
+inline BodyIDVector GetSortedHits(const Collector &inCollector)
+{
+	BodyIDVector ids;
+	for (const auto &hit : inCollector.mHits)
+	{
+		if constexpr (is_same_v<decay_t<decltype(hit)>, BodyID>)
+			ids.push_back(hit);
+		else
+			ids.push_back(hit.mBodyID);
+	}
+	sort(ids.begin(), ids.end());
+	return ids;
+}
+
+/// Compare the results of random queries of all types, inHeightScale scales the random positions and directions along Y (use a small value for a mostly flat world)
+inline void CompareBroadPhaseQueries(const BroadPhase &inReference, const BroadPhase &inBroadPhase, UnitTestRandom &ioRandom, float inHeightScale = 1.0f)
+{
+	uniform_real_distribution<float> position(-60.0f, 60.0f);
+	uniform_real_distribution<float> size(0.1f, 10.0f);
+
+	for (int i = 0; i < 20; ++i)
+	{
+		Vec3 point(position(ioRandom), inHeightScale * position(ioRandom), position(ioRandom));
+		Vec3 extent(size(ioRandom), size(ioRandom), size(ioRandom));
+		Vec3 direction = (i % 2 == 0? 0.1f : 1.0f) * Vec3(position(ioRandom), inHeightScale * position(ioRandom), position(ioRandom));
+
+		// Ray cast
+		{
+			AllHitCollisionCollector<RayCastBodyCollector> reference_collector, collector;
+			inReference.CastRay({ point, direction }, reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CastRay({ point, direction }, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+		}
+
+		// Box cast
+		{
+			AABoxCast box_cast { AABox(point - extent, point + extent), direction };
+			AllHitCollisionCollector<CastShapeBodyCollector> reference_collector, collector;
+			inReference.CastAABox(box_cast, reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CastAABox(box_cast, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+		}
+
+		// Box, sphere, point and oriented box
+		{
+			AllHitCollisionCollector<CollideShapeBodyCollector> reference_collector, collector;
+			inReference.CollideAABox(AABox(point - extent, point + extent), reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CollideAABox(AABox(point - extent, point + extent), collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+
+			reference_collector.Reset();
+			collector.Reset();
+			inReference.CollideSphere(point, extent.GetX(), reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CollideSphere(point, extent.GetX(), collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+
+			reference_collector.Reset();
+			collector.Reset();
+			inReference.CollidePoint(point, reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CollidePoint(point, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+
+			reference_collector.Reset();
+			collector.Reset();
+			OrientedBox oriented_box(Mat44::sRotationTranslation(Quat::sRotation(Vec3::sAxisY(), 0.25f * JPH_PI * size(ioRandom)), point), extent);
+			inReference.CollideOrientedBox(oriented_box, reference_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			inBroadPhase.CollideOrientedBox(oriented_box, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			CHECK(GetSortedHits(reference_collector) == GetSortedHits(collector));
+		}
+	}
+}
+
+/// Compare the colliding pairs of the active bodies, both body managers should contain the same bodies
+inline void CompareBroadPhasePairs(const BodyManager &inReferenceBodyManager, const BroadPhase &inReference, const BodyManager &inBodyManager, const BroadPhase &inBroadPhase)
+{
+	BodyIDVector reference_active, active;
+	inReferenceBodyManager.GetActiveBodies(reference_active);
+	inBodyManager.GetActiveBodies(active);
+	CHECK(!reference_active.empty());
+	CHECK(reference_active == active);
+
+	AllHitCollisionCollector<BodyPairCollector> reference_collector, collector;
+	inReference.FindCollidingPairs(reference_active.data(), (int)reference_active.size(), 0.1f, BroadPhaseCanCollide, ObjectCanCollide, reference_collector);
+	inBroadPhase.FindCollidingPairs(active.data(), (int)active.size(), 0.1f, BroadPhaseCanCollide, ObjectCanCollide, collector);
+	CHECK(!reference_collector.mHits.empty());
+	sort(reference_collector.mHits.begin(), reference_collector.mHits.end());
+	sort(collector.mHits.begin(), collector.mHits.end());
+	CHECK(reference_collector.mHits == collector.mHits);
+}
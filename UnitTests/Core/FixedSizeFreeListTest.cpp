@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <thread>
+
+TEST_SUITE("FixedSizeFreeListTest")
+{
+	// Object that counts how many instances are alive
+	class Counted
+	{
+	public:
+		explicit		Counted(uint32 inValue) : mValue(inValue)	{ ++sNumAlive; }
+						~Counted()									{ --sNumAlive; }
+
+		uint32			mValue;
+
+		static inline atomic<int> sNumAlive { 0 };
+	};
+
+	TEST_CASE("TestFreeListGrows")
+	{
+		FixedSizeFreeList<Counted> list;
+		list.Init(16, 16);
+		CHECK(list.GetCapacity() == 16);
+
+		// Allocate more objects than the initial capacity
+		constexpr uint32 cNumObjects = 1000;
+		vector<uint32> indices;
+		for (uint32 i = 0; i < cNumObjects; ++i)
+		{
+			uint32 index = list.ConstructObject(i);
+			CHECK(index != FixedSizeFreeList<Counted>::cInvalidObjectIndex);
+			indices.push_back(index);
+		}
+		CHECK(list.GetCapacity() >= cNumObjects);
+		CHECK(Counted::sNumAlive == int(cNumObjects));
+
+		// All objects should be unique and hold their value
+		vector<uint32> sorted = indices;
+		sort(sorted.begin(), sorted.end());
+		CHECK(unique(sorted.begin(), sorted.end()) == sorted.end());
+		for (uint32 i = 0; i < cNumObjects; ++i)
+			CHECK(list.Get(indices[i]).mValue == i);
+
+		// Free half of them one by one and the rest as a batch
+		for (uint32 i = 0; i < cNumObjects / 2; ++i)
+			list.DestructObject(indices[i]);
+		FixedSizeFreeList<Counted>::Batch batch;
+		for (uint32 i = cNumObjects / 2; i < cNumObjects; ++i)
+			list.AddObjectToBatch(batch, indices[i]);
+		list.DestructObjectBatch(batch);
+		CHECK(Counted::sNumAlive == 0);
+
+		// Objects should be reused, the list should not grow any further
+		uint capacity = list.GetCapacity();
+		indices.clear();
+		for (uint32 i = 0; i < cNumObjects; ++i)
+			indices.push_back(list.ConstructObject(i));
+		CHECK(list.GetCapacity() == capacity);
+		for (uint32 index : indices)
+			list.DestructObject(index);
+	}
+
+	TEST_CASE("TestFreeListThreadCache")
+	{
+		FixedSizeFreeList<Counted> list;
+		list.Init(64, 64);
+
+		// An object that was freed by this thread should be returned first
+		uint32 a = list.ConstructObject(1);
+		uint32 b = list.ConstructObject(2);
+		list.DestructObject(a);
+		CHECK(list.ConstructObject(3) == a);
+
+		list.DestructObject(a);
+		list.DestructObject(b);
+	}
+
+	TEST_CASE("TestFreeListMultiThreaded")
+	{
+		FixedSizeFreeList<Counted> list;
+		list.Init(128, 32);
+
+		// Every thread allocates objects and frees them again, part of them are handed to another thread to free
+		constexpr int cNumThreads = 8;
+		constexpr uint32 cNumIterations = 200;
+		constexpr uint32 cNumObjectsPerIteration = 50;
+		vector<uint32> handed_over[cNumThreads];
+		Mutex handed_over_mutex[cNumThreads];
+		atomic<int> num_errors { 0 };
+
+		vector<thread> threads;
+		for (int t = 0; t < cNumThreads; ++t)
+			threads.emplace_back([&list, &handed_over, &handed_over_mutex, &num_errors, t]() {
+				vector<uint32> indices;
+				for (uint32 iteration = 0; iteration < cNumIterations; ++iteration)
+				{
+					for (uint32 i = 0; i < cNumObjectsPerIteration; ++i)
+					{
+						uint32 value = (uint32(t) << 24) | (iteration << 8) | i;
+						uint32 index = list.ConstructObject(value);
+						if (index == FixedSizeFreeList<Counted>::cInvalidObjectIndex)
+							++num_errors;
+						else
+							indices.push_back(index);
+					}
+
+					// Check that nobody else has overwritten our objects
+					for (uint32 i = 0; i < indices.size(); ++i)
+						if (list.Get(indices[i]).mValue != ((uint32(t) << 24) | (iteration << 8) | i))
+							++num_errors;
+
+					// Hand the first object to the next thread
+					{
+						int next = (t + 1) % cNumThreads;
+						lock_guard lock(handed_over_mutex[next]);
+						handed_over[next].push_back(indices[0]);
+					}
+
+					// Free the rest, alternating between single frees and batches
+					if (iteration & 1)
+					{
+						for (uint32 i = 1; i < indices.size(); ++i)
+							list.DestructObject(indices[i]);
+					}
+					else
+					{
+						FixedSizeFreeList<Counted>::Batch batch;
+						for (uint32 i = 1; i < indices.size(); ++i)
+							list.AddObjectToBatch(batch, indices[i]);
+						list.DestructObjectBatch(batch);
+					}
+					indices.clear();
+
+					// Free objects that other threads handed to us
+					vector<uint32> to_free;
+					{
+						lock_guard lock(handed_over_mutex[t]);
+						to_free.swap(handed_over[t]);
+					}
+					for (uint32 index : to_free)
+						list.DestructObject(index);
+				}
+			});
+		for (thread &t : threads)
+			t.join();
+
+		// Free objects that were handed over after the receiving thread finished
+		for (vector<uint32> &v : handed_over)
+			for (uint32 index : v)
+				list.DestructObject(index);
+
+		CHECK(num_errors == 0);
+		CHECK(Counted::sNumAlive == 0);
+	}
+}
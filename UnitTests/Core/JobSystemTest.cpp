@@ -3,6 +3,7 @@
 
 #include "UnitTestFramework.h"
 #include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWorkStealing.h>
 
 TEST_SUITE("JobSystemTest")
 {
@@ -87,4 +88,82 @@ TEST_SUITE("JobSystemTest")
 		for (int i = cMaxJobs - 1; i >= 0; --i)
 			CHECK(values[i] == cMaxJobs - i);
 	}
+
+	TEST_CASE("TestJobSystemWorkStealingRunJobs")
+	{
+		// Create job system
+		const int cMaxJobs = 128;
+		const int cMaxBarriers = 10;
+		const int cMaxThreads = 10;
+		JobSystemWorkStealing system(cMaxJobs, cMaxBarriers, cMaxThreads);
+
+		// Create array of zeros
+		atomic<uint32> values[cMaxJobs];
+		for (int i = 0; i < cMaxJobs; ++i)
+			values[i] = 0;
+
+		// Create a barrier
+		JobSystem::Barrier *barrier = system.CreateBarrier();
+
+		// Create jobs that will increment all values
+		for (int i = 0; i < cMaxJobs; ++i)
+		{
+			JobHandle handle = system.CreateJob("JobTest", Color::sRed, [&values, i] { values[i]++; });
+			barrier->AddJob(handle);
+		}
+
+		// Wait for the barrier to complete
+		system.WaitForJobs(barrier);
+
+		// Destroy our barrier
+		system.DestroyBarrier(barrier);
+
+		// Test all values are 1
+		for (int i = 0; i < cMaxJobs; ++i)
+			CHECK(values[i] == 1);
+	}
+
+	TEST_CASE("TestJobSystemWorkStealingFanOut")
+	{
+		// Create job system
+		const int cNumParents = 16;
+		const int cNumChildren = 32;
+		const int cMaxJobs = 1024;
+		const int cMaxBarriers = 10;
+		const int cMaxThreads = 4;
+		JobSystemWorkStealing system(cMaxJobs, cMaxBarriers, cMaxThreads);
+
+		// Create array of zeros
+		atomic<uint32> values[cNumParents * cNumChildren];
+		for (atomic<uint32> &v : values)
+			v = 0;
+
+		// Create a barrier
+		JobSystem::Barrier *barrier = system.CreateBarrier();
+
+		// Create child jobs that will be started by their parent, this means they get queued from a worker thread and end up on the queue of that worker
+		JobHandle children[cNumParents * cNumChildren];
+		for (int i = 0; i < cNumParents * cNumChildren; ++i)
+		{
+			children[i] = system.CreateJob("JobTestChild", Color::sGreen, [&values, i] { values[i]++; }, 1);
+			barrier->AddJob(children[i]);
+		}
+
+		// Create parent jobs that start a batch of children each, idle workers have to steal the children to run them in parallel
+		for (int i = 0; i < cNumParents; ++i)
+		{
+			JobHandle parent = system.CreateJob("JobTestParent", Color::sRed, [&children, i] { JobHandle::sRemoveDependencies(children + i * cNumChildren, cNumChildren); });
+			barrier->AddJob(parent);
+		}
+
+		// Wait for the barrier to complete
+		system.WaitForJobs(barrier);
+
+		// Destroy our barrier
+		system.DestroyBarrier(barrier);
+
+		// Test all values are 1
+		for (const atomic<uint32> &v : values)
+			CHECK(v == 1);
+	}
 }
@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/LockFreeHashMap.h>
+
+TEST_SUITE("LockFreeHashMapTest")
+{
+	using Map = LockFreeHashMap<uint32, uint32>;
+
+	// Insert inNumKeys keys into the map, returns the amount of keys that could be inserted
+	static uint32 sInsertKeys(Map &ioMap, LFHMAllocator &ioAllocator, uint32 inNumKeys)
+	{
+		LFHMAllocatorContext context(ioAllocator, 1024);
+		for (uint32 i = 0; i < inNumKeys; ++i)
+			if (ioMap.Create(context, i, hash<uint32> { } (i), 0, i * 3) == nullptr)
+				return i;
+		return inNumKeys;
+	}
+
+	TEST_CASE("TestAllocatorGrows")
+	{
+		LFHMAllocator allocator;
+		allocator.Init(16 * LFHMAllocator::cFirstChunkSize);
+		CHECK(allocator.GetNumBytesAllocated() == 0);
+
+		Map map(allocator);
+		map.Init(1024);
+
+		// Fill multiple chunks
+		constexpr uint32 cNumKeys = 30000;
+		CHECK(sInsertKeys(map, allocator, cNumKeys) == cNumKeys);
+		CHECK(allocator.GetNumBytesUsed() > 4 * LFHMAllocator::cFirstChunkSize);
+		CHECK(allocator.GetNumBytesAllocated() >= allocator.GetNumBytesUsed());
+		CHECK(allocator.GetNumBytesAllocated() < allocator.GetMaxBytes());
+		CHECK(allocator.GetNumFailedAllocations() == 0);
+
+		// All keys should be found and handles should round trip
+		for (uint32 i = 0; i < cNumKeys; ++i)
+		{
+			const Map::KeyValue *kv = map.Find(i, hash<uint32> { } (i));
+			CHECK(kv != nullptr);
+			CHECK(kv->GetValue() == i * 3);
+			CHECK(map.FromHandle(map.ToHandle(kv)) == kv);
+		}
+
+		LockFreeHashMapStats stats = map.GetStats();
+		CHECK(stats.mNumBuckets == 1024);
+		CHECK(stats.mNumKeyValues == cNumKeys);
+		CHECK(stats.mNumUsedBuckets <= stats.mNumBuckets);
+		CHECK(stats.mLoadFactor == float(cNumKeys) / 1024);
+		CHECK(stats.mMaxProbeLength >= cNumKeys / 1024);
+		CHECK(stats.mAverageProbeLength >= 1.0f);
+		CHECK(stats.mAverageProbeLength <= float(stats.mMaxProbeLength));
+
+		// Clearing after using little memory should release the chunks that are not needed
+		uint32 allocated = allocator.GetNumBytesAllocated();
+		map.Clear();
+		allocator.Clear();
+		CHECK(allocator.GetNumBytesAllocated() == allocated);
+		CHECK(sInsertKeys(map, allocator, 10) == 10);
+		map.Clear();
+		allocator.Clear();
+		CHECK(allocator.GetNumBytesAllocated() < allocated);
+		CHECK(allocator.GetNumBytesAllocated() <= 2 * LFHMAllocator::cFirstChunkSize);
+	}
+
+	TEST_CASE("TestAllocatorFull")
+	{
+		LFHMAllocator allocator;
+		allocator.Init(4096);
+
+		Map map(allocator);
+		map.Init(64);
+
+		// Insert more keys than fit
+		uint32 num_inserted = sInsertKeys(map, allocator, 1000);
+		CHECK(num_inserted < 1000);
+		CHECK(num_inserted == 4096 / sizeof(Map::KeyValue));
+		CHECK(allocator.GetNumBytesAllocated() == 4096);
+		CHECK(allocator.GetNumFailedAllocations() == 1);
+		CHECK(map.GetStats().mNumKeyValues == num_inserted);
+	}
+
+	TEST_CASE("TestSetNumBuckets")
+	{
+		LFHMAllocator allocator;
+		allocator.Init(1024 * 1024);
+
+		Map map(allocator);
+		map.Init(4096);
+		CHECK(map.GetStats().mNumAllocatedBuckets == 4096);
+
+		// Shrinking a little keeps the allocation
+		map.SetNumBuckets(2048);
+		LockFreeHashMapStats stats = map.GetStats();
+		CHECK(stats.mNumBuckets == 2048);
+		CHECK(stats.mNumAllocatedBuckets == 4096);
+
+		// Shrinking a lot reallocates
+		map.SetNumBuckets(16);
+		stats = map.GetStats();
+		CHECK(stats.mNumBuckets == 16);
+		CHECK(stats.mNumAllocatedBuckets == 16);
+
+		// Growing again reallocates and all buckets should be empty
+		map.SetNumBuckets(1024);
+		stats = map.GetStats();
+		CHECK(stats.mNumBuckets == 1024);
+		CHECK(stats.mNumAllocatedBuckets == 1024);
+		CHECK(stats.mNumKeyValues == 0);
+
+		// Check that the map works with the new amount of buckets
+		CHECK(sInsertKeys(map, allocator, 5000) == 5000);
+		for (uint32 i = 0; i < 5000; ++i)
+			CHECK(map.Find(i, hash<uint32> { } (i))->GetValue() == i * 3);
+		stats = map.GetStats();
+		CHECK(stats.mNumKeyValues == 5000);
+		CHECK(stats.mNumUsedBuckets <= 1024);
+	}
+}
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/Memory.h>
+#include <Jolt/Core/STLAllocator.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+
+TEST_SUITE("MemoryTest")
+{
+	// Hooks that count the allocations per tag and forward to the hooks that were installed before
+	static AllocatorHooks sPreviousHooks;
+	static atomic<int> sNumAllocations[uint(EMemoryTag::Count)];
+
+	static void *sCountingAllocate(size_t inSize, EMemoryTag inTag)
+	{
+		++sNumAllocations[uint(inTag)];
+		return sPreviousHooks.mAllocate(inSize, inTag);
+	}
+
+	static void *sCountingReallocate(void *inBlock, size_t inOldSize, size_t inNewSize, EMemoryTag inTag)
+	{
+		if (inBlock == nullptr)
+			++sNumAllocations[uint(inTag)];
+		return sPreviousHooks.mReallocate(inBlock, inOldSize, inNewSize, inTag);
+	}
+
+	static void sCountingFree(void *inBlock, size_t inSize, EMemoryTag inTag)
+	{
+		--sNumAllocations[uint(inTag)];
+		sPreviousHooks.mFree(inBlock, inSize, inTag);
+	}
+
+	static void *sCountingAlignedAllocate(size_t inSize, size_t inAlignment, EMemoryTag inTag)
+	{
+		++sNumAllocations[uint(inTag)];
+		return sPreviousHooks.mAlignedAllocate(inSize, inAlignment, inTag);
+	}
+
+	static void sCountingAlignedFree(void *inBlock, size_t inSize, EMemoryTag inTag)
+	{
+		--sNumAllocations[uint(inTag)];
+		sPreviousHooks.mAlignedFree(inBlock, inSize, inTag);
+	}
+
+	TEST_CASE("TestMemoryTagNames")
+	{
+		for (uint i = 0; i < uint(EMemoryTag::Count); ++i)
+			CHECK(strlen(GetMemoryTagName(EMemoryTag(i))) > 0);
+		CHECK(strcmp(GetMemoryTagName(EMemoryTag::BroadPhase), "BroadPhase") == 0);
+	}
+
+	TEST_CASE("TestMemoryUsage")
+	{
+		MemoryUsage before = GetMemoryUsage(EMemoryTag::Temporary);
+
+		void *block = Allocate(100, EMemoryTag::Temporary);
+		MemoryUsage usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes + 100);
+		CHECK(usage.mNumAllocations == before.mNumAllocations + 1);
+
+		block = Reallocate(block, 100, 200, EMemoryTag::Temporary);
+		usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes + 200);
+		CHECK(usage.mNumAllocations == before.mNumAllocations + 1);
+
+		void *aligned = AlignedAlloc(64, 64, EMemoryTag::Temporary);
+		CHECK(IsAligned(aligned, 64));
+		usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes + 264);
+		CHECK(usage.mNumAllocations == before.mNumAllocations + 2);
+
+		Free(block, 200, EMemoryTag::Temporary);
+		AlignedFree(aligned, 64, EMemoryTag::Temporary);
+		usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes);
+		CHECK(usage.mNumAllocations == before.mNumAllocations);
+	}
+
+	TEST_CASE("TestAlignedFreeWithoutSize")
+	{
+		MemoryUsage before = GetMemoryUsage(EMemoryTag::Temporary);
+
+		void *aligned = AlignedAlloc(100, 64, EMemoryTag::Temporary);
+		CHECK(IsAligned(aligned, 64));
+		MemoryUsage usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes + 100);
+		CHECK(usage.mNumAllocations == before.mNumAllocations + 1);
+
+		// The size and tag should be taken from the block
+		AlignedFree(aligned);
+		usage = GetMemoryUsage(EMemoryTag::Temporary);
+		CHECK(usage.mNumBytes == before.mNumBytes);
+		CHECK(usage.mNumAllocations == before.mNumAllocations);
+	}
+
+	TEST_CASE("TestTaggedVectorOverAligned")
+	{
+		struct alignas(64) Aligned64
+		{
+			float			mValue;
+		};
+
+		TaggedVector<Aligned64, EMemoryTag::Temporary> v(3);
+		CHECK(IsAligned(v.data(), 64));
+		v.resize(100);
+		CHECK(IsAligned(v.data(), 64));
+	}
+
+	TEST_CASE("TestTaggedVector")
+	{
+		MemoryUsage before = GetMemoryUsage(EMemoryTag::Contacts);
+		{
+			TaggedVector<uint32, EMemoryTag::Contacts> v;
+			v.reserve(1000);
+			for (uint32 i = 0; i < 1000; ++i)
+				v.push_back(i);
+
+			MemoryUsage usage = GetMemoryUsage(EMemoryTag::Contacts);
+			CHECK(usage.mNumBytes == before.mNumBytes + 1000 * sizeof(uint32));
+			CHECK(usage.mNumAllocations == before.mNumAllocations + 1);
+		}
+		MemoryUsage after = GetMemoryUsage(EMemoryTag::Contacts);
+		CHECK(after.mNumBytes == before.mNumBytes);
+		CHECK(after.mNumAllocations == before.mNumAllocations);
+	}
+
+	TEST_CASE("TestShapeMemoryTag")
+	{
+		MemoryUsage before = GetMemoryUsage(EMemoryTag::Shapes);
+		{
+			RefConst<Shape> sphere = new SphereShape(1.0f);
+			MemoryUsage usage = GetMemoryUsage(EMemoryTag::Shapes);
+			CHECK(usage.mNumBytes == before.mNumBytes + sizeof(SphereShape));
+			CHECK(usage.mNumAllocations == before.mNumAllocations + 1);
+		}
+		MemoryUsage after = GetMemoryUsage(EMemoryTag::Shapes);
+		CHECK(after.mNumBytes == before.mNumBytes);
+		CHECK(after.mNumAllocations == before.mNumAllocations);
+	}
+
+	TEST_CASE("TestAllocatorHooks")
+	{
+		sPreviousHooks = GetAllocatorHooks();
+		for (atomic<int> &n : sNumAllocations)
+			n = 0;
+		RegisterAllocatorHooks({ sCountingAllocate, sCountingReallocate, sCountingFree, sCountingAlignedAllocate, sCountingAlignedFree });
+
+		{
+			FixedSizeFreeList<uint64> list;
+			list.Init(1024, 128, EMemoryTag::Jobs);
+			int num_allocations = sNumAllocations[uint(EMemoryTag::Jobs)];
+			CHECK(num_allocations > 0);
+			uint32 index = list.ConstructObject(uint64(1));
+			CHECK(sNumAllocations[uint(EMemoryTag::Jobs)] == num_allocations + 1); // First page
+			list.DestructObject(index);
+			CHECK(sNumAllocations[uint(EMemoryTag::General)] == 0);
+
+			TaggedVector<float, EMemoryTag::Bodies> v(10);
+			CHECK(sNumAllocations[uint(EMemoryTag::Bodies)] == 1);
+		}
+
+		// Everything that was allocated through the hooks should have been freed
+		for (const atomic<int> &n : sNumAllocations)
+			CHECK(n == 0);
+
+		RegisterAllocatorHooks(sPreviousHooks);
+	}
+}
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/JobSystemThreadPool.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+#ifdef JPH_PROFILE_ENABLED
+
+TEST_SUITE("ProfilerTest")
+{
+	TEST_CASE("TestDumpTrace")
+	{
+		JPH_PROFILE_THREAD_START("Main");
+		JPH_PROFILE_CAPTURE_TRACE(2);
+		JPH_PROFILE_NEXTFRAME();
+
+		{
+			JPH_PROFILE("TestDumpTrace");
+
+			JobSystemThreadPool system(16, 4, 2);
+			JobSystem::Barrier *barrier = system.CreateBarrier();
+
+			// The first job starts the second job, this should show up as an arrow in the trace
+			JobHandle second = system.CreateJob("SecondTraceJob", Color::sGreen, []() { }, 1);
+			JobHandle first = system.CreateJob("FirstTraceJob", Color::sRed, [second]() { second.RemoveDependency(); });
+			barrier->AddJob(first);
+			barrier->AddJob(second);
+			system.WaitForJobs(barrier);
+			system.DestroyBarrier(barrier);
+		}
+
+		JPH_PROFILE_NEXTFRAME();
+		JPH_PROFILE_DUMP_TRACE("unit_test");
+		JPH_PROFILE_NEXTFRAME();
+		JPH_PROFILE_CAPTURE_TRACE(0);
+		JPH_PROFILE_THREAD_END();
+
+		// Read the trace back
+		const char *file_name = "profile_trace_unit_test.json";
+		string trace;
+		{
+			ifstream f(file_name);
+			REQUIRE(f.is_open());
+			stringstream ss;
+			ss << f.rdbuf();
+			trace = ss.str();
+		}
+		remove(file_name);
+
+		// Check that it contains the threads, samples, frames and the arrow between the jobs
+		CHECK(trace.find(R"("traceEvents":[)") != string::npos);
+		CHECK(trace.find(R"("args":{"name":"Main"})") != string::npos);
+		CHECK(trace.find(R"("name":"TestDumpTrace","cat":"profile","ph":"X")") != string::npos);
+		CHECK(trace.find(R"("name":"FirstTraceJob")") != string::npos);
+		CHECK(trace.find(R"("name":"SecondTraceJob")") != string::npos);
+		CHECK(trace.find(R"("color":"#ff0000")") != string::npos);
+		CHECK(trace.find(R"("name":"Frame 0")") != string::npos);
+		CHECK(trace.find(R"("name":"Frame 1")") != string::npos);
+		CHECK(trace.find(R"("ph":"s")") != string::npos);
+		CHECK(trace.find(R"("ph":"f","bp":"e")") != string::npos);
+		CHECK(trace.rfind("]}") != string::npos);
+	}
+}
+
+#endif // JPH_PROFILE_ENABLED
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/ScratchArena.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+
+TEST_SUITE("ScratchArenaTest")
+{
+	TEST_CASE("TestScratchArenaAllocate")
+	{
+		ScratchArena arena(1024);
+		CHECK(arena.IsEmpty());
+		CHECK(arena.GetSize() == 1024);
+
+		// Allocations are 16 byte aligned
+		void *a = arena.Allocate(10);
+		CHECK(a != nullptr);
+		CHECK(IsAligned(a, 16));
+		uint marker = arena.GetMarker();
+		CHECK(marker == 16);
+		void *b = arena.Allocate(100);
+		CHECK(b == static_cast<uint8 *>(a) + 16);
+		CHECK(arena.GetHighWaterMark() == 128);
+
+		// Too big to fit
+		CHECK(arena.Allocate(1024) == nullptr);
+		CHECK(arena.GetMarker() == 128);
+
+		// Rewinding returns the memory but keeps the high water mark
+		arena.Rewind(marker);
+		CHECK(arena.Allocate(100) == b);
+		arena.Rewind(0);
+		CHECK(arena.IsEmpty());
+		CHECK(arena.GetHighWaterMark() == 128);
+
+		arena.ResetHighWaterMark();
+		CHECK(arena.GetHighWaterMark() == 0);
+	}
+
+	TEST_CASE("TestScratchArray")
+	{
+		ScratchArena arena(1024);
+		ScratchArena::sSetForThread(&arena);
+		CHECK(ScratchArena::sGetForThread() == &arena);
+
+		{
+			// Fits in the arena
+			ScratchArray<Vec4> array(32);
+			CHECK(arena.GetMarker() == 32 * sizeof(Vec4));
+			for (int i = 0; i < 32; ++i)
+				array.push_back(Vec4::sReplicate(float(i)));
+			CHECK(array.size() == 32);
+			CHECK(array.capacity() == 32);
+			CHECK(array[31] == Vec4::sReplicate(31.0f));
+
+			{
+				// Doesn't fit in the arena anymore, falls back to the heap
+				ScratchArray<Vec4> array2(64);
+				CHECK(arena.GetMarker() == 32 * sizeof(Vec4));
+				array2.push_back(Vec4::sZero());
+				CHECK(array2.size() == 1);
+			}
+		}
+
+		{
+			// Elements that are not trivially destructible are destructed by clear and the destructor
+			struct Counted
+			{
+								Counted(int &ioNumDestructed) : mNumDestructed(ioNumDestructed) { }
+								~Counted()				{ ++mNumDestructed; }
+				int &			mNumDestructed;
+			};
+
+			int num_destructed = 0;
+			{
+				ScratchArray<Counted> array(4);
+				array.emplace_back(num_destructed);
+				array.emplace_back(num_destructed);
+				CHECK(array.data() == array.begin());
+				CHECK(&array[1].mNumDestructed == &num_destructed);
+				array.clear();
+				CHECK(array.empty());
+				CHECK(num_destructed == 2);
+				array.emplace_back(num_destructed);
+			}
+			CHECK(num_destructed == 3);
+		}
+
+		// Memory is returned to the arena
+		CHECK(arena.IsEmpty());
+
+		// Uninstall our arena, the thread should get a default arena
+		ScratchArena::sSetForThread(nullptr);
+		ScratchArena *default_arena = ScratchArena::sGetForThread();
+		CHECK(default_arena != &arena);
+		CHECK(default_arena->GetSize() == ScratchArena::cDefaultSize);
+	}
+
+	TEST_CASE("TestJobSystemScratchArenas")
+	{
+		const int cMaxJobs = 128;
+		const int cMaxBarriers = 10;
+		const int cNumThreads = 4;
+		const uint cArenaSize = 4096;
+		const uint cJobAllocationSize = 1024;
+		JobSystemThreadPool system(cMaxJobs, cMaxBarriers, cNumThreads, cArenaSize);
+
+		atomic<int> num_non_empty_arenas = 0;
+		atomic<int> num_failed_allocations = 0;
+
+		// Create jobs that allocate scratch memory
+		JobSystem::Barrier *barrier = system.CreateBarrier();
+		for (int i = 0; i < cMaxJobs; ++i)
+		{
+			JobHandle handle = system.CreateJob("ScratchArenaTest", Color::sRed, [&num_non_empty_arenas, &num_failed_allocations]() {
+				// Arena should not be shared with jobs that are running at the same time
+				ScratchArena *arena = ScratchArena::sGetForThread();
+				if (!arena->IsEmpty())
+					num_non_empty_arenas++;
+
+				ScratchArenaScope scope;
+				uint8 *memory = static_cast<uint8 *>(scope.Allocate(cJobAllocationSize));
+				if (memory == nullptr)
+					num_failed_allocations++;
+				else
+					memset(memory, 0xcd, cJobAllocationSize);
+			});
+			barrier->AddJob(handle);
+		}
+		system.WaitForJobs(barrier);
+		system.DestroyBarrier(barrier);
+
+		CHECK(num_non_empty_arenas == 0);
+		CHECK(num_failed_allocations == 0);
+
+		// Every worker thread either didn't run any job or used exactly the memory of 1 job at a time
+		for (int i = 0; i < cNumThreads; ++i)
+		{
+			uint high_water_mark = system.GetScratchArenaHighWaterMark(i);
+			CHECK((high_water_mark == 0 || high_water_mark == cJobAllocationSize));
+		}
+
+		system.ResetScratchArenaHighWaterMarks();
+		for (int i = 0; i < cNumThreads; ++i)
+			CHECK(system.GetScratchArenaHighWaterMark(i) == 0);
+	}
+}
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Core/Semaphore.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+TEST_SUITE("SemaphoreTest")
+{
+	TEST_CASE("TestSemaphoreNoWait")
+	{
+		Semaphore semaphore;
+		CHECK(semaphore.GetValue() == 0);
+
+		// Release and acquire on the same thread should not block
+		semaphore.Release(3);
+		CHECK(semaphore.GetValue() == 3);
+		semaphore.Acquire(2);
+		CHECK(semaphore.GetValue() == 1);
+		semaphore.Acquire();
+		CHECK(semaphore.GetValue() == 0);
+	}
+
+	TEST_CASE("TestSemaphoreProducerConsumer")
+	{
+		const int cNumConsumers = 4;
+		const int cNumItemsPerConsumer = 1000;
+
+		Semaphore semaphore;
+		atomic<int> num_consumed = 0;
+
+		// Start consumers that will go to sleep waiting for the semaphore
+		vector<thread> consumers;
+		for (int i = 0; i < cNumConsumers; ++i)
+			consumers.emplace_back([&semaphore, &num_consumed]() {
+				for (int j = 0; j < cNumItemsPerConsumer; ++j)
+				{
+					semaphore.Acquire();
+					num_consumed++;
+				}
+			});
+
+		// Release the semaphore one by one and in batches so that we test waking sleeping and spinning threads
+		for (int i = 0; i < cNumConsumers * cNumItemsPerConsumer / 2; ++i)
+			semaphore.Release();
+		for (int i = 0; i < cNumConsumers * cNumItemsPerConsumer / 2; i += 10)
+			semaphore.Release(10);
+
+		// All consumers should finish
+		for (thread &t : consumers)
+			t.join();
+		CHECK(num_consumed == cNumConsumers * cNumItemsPerConsumer);
+		CHECK(semaphore.GetValue() == 0);
+	}
+}
@@ -4,6 +4,7 @@
 #include "UnitTestFramework.h"
 #include <Jolt/Geometry/AABox.h>
 #include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Geometry/RayPacket4.h>
 
 TEST_SUITE("RayAABoxTests")
 {
@@ -82,4 +83,31 @@ TEST_SUITE("RayAABoxTests")
 			CHECK_APPROX_EQUAL(expected_fraction, fraction, 1.0e-6f);
 		}
 	}
+
+	TEST_CASE("TestRayPacket4AABox")
+	{
+		AABox box(Vec3::sReplicate(-1.0f), Vec3::sReplicate(1.0f));
+
+		// Rays that start inside, hit under an angle, miss and are parallel to an axis
+		Vec3 origins[] = { Vec3::sZero(), Vec3(0, 1, 0) - 0.123f * Vec3(4, -4, 0), Vec3(0, 2, 0), Vec3(0.5f, -1.1f, 0.5f) };
+		Vec3 directions[] = { Vec3(1, 0, 0), Vec3(4, -4, 0), Vec3(1, 0, 0), Vec3(0, 1, 0) };
+
+		// The packet should give the same results as testing the rays one by one
+		RayPacket4 packet(origins, directions, 4);
+		Vec4 fractions = RayPacket4AABox(packet, box.mMin, box.mMax);
+		for (int i = 0; i < 4; ++i)
+			CHECK(fractions[i] == RayAABox(origins[i], RayInvDirection(directions[i]), box.mMin, box.mMax));
+		CHECK_APPROX_EQUAL(-1.0f, fractions[0], 1.0e-6f);
+		CHECK_APPROX_EQUAL(0.123f, fractions[1], 1.0e-6f);
+		CHECK(fractions[2] == FLT_MAX);
+		CHECK_APPROX_EQUAL(0.1f, fractions[3], 1.0e-6f);
+
+		// Rays that are not in use never hit
+		RayPacket4 partial_packet(origins, directions, 2);
+		fractions = RayPacket4AABox(partial_packet, box.mMin, box.mMax);
+		CHECK_APPROX_EQUAL(-1.0f, fractions[0], 1.0e-6f);
+		CHECK_APPROX_EQUAL(0.123f, fractions[1], 1.0e-6f);
+		CHECK(fractions[2] == FLT_MAX);
+		CHECK(fractions[3] == FLT_MAX);
+	}
 }
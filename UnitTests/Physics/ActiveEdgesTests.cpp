@@ -61,7 +61,7 @@ TEST_SUITE("ActiveEdgesTest")
 
 	// Compare expected hits with returned hits
 	template <class ResultType>
-	static void sCheckMatch(const vector<ResultType> &inResult, const vector<ExpectedHit> &inExpectedHits, float inAccuracySq)
+	static void sCheckMatch(const TaggedVector<ResultType> &inResult, const vector<ExpectedHit> &inExpectedHits, float inAccuracySq)
 	{
 		CHECK(inResult.size() == inExpectedHits.size());
 
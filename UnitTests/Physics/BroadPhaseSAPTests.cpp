@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include "PhysicsTestContext.h"
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseSAP.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBruteForce.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Geometry/OrientedBox.h>
+#include "BroadPhaseCompare.h"
+#include "Layers.h"
+
+TEST_SUITE("BroadPhaseSAPTests")
+{
+	TEST_CASE("TestBroadPhaseSAPVsBruteForce")
+	{
+		BPLayerInterfaceImpl broad_phase_layer_interface;
+
+		// Create 2 body managers with the same bodies, one for each broadphase
+		constexpr int cNumBodies = 500;
+		BodyManager reference_body_manager, sap_body_manager;
+		reference_body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+		sap_body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+
+		BroadPhaseBruteForce reference;
+		reference.Init(&reference_body_manager, broad_phase_layer_interface);
+		BroadPhaseSAP sap;
+		sap.Init(&sap_body_manager, broad_phase_layer_interface);
+
+		// Create random boxes in a mostly flat world
+		UnitTestRandom random;
+		uniform_real_distribution<float> position(-50.0f, 50.0f);
+		uniform_real_distribution<float> size(0.1f, 2.0f);
+		BodyIDVector ids;
+		for (int i = 0; i < cNumBodies; ++i)
+		{
+			EMotionType motion_type = i % 3 == 0? EMotionType::Static : EMotionType::Dynamic;
+			ObjectLayer layer = motion_type == EMotionType::Static? Layers::NON_MOVING : (i % 3 == 1? Layers::MOVING : Layers::LQ_DEBRIS);
+			BodyCreationSettings settings(new BoxShape(Vec3(size(random), size(random), size(random))), Vec3(position(random), 0.1f * position(random), position(random)), Quat::sIdentity(), motion_type, layer);
+			BodyID reference_id = reference_body_manager.CreateBody(settings)->GetID();
+			BodyID sap_id = sap_body_manager.CreateBody(settings)->GetID();
+			CHECK(reference_id == sap_id);
+			ids.push_back(sap_id);
+		}
+
+		// Add them in batches, this leaves the bodies unsorted in the SAP
+		for (int i = 0; i < cNumBodies; i += 50)
+		{
+			reference.AddBodiesFinalize(ids.data() + i, 50, reference.AddBodiesPrepare(ids.data() + i, 50));
+			sap.AddBodiesFinalize(ids.data() + i, 50, sap.AddBodiesPrepare(ids.data() + i, 50));
+		}
+		CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+
+		// Activate the dynamic bodies
+		for (BodyManager *body_manager : { &reference_body_manager, &sap_body_manager })
+		{
+			body_manager->LockAllBodies();
+			body_manager->ActivateBodies(ids.data(), (int)ids.size());
+			body_manager->UnlockAllBodies();
+		}
+		CompareBroadPhasePairs(reference_body_manager, reference, sap_body_manager, sap);
+
+		// Sort the SAP, the world is flat so a query for a small box should not sweep along Y
+		sap.Optimize();
+		CHECK(sap.GetSweepAxis(BroadPhaseLayers::NON_MOVING, AABox(Vec3::sReplicate(-1.0f), Vec3::sReplicate(1.0f))) != 1);
+		CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+		CompareBroadPhasePairs(reference_body_manager, reference, sap_body_manager, sap);
+
+		// Moves bodies by a random amount in both body managers and notifies the broadphases
+		auto move_bodies = [&](float inDistance)
+		{
+			uniform_real_distribution<float> offset(-inDistance, inDistance);
+			BodyIDVector moved;
+			for (BodyID id : ids)
+			{
+				Body &reference_body = reference_body_manager.GetBody(id);
+				if (reference_body.IsStatic())
+					continue;
+
+				Vec3 new_position = reference_body.GetPosition() + Vec3(offset(random), offset(random), offset(random));
+				reference_body.SetPositionAndRotationInternal(new_position, Quat::sIdentity());
+				sap_body_manager.GetBody(id).SetPositionAndRotationInternal(new_position, Quat::sIdentity());
+				moved.push_back(id);
+			}
+			reference.NotifyBodiesAABBChanged(moved.data(), (int)moved.size(), true);
+			sap.NotifyBodiesAABBChanged(moved.data(), (int)moved.size(), true);
+		};
+
+		// Simulates a physics update for the SAP
+		auto update = [&sap]()
+		{
+			sap.FrameSync();
+			sap.LockModifications();
+			BroadPhase::UpdateState update_state = sap.UpdatePrepare();
+			sap.UpdateFinalize(update_state);
+			sap.UnlockModifications();
+		};
+
+		for (float distance : { 0.5f, 20.0f })
+		{
+			// Move bodies, queries should still find them before the array has been resorted
+			move_bodies(distance);
+			CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+			CompareBroadPhasePairs(reference_body_manager, reference, sap_body_manager, sap);
+
+			// Resort
+			update();
+			CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+			CompareBroadPhasePairs(reference_body_manager, reference, sap_body_manager, sap);
+		}
+
+		// Remove a third of the bodies
+		BodyIDVector removed;
+		for (size_t i = 0; i < ids.size(); i += 3)
+			removed.push_back(ids[i]);
+		reference.RemoveBodies(removed.data(), (int)removed.size());
+		sap.RemoveBodies(removed.data(), (int)removed.size());
+		CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+
+		// Add them again, this places them twice in the SAP arrays until the next update
+		reference.AddBodiesFinalize(removed.data(), (int)removed.size(), reference.AddBodiesPrepare(removed.data(), (int)removed.size()));
+		sap.AddBodiesFinalize(removed.data(), (int)removed.size(), sap.AddBodiesPrepare(removed.data(), (int)removed.size()));
+		CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+		update();
+		CompareBroadPhaseQueries(reference, sap, random, 0.1f);
+		CompareBroadPhasePairs(reference_body_manager, reference, sap_body_manager, sap);
+	}
+
+	TEST_CASE("TestBroadPhaseSAPSweepAxis")
+	{
+		BPLayerInterfaceImpl broad_phase_layer_interface;
+
+		// Create body manager
+		constexpr int cNumBodies = 100;
+		BodyManager body_manager;
+		body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+
+		BroadPhaseSAP broadphase;
+		broadphase.Init(&body_manager, broad_phase_layer_interface);
+
+		// Create a row of boxes along the Z axis
+		RefConst<Shape> box = new BoxShape(Vec3::sReplicate(0.4f));
+		BodyIDVector ids;
+		for (int i = 0; i < cNumBodies; ++i)
+			ids.push_back(body_manager.CreateBody(BodyCreationSettings(box, Vec3(0, 0, float(i)), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING))->GetID());
+		broadphase.AddBodiesFinalize(ids.data(), cNumBodies, nullptr);
+
+		// All boxes overlap along X and Y, so a query should sweep the Z axis
+		broadphase.Optimize();
+		AABox query(Vec3(-1, -1, 9.5f), Vec3(1, 1, 12.5f));
+		CHECK(broadphase.GetSweepAxis(BroadPhaseLayers::NON_MOVING, query) == 2);
+
+		// A box query should find exactly the boxes it overlaps
+		AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+		broadphase.CollideAABox(query, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+		CHECK(GetSortedHits(collector) == BodyIDVector { ids[10], ids[11], ids[12] });
+
+		// Spread the boxes out along the X axis too, after the next sort a query that is narrow along X should sweep the X axis
+		for (int i = 0; i < cNumBodies; ++i)
+			body_manager.GetBody(ids[i]).SetPositionAndRotationInternal(Vec3(float(i) * 10.0f, 0, float(i)), Quat::sIdentity());
+		broadphase.NotifyBodiesAABBChanged(ids.data(), cNumBodies, true);
+		broadphase.FrameSync();
+		broadphase.LockModifications();
+		BroadPhase::UpdateState update_state = broadphase.UpdatePrepare();
+		broadphase.UpdateFinalize(update_state);
+		broadphase.UnlockModifications();
+		query = AABox(Vec3(99, -1, -1), Vec3(121, 1, 50));
+		CHECK(broadphase.GetSweepAxis(BroadPhaseLayers::NON_MOVING, query) == 0);
+
+		collector.Reset();
+		broadphase.CollideAABox(query, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+		CHECK(GetSortedHits(collector) == BodyIDVector { ids[10], ids[11], ids[12] });
+
+		// A query that is narrow along Z should sweep the Z axis
+		query = AABox(Vec3(-1, -1, 19.5f), Vec3(1000, 1, 20.5f));
+		CHECK(broadphase.GetSweepAxis(BroadPhaseLayers::NON_MOVING, query) == 2);
+
+		collector.Reset();
+		broadphase.CollideAABox(query, collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+		CHECK(GetSortedHits(collector) == BodyIDVector { ids[20] });
+	}
+
+	TEST_CASE("TestPhysicsSAPBoxOnFloor")
+	{
+		// Drop a box on the floor using a physics system with the SAP broadphase
+		PhysicsTestContext c(1.0f / 60.0f, 1, 1, 0, EBroadPhaseType::SweepAndPrune);
+		c.CreateFloor();
+		Body &box = c.CreateBox(Vec3(0, 2, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f));
+		c.Simulate(2.0f);
+
+		// The box should be resting on the floor (allowing for the penetration slop)
+		CHECK_APPROX_EQUAL(box.GetPosition(), Vec3(0, 0.5f, 0), 0.05f);
+	}
+}
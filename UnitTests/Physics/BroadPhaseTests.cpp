@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "UnitTestFramework.h"
+#include "PhysicsTestContext.h"
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuadTree.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
@@ -9,6 +10,8 @@
 #include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Physics/Body/BodyManager.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/PhysicsScene.h>
+#include <Jolt/Core/StreamWrapper.h>
 #include "Layers.h"
 
 TEST_SUITE("BroadPhaseTests")
@@ -110,4 +113,253 @@ TEST_SUITE("BroadPhaseTests")
 		CHECK_APPROX_EQUAL(collector.mHits[0].mFraction, 0.5f);
 		collector.Reset();
 	}
+
+	TEST_CASE("TestBroadPhaseBoundsMargin")
+	{
+		BPLayerInterfaceImpl broad_phase_layer_interface; 
+
+		// Create body manager
+		BodyManager body_manager;
+		body_manager.Init(1, 0, broad_phase_layer_interface);
+		
+		// Create quad tree that enlarges the bounds of moving bodies by 0.5 and by the distance traveled in 1 second
+		BroadPhaseQuadTree broadphase;
+		broadphase.Init(&body_manager, broad_phase_layer_interface);
+		broadphase.SetBodyBoundsMargin(0.5f, 1.0f);
+
+		// Create a dynamic box
+		BodyCreationSettings settings(new BoxShape(Vec3::sReplicate(1.0f)), Vec3::sZero(), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
+		Body &body = *body_manager.CreateBody(settings);
+
+		// Add it to the broadphase
+		BodyID id = body.GetID();
+		BroadPhase::AddState add_state = broadphase.AddBodiesPrepare(&id, 1);
+		broadphase.AddBodiesFinalize(&id, 1, add_state);
+
+		// Test if a box around inPoint finds the body
+		auto hits_body = [&broadphase, id](Vec3Arg inPoint)
+		{
+			AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+			broadphase.CollideAABox(AABox(inPoint - Vec3::sReplicate(0.01f), inPoint + Vec3::sReplicate(0.01f)), collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+			return collector.mHits.size() == 1 && collector.mHits[0] == id;
+		};
+
+		// The body should be in the broadphase with enlarged bounds
+		CHECK(hits_body(Vec3(1.4f, 0, 0)));
+		CHECK(hits_body(Vec3(-1.4f, 0, 0)));
+		CHECK(!hits_body(Vec3(1.6f, 0, 0)));
+
+		// Move the body a bit, this should not modify the broadphase as it stays within its enlarged bounds, so optimizing should not shrink the bounds
+		body.SetPositionAndRotationInternal(Vec3(0.3f, 0, 0), Quat::sIdentity());
+		broadphase.NotifyBodiesAABBChanged(&id, 1, true);
+		broadphase.Optimize();
+		CHECK(hits_body(Vec3(-1.4f, 0, 0)));
+		CHECK(!hits_body(Vec3(1.6f, 0, 0)));
+
+		// Give the body a velocity and move it out of its bounds, the new bounds should be extended in the direction of the velocity
+		body.SetLinearVelocity(Vec3(2, 0, 0));
+		body.SetPositionAndRotationInternal(Vec3(1.0f, 0, 0), Quat::sIdentity());
+		broadphase.NotifyBodiesAABBChanged(&id, 1, true);
+		broadphase.Optimize();
+		CHECK(!hits_body(Vec3(-0.6f, 0, 0)));
+		CHECK(hits_body(Vec3(-0.4f, 0, 0)));
+		CHECK(hits_body(Vec3(4.4f, 0, 0)));
+		CHECK(!hits_body(Vec3(4.6f, 0, 0)));
+		CHECK(hits_body(Vec3(1.0f, 1.4f, 0)));
+		CHECK(!hits_body(Vec3(1.0f, 1.6f, 0)));
+	}
+
+	TEST_CASE("TestBroadPhaseOptimizeInBackground")
+	{
+		for (float time_budget : { 0.0f, 1.0f })
+		{
+			BPLayerInterfaceImpl broad_phase_layer_interface; 
+
+			// Create body manager
+			constexpr int cNumBodies = 1000;
+			BodyManager body_manager;
+			body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+
+			// Create quad tree
+			BroadPhaseQuadTree broadphase;
+			broadphase.Init(&body_manager, broad_phase_layer_interface);
+			broadphase.SetUpdateTimeBudget(time_budget);
+
+			// Add static and moving boxes on a grid in small batches, this creates a poor tree
+			RefConst<Shape> box = new BoxShape(Vec3::sReplicate(0.4f));
+			constexpr int cBatchSize = 10;
+			for (int batch = 0; batch < cNumBodies / cBatchSize; ++batch)
+			{
+				BodyID ids[cBatchSize];
+				for (int i = 0; i < cBatchSize; ++i)
+				{
+					int index = batch * cBatchSize + i;
+					EMotionType motion_type = index % 2 == 0? EMotionType::Static : EMotionType::Dynamic;
+					BodyCreationSettings settings(box, Vec3(float(index % 32), 0, float(index / 32)), Quat::sIdentity(), motion_type, motion_type == EMotionType::Static? Layers::NON_MOVING : Layers::MOVING);
+					ids[i] = body_manager.CreateBody(settings)->GetID();
+				}
+				BroadPhase::AddState add_state = broadphase.AddBodiesPrepare(ids, cBatchSize);
+				broadphase.AddBodiesFinalize(ids, cBatchSize, add_state);
+			}
+
+			// Check that all bodies can be found
+			auto check_all_bodies_found = [&]()
+			{
+				AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+				broadphase.CollideAABox(AABox(Vec3(-1, -1, -1), Vec3(33, 1, 33)), collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+				CHECK(collector.mHits.size() == cNumBodies);
+
+				AllHitCollisionCollector<RayCastBodyCollector> ray_collector;
+				broadphase.CastRay({ Vec3(5, 2, 7), Vec3(0, -4, 0) }, ray_collector, BroadPhaseLayerFilter(), ObjectLayerFilter());
+				CHECK(ray_collector.mHits.size() == 1);
+			};
+			check_all_bodies_found();
+
+			// Request the optimization and do a couple of updates, the broadphase should remain usable while the trees are being rebuilt
+			broadphase.OptimizeInBackground();
+			for (int update = 0; update < 4; ++update)
+			{
+				broadphase.FrameSync();
+				broadphase.LockModifications();
+				BroadPhase::UpdateState update_state = broadphase.UpdatePrepare();
+				check_all_bodies_found();
+				broadphase.UpdateFinalize(update_state);
+				broadphase.UnlockModifications();
+				check_all_bodies_found();
+			}
+		}
+	}
+
+	TEST_CASE("TestBroadPhaseDormantBodies")
+	{
+		PhysicsTestContext c;
+		PhysicsSettings settings;
+		settings.mBroadPhaseDormantInterval = 1;
+		c.GetSystem()->SetPhysicsSettings(settings);
+		c.CreateFloor();
+
+		// A sleeping box on the floor and a box that falls on top of it
+		Body &sleeping_box = c.CreateBox(Vec3(0, 0.5f, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f), EActivation::DontActivate);
+		Body &falling_box = c.CreateBox(Vec3(0, 2.0f, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f));
+
+		// Check that a ray finds both boxes
+		auto check_boxes_found = [&]()
+		{
+			AllHitCollisionCollector<RayCastBodyCollector> collector;
+			c.GetSystem()->GetBroadPhaseQuery().CastRay({ Vec3(0, 10, 0), Vec3(0, -9.7f, 0) }, collector, SpecifiedBroadPhaseLayerFilter(BroadPhaseLayers::MOVING), ObjectLayerFilter());
+			CHECK(collector.mHits.size() == 2);
+		};
+
+		// The first step moves the sleeping box to the dormant tree
+		c.SimulateSingleStep();
+		CHECK(!sleeping_box.IsActive());
+		check_boxes_found();
+
+		// The falling box should hit the sleeping box and wake it up
+		c.Simulate(0.6f);
+		CHECK(sleeping_box.IsActive());
+		check_boxes_found();
+
+		// Wait until both boxes are asleep again, the falling box should rest on top of the other box
+		c.Simulate(2.0f);
+		CHECK(!sleeping_box.IsActive());
+		CHECK(!falling_box.IsActive());
+		CHECK_APPROX_EQUAL(sleeping_box.GetPosition(), Vec3(0, 0.5f, 0), 5.0e-2f);
+		CHECK_APPROX_EQUAL(falling_box.GetPosition(), Vec3(0, 1.5f, 0), 5.0e-2f);
+		c.SimulateSingleStep();
+		check_boxes_found();
+
+		// Check that the boxes can still be found after the trees have been rebuilt
+		c.GetSystem()->OptimizeBroadPhase();
+		check_boxes_found();
+
+		// Remove the box from the dormant tree
+		c.GetBodyInterface().RemoveBody(falling_box.GetID());
+		AllHitCollisionCollector<RayCastBodyCollector> collector;
+		c.GetSystem()->GetBroadPhaseQuery().CastRay({ Vec3(0, 10, 0), Vec3(0, -9.7f, 0) }, collector, SpecifiedBroadPhaseLayerFilter(BroadPhaseLayers::MOVING), ObjectLayerFilter());
+		CHECK(collector.mHits.size() == 1);
+	}
+
+	TEST_CASE("TestBroadPhaseTreeLayout")
+	{
+		// Create a scene with a grid of static boxes in 2 layers and a couple of dynamic boxes
+		Ref<PhysicsScene> scene = new PhysicsScene();
+		RefConst<Shape> box = new BoxShape(Vec3::sReplicate(0.4f));
+		for (int x = 0; x < 20; ++x)
+			for (int z = 0; z < 20; ++z)
+				scene->AddBody(BodyCreationSettings(box, Vec3(float(x), 0, float(z)), Quat::sIdentity(), EMotionType::Static, (x + z) % 5 == 0? Layers::LQ_DEBRIS : Layers::NON_MOVING));
+		for (int i = 0; i < 5; ++i)
+			scene->AddBody(BodyCreationSettings(box, Vec3(float(i), 2, 0), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING));
+
+		// Save the scene including the trees and restore it
+		stringstream data;
+		{
+			StreamOutWrapper stream_out(data);
+			scene->SaveBinaryState(stream_out, true, true, true);
+		}
+		Ref<PhysicsScene> restored_scene;
+		{
+			StreamInWrapper stream_in(data);
+			PhysicsScene::PhysicsSceneResult result = PhysicsScene::sRestoreFromBinaryState(stream_in);
+			CHECK(result.IsValid());
+			restored_scene = result.Get();
+		}
+
+		// Check that there's a tree per object layer that contains all static bodies
+		const TaggedVector<PhysicsScene::StaticBodyTree> &trees = restored_scene->GetStaticBodyTrees();
+		CHECK(trees.size() == 2);
+		uint num_static_bodies = 0;
+		for (const PhysicsScene::StaticBodyTree &tree : trees)
+		{
+			CHECK(tree.mLayout.IsValid());
+			CHECK(tree.mLayout.mNumBodies == tree.mBodies.size());
+			num_static_bodies += tree.mLayout.mNumBodies;
+		}
+		CHECK(num_static_bodies == 400);
+
+		// A layout that references a body twice is not valid
+		BroadPhaseTreeLayout layout = trees[0].mLayout;
+		layout.mNodes.back().mChildren[0] = layout.mNodes.back().mChildren[1];
+		CHECK(!layout.IsValid());
+
+		// Instantiate the scene, all static bodies should be found without optimizing the broadphase
+		PhysicsTestContext c;
+		CHECK(restored_scene->CreateBodies(c.GetSystem()));
+		for (int x = 0; x < 20; ++x)
+			for (int z = 0; z < 20; ++z)
+			{
+				AllHitCollisionCollector<RayCastBodyCollector> collector;
+				c.GetSystem()->GetBroadPhaseQuery().CastRay({ Vec3(float(x), 1, float(z)), Vec3(0, -2, 0) }, collector);
+				CHECK(collector.mHits.size() == 1);
+			}
+
+		// The dynamic bodies should have been added and activated too
+		CHECK(c.GetSystem()->GetNumBodies() == 405);
+		CHECK(c.GetSystem()->GetNumActiveBodies() == 5);
+		c.Simulate(1.0f);
+
+		// Make one body in each tree invalid for its tree: change the motion type of one and the object layer of another
+		for (const PhysicsScene::StaticBodyTree &tree : trees)
+			CHECK(tree.mObjectLayer == restored_scene->GetBodies()[tree.mBodies[0]].mObjectLayer);
+		BodyCreationSettings &dynamic_body = restored_scene->GetBodies()[trees[0].mBodies[0]];
+		dynamic_body.mMotionType = EMotionType::Dynamic;
+		dynamic_body.mObjectLayer = Layers::MOVING;
+		BodyCreationSettings &moved_layer_body = restored_scene->GetBodies()[trees[1].mBodies[0]];
+		moved_layer_body.mObjectLayer = trees[0].mObjectLayer;
+
+		// The trees should be skipped and all bodies should still be added to the broadphase with the right settings
+		PhysicsTestContext c2;
+		CHECK(restored_scene->CreateBodies(c2.GetSystem()));
+		CHECK(c2.GetSystem()->GetNumBodies() == 405);
+		CHECK(c2.GetSystem()->GetNumActiveBodies() == 6);
+		for (int x = 0; x < 20; ++x)
+			for (int z = 0; z < 20; ++z)
+			{
+				AllHitCollisionCollector<RayCastBodyCollector> collector;
+				c2.GetSystem()->GetBroadPhaseQuery().CastRay({ Vec3(float(x), 1, float(z)), Vec3(0, -2, 0) }, collector);
+				CHECK(collector.mHits.size() == 1);
+				for (const BroadPhaseCastResult &hit : collector.mHits)
+					CHECK(c2.GetBodyInterface().GetObjectLayer(hit.mBodyID) == restored_scene->GetBodies()[hit.mBodyID.GetIndex()].mObjectLayer);
+			}
+	}
 }
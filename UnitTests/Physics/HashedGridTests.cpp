@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuadTree.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBruteForce.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Geometry/OrientedBox.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/TempAllocator.h>
+#include "BroadPhaseCompare.h"
+#include "Layers.h"
+
+TEST_SUITE("HashedGridTests")
+{
+	// Layer interface that stores the MOVING layer in a grid with fixed cell size and the LQ_DEBRIS layer in a grid with automatic cell size
+	class GridBPLayerInterfaceImpl final : public BroadPhaseLayerInterface
+	{
+	public:
+		virtual uint				GetNumBroadPhaseLayers() const override
+		{
+			return mLayers.GetNumBroadPhaseLayers();
+		}
+
+		virtual BroadPhaseLayer		GetBroadPhaseLayer(ObjectLayer inLayer) const override
+		{
+			return mLayers.GetBroadPhaseLayer(inLayer);
+		}
+
+		virtual float				GetBroadPhaseLayerGridCellSize(BroadPhaseLayer inLayer) const override
+		{
+			if (inLayer == BroadPhaseLayers::MOVING)
+				return 4.0f;
+			else if (inLayer == BroadPhaseLayers::LQ_DEBRIS)
+				return -1.0f;
+			else
+				return 0.0f;
+		}
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+		virtual const char *		GetBroadPhaseLayerName(BroadPhaseLayer inLayer) const override
+		{
+			return mLayers.GetBroadPhaseLayerName(inLayer);
+		}
+#endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
+
+	private:
+		BPLayerInterfaceImpl		mLayers;
+	};
+
+	TEST_CASE("TestHashedGridVsBruteForce")
+	{
+		GridBPLayerInterfaceImpl broad_phase_layer_interface;
+
+		// Create 2 body managers with the same bodies, one for each broadphase
+		constexpr int cNumBodies = 500;
+		BodyManager reference_body_manager, grid_body_manager;
+		reference_body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+		grid_body_manager.Init(cNumBodies, 0, broad_phase_layer_interface);
+
+		BroadPhaseBruteForce reference;
+		reference.Init(&reference_body_manager, broad_phase_layer_interface);
+		BroadPhaseQuadTree grid;
+		grid.Init(&grid_body_manager, broad_phase_layer_interface);
+
+		// Create random boxes, the static ones end up in a tree and the dynamic ones in a grid
+		UnitTestRandom random;
+		uniform_real_distribution<float> position(-50.0f, 50.0f);
+		uniform_real_distribution<float> size(0.1f, 2.0f);
+		BodyIDVector ids;
+		for (int i = 0; i < cNumBodies; ++i)
+		{
+			EMotionType motion_type = i % 3 == 0? EMotionType::Static : EMotionType::Dynamic;
+			ObjectLayer layer = motion_type == EMotionType::Static? Layers::NON_MOVING : (i % 3 == 1? Layers::MOVING : Layers::LQ_DEBRIS);
+			BodyCreationSettings settings(new BoxShape(Vec3(size(random), size(random), size(random))), Vec3(position(random), position(random), position(random)), Quat::sIdentity(), motion_type, layer);
+			BodyID reference_id = reference_body_manager.CreateBody(settings)->GetID();
+			BodyID grid_id = grid_body_manager.CreateBody(settings)->GetID();
+			CHECK(reference_id == grid_id);
+			ids.push_back(grid_id);
+		}
+
+		// Add them in batches, this leaves the bodies in the list of added bodies of the grid
+		for (int i = 0; i < cNumBodies; i += 50)
+		{
+			reference.AddBodiesFinalize(ids.data() + i, 50, reference.AddBodiesPrepare(ids.data() + i, 50));
+			grid.AddBodiesFinalize(ids.data() + i, 50, grid.AddBodiesPrepare(ids.data() + i, 50));
+		}
+		CompareBroadPhaseQueries(reference, grid, random);
+
+		// Activate the dynamic bodies
+		for (BodyManager *body_manager : { &reference_body_manager, &grid_body_manager })
+		{
+			body_manager->LockAllBodies();
+			body_manager->ActivateBodies(ids.data(), (int)ids.size());
+			body_manager->UnlockAllBodies();
+		}
+		CompareBroadPhasePairs(reference_body_manager, reference, grid_body_manager, grid);
+
+		// Build the grids
+		grid.Optimize();
+		CompareBroadPhaseQueries(reference, grid, random);
+		CompareBroadPhasePairs(reference_body_manager, reference, grid_body_manager, grid);
+
+		// Moves bodies by a random amount in both body managers and notifies the broadphases
+		auto move_bodies = [&](float inDistance)
+		{
+			uniform_real_distribution<float> offset(-inDistance, inDistance);
+			BodyIDVector moved;
+			for (BodyID id : ids)
+			{
+				Body &reference_body = reference_body_manager.GetBody(id);
+				if (reference_body.IsStatic())
+					continue;
+
+				Vec3 new_position = reference_body.GetPosition() + Vec3(offset(random), offset(random), offset(random));
+				reference_body.SetPositionAndRotationInternal(new_position, Quat::sIdentity());
+				grid_body_manager.GetBody(id).SetPositionAndRotationInternal(new_position, Quat::sIdentity());
+				moved.push_back(id);
+			}
+			reference.NotifyBodiesAABBChanged(moved.data(), (int)moved.size(), true);
+			grid.NotifyBodiesAABBChanged(moved.data(), (int)moved.size(), true);
+		};
+
+		// Simulates a physics update
+		auto update = [&grid]()
+		{
+			grid.FrameSync();
+			grid.LockModifications();
+			BroadPhase::UpdateState update_state = grid.UpdatePrepare();
+			grid.UpdateFinalize(update_state);
+			grid.UnlockModifications();
+		};
+
+		for (float distance : { 0.5f, 20.0f })
+		{
+			// Move bodies, queries should still find them before the grid has been rebuilt
+			move_bodies(distance);
+			CompareBroadPhaseQueries(reference, grid, random);
+			CompareBroadPhasePairs(reference_body_manager, reference, grid_body_manager, grid);
+
+			// Rebuild
+			update();
+			CompareBroadPhaseQueries(reference, grid, random);
+			CompareBroadPhasePairs(reference_body_manager, reference, grid_body_manager, grid);
+		}
+
+		// Remove a third of the bodies
+		BodyIDVector removed;
+		for (size_t i = 0; i < ids.size(); i += 3)
+			removed.push_back(ids[i]);
+		reference.RemoveBodies(removed.data(), (int)removed.size());
+		grid.RemoveBodies(removed.data(), (int)removed.size());
+		CompareBroadPhaseQueries(reference, grid, random);
+
+		// Add them again, this reuses the elements in the list of added bodies
+		reference.AddBodiesFinalize(removed.data(), (int)removed.size(), reference.AddBodiesPrepare(removed.data(), (int)removed.size()));
+		grid.AddBodiesFinalize(removed.data(), (int)removed.size(), grid.AddBodiesPrepare(removed.data(), (int)removed.size()));
+		CompareBroadPhaseQueries(reference, grid, random);
+		update();
+		CompareBroadPhaseQueries(reference, grid, random);
+		CompareBroadPhasePairs(reference_body_manager, reference, grid_body_manager, grid);
+	}
+
+	TEST_CASE("TestPhysicsHashedGridDebrisOnFloor")
+	{
+		TempAllocatorImpl temp_allocator(4 * 1024 * 1024);
+		JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, 0);
+		GridBPLayerInterfaceImpl broad_phase_layer_interface;
+		PhysicsSystem system;
+		system.Init(1024, 0, 4096, 1024, broad_phase_layer_interface, BroadPhaseCanCollide, ObjectCanCollide);
+		BodyInterface &bi = system.GetBodyInterface();
+
+		// Floor is stored in a tree
+		bi.CreateAndAddBody(BodyCreationSettings(new BoxShape(Vec3(100.0f, 1.0f, 100.0f), 0.0f), Vec3(0, -1, 0), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING), EActivation::DontActivate);
+
+		// Drop small boxes that are stored in hashed grids, a MOVING box is stored in the grid with fixed cell size and a HQ_DEBRIS box lands on top of it (HQ_DEBRIS is in the same broadphase layer).
+		// LQ_DEBRIS boxes don't collide with the other boxes and are stored in the grid with an automatic cell size.
+		RefConst<Shape> box = new BoxShape(Vec3::sReplicate(0.25f));
+		BodyIDVector top_boxes, debris_boxes;
+		for (int x = 0; x < 5; ++x)
+			for (int z = 0; z < 5; ++z)
+			{
+				Vec3 position(float(x), 0.25f, float(z));
+				bi.CreateAndAddBody(BodyCreationSettings(box, position, Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING), EActivation::Activate);
+				top_boxes.push_back(bi.CreateAndAddBody(BodyCreationSettings(box, position + Vec3(0, 1, 0), Quat::sIdentity(), EMotionType::Dynamic, Layers::HQ_DEBRIS), EActivation::Activate));
+				debris_boxes.push_back(bi.CreateAndAddBody(BodyCreationSettings(box, position + Vec3(0, 1, 10), Quat::sIdentity(), EMotionType::Dynamic, Layers::LQ_DEBRIS), EActivation::Activate));
+			}
+		system.OptimizeBroadPhase();
+
+		for (int i = 0; i < 120; ++i)
+			system.Update(1.0f / 60.0f, 1, 1, &temp_allocator, &job_system);
+
+		// The top boxes should be resting on the bottom boxes and the debris on the floor (allowing for the penetration slop)
+		for (BodyID id : top_boxes)
+			CHECK_APPROX_EQUAL(bi.GetPosition(id).GetY(), 0.75f, 0.05f);
+		for (BodyID id : debris_boxes)
+			CHECK_APPROX_EQUAL(bi.GetPosition(id).GetY(), 0.25f, 0.05f);
+	}
+}
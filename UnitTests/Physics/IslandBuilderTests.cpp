@@ -0,0 +1,286 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include "PhysicsTestContext.h"
+#include "Layers.h"
+#include <Jolt/Physics/IslandBuilder.h>
+#include <Jolt/Physics/Constraints/ConstraintManager.h>
+#include <Jolt/Physics/Constraints/PointConstraint.h>
+#include <Jolt/Core/TempAllocator.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+TEST_SUITE("IslandBuilderTests")
+{
+	TEST_CASE("TestIslandBuilderFinalizeMultipleJobs")
+	{
+		// Use enough bodies so that every phase of finalize has multiple batches
+		const uint32 cNumTriplets = 1000;								// Bodies [0, 3 * cNumTriplets) form islands of 3 bodies linked by contacts
+		const uint32 cLargeIslandBegin = 3 * cNumTriplets;				// Of the bodies [cLargeIslandBegin, cNumBodies) every third body is not linked, the others form one island linked by constraints
+		const uint32 cNumSingleBodies = 1000;							// Interleaving the bodies causes every batch to write to the large island many times, which makes the order of its bodies depend on timing
+		const uint32 cNumBodies = cLargeIslandBegin + 3 * cNumSingleBodies;
+		const uint32 cNumContacts = 2 * cNumTriplets;
+		const uint32 cNumConstraints = 2 * cNumSingleBodies - 1;
+		const int cNumJobs = 4;
+
+		// Store the active bodies in reverse order so that the order of the active bodies list differs from the order of the body IDs
+		vector<BodyID> active_bodies;
+		for (uint32 i = 0; i < cNumBodies; ++i)
+			active_bodies.push_back(BodyID(cNumBodies - 1 - i));
+
+		TempAllocatorImpl temp_allocator(16 * 1024 * 1024);
+		IslandBuilder builder;
+		builder.Init(cNumBodies);
+
+		UnitTestRandom random;
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			builder.PrepareContactConstraints(cNumContacts, &temp_allocator);
+			builder.PrepareNonContactConstraints(cNumConstraints, &temp_allocator);
+
+			// Link the triplets with contacts
+			vector<pair<uint32, uint32>> contacts;
+			for (uint32 t = 0; t < cNumTriplets; ++t)
+				for (uint32 b = 0; b < 2; ++b)
+				{
+					uint32 body1 = 3 * t + b, body2 = 3 * t + b + 1;
+					builder.LinkBodies(body1, body2);
+					builder.LinkContact(uint32(contacts.size()), body1, body2);
+					contacts.push_back({ body1, body2 });
+				}
+
+			// Link the large island with constraints in a random tree
+			vector<pair<uint32, uint32>> constraints;
+			vector<uint32> large_island;
+			for (uint32 body2 = cLargeIslandBegin; body2 < cNumBodies; ++body2)
+				if ((body2 - cLargeIslandBegin) % 3 != 2)
+				{
+					if (!large_island.empty())
+					{
+						uint32 body1 = large_island[uniform_int_distribution<size_t>(0, large_island.size() - 1)(random)];
+						builder.LinkConstraint(uint32(constraints.size()), body1, body2);
+						constraints.push_back({ body1, body2 });
+					}
+					large_island.push_back(body2);
+				}
+
+			// Finalize every phase from multiple threads, exactly one thread should finish the phase
+			for (;;)
+			{
+				atomic<int> num_started = 0, num_next_phase = 0, num_done = 0;
+				vector<thread> jobs;
+				for (int j = 0; j < cNumJobs; ++j)
+					jobs.emplace_back([&]() {
+						// Wait until all threads have started so that they process the phase at the same time
+						++num_started;
+						while (num_started < cNumJobs)
+							this_thread::yield();
+
+						switch (builder.Finalize(active_bodies.data(), cNumBodies, cNumContacts, &temp_allocator))
+						{
+						case IslandBuilder::EFinalizeResult::NoMoreWork:	break;
+						case IslandBuilder::EFinalizeResult::NextPhase:		++num_next_phase; break;
+						case IslandBuilder::EFinalizeResult::Done:			++num_done; break;
+						}
+					});
+				for (thread &t : jobs)
+					t.join();
+				CHECK(num_next_phase + num_done == 1);
+				if (num_done > 0)
+					break;
+				CHECK(builder.GetNumNextFinalizePhaseBatches() > 1);
+				builder.StartNextFinalizePhase();
+			}
+			CHECK(builder.GetNumIslands() == cNumTriplets + 1 + cNumSingleBodies);
+
+			// Check that every body is in exactly one island (indexed by the index in the active bodies list)
+			vector<uint32> body_island(cNumBodies, ~uint32(0));
+			for (uint32 island = 0; island < builder.GetNumIslands(); ++island)
+			{
+				BodyID *bodies_begin, *bodies_end;
+				builder.GetBodiesInIsland(island, bodies_begin, bodies_end);
+				CHECK(bodies_begin < bodies_end);
+				for (const BodyID *b = bodies_begin; b < bodies_end; ++b)
+				{
+					// The bodies should be sorted by body ID, regardless of the amount of threads
+					CHECK((b == bodies_begin || b[-1] < b[0]));
+
+					uint32 active_index = cNumBodies - 1 - b->GetIndex();
+					CHECK(body_island[active_index] == ~uint32(0));
+					body_island[active_index] = island;
+				}
+			}
+			for (uint32 i = 0; i < cNumBodies; ++i)
+				CHECK(body_island[i] != ~uint32(0));
+
+			// Check that constraints and contacts are in the island of their bodies and that the largest islands go first
+			uint32 num_found_contacts = 0, num_found_constraints = 0;
+			uint32 prev_island_size = ~uint32(0);
+			for (uint32 island = 0; island < builder.GetNumIslands(); ++island)
+			{
+				uint32 island_size = 0;
+
+				uint32 *contacts_begin, *contacts_end;
+				if (builder.GetContactsInIsland(island, contacts_begin, contacts_end))
+					for (const uint32 *c = contacts_begin; c < contacts_end; ++c)
+					{
+						CHECK(body_island[contacts[*c].first] == island);
+						CHECK(body_island[contacts[*c].second] == island);
+						++num_found_contacts;
+						++island_size;
+					}
+
+				uint32 *constraints_begin, *constraints_end;
+				if (builder.GetConstraintsInIsland(island, constraints_begin, constraints_end))
+					for (const uint32 *c = constraints_begin; c < constraints_end; ++c)
+					{
+						CHECK(body_island[constraints[*c].first] == island);
+						CHECK(body_island[constraints[*c].second] == island);
+						++num_found_constraints;
+						++island_size;
+					}
+
+				CHECK(island_size <= prev_island_size);
+				prev_island_size = island_size;
+			}
+			CHECK(num_found_contacts == cNumContacts);
+			CHECK(num_found_constraints == cNumConstraints);
+
+			builder.ResetIslands(&temp_allocator);
+			CHECK(temp_allocator.IsEmpty());
+		}
+	}
+
+	TEST_CASE("TestIslandBuilderPersistentLinks")
+	{
+		const uint32 cNumBodies = 6;
+
+		BodyID active_bodies[cNumBodies];
+		for (uint32 i = 0; i < cNumBodies; ++i)
+			active_bodies[i] = BodyID(i);
+
+		TempAllocatorImpl temp_allocator(1024 * 1024);
+		IslandBuilder builder;
+		builder.Init(cNumBodies);
+
+		// Run a simulation step, linking the specified bodies, and return the island index for every body
+		auto step = [&](uint32 inNumActiveBodies, const vector<pair<uint32, uint32>> &inLinks, vector<uint32> &outBodyIsland)
+		{
+			builder.PrepareBodyLinks(active_bodies, inNumActiveBodies, true);
+			builder.PrepareContactConstraints(0, &temp_allocator);
+			builder.PrepareNonContactConstraints(0, &temp_allocator);
+			for (const pair<uint32, uint32> &l : inLinks)
+				builder.LinkBodies(l.first, l.second);
+			IslandBuilder::EFinalizeResult result;
+			while ((result = builder.Finalize(active_bodies, inNumActiveBodies, 0, &temp_allocator)) == IslandBuilder::EFinalizeResult::NextPhase)
+				builder.StartNextFinalizePhase();
+			CHECK(result == IslandBuilder::EFinalizeResult::Done);
+
+			outBodyIsland.assign(inNumActiveBodies, ~uint32(0));
+			for (uint32 island = 0; island < builder.GetNumIslands(); ++island)
+			{
+				BodyID *bodies_begin, *bodies_end;
+				builder.GetBodiesInIsland(island, bodies_begin, bodies_end);
+				for (const BodyID *b = bodies_begin; b < bodies_end; ++b)
+					outBodyIsland[b->GetIndex()] = island;
+			}
+
+			builder.ResetIslands(&temp_allocator);
+		};
+
+		// First step starts without links
+		vector<uint32> island;
+		step(4, { { 0, 1 }, { 2, 3 } }, island);
+		CHECK(!builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 0, 1, 1 });
+
+		// Bodies stay in the same island even though they're no longer linked, new links merge islands
+		step(4, { { 1, 2 } }, island);
+		CHECK(builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 0, 0, 0 });
+
+		// Activating bodies keeps the links
+		step(6, { { 4, 5 } }, island);
+		CHECK(builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 0, 0, 0, 1, 1 });
+
+		// Requesting a split starts over
+		builder.RequestSplitIslands();
+		step(6, { { 0, 1 } }, island);
+		CHECK(!builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 0, 1, 2, 3, 4 });
+
+		// Deactivating a body starts over
+		step(6, { { 2, 3 } }, island);
+		CHECK(builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 0, 1, 1, 2, 3 });
+		step(5, { }, island);
+		CHECK(!builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 1, 2, 3, 4 });
+
+		// Replacing a body in the active bodies list starts over
+		step(5, { { 3, 4 } }, island);
+		CHECK(builder.IslandsIncludePreviousLinks());
+		CHECK(island == vector<uint32> { 0, 1, 2, 3, 3 });
+		active_bodies[3] = BodyID(5);
+		step(5, { }, island);
+		CHECK(!builder.IslandsIncludePreviousLinks());
+	}
+
+	TEST_CASE("TestIslandBuilderSplitOnDisabledConstraint")
+	{
+		PhysicsTestContext c;
+		Body &body1 = c.CreateBox(Vec3::sZero(), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f));
+		Body &body2 = c.CreateBox(Vec3(2, 0, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f));
+
+		PointConstraintSettings settings;
+		settings.mPoint1 = settings.mPoint2 = Vec3(1, 0, 0);
+		Ref<Constraint> constraint = settings.Create(body1, body2);
+		Constraint *constraint_ptr = constraint.GetPtr();
+		ConstraintManager manager;
+		manager.Add(&constraint_ptr, 1);
+
+		BodyID active_bodies[] = { body1.GetID(), body2.GetID() };
+		TempAllocatorImpl temp_allocator(1024 * 1024);
+		IslandBuilder builder;
+		builder.Init(2);
+
+		// Run a simulation step that keeps the links of the previous step, returns if the islands included links of the previous step
+		auto step = [&]()
+		{
+			builder.PrepareBodyLinks(active_bodies, 2, true);
+			builder.PrepareContactConstraints(0, &temp_allocator);
+
+			// Determine the active constraints and link their bodies
+			Constraint *active_constraint = nullptr;
+			uint32 num_active_constraints = 0;
+			manager.GetActiveConstraints(0, 1, &active_constraint, num_active_constraints, builder);
+			builder.PrepareNonContactConstraints(num_active_constraints, &temp_allocator);
+			if (num_active_constraints > 0)
+				builder.LinkConstraint(0, 0, 1);
+
+			IslandBuilder::EFinalizeResult result;
+			while ((result = builder.Finalize(active_bodies, 2, 0, &temp_allocator)) == IslandBuilder::EFinalizeResult::NextPhase)
+				builder.StartNextFinalizePhase();
+			CHECK(result == IslandBuilder::EFinalizeResult::Done);
+
+			bool include_previous_links = builder.IslandsIncludePreviousLinks();
+			builder.ResetIslands(&temp_allocator);
+			return include_previous_links;
+		};
+
+		// The first step starts without links, the next step keeps the link of the constraint
+		CHECK(!step());
+		CHECK(step());
+
+		// The step that finds the constraint disabled still uses the old links, the step after it starts over
+		constraint->SetEnabled(false);
+		CHECK(step());
+		CHECK(!step());
+		CHECK(step());
+		CHECK(temp_allocator.IsEmpty());
+	}
+}
@@ -0,0 +1,199 @@
+// SPDX-FileCopyrightText: 2021 Jorrit Rouwe
+// SPDX-License-Identifier: MIT
+
+#include "UnitTestFramework.h"
+#include "PhysicsTestContext.h"
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <random>
+
+TEST_SUITE("NarrowPhaseQueryTests")
+{
+	// Create a grid of spheres with some holes in it
+	static void sCreateSpheres(PhysicsTestContext &ioContext)
+	{
+		for (int x = -5; x <= 5; ++x)
+			for (int z = -5; z <= 5; ++z)
+				if ((x + z) % 3 != 0)
+					ioContext.CreateSphere(Vec3(2.0f * x, 0.0f, 2.0f * z), 0.8f, EMotionType::Static, EMotionQuality::Discrete, Layers::NON_MOVING, EActivation::DontActivate);
+	}
+
+	TEST_CASE("TestCastRaysBatched")
+	{
+		PhysicsTestContext c;
+		sCreateSpheres(c);
+		const NarrowPhaseQuery &query = c.GetSystem()->GetNarrowPhaseQuery();
+
+		JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, 3);
+
+		// Rays pointing down with random offsets, enough to get multiple batches
+		mt19937 random;
+		uniform_real_distribution<float> offset(-12.0f, 12.0f);
+		vector<RayCast> rays;
+		for (int i = 0; i < 1000; ++i)
+			rays.push_back({ Vec3(offset(random), 5.0f, offset(random)), Vec3(0, -10.0f, 0) });
+
+		vector<RayCastResult> hits(rays.size());
+		query.CastRays(rays.data(), (int)rays.size(), hits.data(), job_system);
+
+		// Compare with casting the rays one by one
+		int num_hits = 0;
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			RayCastResult expected;
+			if (query.CastRay(rays[i], expected))
+			{
+				CHECK(hits[i].mBodyID == expected.mBodyID);
+				CHECK(hits[i].mFraction == expected.mFraction);
+				++num_hits;
+			}
+			else
+				CHECK(hits[i].mBodyID.IsInvalid());
+		}
+		CHECK(num_hits > 0);
+		CHECK(num_hits < (int)rays.size());
+	}
+
+	TEST_CASE("TestCastShapesBatched")
+	{
+		PhysicsTestContext c;
+		sCreateSpheres(c);
+		const NarrowPhaseQuery &query = c.GetSystem()->GetNarrowPhaseQuery();
+
+		JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, 3);
+
+		// Cast small spheres down, enough to get multiple batches
+		RefConst<Shape> sphere = new SphereShape(0.1f);
+		mt19937 random;
+		uniform_real_distribution<float> offset(-12.0f, 12.0f);
+		vector<ShapeCast> casts;
+		for (int i = 0; i < 200; ++i)
+			casts.push_back(ShapeCast(sphere, Vec3::sReplicate(1.0f), Mat44::sTranslation(Vec3(offset(random), 5.0f, offset(random))), Vec3(0, -10.0f, 0)));
+
+		ShapeCastSettings settings;
+		vector<ShapeCastResult> hits(casts.size());
+		query.CastShapes(casts.data(), (int)casts.size(), settings, hits.data(), job_system);
+
+		// Compare with casting the shapes one by one
+		for (size_t i = 0; i < casts.size(); ++i)
+		{
+			ClosestHitCollisionCollector<CastShapeCollector> expected;
+			query.CastShape(casts[i], settings, expected);
+			if (expected.HadHit())
+			{
+				CHECK(hits[i].mBodyID2 == expected.mHit.mBodyID2);
+				CHECK(hits[i].mFraction == expected.mHit.mFraction);
+			}
+			else
+				CHECK(hits[i].mBodyID2.IsInvalid());
+		}
+	}
+
+	TEST_CASE("TestCollideShapesBatched")
+	{
+		PhysicsTestContext c;
+		sCreateSpheres(c);
+		const NarrowPhaseQuery &query = c.GetSystem()->GetNarrowPhaseQuery();
+
+		JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, 3);
+
+		// Collide large spheres that overlap with multiple spheres of the grid
+		RefConst<Shape> sphere = new SphereShape(2.5f);
+		mt19937 random;
+		uniform_real_distribution<float> offset(-12.0f, 12.0f);
+		vector<NarrowPhaseQuery::CollideShapeQuery> queries;
+		for (int i = 0; i < 200; ++i)
+			queries.push_back({ sphere, Vec3::sReplicate(1.0f), Mat44::sTranslation(Vec3(offset(random), 0.0f, offset(random))) });
+
+		// Allow only a few hits per query so that some of the queries are truncated
+		constexpr int cMaxHits = 3;
+		CollideShapeSettings settings;
+		vector<CollideShapeResult> hits(queries.size() * cMaxHits);
+		vector<int> num_hits(queries.size());
+		query.CollideShapes(queries.data(), (int)queries.size(), settings, hits.data(), num_hits.data(), cMaxHits, job_system);
+
+		// Compare with colliding the shapes one by one
+		bool had_truncated_query = false;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			AllHitCollisionCollector<CollideShapeCollector> expected;
+			query.CollideShape(queries[i].mShape, queries[i].mShapeScale, queries[i].mCenterOfMassTransform, settings, expected);
+			CHECK(num_hits[i] == min((int)expected.mHits.size(), cMaxHits));
+			had_truncated_query |= (int)expected.mHits.size() > cMaxHits;
+
+			// Every returned hit must be one of the expected hits
+			for (int h = 0; h < num_hits[i]; ++h)
+			{
+				const CollideShapeResult &hit = hits[i * cMaxHits + h];
+				bool found = false;
+				for (const CollideShapeResult &e : expected.mHits)
+					found |= e.mBodyID2 == hit.mBodyID2;
+				CHECK(found);
+			}
+		}
+		CHECK(had_truncated_query);
+	}
+
+	TEST_CASE("TestCastRayPackets")
+	{
+		PhysicsTestContext c;
+		sCreateSpheres(c);
+
+		// Add a bumpy mesh below the spheres
+		TriangleList triangles;
+		constexpr int cGridSize = 20;
+		auto height = [](int inX, int inZ) { return -1.5f + 0.3f * sin(0.7f * inX) * cos(0.5f * inZ); };
+		for (int x = 0; x < cGridSize; ++x)
+			for (int z = 0; z < cGridSize; ++z)
+			{
+				Float3 v1(float(x - cGridSize / 2), height(x, z), float(z - cGridSize / 2));
+				Float3 v2(float(x + 1 - cGridSize / 2), height(x + 1, z), float(z - cGridSize / 2));
+				Float3 v3(float(x - cGridSize / 2), height(x, z + 1), float(z + 1 - cGridSize / 2));
+				Float3 v4(float(x + 1 - cGridSize / 2), height(x + 1, z + 1), float(z + 1 - cGridSize / 2));
+				triangles.push_back(Triangle(v1, v3, v4));
+				triangles.push_back(Triangle(v1, v4, v2));
+			}
+		c.CreateBody(new MeshShapeSettings(triangles), Vec3::sZero(), Quat::sIdentity(), EMotionType::Static, EMotionQuality::Discrete, Layers::NON_MOVING, EActivation::DontActivate);
+
+		const NarrowPhaseQuery &query = c.GetSystem()->GetNarrowPhaseQuery();
+
+		// Fans of coherent rays from random points, some straight down and some under an angle, the number of rays is not a multiple of the packet size
+		mt19937 random;
+		uniform_real_distribution<float> offset(-12.0f, 12.0f);
+		uniform_real_distribution<float> spread(-0.2f, 0.2f);
+		vector<RayCast> rays;
+		for (int fan = 0; fan < 50; ++fan)
+		{
+			Vec3 origin(offset(random), 5.0f, offset(random));
+			Vec3 direction = fan % 2 == 0? Vec3(0, -10, 0) : Vec3(5.0f * spread(random), -10.0f, 5.0f * spread(random));
+			for (int r = 0; r < 7; ++r)
+				rays.push_back({ origin, direction + 10.0f * Vec3(spread(random), 0, spread(random)) });
+		}
+
+		vector<RayCastResult> hits(rays.size());
+		query.CastRayPackets(rays.data(), (int)rays.size(), hits.data());
+
+		// Compare with casting the rays one by one
+		int num_hits = 0;
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			RayCastResult expected;
+			if (query.CastRay(rays[i], expected))
+			{
+				CHECK(hits[i].mBodyID == expected.mBodyID);
+				CHECK(hits[i].mSubShapeID2.GetValue() == expected.mSubShapeID2.GetValue());
+				CHECK(hits[i].mFraction == expected.mFraction);
+				++num_hits;
+			}
+			else
+				CHECK(hits[i].mBodyID.IsInvalid());
+		}
+		CHECK(num_hits > 0);
+	}
+}
@@ -4,6 +4,7 @@
 #include "UnitTestFramework.h"
 #include "PhysicsTestContext.h"
 #include "Layers.h"
+#include <Jolt/Physics/Constraints/PointConstraint.h>
 #include <Jolt/Physics/Constraints/SwingTwistConstraint.h>
 #include <Jolt/Physics/Collision/GroupFilterTable.h>
 
@@ -40,7 +41,8 @@ TEST_SUITE("PhysicsDeterminismTests")
 	}
 
 	/// Step two physics simulations for inTotalTime and check after each step that the simulations are identical
-	static void CompareSimulations(PhysicsTestContext &ioContext1, PhysicsTestContext &ioContext2, float inTotalTime)
+	/// If inAsync2 is true, the second simulation is stepped through StartUpdate / WaitForUpdate
+	static void CompareSimulations(PhysicsTestContext &ioContext1, PhysicsTestContext &ioContext2, float inTotalTime, bool inAsync2 = false)
 	{
 		CHECK(ioContext1.GetDeltaTime() == ioContext2.GetDeltaTime());
 
@@ -48,8 +50,20 @@ TEST_SUITE("PhysicsDeterminismTests")
 		for (float t = 0; t <= inTotalTime; t += ioContext1.GetDeltaTime())
 		{
 			// Step the simulation
-			ioContext1.SimulateSingleStep();
-			ioContext2.SimulateSingleStep();
+			if (inAsync2)
+			{
+				// Note that we can't step the first simulation while the second one is in flight as the calling thread holds the body locks
+				ioContext1.SimulateSingleStep();
+				PhysicsUpdateHandle handle = ioContext2.StartSingleStep();
+				ioContext2.WaitForSingleStep(handle);
+				CHECK(!handle.IsValid());
+				CHECK(handle.IsDone());
+			}
+			else
+			{
+				ioContext1.SimulateSingleStep();
+				ioContext2.SimulateSingleStep();
+			}
 
 			// Get all bodies
 			BodyIDVector bodies1, bodies2;
@@ -92,7 +106,7 @@ TEST_SUITE("PhysicsDeterminismTests")
 			{
 				Body &body = ioContext.CreateBox(Vec3(float(x), 5.0f, float(z)), Quat::sRandom(random), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.1f));
 				body.SetRestitution(restitution(random));
-				body.SetLinearVelocity(Vec3::sRandom(random));
+				body.SetLinearVelocity(float(x % 4) * Vec3::sRandom(random)); // Chains with a higher velocity go to sleep later
 			}
 	}
 
@@ -158,7 +172,7 @@ TEST_SUITE("PhysicsDeterminismTests")
 				Vec3 body_pos = Vec3(float(x), 5.0f, 0.2f * float(z));
 				Body &body = ioContext.CreateBox(body_pos, Quat::sRandom(random), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.1f));
 				body.SetRestitution(restitution(random));
-				body.SetLinearVelocity(Vec3::sRandom(random));
+				body.SetLinearVelocity(float(x % 4) * Vec3::sRandom(random)); // Chains with a higher velocity go to sleep later
 				body.SetCollisionGroup(CollisionGroup(group_filter, CollisionGroup::GroupID(x), CollisionGroup::SubGroupID(z)));
 
 				// Constrain the body to the previous body
@@ -191,4 +205,154 @@ TEST_SUITE("PhysicsDeterminismTests")
 
 		CompareSimulations(c1, c2, 5.0f);
 	}
+
+	static void EnableLargeIslandSplitter(PhysicsTestContext &ioContext)
+	{
+		PhysicsSettings settings = ioContext.GetSystem()->GetPhysicsSettings();
+		settings.mUseLargeIslandSplitter = true;
+		ioContext.GetSystem()->SetPhysicsSettings(settings);
+	}
+
+	static void CreatePyramid(PhysicsTestContext &ioContext)
+	{
+		ioContext.CreateFloor();
+
+		// A pyramid of boxes forms one island that is large enough to be split
+		const int cPyramidHeight = 15;
+		const Vec3 cHalfExtent = Vec3::sReplicate(1.0f);
+		for (int y = 0; y < cPyramidHeight; ++y)
+			for (int x = y; x < cPyramidHeight; ++x)
+				ioContext.CreateBox(Vec3(2.0f * x - y - cPyramidHeight, 1.0f + 2.0f * y, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, cHalfExtent);
+	}
+
+	TEST_CASE("TestPyramidLargeIslandSplitter")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 1, 2, 0);
+		EnableLargeIslandSplitter(c1);
+		CreatePyramid(c1);
+
+		// The splits don't depend on the amount of threads so the simulation should be identical
+		PhysicsTestContext c2(1.0f / 60.0f, 1, 2, 15);
+		EnableLargeIslandSplitter(c2);
+		CreatePyramid(c2);
+
+		CompareSimulations(c1, c2, 2.0f);
+
+		// Check that the pyramid is still standing
+		BodyIDVector bodies;
+		c2.GetSystem()->GetBodies(bodies);
+		CHECK_APPROX_EQUAL(c2.GetBodyInterface().GetPosition(bodies.back()).GetY(), 29.0f, 0.05f);
+	}
+
+	/// Hash the state of all bodies, the hashes of two simulations are only equal if they are identical
+	static uint64 HashBodyStates(PhysicsTestContext &ioContext)
+	{
+		uint64 hash = 14695981039346656037UL;
+		auto hash_bytes = [&hash](const void *inData, size_t inSize)
+		{
+			for (const uint8 *b = (const uint8 *)inData, *end = b + inSize; b < end; ++b)
+			{
+				hash ^= *b;
+				hash = hash * 1099511628211UL;
+			}
+		};
+
+		BodyIDVector bodies;
+		ioContext.GetSystem()->GetBodies(bodies);
+		for (const BodyID &id : bodies)
+		{
+			BodyProperties properties;
+			GetBodyProperties(ioContext, id, properties);
+			Float3 values[] = { Float3(properties.mPositionCOM.GetX(), properties.mPositionCOM.GetY(), properties.mPositionCOM.GetZ()),
+								Float3(properties.mRotation.GetX(), properties.mRotation.GetY(), properties.mRotation.GetZ()),
+								Float3(properties.mLinearVelocity.GetX(), properties.mLinearVelocity.GetY(), properties.mLinearVelocity.GetZ()),
+								Float3(properties.mAngularVelocity.GetX(), properties.mAngularVelocity.GetY(), properties.mAngularVelocity.GetZ()) };
+			float rotation_w = properties.mRotation.GetW();
+			hash_bytes(values, sizeof(values));
+			hash_bytes(&rotation_w, sizeof(rotation_w));
+			hash_bytes(&properties.mIsActive, sizeof(properties.mIsActive));
+		}
+
+		// Note that we don't hash the order of the active bodies list, islands are deactivated in parallel so this order depends on the amount of threads
+		return hash;
+	}
+
+	static void CreateChainsOnFloor(PhysicsTestContext &ioContext)
+	{
+		UnitTestRandom random;
+
+		ioContext.CreateFloor();
+
+		// Create more active bodies than fit in a single batch of the island builder so that islands are finalized by multiple jobs
+		const int cNumChains = 40;
+		const int cChainLength = 30;
+		static_assert(cNumChains * cChainLength > 1024);
+		for (int x = 0; x < cNumChains; ++x)
+		{
+			// Create a chain of bodies connected with point constraints that settles and goes to sleep on the floor
+			Body *prev_body = nullptr;
+			for (int z = 0; z < cChainLength; ++z)
+			{
+				Vec3 body_pos = Vec3(0.5f * float(x), 0.2f, 0.2f * float(z));
+				Body &body = ioContext.CreateBox(body_pos, Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.09f));
+				body.SetLinearVelocity(float(x % 4) * Vec3::sRandom(random)); // Chains with a higher velocity go to sleep later
+
+				if (prev_body != nullptr)
+				{
+					PointConstraintSettings pc;
+					pc.mPoint1 = pc.mPoint2 = body_pos - Vec3(0, 0, 0.1f);
+					ioContext.GetSystem()->AddConstraint(pc.Create(*prev_body, body));
+				}
+
+				prev_body = &body;
+			}
+		}
+	}
+
+	TEST_CASE("TestChainsMultipleFinalizeIslandBatches")
+	{
+		const uint cMaxBodies = 4096;
+
+		PhysicsTestContext c1(1.0f / 60.0f, 1, 1, 0, EBroadPhaseType::QuadTree, cMaxBodies);
+		CreateChainsOnFloor(c1);
+
+		// Finalizing the islands in multiple batches should not change the simulation
+		PhysicsTestContext c2(1.0f / 60.0f, 1, 1, 15, EBroadPhaseType::QuadTree, cMaxBodies);
+		CreateChainsOnFloor(c2);
+
+		for (int i = 0; i < 150; ++i)
+		{
+			c1.SimulateSingleStep();
+			c2.SimulateSingleStep();
+		}
+
+		CHECK(HashBodyStates(c1) == HashBodyStates(c2));
+	}
+
+	TEST_CASE("TestGridOfBoxesCachedJobGraph")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 2, 2, 0);
+		CreateGridOfBoxesLinearCast(c1);
+
+		// Reusing the jobs of the previous update should not change the simulation
+		PhysicsTestContext c2(1.0f / 60.0f, 2, 2, 15);
+		PhysicsSettings settings = c2.GetSystem()->GetPhysicsSettings();
+		settings.mCacheJobGraph = true;
+		c2.GetSystem()->SetPhysicsSettings(settings);
+		CreateGridOfBoxesLinearCast(c2);
+
+		CompareSimulations(c1, c2, 5.0f);
+	}
+
+	TEST_CASE("TestGridOfBoxesStartUpdate")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 2, 2, 0);
+		CreateGridOfBoxesLinearCast(c1);
+
+		// Running the update asynchronously should not change the simulation
+		PhysicsTestContext c2(1.0f / 60.0f, 2, 2, 15);
+		CreateGridOfBoxesLinearCast(c2);
+
+		CompareSimulations(c1, c2, 5.0f, true);
+	}
 }
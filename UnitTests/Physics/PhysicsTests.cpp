@@ -10,6 +10,10 @@
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Body/BodyLockMulti.h>
 
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
 TEST_SUITE("PhysicsTests")
 {
 	// Gravity vector
@@ -188,6 +192,58 @@ TEST_SUITE("PhysicsTests")
 		bi.DestroyBody(body0_id);
 	}
 
+	TEST_CASE("TestPhysicsBodyStorage")
+	{
+		PhysicsTestContext c(1.0f / 60.0f, 1, 1);
+		BodyInterface &bi = c.GetBodyInterface();
+
+		// Create a mix of static and dynamic bodies
+		const int cNumBodies = 600;
+		Body *bodies[cNumBodies];
+		BodyIDVector body_ids;
+		for (int i = 0; i < cNumBodies; ++i)
+		{
+			EMotionType motion_type = (i % 3) == 0? EMotionType::Static : EMotionType::Dynamic;
+			Body *body = bi.CreateBody(BodyCreationSettings(new BoxShape(Vec3::sReplicate(1.0f)), Vec3::sZero(), Quat::sIdentity(), motion_type, motion_type == EMotionType::Static? Layers::NON_MOVING : Layers::MOVING));
+			bodies[i] = body;
+			body_ids.push_back(body->GetID());
+
+			// Check that bodies are cache line aligned and stored next to each other
+			CHECK(body->GetID().GetIndex() == uint32(i));
+			CHECK(IsAligned(body, JPH_CACHE_LINE_SIZE));
+			if (i > 0 && (i % 256) != 0)
+				CHECK(bodies[i - 1] + 1 == body);
+			CHECK(body->IsStatic() == (motion_type == EMotionType::Static));
+		}
+
+		// Destroy and recreate the bodies a couple of times, the storage should be reused
+		for (int iteration = 0; iteration < 3; ++iteration)
+		{
+			bi.DestroyBodies(body_ids.data(), (int)body_ids.size());
+			body_ids.clear();
+
+			for (int i = 0; i < cNumBodies; ++i)
+			{
+				// Make the static and dynamic bodies swap every iteration so that motion properties need to move around
+				EMotionType motion_type = ((i + iteration + 1) % 3) == 0? EMotionType::Static : EMotionType::Dynamic;
+				Body *body = bi.CreateBody(BodyCreationSettings(new BoxShape(Vec3::sReplicate(1.0f)), Vec3(float(i), 0, 0), Quat::sIdentity(), motion_type, motion_type == EMotionType::Static? Layers::NON_MOVING : Layers::MOVING));
+				body_ids.push_back(body->GetID());
+
+				// The body should end up in one of the slots that was freed
+				CHECK(find(bodies, bodies + cNumBodies, body) != bodies + cNumBodies);
+				CHECK(body->GetPosition() == Vec3(float(i), 0, 0));
+				CHECK(body->IsStatic() == (motion_type == EMotionType::Static));
+				if (!body->IsStatic())
+				{
+					CHECK(body->GetMotionProperties()->GetInverseMass() > 0.0f);
+					CHECK(body->GetLinearVelocity() == Vec3::sZero());
+				}
+			}
+		}
+
+		bi.DestroyBodies(body_ids.data(), (int)body_ids.size());
+	}
+
 	TEST_CASE("TestPhysicsBodyUserData")
 	{
 		PhysicsTestContext c(1.0f / 60.0f, 1, 1);
@@ -305,6 +361,37 @@ TEST_SUITE("PhysicsTests")
 		TestPhysicsFreeFall(c);
 	}
 
+	TEST_CASE("TestPhysicsFreeFallStartUpdate")
+	{
+		const Vec3 cInitialPos(0.0f, 10.0f, 0.0f);
+		const int cNumSteps = 60;
+
+		PhysicsTestContext c(1.0f / 60.0f, 1, 1, 4);
+		Body &body = c.CreateBox(cInitialPos, Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3(1, 1, 1));
+
+		for (int s = 0; s < cNumSteps; ++s)
+		{
+			// Poll until the worker threads have finished the step
+			PhysicsUpdateHandle handle = c.StartSingleStep();
+			CHECK(handle.IsValid());
+			while (!handle.IsDone())
+				this_thread::yield();
+			c.WaitForSingleStep(handle);
+			CHECK(!handle.IsValid());
+		}
+
+		// Test resulting position
+		Vec3 expected_pos = c.PredictPosition(cInitialPos, Vec3::sZero(), cGravity, cNumSteps * c.GetDeltaTime());
+		CHECK_APPROX_EQUAL(expected_pos, body.GetPosition());
+
+		// Starting an update without active bodies doesn't start any jobs
+		c.GetBodyInterface().DeactivateBody(body.GetID());
+		PhysicsUpdateHandle handle = c.StartSingleStep();
+		CHECK(!handle.IsValid());
+		CHECK(handle.IsDone());
+		c.WaitForSingleStep(handle);
+	}
+
 	TEST_CASE("TestPhysicsFreeFallSubStep")
 	{
 		PhysicsTestContext c1(2.0f / 60.0f, 1, 2);
@@ -1199,4 +1286,181 @@ TEST_SUITE("PhysicsTests")
 		CHECK_APPROX_EQUAL(lq_debris1.GetPosition(), Vec3(0, 0.5f, 0), slop);
 		CHECK_APPROX_EQUAL(lq_debris2.GetPosition(), Vec3(0, 0.5f, 0), slop);
 	}
+
+	TEST_CASE("TestPhysicsBatchedContactSolver")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 1, 1, 0);
+		PhysicsTestContext c2(1.0f / 60.0f, 1, 1, 0);
+
+		// Enable the batched solver for the second simulation, the splitter puts contacts that don't share bodies next to each other so they can be batched
+		PhysicsSettings settings = c1.GetSystem()->GetPhysicsSettings();
+		settings.mUseLargeIslandSplitter = true;
+		c1.GetSystem()->SetPhysicsSettings(settings);
+		settings.mUseBatchedContactSolver = true;
+		c2.GetSystem()->SetPhysicsSettings(settings);
+
+		// Create a pyramid of boxes
+		for (PhysicsTestContext *c : { &c1, &c2 })
+		{
+			c->CreateFloor();
+			const int cPyramidHeight = 15;
+			for (int y = 0; y < cPyramidHeight; ++y)
+				for (int x = y; x < cPyramidHeight; ++x)
+					c->CreateBox(Vec3(2.0f * x - y - cPyramidHeight, 1.0f + 2.0f * y, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(1.0f));
+		}
+
+		c1.Simulate(1.0f);
+		c2.Simulate(1.0f);
+
+		// Solving the contacts in batches only changes the rounding of the calculations, so the results should be very close
+		BodyIDVector bodies1, bodies2;
+		c1.GetSystem()->GetBodies(bodies1);
+		c2.GetSystem()->GetBodies(bodies2);
+		CHECK(bodies1.size() == bodies2.size());
+		for (size_t i = 0; i < bodies1.size(); ++i)
+		{
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetPosition(bodies1[i]), c2.GetBodyInterface().GetPosition(bodies2[i]), 1.0e-3f);
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetRotation(bodies1[i]), c2.GetBodyInterface().GetRotation(bodies2[i]), 1.0e-3f);
+		}
+	}
+	TEST_CASE("TestPhysicsVectorizedIntegration")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 1, 2, 0);
+		PhysicsTestContext c2(1.0f / 60.0f, 1, 2, 0);
+
+		// Enable vectorized integration for the second simulation
+		PhysicsSettings settings = c2.GetSystem()->GetPhysicsSettings();
+		settings.mUseVectorizedIntegration = true;
+		c2.GetSystem()->SetPhysicsSettings(settings);
+
+		// Create bodies that don't touch with different velocities, damping and inertia. The amount of bodies is not a multiple of the batch size or the SIMD width.
+		const int cNumBodies = 71;
+		BodyIDVector dynamic_bodies1, dynamic_bodies2;
+		UnitTestRandom random;
+		uniform_real_distribution<float> velocity(-10.0f, 10.0f);
+		uniform_real_distribution<float> fraction(0.0f, 1.0f);
+		for (int i = 0; i < cNumBodies; ++i)
+		{
+			Vec3 half_extent(0.1f + fraction(random), 0.1f + fraction(random), 0.1f + fraction(random));
+			Quat rotation = Quat::sRotation(Vec3(fraction(random), fraction(random), 1.0f).Normalized(), JPH_PI * fraction(random));
+			Vec3 linear_velocity(velocity(random), velocity(random), velocity(random));
+			Vec3 angular_velocity(velocity(random), velocity(random), velocity(random));
+			float linear_damping = 0.5f * fraction(random);
+			float angular_damping = 0.5f * fraction(random);
+			EMotionType motion_type = i % 10 == 9? EMotionType::Kinematic : EMotionType::Dynamic;
+			float max_angular_velocity = i % 3 == 0? 5.0f : 100.0f; // Some bodies are clamped
+
+			for (PhysicsTestContext *c : { &c1, &c2 })
+			{
+				Body &body = c->CreateBox(Vec3(10.0f * i, 0, 0), rotation, motion_type, EMotionQuality::Discrete, motion_type == EMotionType::Dynamic? Layers::MOVING : Layers::NON_MOVING, half_extent);
+				if (motion_type == EMotionType::Dynamic)
+					(c == &c1? dynamic_bodies1 : dynamic_bodies2).push_back(body.GetID());
+				MotionProperties *mp = body.GetMotionProperties();
+				mp->SetLinearDamping(linear_damping);
+				mp->SetAngularDamping(angular_damping);
+				mp->SetMaxAngularVelocity(max_angular_velocity);
+				mp->SetLinearVelocityClamped(linear_velocity);
+				mp->SetAngularVelocityClamped(angular_velocity);
+			}
+		}
+
+		// Apply a force and torque on all dynamic bodies every step
+		auto apply_force_and_torque = [](PhysicsTestContext &inContext, const BodyIDVector &inBodies)
+		{
+			for (BodyID id : inBodies)
+			{
+				inContext.GetBodyInterface().AddForce(id, Vec3(1, 2, 3));
+				inContext.GetBodyInterface().AddTorque(id, Vec3(-3, 2, 1));
+			}
+		};
+		c1.Simulate(1.0f, [&]() { apply_force_and_torque(c1, dynamic_bodies1); });
+		c2.Simulate(1.0f, [&]() { apply_force_and_torque(c2, dynamic_bodies2); });
+
+		// Only the rounding of the calculations is different, so the results should be very close
+		BodyIDVector bodies1, bodies2;
+		c1.GetSystem()->GetBodies(bodies1);
+		c2.GetSystem()->GetBodies(bodies2);
+		CHECK(bodies1.size() == bodies2.size());
+		for (size_t i = 0; i < bodies1.size(); ++i)
+		{
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetPosition(bodies1[i]), c2.GetBodyInterface().GetPosition(bodies2[i]), 1.0e-4f);
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetRotation(bodies1[i]), c2.GetBodyInterface().GetRotation(bodies2[i]), 1.0e-4f);
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetLinearVelocity(bodies1[i]), c2.GetBodyInterface().GetLinearVelocity(bodies2[i]), 1.0e-4f);
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetAngularVelocity(bodies1[i]), c2.GetBodyInterface().GetAngularVelocity(bodies2[i]), 1.0e-4f);
+		}
+	}
+
+	TEST_CASE("TestPhysicsSortActiveBodies")
+	{
+		PhysicsTestContext c(1.0f / 60.0f, 1, 1, 0);
+		BodyInterface &bi = c.GetBodyInterface();
+
+		// Sort the active bodies every step
+		PhysicsSettings settings = c.GetSystem()->GetPhysicsSettings();
+		settings.mSortActiveBodiesInterval = 1;
+		c.GetSystem()->SetPhysicsSettings(settings);
+
+		// Create bodies on a line in reverse order so that the activation order is the opposite of the spatial order
+		const int cNumBodies = 50;
+		for (int i = cNumBodies - 1; i >= 0; --i)
+			c.CreateBox(Vec3(5.0f * i, 0, 0), Quat::sIdentity(), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(1.0f));
+
+		// Check that the bodies were activated in creation order
+		BodyIDVector active_bodies;
+		c.GetSystem()->GetActiveBodies(active_bodies);
+		CHECK(active_bodies.size() == cNumBodies);
+		CHECK(bi.GetPosition(active_bodies.front()).GetX() > bi.GetPosition(active_bodies.back()).GetX());
+
+		c.SimulateSingleStep();
+
+		// After a step the active bodies should be sorted along the line and the bodies should know their new index
+		c.GetSystem()->GetActiveBodies(active_bodies);
+		CHECK(active_bodies.size() == cNumBodies);
+		for (int i = 0; i < cNumBodies; ++i)
+		{
+			BodyLockRead lock(c.GetSystem()->GetBodyLockInterface(), active_bodies[i]);
+			CHECK(lock.GetBody().GetPosition().GetX() == 5.0f * i);
+			CHECK(lock.GetBody().GetIndexInActiveBodiesInternal() == uint32(i));
+		}
+
+		// Sorting should not affect the simulation
+		c.Simulate(1.0f);
+		for (BodyID id : active_bodies)
+			CHECK_APPROX_EQUAL(bi.GetLinearVelocity(id), c.GetSystem()->GetGravity() * (1.0f + 1.0f / 60.0f), 1.0e-4f);
+	}
+
+	TEST_CASE("TestPhysicsBroadPhaseBoundsMargin")
+	{
+		PhysicsTestContext c1(1.0f / 60.0f, 1, 1, 0);
+		PhysicsTestContext c2(1.0f / 60.0f, 1, 1, 0);
+
+		// Enlarge the bounds of moving bodies in the broadphase for the second simulation
+		PhysicsSettings settings = c2.GetSystem()->GetPhysicsSettings();
+		settings.mBroadPhaseBoundsMargin = 0.1f;
+		settings.mBroadPhaseBoundsPredictionTime = 2.0f / 60.0f;
+		c2.GetSystem()->SetPhysicsSettings(settings);
+
+		// Drop boxes on the floor, they're far enough apart that the enlarged bounds of some of them overlap but they never touch
+		BodyIDVector bodies1, bodies2;
+		for (PhysicsTestContext *c : { &c1, &c2 })
+		{
+			c->CreateFloor();
+			for (int i = 0; i < 10; ++i)
+			{
+				Body &body = c->CreateBox(Vec3(2.1f * i, 1.0f + 0.5f * i, 0), Quat::sRotation(Vec3::sAxisZ(), 0.1f * i), EMotionType::Dynamic, EMotionQuality::Discrete, Layers::MOVING, Vec3::sReplicate(0.5f));
+				body.SetLinearVelocity(Vec3(i % 2 == 0? 1.0f : -1.0f, 0, 0));
+				(c == &c1? bodies1 : bodies2).push_back(body.GetID());
+			}
+		}
+
+		c1.Simulate(2.0f);
+		c2.Simulate(2.0f);
+
+		// The same contacts are found so the results should be the same
+		for (size_t i = 0; i < bodies1.size(); ++i)
+		{
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetPosition(bodies1[i]), c2.GetBodyInterface().GetPosition(bodies2[i]), 1.0e-5f);
+			CHECK_APPROX_EQUAL(c1.GetBodyInterface().GetRotation(bodies1[i]), c2.GetBodyInterface().GetRotation(bodies2[i]), 1.0e-5f);
+		}
+	}
 }
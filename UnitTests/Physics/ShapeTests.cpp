@@ -15,6 +15,7 @@
 #include <Jolt/Physics/Collision/Shape/TriangleShape.h>
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
 #include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Collision/CollidePointResult.h>
 #include <Jolt/Core/StreamWrapper.h>
@@ -527,6 +528,41 @@ TEST_SUITE("ShapeTests")
 		CHECK(static_cast<SphereShape *>(sphere.GetPtr())->GetRadius() == cRadius);
 	}
 
+	// Test that a mesh shape can only be restored by a build that uses the same tree codec
+	TEST_CASE("TestMeshShapeRestoreTreeCodec")
+	{
+		TriangleList triangles;
+		triangles.push_back(Triangle(Float3(0, 0, 0), Float3(1, 0, 0), Float3(0, 0, 1)));
+		triangles.push_back(Triangle(Float3(1, 0, 0), Float3(1, 0, 1), Float3(0, 0, 1)));
+		Ref<Shape> mesh = MeshShapeSettings(triangles).Create().Get();
+
+		// Write mesh to a binary stream
+		stringstream data;
+		{
+			StreamOutWrapper stream_out(data);
+			mesh->SaveBinaryState(stream_out);
+		}
+		string saved = data.str();
+
+		// Restoring should succeed
+		{
+			stringstream in(saved);
+			StreamInWrapper stream_in(in);
+			Shape::ShapeResult result = Shape::sRestoreFromBinaryState(stream_in);
+			CHECK(result.IsValid());
+			CHECK(result.Get()->GetStats().mNumTriangles == 2);
+		}
+
+		// Change the codec tag that follows the sub shape type and the user data, restoring should fail
+		saved[sizeof(EShapeSubType) + sizeof(uint64)] ^= 0x80;
+		{
+			stringstream in(saved);
+			StreamInWrapper stream_in(in);
+			Shape::ShapeResult result = Shape::sRestoreFromBinaryState(stream_in);
+			CHECK(result.HasError());
+		}
+	}
+
 	// Test setting user data on shapes
 	TEST_CASE("TestIsValidSubShapeID")
 	{
@@ -9,7 +9,7 @@
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/TempAllocator.h>
 
-PhysicsTestContext::PhysicsTestContext(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, int inWorkerThreads) :
+PhysicsTestContext::PhysicsTestContext(float inDeltaTime, int inCollisionSteps, int inIntegrationSubSteps, int inWorkerThreads, EBroadPhaseType inBroadPhaseType, uint inMaxBodies) :
 #ifdef JPH_DISABLE_TEMP_ALLOCATOR
 	mTempAllocator(new TempAllocatorMalloc()),
 #else
@@ -22,7 +22,7 @@ PhysicsTestContext::PhysicsTestContext(float inDeltaTime, int inCollisionSteps,
 {
 	// Create physics system
 	mSystem = new PhysicsSystem();
-	mSystem->Init(1024, 0, 4096, 1024, mBroadPhaseLayerInterface, BroadPhaseCanCollide, ObjectCanCollide);
+	mSystem->Init(inMaxBodies, 0, 4 * inMaxBodies, inMaxBodies, mBroadPhaseLayerInterface, BroadPhaseCanCollide, ObjectCanCollide, inBroadPhaseType);
 }
 
 PhysicsTestContext::~PhysicsTestContext()
@@ -98,6 +98,19 @@ void PhysicsTestContext::SimulateSingleStep()
 #endif // JPH_DISABLE_TEMP_ALLOCATOR
 }
 
+PhysicsUpdateHandle PhysicsTestContext::StartSingleStep()
+{
+	return mSystem->StartUpdate(mDeltaTime, mCollisionSteps, mIntegrationSubSteps, mTempAllocator, mJobSystem);
+}
+
+void PhysicsTestContext::WaitForSingleStep(PhysicsUpdateHandle &ioHandle)
+{
+	mSystem->WaitForUpdate(ioHandle);
+#ifndef JPH_DISABLE_TEMP_ALLOCATOR
+	JPH_ASSERT(static_cast<TempAllocatorImpl *>(mTempAllocator)->IsEmpty());
+#endif // JPH_DISABLE_TEMP_ALLOCATOR
+}
+
 Vec3 PhysicsTestContext::PredictPosition(Vec3Arg inPosition, Vec3Arg inVelocity, Vec3Arg inAcceleration, float inTotalTime) const
 {
 	// Integrate position using a Symplectic Euler step (just like the PhysicsSystem)
@@ -18,7 +18,7 @@ class PhysicsTestContext
 {
 public:
 	// Constructor / destructor
-						PhysicsTestContext(float inDeltaTime = 1.0f / 60.0f, int inCollisionSteps = 1, int inIntegrationSubSteps = 1, int inWorkerThreads = 0);
+						PhysicsTestContext(float inDeltaTime = 1.0f / 60.0f, int inCollisionSteps = 1, int inIntegrationSubSteps = 1, int inWorkerThreads = 0, EBroadPhaseType inBroadPhaseType = EBroadPhaseType::QuadTree, uint inMaxBodies = 1024);
 						~PhysicsTestContext();
 
 	// Set the gravity to zero
@@ -48,6 +48,12 @@ public:
 	// Simulate only for one delta time step
 	void				SimulateSingleStep();
 
+	// Start simulating one delta time step without waiting for it to finish
+	PhysicsUpdateHandle	StartSingleStep();
+
+	// Wait for a step that was started with StartSingleStep
+	void				WaitForSingleStep(PhysicsUpdateHandle &ioHandle);
+
 	// Simulate the world for inTotalTime time
 	void				Simulate(float inTotalTime, function<void()> inPreStepCallback = []() { });
 